@@ -1,12 +1,43 @@
 #include <QApplication>
+#include <QStringList>
 #include <teks/app/MainWindow.hpp>
+#include <teks/metrics.hpp>
+#include <teks/trace.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
 
 int main(int argc, char* argv[]) {
     QApplication app(argc, argv);
 
     teks::app::MainWindow window;
     window.resize(800, 600);
+    // every frame painted is logged where this names, with QT_QPA_PLATFORM=offscreen runs headless
+    const char* frameLogPath = std::getenv("TEKS_FRAME_LOG");
+    if (frameLogPath != nullptr) {
+        window.setFrameLog(std::make_shared<std::ofstream>(frameLogPath));
+    }
+    const QStringList arguments = QApplication::arguments();
+    if (arguments.size() > 1) {
+        window.openFile(std::filesystem::path(arguments[1].toStdU16String()));
+    } else {
+        // TODO(TB): Replace this development-only bootstrap with real document loading wiring.
+        window.openFile(std::filesystem::path(__FILE__));
+    }
     window.show();
 
-    return app.exec();
+    const int result = app.exec();
+
+    // built with TEKS_METRICS, the latencies of the session are written where this names
+    const char* metricsPath = std::getenv("TEKS_METRICS_JSON");
+    if (teks::metrics::enabled && metricsPath != nullptr) {
+        std::ofstream(metricsPath) << teks::metrics::toJson() << '\n';
+    }
+    // built with TEKS_TRACE, so is the trace, to open in Perfetto
+    const char* tracePath = std::getenv("TEKS_TRACE_JSON");
+    if (teks::trace::enabled && tracePath != nullptr) {
+        std::ofstream(tracePath) << teks::trace::toChromeJson() << '\n';
+    }
+    return result;
 }
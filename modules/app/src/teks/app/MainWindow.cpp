@@ -1,16 +1,147 @@
 #include "MainWindow.hpp"
 #include <teks/editor/DocumentView.hpp>
+#include <teks/editor/DocumentSession.hpp>
+#include <teks/editor/HugeFileView.hpp>
+#include <teks/MemoryUsage.hpp>
+#include <teks/metrics.hpp>
+#include <teks/trace.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <QKeyEvent>
+#include <QSplitter>
+#include <QString>
 #include <QVBoxLayout>
 
 namespace teks::app {
     MainWindow::MainWindow()
-        : documentView_(new editor::DocumentView(this))
+        : splitter_(new QSplitter(this))
+        , documentViews_{new editor::DocumentView(splitter_)}
     {
         auto* layout = new QVBoxLayout(this);
         layout->setContentsMargins(0, 0, 0, 0);
         layout->setSpacing(0);
-        layout->addWidget(documentView_);
+        layout->addWidget(splitter_);
 
         setWindowTitle(QString("Teks"));
     }
+
+    bool MainWindow::openFile(const std::filesystem::path& path) {
+        std::error_code error;
+        const auto size = std::filesystem::file_size(path, error);
+        const bool huge = !error && size >= editor::HugeFileView::minFileBytes;
+
+        if (huge) {
+            if (hugeFileView_ == nullptr) {
+                hugeFileView_ = new editor::HugeFileView(this);
+                layout()->addWidget(hugeFileView_);
+            }
+            if (!hugeFileView_->openFile(path)) {
+                return false;
+            }
+        } else {
+            if (!documentViews_.front()->openFile(path)) {
+                return false;
+            }
+            // every split shows the new document
+            for (usize i = 1; i < documentViews_.size(); ++i) {
+                documentViews_[i]->setSession(documentViews_.front()->session());
+            }
+        }
+
+        splitter_->setVisible(!huge);
+        if (hugeFileView_ != nullptr) {
+            hugeFileView_->setVisible(huge);
+        }
+        const QString name = QString::fromStdU16String(path.filename().u16string());
+        setWindowTitle(huge ? QString("%1 (read-only) - Teks").arg(name) : QString("%1 - Teks").arg(name));
+        return true;
+    }
+
+    void MainWindow::setFrameLog(std::shared_ptr<std::ostream> log) {
+        frameLog_ = std::move(log);
+        for (editor::DocumentView* view : documentViews_) {
+            view->setFrameLog(frameLog_);
+        }
+    }
+
+    void MainWindow::keyPressEvent(QKeyEvent* event) {
+        // views pass on the keys they do not handle
+        if (event->key() == Qt::Key_S && event->modifiers() == Qt::AltModifier) {
+            split();
+            return;
+        }
+        if (event->key() == Qt::Key_S && event->modifiers() == (Qt::AltModifier | Qt::ShiftModifier)) {
+            unsplit();
+            return;
+        }
+        if (event->key() == Qt::Key_M && event->modifiers() == Qt::AltModifier && metrics::enabled) {
+            std::fprintf(stderr, "%s\n", metrics::toJson().c_str());
+            return;
+        }
+        if (event->key() == Qt::Key_U && event->modifiers() == Qt::AltModifier) {
+            printMemoryUsage();
+            return;
+        }
+        if (event->key() == Qt::Key_T && event->modifiers() == Qt::AltModifier && trace::enabled) {
+            // what was just slow is still in the rings
+            const char* path = std::getenv("TEKS_TRACE_JSON");
+            std::ofstream(path != nullptr ? path : "teks-trace.json") << trace::toChromeJson() << '\n';
+            return;
+        }
+        QWidget::keyPressEvent(event);
+    }
+
+    void MainWindow::printMemoryUsage() const {
+        const auto& session = documentViews_[focusedView()]->session();
+        if (!session) {
+            return;
+        }
+        const MemoryUsage usage = session->memoryUsage();
+        std::fprintf(
+            stderr,
+            "{\"text\":%llu,\"lineIndex\":%llu,\"undoHistory\":%llu,\"caches\":%llu,\"slack\":%llu,\"total\":%llu}\n",
+            static_cast<unsigned long long>(usage.text),
+            static_cast<unsigned long long>(usage.lineIndex),
+            static_cast<unsigned long long>(usage.undoHistory),
+            static_cast<unsigned long long>(usage.caches),
+            static_cast<unsigned long long>(usage.slack),
+            static_cast<unsigned long long>(usage.total())
+        );
+    }
+
+    void MainWindow::split() {
+        const usize focused = focusedView();
+        auto* view = new editor::DocumentView();
+        view->setSession(documentViews_[focused]->session());
+        view->setWordWrap(documentViews_[focused]->wordWrap());
+        view->setHudVisible(documentViews_[focused]->hudVisible());
+        view->setFrameLog(frameLog_);
+        splitter_->insertWidget(static_cast<int>(focused + 1), view);
+        documentViews_.insert(documentViews_.begin() + static_cast<std::ptrdiff_t>(focused + 1), view);
+        view->setFocus();
+    }
+
+    void MainWindow::unsplit() {
+        if (documentViews_.size() == 1) {
+            return;
+        }
+        const usize focused = focusedView();
+        editor::DocumentView* view = documentViews_[focused];
+        documentViews_.erase(documentViews_.begin() + static_cast<std::ptrdiff_t>(focused));
+        documentViews_[std::min(focused, documentViews_.size() - 1)]->setFocus();
+        delete view;
+    }
+
+    usize MainWindow::focusedView() const {
+        for (usize i = 0; i < documentViews_.size(); ++i) {
+            if (documentViews_[i]->hasFocus()) {
+                return i;
+            }
+        }
+        return 0;
+    }
 } // namespace teks::app
@@ -1,13 +1,40 @@
 #pragma once
 
 #include <teks/editor/DocumentView.hpp>
+#include <teks/editor/HugeFileView.hpp>
+#include <teks/types.hpp>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <vector>
 #include <QWidget>
 
+class QSplitter;
+
 namespace teks::app {
     struct MainWindow : public QWidget {
         MainWindow();
 
+        // Files of at least `HugeFileView::minFileBytes` are shown read-only in a `HugeFileView`
+        bool openFile(const std::filesystem::path& path);
+        // Every view, including views split off later, logs its frames to `log`, see `DocumentView::setFrameLog`
+        void setFrameLog(std::shared_ptr<std::ostream> log);
+
     private:
-        editor::DocumentView* documentView_;
+        // side by side views of the same document
+        QSplitter* splitter_;
+        std::vector<editor::DocumentView*> documentViews_;
+        // created the first time a huge file is opened
+        editor::HugeFileView* hugeFileView_{nullptr};
+        std::shared_ptr<std::ostream> frameLog_;
+
+        void keyPressEvent(QKeyEvent* event) override;
+        // Adds a view of the focused view's document after it
+        void split();
+        // Closes the focused view, unless it is the last one
+        void unsplit();
+        // Prints the memory the focused view's document holds to stderr as JSON, see `DocumentSession::memoryUsage`
+        void printMemoryUsage() const;
+        [[nodiscard]] usize focusedView() const;
     };
 } // namespace teks::app
@@ -0,0 +1,240 @@
+#include "DocumentSession.hpp"
+#include <teks/assert.hpp>
+#include <teks/highlight/Languages.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+namespace {
+    // time slice for lexing off-screen lines, keeps the event loop responsive
+    constexpr std::chrono::milliseconds highlightBudget(4);
+}
+
+namespace teks::editor {
+    std::shared_ptr<DocumentSession> DocumentSession::open(std::filesystem::path path) {
+        auto document = Document::openFile(std::move(path));
+        if (!document.has_value()) {
+            return nullptr;
+        }
+        return std::make_shared<DocumentSession>(std::move(*document));
+    }
+
+    DocumentSession::DocumentSession(Document document)
+        : document_(std::move(document))
+        , generation_(document_.generation())
+        , idleTimer_(std::make_unique<QTimer>())
+        , changeTimer_(std::make_unique<QTimer>())
+        , fileWatcher_(std::make_unique<QFileSystemWatcher>())
+    {
+        const buffer::Buffer& buffer = document_.buffer();
+        for (usize line = 0; line < buffer.lineCount(); ++line) {
+            longestLineBytes_ = std::max(longestLineBytes_, buffer.lineRange(line).value().size().raw());
+        }
+
+        const auto lexer = highlight::lexerForExtension(document_.path().extension().string());
+        if (lexer != nullptr) {
+            highlightCache_ = std::make_unique<highlight::HighlightCache>(lexer, buffer.lineCount());
+        }
+
+        idleTimer_->setSingleShot(true);
+        idleTimer_->setInterval(0);
+        QObject::connect(idleTimer_.get(), &QTimer::timeout, idleTimer_.get(), [this]() { runIdleWork(); });
+        changeTimer_->setSingleShot(true);
+        changeTimer_->setInterval(0);
+        QObject::connect(changeTimer_.get(), &QTimer::timeout, changeTimer_.get(), [this]() { publishChanges(); });
+        QObject::connect(
+            fileWatcher_.get(),
+            &QFileSystemWatcher::fileChanged,
+            fileWatcher_.get(),
+            [this]() { fileChanged(); }
+        );
+
+        if (highlightCache_) {
+            idleTimer_->start();
+        }
+        watchFile();
+    }
+
+    DocumentSession::~DocumentSession() = default;
+
+    Document& DocumentSession::document() {
+        return document_;
+    }
+
+    const Document& DocumentSession::document() const {
+        return document_;
+    }
+
+    highlight::HighlightCache* DocumentSession::highlightCache() {
+        return highlightCache_.get();
+    }
+
+    u64 DocumentSession::longestLineBytes() const {
+        return longestLineBytes_;
+    }
+
+    MemoryUsage DocumentSession::memoryUsage() const {
+        MemoryUsage usage = document_.memoryUsage();
+        if (highlightCache_) {
+            const HeapBytes highlighting = highlightCache_->heapBytes();
+            usage.caches += highlighting.used;
+            usage.slack += highlighting.slack;
+        }
+        return usage;
+    }
+
+    void DocumentSession::shrinkToFit() {
+        document_.shrinkToFit();
+        if (highlightCache_) {
+            highlightCache_->shrinkToFit();
+        }
+    }
+
+    std::shared_ptr<WrapLayout> DocumentSession::wrapLayout(qreal width, const QFont& font) {
+        std::erase_if(wrapLayouts_, [](const std::weak_ptr<WrapLayout>& layout) { return layout.expired(); });
+        for (const std::weak_ptr<WrapLayout>& weak : wrapLayouts_) {
+            auto layout = weak.lock();
+            if (layout->width() == width && layout->font() == font) {
+                return layout;
+            }
+        }
+
+        auto layout = std::make_shared<WrapLayout>();
+        layout->reset(document_.buffer().lineCount());
+        (void)layout->setWidth(width, font);
+        wrapLayouts_.push_back(layout);
+        return layout;
+    }
+
+    bool DocumentSession::following() const {
+        return following_;
+    }
+
+    void DocumentSession::setFollowing(bool enabled) {
+        if (following_ == enabled) {
+            return;
+        }
+        following_ = enabled;
+        if (enabled) {
+            // catch up with what was written while not following
+            fileChanged();
+        }
+    }
+
+    usize DocumentSession::subscribe(Listener listener) {
+        listeners_.emplace_back(nextListenerId_, std::move(listener));
+        return nextListenerId_++;
+    }
+
+    void DocumentSession::unsubscribe(usize id) {
+        std::erase_if(listeners_, [id](const auto& listener) { return listener.first == id; });
+    }
+
+    u64 DocumentSession::generation() const {
+        return generation_;
+    }
+
+    bool DocumentSession::replace(buffer::Range range, std::string_view content) {
+        return edited(document_.replace(range, content));
+    }
+
+    bool DocumentSession::insertAtSelections(std::string_view text) {
+        return edited(document_.insertAtSelections(text));
+    }
+
+    bool DocumentSession::eraseBackward() {
+        return edited(document_.eraseBackward());
+    }
+
+    bool DocumentSession::eraseForward() {
+        return edited(document_.eraseForward());
+    }
+
+    bool DocumentSession::edited(bool success) {
+        if (success) {
+            changeTimer_->start();
+        }
+        return success;
+    }
+
+    void DocumentSession::watchFile() {
+        if (!fileWatcher_->files().isEmpty()) {
+            fileWatcher_->removePaths(fileWatcher_->files());
+        }
+        if (!document_.path().empty()) {
+            fileWatcher_->addPath(QString::fromStdString(document_.path().string()));
+        }
+    }
+
+    void DocumentSession::fileChanged() {
+        // writers that replace the file rather than write to it drop it from the watcher
+        if (fileWatcher_->files().isEmpty()) {
+            watchFile();
+        }
+
+        // unsaved edits are never replaced by what is on disk, the document is left conflicted
+        const bool wasConflicted = document_.conflicted();
+        if (document_.modified()) {
+            (void)document_.reload();
+        } else if (following_) {
+            // a followed file is assumed to only grow, anything else is diffed against the buffer
+            (void)document_.readAppended();
+        } else {
+            (void)document_.reload();
+        }
+        if (document_.conflicted() && !wasConflicted) {
+            std::fprintf(
+                stderr,
+                "%s changed on disk, the unsaved edits are kept and saving overwrites it\n",
+                document_.path().string().c_str()
+            );
+        }
+        publishChanges();
+    }
+
+    void DocumentSession::publishChanges() {
+        changeTimer_->stop();
+        for (const Document::Change& change : document_.takeChanges()) {
+            changed(change);
+        }
+    }
+
+    void DocumentSession::changed(const Document::Change& change) {
+        TEKS_ASSERT(change.generation > generation_);
+        generation_ = change.generation;
+        const Document::LinesReplaced& lines = change.lines;
+        const buffer::Buffer& buffer = document_.buffer();
+        if (lines.first == 0 && lines.inserted == buffer.lineCount()) {
+            // everything was replaced, the longest line may be gone
+            longestLineBytes_ = 0;
+        }
+        for (usize line = lines.first; line < lines.first + lines.inserted; ++line) {
+            longestLineBytes_ = std::max(longestLineBytes_, buffer.lineRange(line).value().size().raw());
+        }
+
+        for (const std::weak_ptr<WrapLayout>& weak : wrapLayouts_) {
+            if (auto layout = weak.lock()) {
+                layout->replaceLines(lines.first, lines.removed, lines.inserted);
+            }
+        }
+        if (highlightCache_) {
+            highlightCache_->replaceLines(lines.first, lines.removed, lines.inserted);
+            idleTimer_->start();
+        }
+
+        // a listener may unsubscribe while being told
+        const auto listeners = listeners_;
+        for (const auto& listener : listeners) {
+            listener.second(change);
+        }
+    }
+
+    void DocumentSession::runIdleWork() {
+        if (highlightCache_ && highlightCache_->lexSome(document_.buffer(), highlightBudget)) {
+            idleTimer_->start();
+        }
+    }
+} // namespace teks::editor
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "WrapLayout.hpp"
+#include <teks/editor/Document.hpp>
+#include <teks/highlight/HighlightCache.hpp>
+#include <teks/types.hpp>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <QFont>
+
+class QFileSystemWatcher;
+class QTimer;
+
+namespace teks::editor {
+    // A document open in one or more views, with what its views share: highlighting, the longest
+    // line, wrap layouts (one per width and font) and watching its file.
+    //
+    // Changes to the document go through the session. Once per event loop tick it takes the document's
+    // coalesced changes, updates the shared caches once per change, then tells each view, which only
+    // updates what is its own.
+    struct DocumentSession {
+        using Listener = std::function<void(const Document::Change&)>;
+
+        // Returns null when the file cannot be read
+        static std::shared_ptr<DocumentSession> open(std::filesystem::path path);
+
+        explicit DocumentSession(Document document);
+        DocumentSession(const DocumentSession&) = delete;
+        DocumentSession& operator=(const DocumentSession&) = delete;
+        ~DocumentSession();
+
+        [[nodiscard]] Document& document();
+        [[nodiscard]] const Document& document() const;
+
+        // null when there is no lexer for the document's file type
+        [[nodiscard]] highlight::HighlightCache* highlightCache();
+
+        [[nodiscard]] u64 longestLineBytes() const;
+
+        // The document's memory, with highlighting among its caches
+        [[nodiscard]] MemoryUsage memoryUsage() const;
+        void shrinkToFit();
+
+        // The layout of the whole document at `width` in `font`, shared by every view asking for both.
+        // It is kept up to date as the document changes for as long as a view holds it.
+        [[nodiscard]] std::shared_ptr<WrapLayout> wrapLayout(qreal width, const QFont& font);
+
+        // Following the file reads what is appended to it as it is written, like `tail -f`, other
+        // changes to it are diffed against the document
+        [[nodiscard]] bool following() const;
+        void setFollowing(bool enabled);
+
+        // `listener` is called after every change, once the shared caches are up to date.
+        // Returns an id for `unsubscribe`.
+        usize subscribe(Listener listener);
+        void unsubscribe(usize id);
+
+        // The document generation the shared caches and listeners are up to date with
+        [[nodiscard]] u64 generation() const;
+
+        // Like `Document::replace`, listeners are told at the end of the event loop tick
+        bool replace(buffer::Range range, std::string_view content);
+
+        // Like `Document::insertAtSelections`, `eraseBackward` and `eraseForward`: one change however
+        // many cursors there are, told like `replace`
+        bool insertAtSelections(std::string_view text);
+        bool eraseBackward();
+        bool eraseForward();
+
+        // Applies what changed in the file since it was last read, listeners are told right away. With
+        // unsaved edits nothing is applied and the document becomes `Document::conflicted`.
+        void fileChanged();
+
+        // Tells listeners about the edits made so far right away, rather than at the end of the tick
+        void publishChanges();
+
+    private:
+        Document document_;
+        std::unique_ptr<highlight::HighlightCache> highlightCache_;
+        u64 longestLineBytes_{0};
+        std::vector<std::weak_ptr<WrapLayout>> wrapLayouts_;
+        std::vector<std::pair<usize, Listener>> listeners_;
+        usize nextListenerId_{0};
+        u64 generation_{0};
+        bool following_{false};
+        // lexes beyond what views have asked for whenever the event loop is idle
+        std::unique_ptr<QTimer> idleTimer_;
+        // tells listeners about edits once the event loop tick making them is over
+        std::unique_ptr<QTimer> changeTimer_;
+        std::unique_ptr<QFileSystemWatcher> fileWatcher_;
+
+        // Schedules telling listeners when an edit succeeded, returns `success`
+        bool edited(bool success);
+        void watchFile();
+        void changed(const Document::Change& change);
+        void runIdleWork();
+    };
+} // namespace teks::editor
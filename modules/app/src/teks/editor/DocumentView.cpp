@@ -1,40 +1,394 @@
 #include "DocumentView.hpp"
-#include "Document.hpp"
+#include "DocumentSession.hpp"
+#include <teks/buffer/Utf8.hpp>
+#include <teks/metrics.hpp>
+#include <teks/trace.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <ostream>
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <QEvent>
+#include <QInputDialog>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QResizeEvent>
+#include <QScreen>
 #include <QScrollBar>
+#include <QTimer>
+
+namespace {
+    constexpr int textMargin = 12;
+    // lines longer than this are read, shaped and drawn only where they intersect the viewport
+    constexpr teks::u64 longLineBytes = 4096;
+    // bounds the memory held by advance indices of long lines that have scrolled out of view
+    constexpr teks::usize maxLineAdvanceIndices = 256;
+    // time slice for wrapping off-screen lines, keeps the event loop responsive
+    constexpr std::chrono::milliseconds rewrapBudget(4);
+    // space between the HUD and the viewport's corner, and around its text
+    constexpr int hudMargin = 8;
+    constexpr int hudPadding = 6;
+    // when the screen does not know its refresh rate
+    constexpr qreal defaultRefreshRate = 60.0;
+
+    // Removes the last codepoint of UTF-8 `text`
+    void popCodepoint(std::string& text) {
+        while (!text.empty() && (static_cast<unsigned char>(text.back()) & 0xc0) == 0x80) {
+            text.pop_back();
+        }
+        if (!text.empty()) {
+            text.pop_back();
+        }
+    }
+
+    QColor tokenColor(teks::highlight::TokenKind kind, const QColor& text) {
+        using teks::highlight::TokenKind;
+        switch (kind) {
+            case TokenKind::Keyword: return QColor(0x00, 0x33, 0xb3);
+            case TokenKind::Type: return QColor(0x00, 0x86, 0xb3);
+            case TokenKind::Number: return QColor(0x17, 0x50, 0xeb);
+            case TokenKind::String: return QColor(0x06, 0x7d, 0x17);
+            case TokenKind::Comment: return QColor(0x8c, 0x8c, 0x8c);
+            case TokenKind::Preprocessor: return QColor(0x9e, 0x88, 0x0d);
+            case TokenKind::Identifier:
+            case TokenKind::Punctuation:
+                break;
+        }
+        return text;
+    }
+
+    QColor invalidColor() {
+        return QColor(0xc0, 0x1c, 0x28);
+    }
+
+    // Text outside invalid runs was validated when it was loaded or inserted, so it is decoded
+    // without being validated again on every repaint
+    QString decodeValid(std::string_view text) {
+        QString result(static_cast<qsizetype>(text.size()), Qt::Uninitialized);
+        const teks::usize units = teks::buffer::decodeValidUtf8(text, reinterpret_cast<char16_t*>(result.data()));
+        result.resize(static_cast<qsizetype>(units));
+        return result;
+    }
+
+    // The invalid UTF-8 runs of `range`, relative to its start
+    std::vector<teks::buffer::Range> invalidRunsIn(const teks::buffer::Buffer& buffer, teks::buffer::Range range) {
+        std::vector<teks::buffer::Range> runs = buffer.invalidUtf8Runs(range).value_or(std::vector<teks::buffer::Range>());
+        for (teks::buffer::Range& run : runs) {
+            run = teks::buffer::Range::makeUnchecked(
+                teks::buffer::Offset(run.start() - range.start()),
+                teks::buffer::Offset(run.end() - range.start())
+            );
+        }
+        return runs;
+    }
+
+    // Draws `text`, which starts `textStart` bytes into its line, colouring the parts of it
+    // covered by `tokens`. Bytes in `invalid` (relative to `text`) are drawn as U+FFFD, one per byte.
+    // Only the segments that are drawn are converted and measured.
+    void drawTokenized(
+        QPainter& p,
+        const QFontMetricsF& metrics,
+        QPointF position,
+        std::string_view text,
+        teks::u64 textStart,
+        const std::vector<teks::highlight::Token>* tokens,
+        const std::vector<teks::buffer::Range>& invalid
+    ) {
+        const QColor plain = p.pen().color();
+        if ((tokens == nullptr || tokens->empty()) && invalid.empty()) {
+            p.drawText(position, decodeValid(text));
+            return;
+        }
+
+        teks::usize at = 0;
+        teks::usize run = 0;
+        const auto drawPiece = [&](teks::usize end, const QColor& color) {
+            while (run < invalid.size() && invalid[run].end().raw() <= at) {
+                ++run;
+            }
+            QString piece;
+            if (run < invalid.size() && invalid[run].start().raw() <= at) {
+                end = std::min<teks::usize>(end, invalid[run].end().raw());
+                piece = QString(static_cast<qsizetype>(end - at), QChar::ReplacementCharacter);
+                p.setPen(invalidColor());
+            } else {
+                if (run < invalid.size()) {
+                    end = std::min<teks::usize>(end, invalid[run].start().raw());
+                }
+                piece = decodeValid(text.substr(at, end - at));
+                p.setPen(color);
+            }
+            p.drawText(position, piece);
+            position.rx() += metrics.horizontalAdvance(piece);
+            at = end;
+        };
+        const auto drawSegment = [&](teks::u64 lineEnd, const QColor& color) {
+            const auto end = static_cast<teks::usize>(
+                std::clamp<teks::u64>(lineEnd, textStart, textStart + text.size()) - textStart
+            );
+            while (at < end) {
+                drawPiece(end, color);
+            }
+        };
+
+        if (tokens != nullptr) {
+            for (const teks::highlight::Token& token : *tokens) {
+                const teks::u64 tokenEnd = teks::u64{token.start} + token.length;
+                if (tokenEnd <= textStart) {
+                    continue;
+                }
+                if (token.start >= textStart + text.size()) {
+                    break;
+                }
+                drawSegment(token.start, plain);
+                drawSegment(tokenEnd, tokenColor(token.kind, plain));
+            }
+        }
+        drawSegment(textStart + text.size(), plain);
+        p.setPen(plain);
+    }
+}
 
 namespace teks::editor {
     DocumentView::DocumentView(QWidget* parent)
         : QAbstractScrollArea(parent)
+        , wrapLayout_(std::make_shared<WrapLayout>())
+        , idleTimer_(new QTimer(this))
+        , frameTimer_(new QTimer(this))
     {
         setFocusPolicy(Qt::StrongFocus);
-        setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+        setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
         setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
 
+        idleTimer_->setSingleShot(true);
+        idleTimer_->setInterval(0);
+        connect(idleTimer_, &QTimer::timeout, this, [this]() { runIdleWork(); });
+        frameTimer_->setSingleShot(true);
+        frameTimer_->setTimerType(Qt::PreciseTimer);
+        connect(frameTimer_, &QTimer::timeout, this, [this]() { runFrame(); });
+
         updateScrollbars();
+    }
+
+    DocumentView::~DocumentView() {
+        if (session_) {
+            session_->unsubscribe(sessionListener_);
+        }
+    }
 
-        // TODO(TB): Replace this development-only bootstrap with real document loading wiring.
-        const auto document = Document::openFile(std::filesystem::path(__FILE__));
-        if (document.has_value()) {
-            setDocument(std::make_shared<Document>(std::move(*document)));
+    bool DocumentView::openFile(const std::filesystem::path& path) {
+        auto session = DocumentSession::open(path);
+        if (!session) {
+            return false;
+        }
+        setSession(std::move(session));
+        return true;
+    }
+
+    const std::shared_ptr<DocumentSession>& DocumentView::session() const {
+        return session_;
+    }
+
+    void DocumentView::setSession(std::shared_ptr<DocumentSession> session) {
+        if (session_) {
+            session_->unsubscribe(sessionListener_);
+        }
+        session_ = std::move(session);
+        lineAdvanceIndices_.clear();
+        filter_.reset();
+        // typing was meant for the previous document, and the whole view is laid out and repainted below
+        pendingEdits_.clear();
+        pendingSince_.reset();
+        layoutPending_ = false;
+        keepAtBottomPending_ = false;
+        repaintPending_ = QRegion();
+        if (session_) {
+            sessionListener_ = session_->subscribe(
+                [this](const Document::Change& change) { changed(change); }
+            );
+        }
+
+        resetWrapLayout();
+        if (session_ && wordWrap_) {
+            idleTimer_->start();
+        }
+        verticalScrollBar()->setValue(0);
+        horizontalScrollBar()->setValue(0);
+        updateContentSize();
+        updateScrollbars();
+        viewport()->update();
+    }
+
+    bool DocumentView::wordWrap() const {
+        return wordWrap_;
+    }
+
+    void DocumentView::setWordWrap(bool enabled) {
+        if (wordWrap_ == enabled) {
+            return;
+        }
+        wordWrap_ = enabled;
+        setHorizontalScrollBarPolicy(enabled ? Qt::ScrollBarAlwaysOff : Qt::ScrollBarAsNeeded);
+        verticalScrollBar()->setValue(0);
+        horizontalScrollBar()->setValue(0);
+        if (enabled) {
+            updateWrapWidth();
+        }
+        updateContentSize();
+        updateScrollbars();
+        viewport()->update();
+    }
+
+    bool DocumentView::following() const {
+        return session_ && session_->following();
+    }
+
+    void DocumentView::setFollowing(bool enabled) {
+        if (!session_ || session_->following() == enabled) {
+            return;
+        }
+        // the session catches up with what was written while not following, this view starts at the end
+        session_->setFollowing(enabled);
+        if (enabled) {
+            verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        }
+    }
+
+    void DocumentView::setFilter(std::string pattern) {
+        if (!session_) {
+            return;
+        }
+        const usize top = filter_ ? (shownLineCount() > 0 ? sourceLine(topLine()) : 0) : topLine();
+        filter_.emplace(session_->document().buffer(), std::move(pattern));
+        filterChanged(top);
+    }
+
+    void DocumentView::clearFilter() {
+        if (!filter_) {
+            return;
+        }
+        const usize top = shownLineCount() > 0 ? sourceLine(topLine()) : 0;
+        filter_.reset();
+        filterChanged(top);
+    }
+
+    const buffer::LineFilter* DocumentView::filter() const {
+        return filter_ ? &*filter_ : nullptr;
+    }
+
+    bool DocumentView::hudVisible() const {
+        return hudVisible_;
+    }
+
+    void DocumentView::setHudVisible(bool visible) {
+        if (hudVisible_ == visible) {
+            return;
+        }
+        hudVisible_ = visible;
+        viewport()->update();
+    }
+
+    void DocumentView::setFrameLog(std::shared_ptr<std::ostream> log) {
+        frameLog_ = std::move(log);
+    }
+
+    void DocumentView::filterChanged(usize topSourceLine) {
+        resetWrapLayout();
+        updateContentSize();
+        updateScrollbars();
+        scrollToLine(filter_ ? filter_->lineAtOrAfter(topSourceLine) : topSourceLine);
+        if (wordWrap_) {
+            idleTimer_->start();
+        }
+        viewport()->update();
+    }
+
+    usize DocumentView::shownLineCount() const {
+        if (!session_) {
+            return 1;
+        }
+        return filter_ ? filter_->lineCount() : session_->document().buffer().lineCount();
+    }
+
+    usize DocumentView::sourceLine(usize line) const {
+        return filter_ ? filter_->sourceLine(line) : line;
+    }
+
+    usize DocumentView::topLine() const {
+        const u64 row = static_cast<u64>(verticalScrollBar()->value() / QFontMetrics(font()).height());
+        return wordWrap_ ? wrapLayout_->index().locate(row).line : static_cast<usize>(row);
+    }
+
+    void DocumentView::scrollToLine(usize line) {
+        const int lineHeight = QFontMetrics(font()).height();
+        if (wordWrap_) {
+            // rows above a stale line are estimates, wrap from it first so it settles quickly
+            line = std::min(line, wrapLayout_->index().lineCount() - 1);
+            wrapLayout_->prioritize(line);
+            verticalScrollBar()->setValue(static_cast<int>(wrapLayout_->index().firstRow(line)) * lineHeight);
+        } else {
+            verticalScrollBar()->setValue(static_cast<int>(line) * lineHeight);
         }
     }
 
     void DocumentView::paintEvent(QPaintEvent* event) {
-        Q_UNUSED(event);
+        TEKS_MEASURE_LATENCY(Paint);
+        TEKS_TRACE_SCOPE("DocumentView::paintEvent");
+        // a paint of only the HUD, showing the frame before it, is not a frame of its own
+        const bool hudRefresh = hudRefreshPending_ && event->region() == QRegion(hudRect());
+        hudRefreshPending_ = false;
+        if (!hudRefresh) {
+            frameStats_.beginFrame(FrameStats::Clock::now());
+        }
 
         QPainter p(viewport());
-        p.fillRect(viewport()->rect(), palette().base());
-        if (!document_) {
+        p.fillRect(event->rect(), palette().base());
+        if (session_) {
+            p.setPen(palette().text().color());
+            if (wordWrap_) {
+                paintWrapped(p);
+            } else {
+                paintUnwrapped(p, event->rect());
+            }
+        }
+        if (hudRefresh) {
+            paintHud(p);
             return;
         }
 
-        p.setPen(palette().text().color());
+        // the end of the paint stands in for the frame reaching the screen, which the view is not told of
+        const FrameStats::Frame& frame = frameStats_.endFrame(FrameStats::Clock::now());
+        if constexpr (metrics::enabled) {
+            if (frame.keyToPaint.has_value()) {
+                metrics::record(
+                    metrics::Operation::KeyToPaint,
+                    static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(*frame.keyToPaint).count())
+                );
+            }
+        }
+        if (frameLog_) {
+            *frameLog_ << FrameStats::toJson(frame) << std::endl;
+        }
+        if (hudVisible_) {
+            paintHud(p);
+            if (event->region().intersected(hudRect()) != QRegion(hudRect())) {
+                hudRefreshPending_ = true;
+                viewport()->update(hudRect());
+            }
+        }
+    }
+
+    void DocumentView::paintUnwrapped(QPainter& p, const QRect& dirty) {
         const QFontMetrics metrics = p.fontMetrics();
+        const QFontMetricsF metricsF(p.font());
         const int lineHeight = metrics.height();
         const int baseline = metrics.ascent();
 
@@ -42,44 +396,401 @@ namespace teks::editor {
         const usize firstVisibleLine = static_cast<usize>(scrollY / lineHeight);
         const int yOffsetWithinLine = scrollY % lineHeight;
 
+        const int scrollX = horizontalScrollBar()->value();
+        const int x = textMargin - scrollX;
+        // line-local x range that intersects the viewport
+        const qreal visibleLeft = static_cast<qreal>(scrollX - textMargin);
+        const qreal visibleRight = visibleLeft + static_cast<qreal>(viewport()->width());
+
         int y = baseline - yOffsetWithinLine;
-        const int x = 12;
+        const buffer::Buffer& buffer = session_->document().buffer();
 
         for (
-            usize line = firstVisibleLine;
-            line < document_->buffer().lineCount() && y < viewport()->height() + lineHeight;
-            ++line
+            usize shown = firstVisibleLine;
+            shown < shownLineCount() && y - baseline <= dirty.bottom();
+            ++shown
         ) {
-            const auto text = buffer::readLine(document_->buffer(), line);
-            if (text.has_value()) {
-                p.drawText(x, y, QString::fromStdString(*text));
+            // only lines in the region being repainted are read and drawn
+            if (y - baseline + lineHeight <= dirty.top()) {
+                y += lineHeight;
+                continue;
+            }
+            const usize line = sourceLine(shown);
+            const auto range = buffer.lineRange(line);
+            if (!range.has_value()) {
+                continue;
+            }
+
+            const auto* tokens = lineTokens(line);
+            frameStats_.lineDrawn();
+            if (range->size() <= buffer::Bytes(longLineBytes)) {
+                const auto text = buffer.readString(*range);
+                if (text.has_value()) {
+                    drawTokenized(p, metricsF, QPointF(x, y), *text, 0, tokens, invalidRunsIn(buffer, *range));
+                }
+            } else {
+                LineAdvanceIndex& index = lineAdvanceIndex(line, *range);
+                const auto window = index.window(buffer, metricsF, visibleLeft, visibleRight);
+                const auto text = buffer.readString(window.range);
+                if (text.has_value()) {
+                    drawTokenized(
+                        p,
+                        metricsF,
+                        QPointF(static_cast<qreal>(x) + window.x, y),
+                        *text,
+                        (window.range.start() - range->start()).raw(),
+                        tokens,
+                        invalidRunsIn(buffer, window.range)
+                    );
+                }
+
+                const auto width = index.width();
+                if (width.has_value()
+                    && textMargin * 2 + static_cast<int>(std::ceil(*width)) > std::max(contentWidth_, measuredContentWidth_)) {
+                    measuredContentWidth_ = textMargin * 2 + static_cast<int>(std::ceil(*width));
+                    layoutPending_ = true;
+                    scheduleFrame();
+                }
+            }
+            y += lineHeight;
+        }
+    }
+
+    void DocumentView::paintWrapped(QPainter& p) {
+        const QFontMetrics metrics = p.fontMetrics();
+        const QFontMetricsF metricsF(p.font());
+        const int lineHeight = metrics.height();
+        const int baseline = metrics.ascent();
+
+        const int scrollY = verticalScrollBar()->value();
+        const auto location = wrapLayout_->index().locate(static_cast<u64>(scrollY / lineHeight));
+        const int yOffsetWithinLine = scrollY % lineHeight;
+        const auto visibleRows = static_cast<u64>(viewport()->height() / lineHeight + 2);
+
+        int y = baseline - yOffsetWithinLine;
+        const buffer::Buffer& buffer = session_->document().buffer();
+
+        // visible lines are always wrapped before drawing, whatever the idle pass has reached
+        u64 drawnRows = 0;
+        u64 rowInLine = location.rowInLine;
+        for (usize shown = location.line; shown < shownLineCount() && drawnRows < visibleRows; ++shown) {
+            const usize line = sourceLine(shown);
+            const auto* tokens = lineTokens(line);
+            frameStats_.lineDrawn();
+            const buffer::Offset lineStart = buffer.lineRange(line).value().start();
+            for (const buffer::Range& row : wrapLayout_->wrap(buffer, shown, rowInLine, visibleRows - drawnRows)) {
+                const auto text = buffer.readString(row);
+                if (text.has_value()) {
+                    drawTokenized(
+                        p,
+                        metricsF,
+                        QPointF(textMargin, y),
+                        *text,
+                        (row.start() - lineStart).raw(),
+                        tokens,
+                        invalidRunsIn(buffer, row)
+                    );
+                }
                 y += lineHeight;
+                ++drawnRows;
             }
+            rowInLine = 0;
+        }
+
+        // wrapping the visible lines refined their rows, the scrollbars catch up in the next frame
+        if (static_cast<u64>(contentHeight_) != wrapLayout_->index().rowCount() * static_cast<u64>(lineHeight)) {
+            layoutPending_ = true;
+            scheduleFrame();
         }
     }
 
     void DocumentView::resizeEvent(QResizeEvent* event) {
         QAbstractScrollArea::resizeEvent(event);
+        if (wordWrap_) {
+            updateWrapWidth();
+        }
         updateScrollbars();
     }
 
+    void DocumentView::changeEvent(QEvent* event) {
+        QAbstractScrollArea::changeEvent(event);
+        if (event->type() == QEvent::FontChange) {
+            lineAdvanceIndices_.clear();
+            if (wordWrap_) {
+                updateWrapWidth();
+            }
+            updateContentSize();
+            updateScrollbars();
+        }
+    }
+
+    void DocumentView::keyPressEvent(QKeyEvent* event) {
+        const FrameStats::Clock::time_point received = FrameStats::Clock::now();
+        if (event->key() == Qt::Key_Z && event->modifiers() == Qt::AltModifier) {
+            setWordWrap(!wordWrap_);
+            return;
+        }
+        if (event->key() == Qt::Key_F && event->modifiers() == Qt::AltModifier) {
+            setFollowing(!following());
+            return;
+        }
+        if (event->key() == Qt::Key_G && event->modifiers() == Qt::AltModifier) {
+            bool accepted = false;
+            const QString pattern = QInputDialog::getText(
+                this,
+                QString("Filter Lines"),
+                QString("Show lines containing:"),
+                QLineEdit::Normal,
+                filter_ ? QString::fromStdString(filter_->pattern()) : QString(),
+                &accepted
+            );
+            if (accepted && pattern.isEmpty()) {
+                clearFilter();
+            } else if (accepted) {
+                setFilter(pattern.toStdString());
+            }
+            return;
+        }
+        if (event->key() == Qt::Key_H && event->modifiers() == Qt::AltModifier) {
+            setHudVisible(!hudVisible_);
+            return;
+        }
+        if (editKey(event, received)) {
+            return;
+        }
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+
+    bool DocumentView::editKey(QKeyEvent* event, FrameStats::Clock::time_point received) {
+        if (!session_ || (event->modifiers() & (Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier))) {
+            return false;
+        }
+        switch (event->key()) {
+            case Qt::Key_Backspace:
+                queueEdit(PendingEdit::Kind::EraseBackward);
+                break;
+            case Qt::Key_Delete:
+                queueEdit(PendingEdit::Kind::EraseForward);
+                break;
+            case Qt::Key_Return:
+            case Qt::Key_Enter:
+                queueEdit(PendingEdit::Kind::Insert, "\n");
+                break;
+            case Qt::Key_Tab:
+                queueEdit(PendingEdit::Kind::Insert, "\t");
+                break;
+            default: {
+                const QString text = event->text();
+                if (text.isEmpty() || !text.front().isPrint()) {
+                    return false;
+                }
+                queueEdit(PendingEdit::Kind::Insert, text.toStdString());
+                break;
+            }
+        }
+        if (!pendingSince_.has_value()) {
+            pendingSince_ = received;
+        }
+        scheduleFrame();
+        return true;
+    }
+
+    void DocumentView::queueEdit(PendingEdit::Kind kind, std::string_view text) {
+        using Kind = PendingEdit::Kind;
+        PendingEdit* last = pendingEdits_.empty() ? nullptr : &pendingEdits_.back();
+        if (last != nullptr && kind == Kind::EraseBackward && last->kind == Kind::Insert && !last->text.empty()) {
+            // erasing what was typed before it was applied, which is what erasing it after would do.
+            // Inserting nothing is kept, it still replaces the selections.
+            popCodepoint(last->text);
+            return;
+        }
+        if (last != nullptr && last->kind == kind) {
+            last->text += text;
+            ++last->count;
+            return;
+        }
+        pendingEdits_.push_back(PendingEdit{kind, std::string(text), 1});
+    }
+
+    void DocumentView::scheduleFrame() {
+        if (frameTimer_->isActive()) {
+            return;
+        }
+        // right away after an idle spell, otherwise once the display has refreshed since the last frame
+        const FrameStats::Clock::duration sinceLast = FrameStats::Clock::now() - lastFrame_;
+        const FrameStats::Clock::duration wait = std::max(frameInterval() - sinceLast, FrameStats::Clock::duration::zero());
+        frameTimer_->start(std::chrono::ceil<std::chrono::milliseconds>(wait));
+    }
+
+    FrameStats::Clock::duration DocumentView::frameInterval() const {
+        const QScreen* shownOn = screen();
+        const qreal rate = shownOn != nullptr && shownOn->refreshRate() > 0 ? shownOn->refreshRate() : defaultRefreshRate;
+        return std::chrono::duration_cast<FrameStats::Clock::duration>(std::chrono::duration<qreal>(1.0 / rate));
+    }
+
+    void DocumentView::runFrame() {
+        TEKS_TRACE_SCOPE("DocumentView::runFrame");
+        lastFrame_ = FrameStats::Clock::now();
+        applyPendingEdits();
+        layOut();
+        if (!repaintPending_.isEmpty()) {
+            viewport()->update(repaintPending_);
+            repaintPending_ = QRegion();
+        }
+        // the changes published by the edits above, which scheduled another frame, are done
+        frameTimer_->stop();
+    }
+
+    void DocumentView::applyPendingEdits() {
+        const std::optional<FrameStats::Clock::time_point> received = pendingSince_;
+        pendingSince_.reset();
+        if (pendingEdits_.empty() || !session_) {
+            return;
+        }
+        const u64 generation = session_->document().generation();
+        for (const PendingEdit& edit : pendingEdits_) {
+            switch (edit.kind) {
+                case PendingEdit::Kind::Insert:
+                    session_->insertAtSelections(edit.text);
+                    break;
+                case PendingEdit::Kind::EraseBackward:
+                    // each erase touches the one before it, the document coalesces them into one change
+                    for (usize i = 0; i < edit.count; ++i) {
+                        session_->eraseBackward();
+                    }
+                    break;
+                case PendingEdit::Kind::EraseForward:
+                    for (usize i = 0; i < edit.count; ++i) {
+                        session_->eraseForward();
+                    }
+                    break;
+            }
+        }
+        pendingEdits_.clear();
+        if (session_->document().generation() != generation) {
+            frameStats_.keyEdited(*received);
+        }
+        // this view and every other view of the document take the change in this frame, not the next tick
+        session_->publishChanges();
+    }
+
+    void DocumentView::layOut() {
+        if (!layoutPending_) {
+            return;
+        }
+        layoutPending_ = false;
+        updateContentSize();
+        if (!wordWrap_) {
+            contentWidth_ = std::max(contentWidth_, measuredContentWidth_);
+        }
+        measuredContentWidth_ = 0;
+        updateScrollbars();
+        if (keepAtBottomPending_) {
+            verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        }
+        keepAtBottomPending_ = false;
+    }
+
+    void DocumentView::mouseDoubleClickEvent(QMouseEvent* event) {
+        if (!filter_) {
+            QAbstractScrollArea::mouseDoubleClickEvent(event);
+            return;
+        }
+        const int lineHeight = QFontMetrics(font()).height();
+        const auto row = static_cast<u64>((verticalScrollBar()->value() + event->position().toPoint().y()) / lineHeight);
+        const usize shown = wordWrap_ ? wrapLayout_->index().locate(row).line : static_cast<usize>(row);
+        if (shown >= shownLineCount()) {
+            return;
+        }
+        const usize line = filter_->sourceLine(shown);
+        filter_.reset();
+        filterChanged(line);
+    }
+
     void DocumentView::scrollContentsBy(int dx, int dy) {
         Q_UNUSED(dx);
         Q_UNUSED(dy);
         viewport()->update();
     }
 
-    void DocumentView::setDocument(std::shared_ptr<Document> document) {
-        document_ = std::move(document);
+    void DocumentView::changed(const Document::Change& change) {
+        frameStats_.changed();
+        // the session has already updated highlighting, the longest line and the layouts it shares
+        const Document::LinesReplaced& lines = change.lines;
+        // the scrollbars are those of the last frame, so at the bottom of what was shown then
+        keepAtBottomPending_ = keepAtBottomPending_ || (session_->following() && atBottom());
+        Document::LinesReplaced shown = lines;
+        if (filter_) {
+            const auto filtered = filter_->replaceLines(
+                session_->document().buffer(),
+                lines.first,
+                lines.removed,
+                lines.inserted
+            );
+            shown = Document::LinesReplaced{filtered.first, filtered.removed, filtered.inserted};
+            wrapLayout_->replaceLines(shown.first, shown.removed, shown.inserted);
+            if (wrapLayout_->index().lineCount() != std::max<usize>(1, filter_->lineCount())) {
+                // the layout keeps an empty line when nothing matches, which does not survive matches appearing
+                wrapLayout_->reset(std::max<usize>(1, filter_->lineCount()));
+            }
+        }
+        if (wordWrap_) {
+            idleTimer_->start();
+        }
+
+        // advance indices check the line's range when used, so they need no updating
+        layoutPending_ = true;
+        repaintReplaced(shown.first, shown.removed, shown.inserted);
+        scheduleFrame();
+    }
 
+    void DocumentView::repaintReplaced(usize first, usize removed, usize inserted) {
+        const int lineHeight = QFontMetrics(font()).height();
+        const usize top = topLine();
+        const auto visibleLines = static_cast<usize>(viewport()->height() / lineHeight + 2);
+        if (first >= top + visibleLines) {
+            // below the viewport, only the scrollbar changed
+            return;
+        }
+        if (!wordWrap_ && removed == inserted && first + removed <= top) {
+            // above the viewport without moving the lines below
+            return;
+        }
+        if (wordWrap_ || first < top) {
+            // rows of wrapped lines, or lines above the viewport, move everything below them
+            repaintPending_ = QRegion(viewport()->rect());
+            return;
+        }
+        const int y = static_cast<int>(first - top) * lineHeight - verticalScrollBar()->value() % lineHeight;
+        const int height = removed == inserted ? static_cast<int>(inserted) * lineHeight : viewport()->height() - y;
+        repaintPending_ += QRect(0, y, viewport()->width(), height);
+    }
+
+    bool DocumentView::atBottom() const {
+        return verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+    }
+
+    void DocumentView::updateContentSize() {
         const QFontMetrics metrics(font());
         const int lineHeight = metrics.height();
 
-        const usize lineCount = document_ ? document_->buffer().lineCount() : 1;
-        contentHeight_ = static_cast<int>(lineCount) * lineHeight;
+        if (wordWrap_) {
+            // rows of lines that have not been wrapped yet are estimated, refined by the idle rewrap
+            contentHeight_ = static_cast<int>(wrapLayout_->index().rowCount()) * lineHeight;
+            contentWidth_ = 0;
+            return;
+        }
+
+        contentHeight_ = static_cast<int>(shownLineCount()) * lineHeight;
 
-        updateScrollbars();
-        viewport()->update();
+        // Estimated from the longest line in bytes so nothing has to be shaped up front,
+        // widened by `layOut` once `paintUnwrapped` has measured a long line to its end.
+        const u64 longestLineBytes = session_ ? session_->longestLineBytes() : 0;
+        const qreal estimatedWidth = static_cast<qreal>(longestLineBytes) * QFontMetricsF(font()).averageCharWidth();
+        contentWidth_ = textMargin * 2 + static_cast<int>(std::min<qreal>(
+            std::ceil(estimatedWidth),
+            static_cast<qreal>(std::numeric_limits<int>::max() - textMargin * 2)
+        ));
     }
 
     void DocumentView::updateScrollbars() {
@@ -91,5 +802,140 @@ namespace teks::editor {
         );
         verticalScrollBar()->setPageStep(page);
         verticalScrollBar()->setSingleStep(24);
+
+        const int pageWidth = viewport()->width();
+        const int maxX = std::max(0, contentWidth_ - pageWidth);
+        horizontalScrollBar()->setRange(0, maxX);
+        horizontalScrollBar()->setValue(
+            std::min(horizontalScrollBar()->value(), horizontalScrollBar()->maximum())
+        );
+        horizontalScrollBar()->setPageStep(pageWidth);
+        horizontalScrollBar()->setSingleStep(24);
+    }
+
+    void DocumentView::resetWrapLayout() {
+        // Views of the whole document share the session's layout for their width and font, a filtered
+        // view has one of its own as its lines are not the document's
+        if (session_ && !filter_) {
+            wrapLayout_ = session_->wrapLayout(wrapWidth(), font());
+            return;
+        }
+        wrapLayout_ = std::make_shared<WrapLayout>();
+        wrapLayout_->setFilter(filter());
+        wrapLayout_->reset(std::max<usize>(1, shownLineCount()));
+        (void)wrapLayout_->setWidth(wrapWidth(), font());
+    }
+
+    qreal DocumentView::wrapWidth() const {
+        return static_cast<qreal>(std::max(1, viewport()->width() - textMargin * 2));
+    }
+
+    void DocumentView::updateWrapWidth() {
+        if (session_ && !filter_) {
+            auto layout = session_->wrapLayout(wrapWidth(), font());
+            if (layout == wrapLayout_) {
+                return;
+            }
+            wrapLayout_ = std::move(layout);
+        } else if (!wrapLayout_->setWidth(wrapWidth(), font())) {
+            return;
+        }
+
+        const int lineHeight = QFontMetrics(font()).height();
+        const auto top = wrapLayout_->index().locate(static_cast<u64>(verticalScrollBar()->value() / lineHeight));
+        wrapLayout_->prioritize(top.line);
+        idleTimer_->start();
+    }
+
+    void DocumentView::runIdleWork() {
+        // highlighting beyond the viewport is the session's idle work, shared by its views
+        if (session_ && wordWrap_ && rewrapSome()) {
+            idleTimer_->start();
+        }
+    }
+
+    bool DocumentView::rewrapSome() {
+        // keep the top visible line in place while rows above it change height
+        const int lineHeight = QFontMetrics(font()).height();
+        const int scrollY = verticalScrollBar()->value();
+        const auto top = wrapLayout_->index().locate(static_cast<u64>(scrollY / lineHeight));
+        const bool keepAtBottom = following() && atBottom();
+
+        const bool more = wrapLayout_->rewrapSome(session_->document().buffer(), rewrapBudget);
+
+        updateContentSize();
+        updateScrollbars();
+        if (keepAtBottom) {
+            verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+            return more;
+        }
+        const u64 topRow = wrapLayout_->index().firstRow(top.line)
+            + std::min(top.rowInLine, wrapLayout_->index().rows(top.line) - 1);
+        verticalScrollBar()->setValue(static_cast<int>(topRow) * lineHeight + scrollY % lineHeight);
+        return more;
+    }
+
+    const std::vector<highlight::Token>* DocumentView::lineTokens(usize line) {
+        highlight::HighlightCache* cache = session_->highlightCache();
+        if (cache == nullptr) {
+            return nullptr;
+        }
+        frameStats_.tokenLookup(line < cache->validLines());
+        return &cache->tokens(session_->document().buffer(), line);
+    }
+
+    LineAdvanceIndex& DocumentView::lineAdvanceIndex(usize line, buffer::Range range) {
+        auto found = lineAdvanceIndices_.find(line);
+        if (found != lineAdvanceIndices_.end() && found->second.line() == range) {
+            frameStats_.advanceLookup(true);
+            return found->second;
+        }
+        frameStats_.advanceLookup(false);
+
+        if (found != lineAdvanceIndices_.end()) {
+            lineAdvanceIndices_.erase(found);
+        } else if (lineAdvanceIndices_.size() >= maxLineAdvanceIndices) {
+            lineAdvanceIndices_.clear();
+        }
+        return lineAdvanceIndices_.emplace(line, LineAdvanceIndex(range)).first->second;
+    }
+
+    QRect DocumentView::hudRect() const {
+        const QFontMetrics metrics(font());
+        // wide enough for the longest line at any plausible numbers, so the HUD does not resize as they change
+        const int width = metrics.horizontalAdvance(QString("key to paint 0000.0 ms, worst 0000.0 ms")) + hudPadding * 2;
+        const int height = metrics.height() * 3 + hudPadding * 2;
+        return QRect(viewport()->width() - width - hudMargin, hudMargin, width, height);
+    }
+
+    void DocumentView::paintHud(QPainter& p) {
+        const auto milliseconds = [](std::optional<FrameStats::Clock::duration> duration) {
+            if (!duration.has_value()) {
+                return QString("-");
+            }
+            return QString::number(std::chrono::duration<double, std::milli>(*duration).count(), 'f', 1) + " ms";
+        };
+        const auto hitRate = [](u64 hits, u64 lookups) {
+            return lookups == 0 ? QString("-") : QString::number(hits * 100 / lookups) + "%";
+        };
+        const FrameStats::Frame& frame = frameStats_.last();
+        const QString lines[] = {
+            QString("frame %1, paint %2").arg(milliseconds(frame.interval), milliseconds(frame.paint)),
+            QString("%1 lines, tokens %2, advances %3")
+                .arg(frame.linesDrawn)
+                .arg(hitRate(frame.tokenHits, frame.tokenLookups), hitRate(frame.advanceHits, frame.advanceLookups)),
+            QString("key to paint %1, worst %2")
+                .arg(milliseconds(frameStats_.lastKeyToPaint()), milliseconds(frameStats_.worstRecentKeyToPaint())),
+        };
+
+        const QRect rect = hudRect();
+        const QFontMetrics metrics(font());
+        p.fillRect(rect, QColor(0, 0, 0, 180));
+        p.setPen(Qt::white);
+        int y = rect.top() + hudPadding + metrics.ascent();
+        for (const QString& line : lines) {
+            p.drawText(rect.left() + hudPadding, y, line);
+            y += metrics.height();
+        }
     }
 } // namespace teks::editor
@@ -1,22 +1,159 @@
 #pragma once
 
+#include "FrameStats.hpp"
+#include "LineAdvanceIndex.hpp"
+#include "WrapLayout.hpp"
+#include <teks/buffer/LineFilter.hpp>
+#include <teks/buffer/types.hpp>
+#include <teks/editor/Document.hpp>
+#include <teks/highlight/Token.hpp>
+#include <teks/types.hpp>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <QAbstractScrollArea>
+#include <QRegion>
+
+class QKeyEvent;
+class QPainter;
+class QRect;
+class QTimer;
 
 namespace teks::editor {
-    struct Document;
+    struct DocumentSession;
 
+    // A view of a document. Several views can show the same document, each with its own scrolling,
+    // wrapping and filter, sharing the caches of the document's `DocumentSession`.
+    //
+    // Work is done at most once per display frame: typing received since the last frame is applied
+    // as one edit per run of the same key kind, and the content size, scrollbars and repaints of the
+    // changes since are worked out once, so keys repeating faster than the display refreshes do not
+    // each cost an edit, a layout and a paint.
     struct DocumentView final : public QAbstractScrollArea {
         DocumentView(QWidget* parent = nullptr);
+        ~DocumentView() override;
+
+        // Returns whether the file could be read, the previous document is kept otherwise
+        bool openFile(const std::filesystem::path& path);
+
+        [[nodiscard]] const std::shared_ptr<DocumentSession>& session() const;
+        // Shows the document of `session`, alongside any other view of it
+        void setSession(std::shared_ptr<DocumentSession> session);
+
+        [[nodiscard]] bool wordWrap() const;
+        void setWordWrap(bool enabled);
+
+        // Following a file shows what is appended to it as it is written, like `tail -f`, in every view
+        // of it. Each view keeps scrolling to the end as long as it was at the end.
+        [[nodiscard]] bool following() const;
+        void setFollowing(bool enabled);
+
+        // Shows only the lines containing `pattern`, like grep. Lines are not copied, the view maps its
+        // lines to the document's through a `buffer::LineFilter` that follows the document as it changes.
+        // Double clicking a line, like clearing the filter, shows that line in the whole document.
+        void setFilter(std::string pattern);
+        void clearFilter();
+        // null when every line is shown
+        [[nodiscard]] const buffer::LineFilter* filter() const;
+
+        // The HUD shows over the text what the last frame took, and how long the last key took to be
+        // painted, see `FrameStats`
+        [[nodiscard]] bool hudVisible() const;
+        void setHudVisible(bool visible);
+        // Every frame is written to `log` as a line of JSON, with or without the HUD. Null stops logging.
+        void setFrameLog(std::shared_ptr<std::ostream> log);
 
     private:
+        // Typing not yet applied to the document. Runs of the same kind are merged, and erasing
+        // backward what is still pending only shortens it.
+        struct PendingEdit {
+            enum class Kind {
+                Insert,
+                EraseBackward,
+                EraseForward,
+            };
+
+            Kind kind;
+            // what `Insert` inserts
+            std::string text;
+            // how many codepoints `EraseBackward` or `EraseForward` erase
+            usize count{0};
+        };
+
         int contentHeight_{0};
-        std::shared_ptr<Document> document_;
+        int contentWidth_{0};
+        bool wordWrap_{false};
+        // shared with the other views of the document at the same width and font, unless filtered
+        std::shared_ptr<WrapLayout> wrapLayout_;
+        // drives layout work beyond the viewport whenever the event loop is idle
+        QTimer* idleTimer_;
+        // runs the next frame's work, no sooner than a display refresh after the last
+        QTimer* frameTimer_;
+        FrameStats::Clock::time_point lastFrame_;
+        std::vector<PendingEdit> pendingEdits_;
+        // when the earliest pending key was received
+        std::optional<FrameStats::Clock::time_point> pendingSince_;
+        // the content size and scrollbars are out of date with the document, or with what a paint found
+        bool layoutPending_{false};
+        // the widest long line a paint has measured, applied by the next layout rather than mid-paint
+        int measuredContentWidth_{0};
+        // following at the bottom when a change came in, the next layout scrolls to the new bottom
+        bool keepAtBottomPending_{false};
+        QRegion repaintPending_;
+        std::shared_ptr<DocumentSession> session_;
+        usize sessionListener_{0};
+        std::optional<buffer::LineFilter> filter_;
+        // keyed by line index, only populated for lines too long to draw whole
+        std::unordered_map<usize, LineAdvanceIndex> lineAdvanceIndices_;
+        FrameStats frameStats_;
+        bool hudVisible_{false};
+        // the HUD was outside the last frame's paint, it is repainted on its own to show that frame
+        bool hudRefreshPending_{false};
+        std::shared_ptr<std::ostream> frameLog_;
 
         void paintEvent(QPaintEvent* event) override;
+        void paintUnwrapped(QPainter& p, const QRect& dirty);
+        void paintWrapped(QPainter& p);
         void resizeEvent(QResizeEvent* event) override;
+        void changeEvent(QEvent* event) override;
+        void keyPressEvent(QKeyEvent* event) override;
+        // Queues the edit of `event` for the next frame if it is typing, returns whether it was
+        bool editKey(QKeyEvent* event, FrameStats::Clock::time_point received);
+        void queueEdit(PendingEdit::Kind kind, std::string_view text = {});
+        void scheduleFrame();
+        [[nodiscard]] FrameStats::Clock::duration frameInterval() const;
+        // Applies pending typing, then lays out and repaints what changed since the last frame
+        void runFrame();
+        void applyPendingEdits();
+        void layOut();
+        void mouseDoubleClickEvent(QMouseEvent* event) override;
         void scrollContentsBy(int dx, int dy) override;
-        void setDocument(std::shared_ptr<Document> document);
+        void filterChanged(usize topSourceLine);
+        [[nodiscard]] usize shownLineCount() const;
+        // the document line shown as `line`
+        [[nodiscard]] usize sourceLine(usize line) const;
+        [[nodiscard]] usize topLine() const;
+        void scrollToLine(usize line);
+        void updateContentSize();
         void updateScrollbars();
+        void resetWrapLayout();
+        [[nodiscard]] qreal wrapWidth() const;
+        void updateWrapWidth();
+        void changed(const Document::Change& change);
+        // Queues repainting lines `[first, first + removed)` after they were replaced with `inserted`
+        // lines, and the lines after them if they moved
+        void repaintReplaced(usize first, usize removed, usize inserted);
+        [[nodiscard]] bool atBottom() const;
+        void runIdleWork();
+        bool rewrapSome();
+        const std::vector<highlight::Token>* lineTokens(usize line);
+        LineAdvanceIndex& lineAdvanceIndex(usize line, buffer::Range range);
+        [[nodiscard]] QRect hudRect() const;
+        void paintHud(QPainter& p);
     };
 } // namespace teks::editor
@@ -0,0 +1,89 @@
+#include "FrameStats.hpp"
+
+namespace {
+    // microseconds with one decimal
+    std::string microseconds(std::chrono::steady_clock::duration duration) {
+        const auto tenths = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 100;
+        return std::to_string(tenths / 10) + "." + std::to_string(tenths % 10);
+    }
+}
+
+namespace teks::editor {
+    void FrameStats::keyEdited(Clock::time_point at) {
+        if (!keyPending_.has_value()) {
+            keyPending_ = at;
+        }
+    }
+
+    void FrameStats::changed() {
+        if (keyPending_.has_value() && !keyChanged_.has_value()) {
+            keyChanged_ = keyPending_;
+        }
+        keyPending_.reset();
+    }
+
+    void FrameStats::beginFrame(Clock::time_point at) {
+        frameStart_ = at;
+        frame_ = Frame{};
+    }
+
+    void FrameStats::lineDrawn() {
+        ++frame_.linesDrawn;
+    }
+
+    void FrameStats::tokenLookup(bool hit) {
+        ++frame_.tokenLookups;
+        frame_.tokenHits += hit ? 1 : 0;
+    }
+
+    void FrameStats::advanceLookup(bool hit) {
+        ++frame_.advanceLookups;
+        frame_.advanceHits += hit ? 1 : 0;
+    }
+
+    const FrameStats::Frame& FrameStats::endFrame(Clock::time_point at) {
+        frame_.paint = at - frameStart_;
+        frame_.interval = lastFrameEnd_.has_value() ? at - *lastFrameEnd_ : Clock::duration::zero();
+        if (keyChanged_.has_value()) {
+            frame_.keyToPaint = at - *keyChanged_;
+            lastKeyToPaint_ = frame_.keyToPaint;
+            keyChanged_.reset();
+        }
+        lastFrameEnd_ = at;
+        recentKeyToPaint_[framesPainted_ % recentFrames] = frame_.keyToPaint;
+        ++framesPainted_;
+        last_ = frame_;
+        return last_;
+    }
+
+    const FrameStats::Frame& FrameStats::last() const {
+        return last_;
+    }
+
+    std::optional<FrameStats::Clock::duration> FrameStats::lastKeyToPaint() const {
+        return lastKeyToPaint_;
+    }
+
+    std::optional<FrameStats::Clock::duration> FrameStats::worstRecentKeyToPaint() const {
+        std::optional<Clock::duration> worst;
+        for (const std::optional<Clock::duration>& latency : recentKeyToPaint_) {
+            if (latency.has_value() && (!worst.has_value() || *latency > *worst)) {
+                worst = latency;
+            }
+        }
+        return worst;
+    }
+
+    std::string FrameStats::toJson(const Frame& frame) {
+        std::string json = "{\"intervalUs\":" + microseconds(frame.interval);
+        json += ",\"paintUs\":" + microseconds(frame.paint);
+        json += ",\"linesDrawn\":" + std::to_string(frame.linesDrawn);
+        json += ",\"tokenLookups\":" + std::to_string(frame.tokenLookups);
+        json += ",\"tokenHits\":" + std::to_string(frame.tokenHits);
+        json += ",\"advanceLookups\":" + std::to_string(frame.advanceLookups);
+        json += ",\"advanceHits\":" + std::to_string(frame.advanceHits);
+        json += ",\"keyToPaintUs\":" + (frame.keyToPaint.has_value() ? microseconds(*frame.keyToPaint) : std::string("null"));
+        json += '}';
+        return json;
+    }
+} // namespace teks::editor
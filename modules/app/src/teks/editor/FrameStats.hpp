@@ -0,0 +1,67 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace teks::editor {
+    // What a view's frames took, for its HUD and its frame log: paint time, lines drawn, how often the
+    // highlight and advance caches had what was drawn, and how long after a key its edit was painted.
+    //
+    // A key's latency runs from the view receiving it to the end of the first frame painted after its
+    // change reached the view, the frame that shows it. Keys whose changes reach the view together are
+    // painted by the same frame, the latency is that of the earliest.
+    struct FrameStats {
+        using Clock = std::chrono::steady_clock;
+
+        // How many of the last frames the worst key latency is kept over
+        static constexpr usize recentFrames = 64;
+
+        struct Frame {
+            // since the end of the previous frame, zero for the first
+            Clock::duration interval{};
+            Clock::duration paint{};
+            usize linesDrawn{0};
+            u64 tokenLookups{0};
+            u64 tokenHits{0};
+            u64 advanceLookups{0};
+            u64 advanceHits{0};
+            std::optional<Clock::duration> keyToPaint;
+        };
+
+        // A key received at `at` edited the document
+        void keyEdited(Clock::time_point at);
+        // The view was told about the document's change, the next frame shows every key edited before
+        void changed();
+
+        void beginFrame(Clock::time_point at);
+        void lineDrawn();
+        void tokenLookup(bool hit);
+        void advanceLookup(bool hit);
+        const Frame& endFrame(Clock::time_point at);
+
+        // The last frame painted, empty before the first
+        [[nodiscard]] const Frame& last() const;
+        // The latency of the last key painted, and the worst over the last `recentFrames` frames
+        [[nodiscard]] std::optional<Clock::duration> lastKeyToPaint() const;
+        [[nodiscard]] std::optional<Clock::duration> worstRecentKeyToPaint() const;
+
+        // `frame` as one line of JSON, durations in microseconds
+        [[nodiscard]] static std::string toJson(const Frame& frame);
+
+    private:
+        // the earliest key edited whose change has not reached the view yet
+        std::optional<Clock::time_point> keyPending_;
+        // the earliest key whose change has reached the view but not been painted
+        std::optional<Clock::time_point> keyChanged_;
+        std::optional<Clock::time_point> lastFrameEnd_;
+        Clock::time_point frameStart_;
+        Frame frame_;
+        Frame last_;
+        std::optional<Clock::duration> lastKeyToPaint_;
+        std::array<std::optional<Clock::duration>, recentFrames> recentKeyToPaint_{};
+        usize framesPainted_{0};
+    };
+} // namespace teks::editor
@@ -0,0 +1,255 @@
+#include "HugeFileView.hpp"
+#include <teks/trace.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QSignalBlocker>
+#include <QTimer>
+#include <QWheelEvent>
+
+namespace {
+    constexpr int textMargin = 12;
+    // positions of the vertical scrollbar while it is in bytes
+    constexpr int approximateSteps = 1 << 20;
+    // indexed per turn of the event loop, a few milliseconds of scanning
+    constexpr teks::u64 indexSliceBytes = 16 << 20;
+    constexpr int wheelLines = 3;
+}
+
+namespace teks::editor {
+    HugeFileView::HugeFileView(QWidget* parent)
+        : QAbstractScrollArea(parent)
+        , indexTimer_(new QTimer(this))
+    {
+        setFocusPolicy(Qt::StrongFocus);
+        setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+        setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+        indexTimer_->setSingleShot(true);
+        indexTimer_->setInterval(0);
+        connect(indexTimer_, &QTimer::timeout, this, [this]() { indexSome(); });
+
+        updateScrollbars();
+    }
+
+    bool HugeFileView::openFile(const std::filesystem::path& path) {
+        std::optional<MappedFile> file = MappedFile::open(path);
+        if (!file.has_value()) {
+            return false;
+        }
+        file_ = std::move(file);
+        path_ = path;
+        lineIndex_ = buffer::SparseLineIndex();
+        top_ = buffer::Offset(0);
+        contentWidth_ = 0;
+        horizontalScrollBar()->setValue(0);
+        indexTimer_->start();
+        updateScrollbars();
+        viewport()->update();
+        return true;
+    }
+
+    std::string_view HugeFileView::text() const {
+        return file_.has_value() ? file_->bytes() : std::string_view();
+    }
+
+    bool HugeFileView::scrollsByLine() const {
+        const auto lineCount = lineIndex_.lineCount(text());
+        return lineCount.has_value() && *lineCount <= static_cast<usize>(std::numeric_limits<int>::max());
+    }
+
+    int HugeFileView::visibleLines() const {
+        return std::max(1, viewport()->height() / QFontMetrics(font()).height());
+    }
+
+    void HugeFileView::paintEvent(QPaintEvent* event) {
+        Q_UNUSED(event);
+        TEKS_TRACE_SCOPE("HugeFileView::paintEvent");
+
+        QPainter p(viewport());
+        p.fillRect(viewport()->rect(), palette().base());
+        if (!file_.has_value()) {
+            return;
+        }
+        if (file_->truncated()) {
+            // not while painting, mapping it again resets the scrollbars
+            QTimer::singleShot(0, this, [this]() { remapIfTruncated(); });
+        }
+        p.setPen(palette().text().color());
+
+        const QFontMetrics metrics = p.fontMetrics();
+        const QFontMetricsF metricsF(p.font());
+        const int lineHeight = metrics.height();
+        const std::string_view bytes = text();
+        const qreal x = static_cast<qreal>(textMargin - horizontalScrollBar()->value());
+
+        // the view scrolls by whole rows, `top_` is always at the top edge
+        bool widened = false;
+        buffer::Offset at = top_;
+        for (int y = metrics.ascent(); y < viewport()->height() + lineHeight; y += lineHeight) {
+            const buffer::Offset end = buffer::SparseLineIndex::rowEndAt(bytes, at, maxDrawnLineBytes);
+            std::string_view drawn = bytes.substr(static_cast<usize>(at.raw()), static_cast<usize>((end - at).raw()));
+            const bool endsLine = end.raw() == bytes.size() || bytes[static_cast<usize>(end.raw())] == '\n';
+            if (endsLine && drawn.ends_with('\r')) {
+                drawn.remove_suffix(1);
+            }
+            // the mapped bytes were never validated, invalid UTF-8 is drawn as replacement characters
+            const QString line = QString::fromUtf8(drawn.data(), static_cast<qsizetype>(drawn.size()));
+            p.drawText(QPointF(x, y), line);
+
+            const int width = textMargin * 2 + static_cast<int>(std::ceil(metricsF.horizontalAdvance(line)));
+            if (width > contentWidth_) {
+                contentWidth_ = width;
+                widened = true;
+            }
+            if (end.raw() == bytes.size()) {
+                break;
+            }
+            at = endsLine ? end + buffer::Bytes(1) : end;
+        }
+        if (widened) {
+            // not while painting, the horizontal scrollbar may move what was drawn
+            QTimer::singleShot(0, this, [this]() { updateScrollbars(); });
+        }
+    }
+
+    void HugeFileView::resizeEvent(QResizeEvent* event) {
+        QAbstractScrollArea::resizeEvent(event);
+        updateScrollbars();
+    }
+
+    void HugeFileView::keyPressEvent(QKeyEvent* event) {
+        const s64 page = std::max(1, visibleLines() - 1);
+        switch (event->key()) {
+            case Qt::Key_Up: scrollLines(-1); return;
+            case Qt::Key_Down: scrollLines(1); return;
+            case Qt::Key_PageUp: scrollLines(-page); return;
+            case Qt::Key_PageDown: scrollLines(page); return;
+            case Qt::Key_Home:
+                top_ = buffer::Offset(0);
+                scrollLines(0);
+                return;
+            case Qt::Key_End:
+                top_ = buffer::SparseLineIndex::rowStartAt(text(), buffer::Offset(text().size()), maxDrawnLineBytes);
+                scrollLines(-page);
+                return;
+            default:
+                break;
+        }
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+
+    void HugeFileView::wheelEvent(QWheelEvent* event) {
+        const int notches = event->angleDelta().y() / 120;
+        if (notches == 0) {
+            QAbstractScrollArea::wheelEvent(event);
+            return;
+        }
+        scrollLines(static_cast<s64>(-notches) * wheelLines);
+        event->accept();
+    }
+
+    void HugeFileView::scrollContentsBy(int dx, int dy) {
+        Q_UNUSED(dx);
+        if (dy != 0 && file_.has_value()) {
+            // the scrollbar was moved, it is only set without notifying when the view moves itself
+            const int value = verticalScrollBar()->value();
+            if (scrollsByLine()) {
+                top_ = lineIndex_.lineStart(text(), static_cast<usize>(value)).value();
+            } else if (value >= verticalScrollBar()->maximum()) {
+                top_ = buffer::SparseLineIndex::rowStartAt(text(), buffer::Offset(text().size()), maxDrawnLineBytes);
+                scrollLines(-std::max(1, visibleLines() - 1));
+            } else {
+                const u64 at = text().size() * static_cast<u64>(value) / static_cast<u64>(approximateSteps);
+                top_ = buffer::SparseLineIndex::rowStartAt(text(), buffer::Offset(at), maxDrawnLineBytes);
+            }
+        }
+        viewport()->update();
+    }
+
+    void HugeFileView::scrollLines(s64 lines) {
+        for (; lines > 0; --lines) {
+            const std::optional<buffer::Offset> next = nextRowStart(top_);
+            if (!next.has_value()) {
+                break;
+            }
+            top_ = *next;
+        }
+        for (; lines < 0 && top_.raw() > 0; ++lines) {
+            top_ = previousRowStart(top_);
+        }
+        updateScrollbars();
+        viewport()->update();
+    }
+
+    std::optional<buffer::Offset> HugeFileView::nextRowStart(buffer::Offset at) const {
+        const std::string_view bytes = text();
+        const buffer::Offset end = buffer::SparseLineIndex::rowEndAt(bytes, at, maxDrawnLineBytes);
+        if (end.raw() == bytes.size()) {
+            return std::nullopt;
+        }
+        // a row cut from a long line is continued by the next, one ending its line by the line after
+        return bytes[static_cast<usize>(end.raw())] == '\n' ? end + buffer::Bytes(1) : end;
+    }
+
+    buffer::Offset HugeFileView::previousRowStart(buffer::Offset at) const {
+        const std::string_view bytes = text();
+        const bool startsLine = bytes[static_cast<usize>(at.raw()) - 1] == '\n';
+        return buffer::SparseLineIndex::rowStartAt(bytes, startsLine ? at - buffer::Bytes(1) : at, maxDrawnLineBytes);
+    }
+
+    void HugeFileView::remapIfTruncated() {
+        if (file_.has_value() && file_->truncated()) {
+            (void)openFile(path_);
+        }
+    }
+
+    void HugeFileView::indexSome() {
+        if (!file_.has_value()) {
+            return;
+        }
+        if (file_->truncated()) {
+            remapIfTruncated();
+            return;
+        }
+        if (lineIndex_.indexSome(text(), indexSliceBytes)) {
+            indexTimer_->start();
+        }
+        // refines the estimate, and switches the scrollbar to lines once complete
+        updateScrollbars();
+    }
+
+    void HugeFileView::updateScrollbars() {
+        // setting the value must not move the view back to where the scrollbar says
+        const QSignalBlocker blocker(verticalScrollBar());
+        const std::string_view bytes = text();
+        const int page = visibleLines();
+        if (scrollsByLine()) {
+            const auto lineCount = static_cast<int>(lineIndex_.lineCount(bytes).value());
+            verticalScrollBar()->setRange(0, std::max(0, lineCount - page));
+            verticalScrollBar()->setPageStep(page);
+            verticalScrollBar()->setValue(static_cast<int>(lineIndex_.lineOf(bytes, top_).value()));
+        } else {
+            const u64 lineCount = lineIndex_.estimatedLineCount(bytes);
+            verticalScrollBar()->setRange(0, bytes.empty() ? 0 : approximateSteps);
+            verticalScrollBar()->setPageStep(static_cast<int>(std::clamp<u64>(
+                static_cast<u64>(approximateSteps) * static_cast<u64>(page) / lineCount,
+                1,
+                static_cast<u64>(approximateSteps)
+            )));
+            verticalScrollBar()->setValue(
+                bytes.empty() ? 0 : static_cast<int>(top_.raw() * static_cast<u64>(approximateSteps) / bytes.size())
+            );
+        }
+        verticalScrollBar()->setSingleStep(1);
+
+        const int pageWidth = viewport()->width();
+        horizontalScrollBar()->setRange(0, std::max(0, contentWidth_ - pageWidth));
+        horizontalScrollBar()->setPageStep(pageWidth);
+        horizontalScrollBar()->setSingleStep(24);
+    }
+} // namespace teks::editor
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <teks/MappedFile.hpp>
+#include <teks/buffer/SparseLineIndex.hpp>
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <QAbstractScrollArea>
+
+class QTimer;
+
+namespace teks::editor {
+    // Read-only view of a file too large to load into a `Document`. The file is mapped rather than
+    // read, and lines are found through a sparse index, so memory stays bounded whatever its size.
+    //
+    // The file is indexed in slices while the event loop is idle. Until it is done the vertical
+    // scrollbar is a position in bytes, snapped to the start of the line there, and after it is a
+    // line number. Lines are drawn unwrapped and without highlighting. A line longer than
+    // `maxDrawnLineBytes` is shown as rows of that many bytes, so no paint or scroll scans further.
+    // A file truncated while it is shown, like a log rotated by copytruncate, is mapped again.
+    struct HugeFileView final : public QAbstractScrollArea {
+        // files at least this large are opened here rather than in a `DocumentView`
+        static constexpr u64 minFileBytes = u64{1} << 30;
+        static constexpr u64 maxDrawnLineBytes = 4096;
+
+        HugeFileView(QWidget* parent = nullptr);
+
+        // Returns whether the file could be mapped, the previous file is kept otherwise
+        bool openFile(const std::filesystem::path& path);
+
+    private:
+        std::optional<MappedFile> file_;
+        std::filesystem::path path_;
+        buffer::SparseLineIndex lineIndex_;
+        // start of the first line shown
+        buffer::Offset top_;
+        int contentWidth_{0};
+        QTimer* indexTimer_;
+
+        void paintEvent(QPaintEvent* event) override;
+        void resizeEvent(QResizeEvent* event) override;
+        void keyPressEvent(QKeyEvent* event) override;
+        void wheelEvent(QWheelEvent* event) override;
+        void scrollContentsBy(int dx, int dy) override;
+        void indexSome();
+        // Maps the file again when it shrank, what was mapped past its end reads as zeros until then
+        void remapIfTruncated();
+        // Start of the row after the one starting at `at`, `std::nullopt` for the last row
+        [[nodiscard]] std::optional<buffer::Offset> nextRowStart(buffer::Offset at) const;
+        // Start of the row before the one starting at `at`, which is not the first
+        [[nodiscard]] buffer::Offset previousRowStart(buffer::Offset at) const;
+        void scrollLines(s64 lines);
+        void updateScrollbars();
+        [[nodiscard]] std::string_view text() const;
+        // whether the scrollbar is exact, in lines
+        [[nodiscard]] bool scrollsByLine() const;
+        [[nodiscard]] int visibleLines() const;
+    };
+} // namespace teks::editor
@@ -0,0 +1,157 @@
+#include "LineAdvanceIndex.hpp"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <QString>
+
+namespace {
+    bool isContinuationByte(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    teks::usize codepointLength(std::string_view bytes, teks::usize at) {
+        teks::usize length = 1;
+        while (at + length < bytes.size() && isContinuationByte(bytes[at + length])) {
+            ++length;
+        }
+        return length;
+    }
+}
+
+namespace teks::editor {
+    LineAdvanceIndex::LineAdvanceIndex(buffer::Range line)
+        : line_(line)
+        , checkpoints_{Checkpoint{line.start(), 0.0}}
+        , complete_(line.size() == buffer::Bytes(0))
+    {}
+
+    buffer::Range LineAdvanceIndex::line() const {
+        return line_;
+    }
+
+    bool LineAdvanceIndex::extend(const buffer::Buffer& buffer, const QFontMetricsF& metrics) {
+        if (complete_) {
+            return false;
+        }
+
+        const Checkpoint last = checkpoints_.back();
+        // read a few extra bytes so the chunk can be grown to the next codepoint boundary
+        const buffer::Offset readEnd = std::min(
+            line_.end(),
+            last.offset + buffer::Bytes(checkpointBytes + 3)
+        );
+        std::string bytes = buffer.readString(buffer::Range::makeUnchecked(last.offset, readEnd)).value();
+        usize chunkSize = std::min<usize>(bytes.size(), checkpointBytes);
+        while (chunkSize < bytes.size() && isContinuationByte(bytes[chunkSize])) {
+            ++chunkSize;
+        }
+        bytes.resize(chunkSize);
+
+        const qreal advance = metrics.horizontalAdvance(QString::fromStdString(bytes));
+        checkpoints_.push_back(Checkpoint{last.offset + buffer::Bytes(chunkSize), last.x + advance});
+        complete_ = checkpoints_.back().offset == line_.end();
+        return true;
+    }
+
+    std::vector<LineAdvanceIndex::Checkpoint>::const_iterator
+    LineAdvanceIndex::checkpointAtOrBeforeX(qreal x) const {
+        const auto after = std::upper_bound(
+            checkpoints_.begin(),
+            checkpoints_.end(),
+            x,
+            [](qreal value, const Checkpoint& checkpoint) { return value < checkpoint.x; }
+        );
+        // checkpoints_[0].x is 0, so only a negative `x` has nothing before it
+        return after == checkpoints_.begin() ? after : after - 1;
+    }
+
+    std::vector<LineAdvanceIndex::Checkpoint>::const_iterator
+    LineAdvanceIndex::checkpointAtOrBeforeOffset(buffer::Offset at) const {
+        const auto after = std::upper_bound(
+            checkpoints_.begin(),
+            checkpoints_.end(),
+            at,
+            [](buffer::Offset value, const Checkpoint& checkpoint) { return value < checkpoint.offset; }
+        );
+        return after == checkpoints_.begin() ? after : after - 1;
+    }
+
+    LineAdvanceIndex::Window LineAdvanceIndex::window(
+        const buffer::Buffer& buffer,
+        const QFontMetricsF& metrics,
+        qreal left,
+        qreal right
+    ) {
+        while (checkpoints_.back().x < right && extend(buffer, metrics)) {}
+
+        const auto first = checkpointAtOrBeforeX(left);
+        auto last = std::lower_bound(
+            first,
+            checkpoints_.cend(),
+            right,
+            [](const Checkpoint& checkpoint, qreal value) { return checkpoint.x < value; }
+        );
+        if (last == checkpoints_.cend()) {
+            --last;
+        }
+
+        return Window{buffer::Range::makeUnchecked(first->offset, last->offset), first->x};
+    }
+
+    qreal LineAdvanceIndex::xAt(
+        const buffer::Buffer& buffer,
+        const QFontMetricsF& metrics,
+        buffer::Offset at
+    ) {
+        at = std::clamp(at, line_.start(), line_.end());
+        while (checkpoints_.back().offset < at && extend(buffer, metrics)) {}
+
+        const auto checkpoint = checkpointAtOrBeforeOffset(at);
+        if (checkpoint->offset == at) {
+            return checkpoint->x;
+        }
+        const std::string bytes = buffer.readString(
+            buffer::Range::makeUnchecked(checkpoint->offset, at)
+        ).value();
+        return checkpoint->x + metrics.horizontalAdvance(QString::fromStdString(bytes));
+    }
+
+    buffer::Offset LineAdvanceIndex::offsetAt(
+        const buffer::Buffer& buffer,
+        const QFontMetricsF& metrics,
+        qreal x
+    ) {
+        while (checkpoints_.back().x <= x && extend(buffer, metrics)) {}
+
+        const auto checkpoint = checkpointAtOrBeforeX(x);
+        const auto next = checkpoint + 1;
+        if (next == checkpoints_.cend()) {
+            return checkpoint->offset;
+        }
+
+        const std::string bytes = buffer.readString(
+            buffer::Range::makeUnchecked(checkpoint->offset, next->offset)
+        ).value();
+        qreal cursorX = checkpoint->x;
+        usize at = 0;
+        while (at < bytes.size()) {
+            const usize length = codepointLength(bytes, at);
+            const qreal advance = metrics.horizontalAdvance(
+                QString::fromUtf8(bytes.data() + at, static_cast<qsizetype>(length))
+            );
+            if (x < cursorX + advance / 2) {
+                break;
+            }
+            cursorX += advance;
+            at += length;
+        }
+        return checkpoint->offset + buffer::Bytes(at);
+    }
+
+    std::optional<qreal> LineAdvanceIndex::width() const {
+        if (complete_) {
+            return checkpoints_.back().x;
+        }
+        return std::nullopt;
+    }
+} // namespace teks::editor
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/types.hpp>
+#include <optional>
+#include <vector>
+#include <QFontMetricsF>
+
+namespace teks::editor {
+    // Lazily built x-advance checkpoints for a single line.
+    // Lets very long lines be mapped between x and byte offsets without shaping the whole line;
+    // the index is only extended as far to the right as has been asked for.
+    struct LineAdvanceIndex {
+        // Checkpoints are placed roughly this many bytes apart, always on a codepoint boundary
+        static constexpr u64 checkpointBytes = 1024;
+
+        struct Checkpoint {
+            buffer::Offset offset;
+            // line-local x of `offset`
+            qreal x;
+        };
+
+        // A checkpoint aligned slice of the line, `x` is the line-local x of `range.start()`
+        struct Window {
+            buffer::Range range;
+            qreal x;
+        };
+
+        explicit LineAdvanceIndex(buffer::Range line);
+
+        [[nodiscard]] buffer::Range line() const;
+
+        // Returns the smallest checkpoint aligned slice covering line-local `[left, right)`
+        [[nodiscard]] Window window(
+            const buffer::Buffer& buffer,
+            const QFontMetricsF& metrics,
+            qreal left,
+            qreal right
+        );
+
+        [[nodiscard]] qreal xAt(
+            const buffer::Buffer& buffer,
+            const QFontMetricsF& metrics,
+            buffer::Offset at
+        );
+
+        // Returns the offset of the codepoint boundary closest to line-local `x`
+        [[nodiscard]] buffer::Offset offsetAt(
+            const buffer::Buffer& buffer,
+            const QFontMetricsF& metrics,
+            qreal x
+        );
+
+        // The line width, once the index has been extended to the end of the line
+        [[nodiscard]] std::optional<qreal> width() const;
+
+    private:
+        buffer::Range line_;
+        std::vector<Checkpoint> checkpoints_;
+        bool complete_{false};
+
+        bool extend(const buffer::Buffer& buffer, const QFontMetricsF& metrics);
+        std::vector<Checkpoint>::const_iterator checkpointAtOrBeforeX(qreal x) const;
+        std::vector<Checkpoint>::const_iterator checkpointAtOrBeforeOffset(buffer::Offset at) const;
+    };
+} // namespace teks::editor
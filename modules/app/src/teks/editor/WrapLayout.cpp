@@ -0,0 +1,208 @@
+#include "WrapLayout.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <QFontMetricsF>
+#include <QString>
+#include <QTextLayout>
+#include <QTextOption>
+
+namespace {
+    bool isContinuationByte(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    teks::usize codepointLength(char lead) {
+        const auto byte = static_cast<unsigned char>(lead);
+        if ((byte & 0xE0) == 0xC0) {
+            return 2;
+        }
+        if ((byte & 0xF0) == 0xE0) {
+            return 3;
+        }
+        if ((byte & 0xF8) == 0xF0) {
+            return 4;
+        }
+        return 1;
+    }
+}
+
+namespace teks::editor {
+    WrapLayout::WrapLayout() {
+        reset(1);
+    }
+
+    void WrapLayout::reset(usize lineCount) {
+        index_ = layout::VisualLineIndex(lineCount);
+        nextStale_ = 0;
+    }
+
+    bool WrapLayout::setWidth(qreal width, const QFont& font) {
+        if (width == width_ && font == font_) {
+            return false;
+        }
+        width_ = width;
+        font_ = font;
+        // row counts are kept as estimates until each line is rewrapped
+        index_.markAllStale();
+        return true;
+    }
+
+    qreal WrapLayout::width() const {
+        return width_;
+    }
+
+    const QFont& WrapLayout::font() const {
+        return font_;
+    }
+
+    const layout::VisualLineIndex& WrapLayout::index() const {
+        return index_;
+    }
+
+    void WrapLayout::setFilter(const buffer::LineFilter* filter) {
+        filter_ = filter;
+    }
+
+    u64 WrapLayout::longLineBytesPerRow() const {
+        const qreal charWidth = QFontMetricsF(font_).averageCharWidth();
+        if (charWidth <= 0.0) {
+            return longLineBytes;
+        }
+        return std::max<u64>(1, static_cast<u64>(std::floor(width_ / charWidth)));
+    }
+
+    std::vector<usize> WrapLayout::rowStarts(std::string_view text) const {
+        std::vector<usize> result{0};
+        if (text.empty()) {
+            return result;
+        }
+
+        const QString string = QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+        QTextLayout textLayout(string, font_);
+        QTextOption option;
+        option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        textLayout.setTextOption(option);
+
+        std::vector<qsizetype> utf16Starts;
+        textLayout.beginLayout();
+        for (QTextLine row = textLayout.createLine(); row.isValid(); row = textLayout.createLine()) {
+            row.setLineWidth(width_);
+            utf16Starts.push_back(row.textStart());
+        }
+        textLayout.endLayout();
+
+        // QTextLayout works in UTF-16 code units, rows are kept as byte offsets into the line
+        usize byte = 0;
+        qsizetype utf16 = 0;
+        for (usize i = 1; i < utf16Starts.size(); ++i) {
+            while (utf16 < utf16Starts[i] && byte < text.size()) {
+                const usize length = std::min(codepointLength(text[byte]), text.size() - byte);
+                utf16 += length == 4 ? 2 : 1;
+                byte += length;
+            }
+            if (byte > result.back() && byte < text.size()) {
+                result.push_back(byte);
+            }
+        }
+        return result;
+    }
+
+    std::vector<buffer::Range> WrapLayout::wrap(
+        const buffer::Buffer& buffer,
+        usize line,
+        u64 firstRow,
+        u64 maxRows
+    ) {
+        std::vector<buffer::Range> result;
+        if (filter_ != nullptr && line >= filter_->lineCount()) {
+            // the one empty line kept when nothing matches the filter
+            index_.setRows(line, 1);
+            return result;
+        }
+        const buffer::Range range = buffer.lineRange(filter_ != nullptr ? filter_->sourceLine(line) : line).value();
+
+        if (range.size() > buffer::Bytes(longLineBytes)) {
+            // Split into rows of a fixed number of bytes nudged forward to codepoint boundaries,
+            // so only the bytes around the requested rows have to be read.
+            const u64 bytesPerRow = longLineBytesPerRow();
+            const u64 rows = (range.size().raw() + bytesPerRow - 1) / bytesPerRow;
+            index_.setRows(line, rows);
+
+            const auto rowStart = [&](u64 row) {
+                if (row >= rows) {
+                    return range.end();
+                }
+                const buffer::Offset nominal = range.start() + buffer::Bytes(row * bytesPerRow);
+                const buffer::Offset probeEnd = std::min(range.end(), nominal + buffer::Bytes(3));
+                const std::string probe = buffer.readString(
+                    buffer::Range::makeUnchecked(nominal, probeEnd)
+                ).value();
+                usize skip = 0;
+                while (skip < probe.size() && isContinuationByte(probe[skip])) {
+                    ++skip;
+                }
+                return nominal + buffer::Bytes(skip);
+            };
+
+            const u64 available = firstRow < rows ? rows - firstRow : 0;
+            const u64 lastRow = firstRow + std::min(available, maxRows);
+            if (lastRow == firstRow) {
+                return result;
+            }
+            buffer::Offset start = rowStart(firstRow);
+            for (u64 row = firstRow; row < lastRow; ++row) {
+                const buffer::Offset end = rowStart(row + 1);
+                result.push_back(buffer::Range::makeUnchecked(start, std::max(start, end)));
+                start = end;
+            }
+            return result;
+        }
+
+        const std::string text = buffer.readString(range).value();
+        const std::vector<usize> starts = rowStarts(text);
+        index_.setRows(line, starts.size());
+
+        for (u64 row = firstRow; row < starts.size() && row - firstRow < maxRows; ++row) {
+            const usize end = row + 1 < starts.size() ? starts[row + 1] : text.size();
+            result.push_back(buffer::Range::makeUnchecked(
+                range.start() + buffer::Bytes(starts[row]),
+                range.start() + buffer::Bytes(end)
+            ));
+        }
+        return result;
+    }
+
+    void WrapLayout::replaceLines(usize first, usize removed, usize inserted) {
+        index_.replaceLines(first, removed, inserted);
+        if (nextStale_ > index_.lineCount()) {
+            nextStale_ = 0;
+        }
+    }
+
+    void WrapLayout::prioritize(usize line) {
+        nextStale_ = std::min(line, index_.lineCount());
+    }
+
+    bool WrapLayout::rewrapSome(const buffer::Buffer& buffer, std::chrono::nanoseconds budget) {
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        while (index_.staleCount() > 0) {
+            // from `nextStale_` on, then around from the top
+            std::optional<usize> line = index_.nextStale(nextStale_);
+            if (!line) {
+                line = index_.nextStale(0);
+            }
+            (void)wrap(buffer, *line, 0, 0);
+            nextStale_ = *line + 1;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+        return index_.staleCount() > 0;
+    }
+
+    bool WrapLayout::hasStaleLines() const {
+        return index_.staleCount() > 0;
+    }
+} // namespace teks::editor
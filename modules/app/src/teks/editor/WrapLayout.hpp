@@ -0,0 +1,69 @@
+#pragma once
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/LineFilter.hpp>
+#include <teks/layout/VisualLineIndex.hpp>
+#include <teks/types.hpp>
+#include <chrono>
+#include <limits>
+#include <string_view>
+#include <vector>
+#include <QFont>
+
+namespace teks::editor {
+    // Soft-wrap layout of a document at a given width.
+    // Row counts live in a `layout::VisualLineIndex`, which also marks the lines whose row count may be
+    // out of date as stale. Those are rewrapped on demand (visible lines) or in bounded idle batches
+    // (the rest).
+    struct WrapLayout {
+        // Lines longer than this are split into fixed byte-width rows instead of being shaped
+        static constexpr u64 longLineBytes = 4096;
+
+        WrapLayout();
+
+        // Discards all wrapping, every line becomes stale
+        void reset(usize lineCount);
+
+        // Returns whether the width or font changed, in which case every line becomes stale
+        bool setWidth(qreal width, const QFont& font);
+        [[nodiscard]] qreal width() const;
+        [[nodiscard]] const QFont& font() const;
+
+        [[nodiscard]] const layout::VisualLineIndex& index() const;
+
+        // With a filter the layout's lines are the filter's lines rather than the buffer's.
+        // The filter must outlive the layout or be unset first.
+        void setFilter(const buffer::LineFilter* filter);
+
+        // Wraps `line` and returns the byte ranges of up to `maxRows` of its rows from `firstRow`.
+        // Long lines are only read around the returned rows.
+        std::vector<buffer::Range> wrap(
+            const buffer::Buffer& buffer,
+            usize line,
+            u64 firstRow = 0,
+            u64 maxRows = std::numeric_limits<u64>::max()
+        );
+
+        // Replaces lines `[first, first + removed)` with `inserted` stale lines, which are wrapped when
+        // they are drawn or by idle rewrapping
+        void replaceLines(usize first, usize removed, usize inserted);
+
+        // Idle rewrapping continues from `line`, used to wrap what is about to become visible first
+        void prioritize(usize line);
+
+        // Rewraps stale lines until `budget` elapses, returns whether stale lines remain
+        bool rewrapSome(const buffer::Buffer& buffer, std::chrono::nanoseconds budget);
+
+        [[nodiscard]] bool hasStaleLines() const;
+
+    private:
+        qreal width_{0.0};
+        QFont font_;
+        layout::VisualLineIndex index_;
+        const buffer::LineFilter* filter_{nullptr};
+        usize nextStale_{0};
+
+        [[nodiscard]] u64 longLineBytesPerRow() const;
+        std::vector<usize> rowStarts(std::string_view text) const;
+    };
+} // namespace teks::editor
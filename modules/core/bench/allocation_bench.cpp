@@ -0,0 +1,205 @@
+// Counts the heap allocations of `Buffer` edits under synthetic edit traces, with the buffer allocating
+// from the default resource and from a pool of its own as a `Document` gives it. Every `operator new`
+// in the process is counted, so allocations outside the buffer's resource (its other indices) show too.
+//
+// "held" is what the heap holds once the trace is over for the buffer and everything it allocated,
+// as a multiple of its text: memory lost to growth and to pooling shows as more than 1.
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/types.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace teks;
+    using namespace teks::buffer;
+
+    struct HeapCounters {
+        u64 allocations{0};
+        u64 liveBytes{0};
+        u64 peakBytes{0};
+    };
+
+    HeapCounters heap;
+
+    // a header before each block remembers its size, so unsized deletes can count what they free
+    constexpr std::size_t headerBytes = alignof(std::max_align_t);
+
+    void* countedAllocate(std::size_t size) {
+        void* block = std::malloc(size + headerBytes);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memcpy(block, &size, sizeof(size));
+        ++heap.allocations;
+        heap.liveBytes += size;
+        heap.peakBytes = std::max(heap.peakBytes, heap.liveBytes);
+        return static_cast<std::byte*>(block) + headerBytes;
+    }
+
+    void countedFree(void* pointer) {
+        if (pointer == nullptr) {
+            return;
+        }
+        std::byte* block = static_cast<std::byte*>(pointer) - headerBytes;
+        std::size_t size;
+        std::memcpy(&size, block, sizeof(size));
+        heap.liveBytes -= size;
+        std::free(block);
+    }
+
+    // over-aligned blocks keep the block they were carved from just before them
+    void* countedAlignedAllocate(std::size_t size, std::align_val_t alignment) {
+        const auto align = static_cast<std::size_t>(alignment);
+        std::byte* block = static_cast<std::byte*>(countedAllocate(size + align + sizeof(void*)));
+        const auto address = reinterpret_cast<std::uintptr_t>(block + sizeof(void*));
+        std::byte* aligned = block + sizeof(void*) + ((align - address % align) % align);
+        std::memcpy(aligned - sizeof(void*), &block, sizeof(void*));
+        return aligned;
+    }
+
+    void countedAlignedFree(void* pointer) {
+        if (pointer == nullptr) {
+            return;
+        }
+        void* block;
+        std::memcpy(&block, static_cast<std::byte*>(pointer) - sizeof(void*), sizeof(void*));
+        countedFree(block);
+    }
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedAllocate(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedAllocate(size, alignment); }
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+
+namespace {
+    constexpr usize documentLines = 20000;
+
+    std::string makeSource(std::mt19937& random) {
+        static constexpr const char* words[] = {"auto", "const", "value", "buffer", "return", "line", "(", ")", ";"};
+        std::string text;
+        for (usize line = 0; line < documentLines; ++line) {
+            text.append(4 * (random() % 4), ' ');
+            for (u64 word = random() % 10; word > 0; --word) {
+                text += words[random() % 9];
+                text += ' ';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    // A trace edits the buffer it is given, the same way for the same seed
+    using Trace = std::function<void(Buffer&, std::mt19937&)>;
+
+    // Typing a few words at a time at random places, with newlines and backspaces
+    void typing(Buffer& buffer, std::mt19937& random) {
+        for (int burst = 0; burst < 200; ++burst) {
+            Offset at(random() % (buffer.size().raw() + 1));
+            for (int key = 0; key < 50; ++key) {
+                const u64 roll = random() % 20;
+                if (roll == 0 && at.raw() > 0) {
+                    at -= Bytes(1);
+                    (void)buffer.erase(Range::makeUnchecked(at, Bytes(1)));
+                } else {
+                    (void)buffer.insert(at, roll == 1 ? "\n" : "x");
+                    at += Bytes(1);
+                }
+            }
+        }
+    }
+
+    // Renaming: replacing short ranges with identifiers of another length
+    void renaming(Buffer& buffer, std::mt19937& random) {
+        for (int edit = 0; edit < 5000; ++edit) {
+            const u64 start = random() % buffer.size().raw();
+            const Range range = Range::makeUnchecked(Offset(start), Offset(std::min(buffer.size().raw(), start + random() % 12)));
+            (void)buffer.replace(range, std::string(random() % 16, 'r'));
+        }
+    }
+
+    // Pasting CRLF text copied from elsewhere, which is normalized on the way in
+    void pasting(Buffer& buffer, std::mt19937& random) {
+        std::string paste;
+        for (int line = 0; line < 2000; ++line) {
+            paste += "pasted line " + std::to_string(line) + "\r\n";
+        }
+        for (int edit = 0; edit < 20; ++edit) {
+            (void)buffer.insert(Offset(random() % (buffer.size().raw() + 1)), paste);
+        }
+    }
+
+    // Typing at 1000 cursors at once
+    void multiCursor(Buffer& buffer, std::mt19937& random) {
+        std::vector<u64> offsets(1000);
+        for (u64& offset : offsets) {
+            offset = random() % (buffer.size().raw() + 1);
+        }
+        std::sort(offsets.begin(), offsets.end());
+        std::vector<Replacement> replacements;
+        for (u64 key = 0; key < 50; ++key) {
+            replacements.clear();
+            for (usize cursor = 0; cursor < offsets.size(); ++cursor) {
+                // each earlier cursor has typed `key` characters before this one
+                const Offset at(offsets[cursor] + cursor * key);
+                replacements.push_back(Replacement{Range::makeUnchecked(at, at), "y"});
+            }
+            (void)buffer.replaceEach(replacements);
+        }
+    }
+
+    void report(const char* name, const Trace& trace, const std::string& text) {
+        for (const bool pooled : {false, true}) {
+            std::mt19937 random(11);
+            const HeapCounters before = heap;
+            std::pmr::unsynchronized_pool_resource pool;
+            std::pmr::memory_resource* resource = pooled ? &pool : std::pmr::get_default_resource();
+            Buffer buffer(text, resource);
+            const HeapCounters loaded = heap;
+
+            const auto start = std::chrono::steady_clock::now();
+            trace(buffer, random);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::printf(
+                "%-12s %-7s %9llu allocations %7.2f MiB peak %5.2fx held %8.2f ms\n",
+                name,
+                pooled ? "pool" : "default",
+                static_cast<unsigned long long>(heap.allocations - loaded.allocations),
+                static_cast<double>(heap.peakBytes - before.liveBytes) / (1024.0 * 1024.0),
+                static_cast<double>(heap.liveBytes - before.liveBytes) / static_cast<double>(buffer.size().raw()),
+                elapsed.count() * 1e3
+            );
+            heap.peakBytes = heap.liveBytes;
+        }
+    }
+}
+
+int main() {
+    std::mt19937 random(3);
+    const std::string text = makeSource(random);
+    report("typing", typing, text);
+    report("renaming", renaming, text);
+    report("pasting", pasting, text);
+    report("multicursor", multiCursor, text);
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Compares tokens/sec of the compile-time specialized lexers against `ConfigurableLexer`
+// configured for the same language, on synthetic C++ and JSON documents.
+
+#include <teks/highlight/ConfigurableLexer.hpp>
+#include <teks/highlight/TableLexers.hpp>
+#include <teks/types.hpp>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using namespace teks;
+    using namespace teks::highlight;
+
+    constexpr usize documentLines = 200000;
+    constexpr int repetitions = 5;
+
+    constexpr std::array cppSample{
+        std::string_view("#include <teks/buffer/Buffer.hpp>"),
+        std::string_view("namespace teks::buffer {"),
+        std::string_view("    // Returns the line containing `at`, or std::nullopt when out of range"),
+        std::string_view("    [[nodiscard]] std::optional<usize> lineOf(const Buffer& buffer, Offset at) {"),
+        std::string_view("        const auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), at);"),
+        std::string_view("        if (it == lineStarts_.begin()) { return std::nullopt; } /* unreachable */"),
+        std::string_view("        static constexpr unsigned long mask = 0xFF'FFu + 1.5e3;"),
+        std::string_view("        return static_cast<usize>(it - lineStarts_.begin()) - 1; // \"done\""),
+        std::string_view("    }"),
+        std::string_view("} // namespace teks::buffer"),
+    };
+
+    constexpr std::array jsonSample{
+        std::string_view(R"({"id": 1024, "name": "widget", "tags": ["a", "b", "c"], "price": 12.5,)"),
+        std::string_view(R"( "active": true, "parent": null, "dimensions": {"w": 10, "h": 20.25}},)"),
+    };
+
+    template <usize N>
+    std::vector<std::string> makeDocument(const std::array<std::string_view, N>& sample) {
+        std::vector<std::string> lines;
+        lines.reserve(documentLines);
+        for (usize i = 0; i < documentLines; ++i) {
+            lines.emplace_back(sample[i % sample.size()]);
+        }
+        return lines;
+    }
+
+    struct Result {
+        u64 tokens;
+        double seconds;
+    };
+
+    Result run(const Lexer& lexer, const std::vector<std::string>& lines) {
+        std::vector<Token> tokens;
+        u64 tokenCount = 0;
+        double best = 0.0;
+        for (int repetition = 0; repetition < repetitions; ++repetition) {
+            tokenCount = 0;
+            LexerState state = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (const std::string& line : lines) {
+                tokens.clear();
+                state = lexer.lexLine(line, state, tokens);
+                tokenCount += tokens.size();
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (repetition == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+        }
+        return Result{tokenCount, best};
+    }
+
+    void report(const char* language, const Lexer& configurable, const Lexer& specialized, const std::vector<std::string>& lines) {
+        u64 bytes = 0;
+        for (const std::string& line : lines) {
+            bytes += line.size() + 1;
+        }
+
+        const Result baseline = run(configurable, lines);
+        const Result table = run(specialized, lines);
+        const auto print = [&](const char* lexerName, const Result& result) {
+            std::printf(
+                "%-5s %-13s %10llu tokens %8.2f Mtok/s %8.2f MiB/s\n",
+                language,
+                lexerName,
+                static_cast<unsigned long long>(result.tokens),
+                static_cast<double>(result.tokens) / result.seconds / 1e6,
+                static_cast<double>(bytes) / result.seconds / (1024.0 * 1024.0)
+            );
+        };
+        print("configurable", baseline);
+        print("table", table);
+        std::printf("%-5s speedup       %.2fx\n", language, baseline.seconds / table.seconds);
+    }
+}
+
+int main() {
+    report("cpp", ConfigurableLexer(cppLanguageConfig()), CppLexer(), makeDocument(cppSample));
+    report("json", ConfigurableLexer(jsonLanguageConfig()), JsonLexer(), makeDocument(jsonSample));
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Compares the memory and line range lookup speed of `LineStartIndex` against the `std::vector<Offset>`
+// it replaced, on synthetic source and log documents. Lookups read a screenful of consecutive lines
+// at random places, as painting does.
+
+#include <teks/buffer/LineStartIndex.hpp>
+#include <teks/types.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using namespace teks;
+    using namespace teks::buffer;
+
+    constexpr usize documentLines = 2000000;
+    constexpr usize screenLines = 60;
+    constexpr usize screens = 200000;
+    constexpr int repetitions = 5;
+
+    std::string makeDocument(u32 seed, u32 minLineBytes, u32 maxLineBytes) {
+        std::mt19937 random(seed);
+        std::string text;
+        for (usize i = 0; i < documentLines; ++i) {
+            text.append(minLineBytes + random() % (maxLineBytes - minLineBytes + 1), 'x');
+            text.push_back('\n');
+        }
+        return text;
+    }
+
+    std::vector<Offset> offsetVector(const std::string& text) {
+        std::vector<Offset> starts{Offset(0)};
+        for (usize i = 0; i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                starts.push_back(Offset(i + 1));
+            }
+        }
+        starts.shrink_to_fit();
+        return starts;
+    }
+
+    template <typename LineRange>
+    double run(usize lineCount, const LineRange& lineRange) {
+        double best = 0.0;
+        u64 sum = 0;
+        for (int repetition = 0; repetition < repetitions; ++repetition) {
+            std::mt19937 random(7);
+            const auto start = std::chrono::steady_clock::now();
+            for (usize screen = 0; screen < screens; ++screen) {
+                const usize top = random() % (lineCount - screenLines);
+                for (usize line = top; line < top + screenLines; ++line) {
+                    sum += lineRange(line).end().raw();
+                }
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (repetition == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+        }
+        // keeps the lookups from being optimized away
+        if (sum == 0) {
+            std::printf("\n");
+        }
+        return best;
+    }
+
+    void report(const char* name, const std::string& text) {
+        const std::vector<Offset> starts = offsetVector(text);
+        const LineStartIndex index(text);
+        const Bytes size(text.size());
+        const double vectorSeconds = run(starts.size(), [&starts, size](usize line) {
+            return line + 1 < starts.size()
+                ? Range::makeUnchecked(starts[line], starts[line + 1] - Bytes(1))
+                : Range::makeUnchecked(starts[line], Offset(size));
+        });
+        const double indexSeconds = run(index.lineCount(), [&index, size](usize line) {
+            return index.lineRange(line, size);
+        });
+        const double lookups = static_cast<double>(screens * screenLines);
+
+        std::printf(
+            "%-6s vector %8.2f MiB %6.2f ns/line\n",
+            name,
+            static_cast<double>(starts.capacity() * sizeof(Offset)) / (1024.0 * 1024.0),
+            vectorSeconds / lookups * 1e9
+        );
+        std::printf(
+            "%-6s index  %8.2f MiB %6.2f ns/line (%.2fx smaller)\n",
+            name,
+            static_cast<double>(index.memoryBytes()) / (1024.0 * 1024.0),
+            indexSeconds / lookups * 1e9,
+            static_cast<double>(starts.capacity() * sizeof(Offset)) / static_cast<double>(index.memoryBytes())
+        );
+    }
+}
+
+int main() {
+    report("source", makeDocument(1, 0, 80));
+    report("log", makeDocument(2, 60, 160));
+    return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace teks {
+    // A file mapped read-only into memory. Pages are read by the OS as they are touched and can be
+    // dropped again under memory pressure, so a file far larger than memory can be viewed.
+    //
+    // A file truncated while it is mapped, as logrotate's copytruncate does to logs, would crash the
+    // reader of a page past its new end with SIGBUS. Those pages read as zeros instead, and
+    // `truncated` tells the reader to map the file again. Windows refuses to truncate mapped files.
+    struct MappedFile {
+        // Returns `std::nullopt` when the file cannot be opened or mapped
+        [[nodiscard]] static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        [[nodiscard]] std::string_view bytes() const;
+
+        // Whether the file is now shorter than what is mapped, asking the OS each call
+        [[nodiscard]] bool truncated() const;
+
+    private:
+        const char* data_{nullptr};
+        usize size_{0};
+        // kept open to check the size of the file mapped, -1 when nothing is or on Windows
+        int file_{-1};
+
+        MappedFile(const char* data, usize size, int file);
+        void unmap();
+    };
+} // namespace teks
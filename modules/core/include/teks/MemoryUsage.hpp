@@ -0,0 +1,51 @@
+#pragma once
+
+#include <teks/types.hpp>
+
+namespace teks {
+    // Heap bytes held by a container or a structure of them: what its elements use, and what is
+    // allocated past them, which `shrinkToFit` releases
+    struct HeapBytes {
+        u64 used{0};
+        u64 slack{0};
+
+        HeapBytes& operator+=(const HeapBytes& other) {
+            used += other.used;
+            slack += other.slack;
+            return *this;
+        }
+    };
+
+    // The heap bytes of a contiguous container like `std::vector` or `std::string`, not counting what
+    // its elements hold themselves. A string's small buffer is counted too, it is part of the string.
+    template <typename Container>
+    [[nodiscard]] HeapBytes heapBytesOf(const Container& container) {
+        const u64 element = sizeof(typename Container::value_type);
+        return HeapBytes{container.size() * element, (container.capacity() - container.size()) * element};
+    }
+
+    // Bytes held by a buffer or a document, by what they are for. Slack is apart from the rest: the
+    // capacity every part has allocated past what it uses.
+    struct MemoryUsage {
+        u64 text{0};
+        u64 lineIndex{0};
+        u64 undoHistory{0};
+        // what is kept to answer queries quickly: column counts, content hashes, invalid UTF-8 runs,
+        // highlighting
+        u64 caches{0};
+        u64 slack{0};
+
+        [[nodiscard]] u64 total() const {
+            return text + lineIndex + undoHistory + caches + slack;
+        }
+
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            text += other.text;
+            lineIndex += other.lineIndex;
+            undoHistory += other.undoHistory;
+            caches += other.caches;
+            slack += other.slack;
+            return *this;
+        }
+    };
+} // namespace teks
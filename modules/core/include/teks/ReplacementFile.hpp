@@ -0,0 +1,46 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace teks {
+    // Makes what was written to `file` durable, not just handed to the OS. Returns success.
+    bool syncFile(std::FILE* file);
+
+    // A new version of the file at a path, written beside it and renamed over it once complete, so a
+    // crash or a full disk leaves either the old file or the new one whole, never a truncated mix.
+    // The temporary file is the path with ".tmp" appended. A symlink keeps pointing at its target, which
+    // is what gets replaced, and the new file takes the old one's permissions.
+    //
+    // Without a successful `commit`, destroying it removes the temporary file and the old one stays.
+    struct ReplacementFile {
+        // Returns `std::nullopt` when the temporary file cannot be created
+        [[nodiscard]] static std::optional<ReplacementFile> create(const std::filesystem::path& path);
+
+        ReplacementFile(ReplacementFile&& other) noexcept;
+        ReplacementFile& operator=(ReplacementFile&& other) noexcept;
+        ReplacementFile(const ReplacementFile&) = delete;
+        ReplacementFile& operator=(const ReplacementFile&) = delete;
+        ~ReplacementFile();
+
+        // Appends `bytes`. Returns success, after a failure nothing more is written and `commit` fails.
+        bool write(std::string_view bytes);
+
+        // Syncs what was written to disk and renames it over the file. Returns success.
+        [[nodiscard]] bool commit();
+
+    private:
+        std::filesystem::path path_;
+        std::filesystem::path temporary_;
+        std::FILE* file_;
+        bool failed_{false};
+
+        ReplacementFile(std::filesystem::path path, std::filesystem::path temporary, std::FILE* file);
+
+        // Closes and removes the temporary file, unless it was committed
+        void discard();
+    };
+} // namespace teks
@@ -0,0 +1,588 @@
+#pragma once
+
+#include <teks/assert.hpp>
+#include <teks/MemoryUsage.hpp>
+#include <teks/types.hpp>
+#include <algorithm>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace teks {
+    // A sequence of items in a B+ tree whose inner nodes keep the item count and combined summary of each
+    // child. Finding an item by index or by running summary, prefix summaries, and point updates are
+    // O(log n); inserting or erasing a run of items is O(log n) plus the run. Building from items is O(n).
+    //
+    // `Summarize{}(item)` is the summary of one item, `Summary{}` the summary of none, and `a + b` the
+    // summary of a run `a` followed by a run `b`. `+` must be associative, it need not be commutative.
+    // Nodes and their entries are allocated from the tree's allocator.
+    template <typename Item, typename Summary, typename Summarize>
+    struct SumTree {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        // Items per leaf and children per inner node, nodes other than the root keep at least a quarter
+        static constexpr usize maxEntries = 32;
+        static constexpr usize minEntries = maxEntries / 4;
+
+        struct Found {
+            usize index;
+            // the summary of the items before `index`
+            Summary before;
+            // `nullptr` when nothing was found, then `index` is `size()` and `before` the total
+            const Item* item;
+        };
+
+        SumTree() = default;
+
+        explicit SumTree(allocator_type allocator)
+            : allocator_(allocator)
+        {}
+
+        explicit SumTree(std::span<const Item> items, allocator_type allocator = {})
+            : allocator_(allocator)
+        {
+            assign(items);
+        }
+
+        // Like the `std::pmr` containers a copy gets the default allocator unless given one
+        SumTree(const SumTree& other)
+            : SumTree(other, allocator_type())
+        {}
+
+        SumTree(const SumTree& other, allocator_type allocator)
+            : allocator_(allocator)
+            , root_(other.root_.node != nullptr ? copy(other.root_) : Child{})
+        {}
+
+        SumTree(SumTree&& other) noexcept
+            : allocator_(other.allocator_)
+            , root_(std::exchange(other.root_, Child{}))
+        {}
+
+        SumTree(SumTree&& other, allocator_type allocator)
+            : allocator_(allocator)
+        {
+            *this = std::move(other);
+        }
+
+        ~SumTree() {
+            clear();
+        }
+
+        SumTree& operator=(const SumTree& other) {
+            if (this != &other) {
+                clear();
+                if (other.root_.node != nullptr) {
+                    root_ = copy(other.root_);
+                }
+            }
+            return *this;
+        }
+
+        // The allocator is kept, items are copied when the other tree's allocator is a different one
+        SumTree& operator=(SumTree&& other) {
+            if (this == &other) {
+                return *this;
+            }
+            clear();
+            if (allocator_ == other.allocator_) {
+                root_ = std::exchange(other.root_, Child{});
+            } else if (other.root_.node != nullptr) {
+                root_ = copy(other.root_);
+                other.clear();
+            }
+            return *this;
+        }
+
+        [[nodiscard]] allocator_type get_allocator() const {
+            return allocator_;
+        }
+
+        [[nodiscard]] usize size() const {
+            return root_.count;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return root_.count == 0;
+        }
+
+        // The summary of every item
+        [[nodiscard]] const Summary& total() const {
+            return root_.summary;
+        }
+
+        [[nodiscard]] const Item& operator[](usize index) const {
+            TEKS_ASSERT(index < size());
+            const Node* node = root_.node;
+            while (!node->leaf) {
+                node = node->children[childAt(node, index)].node;
+            }
+            return node->items[index];
+        }
+
+        // The summary of the first `count` items
+        [[nodiscard]] Summary prefixSum(usize count) const {
+            TEKS_ASSERT(count <= size());
+            if (count == size()) {
+                return root_.summary;
+            }
+            Summary sum{};
+            const Node* node = root_.node;
+            while (!node->leaf) {
+                for (const Child& child : node->children) {
+                    if (count < child.count) {
+                        node = child.node;
+                        break;
+                    }
+                    sum = sum + child.summary;
+                    count -= child.count;
+                }
+            }
+            for (usize i = 0; i < count; ++i) {
+                sum = sum + Summarize{}(node->items[i]);
+            }
+            return sum;
+        }
+
+        // The first item whose summary together with those before it is `reached`. `reached` must be
+        // false for `Summary{}` and stay true for every longer run once it is true for one.
+        template <typename Reached>
+        [[nodiscard]] Found find(Reached&& reached) const {
+            if (root_.node == nullptr || !reached(root_.summary)) {
+                return Found{size(), root_.summary, nullptr};
+            }
+            Summary before{};
+            usize index = 0;
+            const Node* node = root_.node;
+            while (!node->leaf) {
+                // the node is reached, so its last child is when none before it is
+                usize i = 0;
+                for (; i + 1 < node->children.size(); ++i) {
+                    Summary through = before + node->children[i].summary;
+                    if (reached(std::as_const(through))) {
+                        break;
+                    }
+                    before = std::move(through);
+                    index += node->children[i].count;
+                }
+                node = node->children[i].node;
+            }
+            usize i = 0;
+            for (; i + 1 < node->items.size(); ++i) {
+                Summary through = before + Summarize{}(node->items[i]);
+                if (reached(std::as_const(through))) {
+                    break;
+                }
+                before = std::move(through);
+                ++index;
+            }
+            return Found{index, std::move(before), &node->items[i]};
+        }
+
+        // Calls `visit` with items `[first, last)` in order
+        template <typename Visit>
+        void forEach(usize first, usize last, Visit&& visit) const {
+            TEKS_ASSERT(first <= last && last <= size());
+            if (first < last) {
+                forEachIn(root_.node, first, last, visit);
+            }
+        }
+
+        void set(usize index, Item item) {
+            TEKS_ASSERT(index < size());
+            setIn(root_, index, item);
+        }
+
+        void assign(std::span<const Item> items) {
+            clear();
+            if (items.empty()) {
+                return;
+            }
+            std::pmr::vector<Child> level(allocator_);
+            const usize groups = groupCount(items.size());
+            level.reserve(groups);
+            for (usize group = 0; group < groups; ++group) {
+                level.push_back(makeLeaf(
+                    items.begin() + static_cast<ssize>(groupStart(items.size(), groups, group)),
+                    items.begin() + static_cast<ssize>(groupStart(items.size(), groups, group + 1))
+                ));
+            }
+            while (level.size() > 1) {
+                std::pmr::vector<Child> above(allocator_);
+                const usize aboveGroups = groupCount(level.size());
+                above.reserve(aboveGroups);
+                for (usize group = 0; group < aboveGroups; ++group) {
+                    above.push_back(makeInner(
+                        level.begin() + static_cast<ssize>(groupStart(level.size(), aboveGroups, group)),
+                        level.begin() + static_cast<ssize>(groupStart(level.size(), aboveGroups, group + 1))
+                    ));
+                }
+                level = std::move(above);
+            }
+            root_ = level.front();
+        }
+
+        // Inserts `items` before the item at `at`, `at == size()` appends them
+        void insert(usize at, std::span<const Item> items) {
+            TEKS_ASSERT(at <= size());
+            if (items.empty()) {
+                return;
+            }
+            if (root_.node == nullptr) {
+                assign(items);
+                return;
+            }
+            std::pmr::vector<Child> split(allocator_);
+            insertIn(root_, at, items, split);
+            while (!split.empty()) {
+                // the root split, it and the nodes split off it go a level down under a new root
+                Node* node = allocator_.template new_object<Node>(false, allocator_);
+                node->children.push_back(root_);
+                node->children.insert(node->children.end(), split.begin(), split.end());
+                split.clear();
+                root_ = measure(node);
+                splitOverfull(root_, split);
+            }
+        }
+
+        void push(const Item& item) {
+            insert(size(), std::span<const Item>(&item, 1));
+        }
+
+        // Erases items `[first, last)`
+        void erase(usize first, usize last) {
+            TEKS_ASSERT(first <= last && last <= size());
+            if (first == last) {
+                return;
+            }
+            if (first == 0 && last == size()) {
+                clear();
+                return;
+            }
+            eraseIn(root_, first, last);
+            while (!root_.node->leaf && root_.node->children.size() == 1) {
+                Node* const old = root_.node;
+                root_ = old->children.front();
+                old->children.clear();
+                allocator_.delete_object(old);
+            }
+        }
+
+        // Replaces items `[first, last)` with `items`
+        void replace(usize first, usize last, std::span<const Item> items) {
+            erase(first, last);
+            insert(first, items);
+        }
+
+        void clear() {
+            if (root_.node != nullptr) {
+                destroy(root_.node);
+                root_ = Child{};
+            }
+        }
+
+        [[nodiscard]] HeapBytes heapBytes() const {
+            HeapBytes bytes;
+            if (root_.node != nullptr) {
+                addHeapBytes(root_.node, bytes);
+            }
+            return bytes;
+        }
+
+        void shrinkToFit() {
+            if (root_.node != nullptr) {
+                shrinkIn(root_.node);
+            }
+        }
+
+    private:
+        struct Node;
+
+        struct Child {
+            Node* node{nullptr};
+            usize count{0};
+            Summary summary{};
+        };
+
+        struct Node {
+            Node(bool isLeaf, allocator_type allocator)
+                : leaf(isLeaf)
+                , items(allocator)
+                , children(allocator)
+            {}
+
+            // leaves hold items, inner nodes children
+            bool leaf;
+            std::pmr::vector<Item> items;
+            std::pmr::vector<Child> children;
+        };
+
+        allocator_type allocator_;
+        // `nullptr` while there are no items
+        Child root_;
+
+        // `count` entries go into the fewest nodes of at most `maxEntries`, split evenly so that each
+        // has at least half of that when there is more than one
+        [[nodiscard]] static usize groupCount(usize count) {
+            return (count + maxEntries - 1) / maxEntries;
+        }
+
+        [[nodiscard]] static usize groupStart(usize count, usize groups, usize group) {
+            return count * group / groups;
+        }
+
+        [[nodiscard]] static usize entryCount(const Node* node) {
+            return node->leaf ? node->items.size() : node->children.size();
+        }
+
+        // The child `index` is in, `index` becomes the index in that child
+        [[nodiscard]] static usize childAt(const Node* node, usize& index) {
+            usize i = 0;
+            while (index >= node->children[i].count) {
+                index -= node->children[i].count;
+                ++i;
+            }
+            return i;
+        }
+
+        [[nodiscard]] static Child measure(Node* node) {
+            Child child{node, 0, Summary{}};
+            if (node->leaf) {
+                child.count = node->items.size();
+                for (const Item& item : node->items) {
+                    child.summary = child.summary + Summarize{}(item);
+                }
+            } else {
+                for (const Child& inner : node->children) {
+                    child.count += inner.count;
+                    child.summary = child.summary + inner.summary;
+                }
+            }
+            return child;
+        }
+
+        template <typename Iterator>
+        [[nodiscard]] Child makeLeaf(Iterator first, Iterator last) {
+            Node* node = allocator_.template new_object<Node>(true, allocator_);
+            node->items.assign(first, last);
+            return measure(node);
+        }
+
+        template <typename Iterator>
+        [[nodiscard]] Child makeInner(Iterator first, Iterator last) {
+            Node* node = allocator_.template new_object<Node>(false, allocator_);
+            node->children.assign(first, last);
+            return measure(node);
+        }
+
+        [[nodiscard]] Child copy(const Child& other) {
+            const Node* from = other.node;
+            if (from->leaf) {
+                return makeLeaf(from->items.begin(), from->items.end());
+            }
+            Node* node = allocator_.template new_object<Node>(false, allocator_);
+            node->children.reserve(from->children.size());
+            for (const Child& child : from->children) {
+                node->children.push_back(copy(child));
+            }
+            return Child{node, other.count, other.summary};
+        }
+
+        void destroy(Node* node) {
+            for (const Child& child : node->children) {
+                destroy(child.node);
+            }
+            allocator_.delete_object(node);
+        }
+
+        template <typename Visit>
+        static void forEachIn(const Node* node, usize first, usize last, Visit& visit) {
+            if (node->leaf) {
+                for (usize i = first; i < last; ++i) {
+                    visit(node->items[i]);
+                }
+                return;
+            }
+            usize start = 0;
+            for (const Child& child : node->children) {
+                const usize end = start + child.count;
+                if (end > first) {
+                    forEachIn(child.node, std::max(first, start) - start, std::min(last, end) - start, visit);
+                }
+                start = end;
+                if (start >= last) {
+                    break;
+                }
+            }
+        }
+
+        void setIn(Child& child, usize index, Item& item) {
+            Node* node = child.node;
+            if (node->leaf) {
+                node->items[index] = std::move(item);
+            } else {
+                const usize i = childAt(node, index);
+                setIn(node->children[i], index, item);
+            }
+            child = measure(node);
+        }
+
+        // Inserts into the subtree of `child`, the nodes it had to split off go to `split` in order
+        void insertIn(Child& child, usize at, std::span<const Item> items, std::pmr::vector<Child>& split) {
+            Node* node = child.node;
+            if (node->leaf) {
+                node->items.insert(node->items.begin() + static_cast<ssize>(at), items.begin(), items.end());
+            } else {
+                // a position between two children goes to the end of the first
+                usize i = 0;
+                while (i + 1 < node->children.size() && at > node->children[i].count) {
+                    at -= node->children[i].count;
+                    ++i;
+                }
+                std::pmr::vector<Child> grown(allocator_);
+                insertIn(node->children[i], at, items, grown);
+                node->children.insert(node->children.begin() + static_cast<ssize>(i + 1), grown.begin(), grown.end());
+            }
+            child = measure(node);
+            splitOverfull(child, split);
+        }
+
+        void splitOverfull(Child& child, std::pmr::vector<Child>& split) {
+            Node* node = child.node;
+            const usize entries = entryCount(node);
+            if (entries <= maxEntries) {
+                return;
+            }
+            const usize groups = groupCount(entries);
+            const usize kept = groupStart(entries, groups, 1);
+            if (node->leaf) {
+                for (usize group = 1; group < groups; ++group) {
+                    split.push_back(makeLeaf(
+                        std::make_move_iterator(node->items.begin() + static_cast<ssize>(groupStart(entries, groups, group))),
+                        std::make_move_iterator(node->items.begin() + static_cast<ssize>(groupStart(entries, groups, group + 1)))
+                    ));
+                }
+                node->items.erase(node->items.begin() + static_cast<ssize>(kept), node->items.end());
+            } else {
+                for (usize group = 1; group < groups; ++group) {
+                    split.push_back(makeInner(
+                        node->children.begin() + static_cast<ssize>(groupStart(entries, groups, group)),
+                        node->children.begin() + static_cast<ssize>(groupStart(entries, groups, group + 1))
+                    ));
+                }
+                node->children.erase(node->children.begin() + static_cast<ssize>(kept), node->children.end());
+            }
+            // what the node grew to before it split is not needed anymore
+            node->items.shrink_to_fit();
+            node->children.shrink_to_fit();
+            child = measure(node);
+        }
+
+        void eraseIn(Child& child, usize first, usize last) {
+            Node* node = child.node;
+            if (node->leaf) {
+                node->items.erase(node->items.begin() + static_cast<ssize>(first), node->items.begin() + static_cast<ssize>(last));
+            } else {
+                // `start` is where the child at `i` starts before anything was erased
+                usize start = 0;
+                for (usize i = 0; i < node->children.size() && start < last;) {
+                    const usize end = start + node->children[i].count;
+                    if (end <= first) {
+                        ++i;
+                    } else if (first <= start && end <= last) {
+                        destroy(node->children[i].node);
+                        node->children.erase(node->children.begin() + static_cast<ssize>(i));
+                    } else {
+                        eraseIn(node->children[i], std::max(first, start) - start, std::min(last, end) - start);
+                        ++i;
+                    }
+                    start = end;
+                }
+                rebalanceChildren(node);
+            }
+            child = measure(node);
+        }
+
+        // Merges children left with fewer than `minEntries` entries into a neighbour, or moves entries to
+        // them from it when both would not fit in one node
+        void rebalanceChildren(Node* node) {
+            for (usize i = 0; i < node->children.size() && node->children.size() > 1;) {
+                if (entryCount(node->children[i].node) >= minEntries) {
+                    ++i;
+                    continue;
+                }
+                const usize left = i + 1 < node->children.size() ? i : i - 1;
+                if (balancePair(node, left)) {
+                    i = left;
+                } else {
+                    ++i;
+                }
+            }
+        }
+
+        // Balances the children at `left` and `left + 1`, returns whether they were merged into one
+        bool balancePair(Node* node, usize left) {
+            Node* first = node->children[left].node;
+            Node* second = node->children[left + 1].node;
+            const usize firstEntries = entryCount(first);
+            const usize total = firstEntries + entryCount(second);
+            if (total <= maxEntries) {
+                if (first->leaf) {
+                    moveEntries(second->items, 0, second->items.size(), first->items, first->items.size());
+                } else {
+                    moveEntries(second->children, 0, second->children.size(), first->children, first->children.size());
+                    // a child that was alone in its node could not be balanced there
+                    rebalanceChildren(first);
+                }
+                allocator_.delete_object(second);
+                node->children.erase(node->children.begin() + static_cast<ssize>(left + 1));
+                node->children[left] = measure(first);
+                return true;
+            }
+
+            const usize kept = total / 2;
+            if (firstEntries > kept) {
+                if (first->leaf) {
+                    moveEntries(first->items, kept, firstEntries, second->items, 0);
+                } else {
+                    moveEntries(first->children, kept, firstEntries, second->children, 0);
+                }
+            } else if (first->leaf) {
+                moveEntries(second->items, 0, kept - firstEntries, first->items, firstEntries);
+            } else {
+                moveEntries(second->children, 0, kept - firstEntries, first->children, firstEntries);
+            }
+            node->children[left] = measure(first);
+            node->children[left + 1] = measure(second);
+            return false;
+        }
+
+        // Moves entries `[first, last)` of `from` to before entry `at` of `to`
+        template <typename Entries>
+        static void moveEntries(Entries& from, usize first, usize last, Entries& to, usize at) {
+            const auto begin = from.begin() + static_cast<ssize>(first);
+            const auto end = from.begin() + static_cast<ssize>(last);
+            to.insert(to.begin() + static_cast<ssize>(at), std::make_move_iterator(begin), std::make_move_iterator(end));
+            from.erase(begin, end);
+        }
+
+        void addHeapBytes(const Node* node, HeapBytes& bytes) const {
+            bytes.used += sizeof(Node);
+            bytes += heapBytesOf(node->items);
+            bytes += heapBytesOf(node->children);
+            for (const Child& child : node->children) {
+                addHeapBytes(child.node, bytes);
+            }
+        }
+
+        void shrinkIn(Node* node) {
+            node->items.shrink_to_fit();
+            node->children.shrink_to_fit();
+            for (const Child& child : node->children) {
+                shrinkIn(child.node);
+            }
+        }
+    };
+} // namespace teks
@@ -1,10 +1,15 @@
 #pragma once
 
 #include <concepts>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <teks/buffer/types.hpp>
+#include <teks/buffer/ChunkHashTree.hpp>
+#include <teks/MemoryUsage.hpp>
 
 #ifndef TEKS_BUFFER_IMPL_STRING
 #error "TEKS_BUFFER_IMPL_STRING must be defined by build configuration"
@@ -19,6 +24,14 @@
 namespace teks::buffer {
     namespace concepts {
         // Buffer newlines must be normalized to LF style, and this must be maintained by all mutating methods
+        //
+        // Every backend stays within these costs, with n the buffer's `size()`. `buffer_complexity_test.cpp`
+        // times each operation at growing sizes and fails when one grows faster.
+        // - Constructing from text and each mutating method: O(n) plus what is inserted.
+        // - `size`, `empty`, `lineCount` and `contentHash`: O(1).
+        // - `lineRange`, `positionOf` and `offsetOf`: O(log n) plus a scan bounded by the backend's block
+        //   or chunk size, not by n.
+        // - `readString` and `invalidUtf8Runs`: O(log n) plus the size of the range.
         template <typename T>
         concept Buffer = requires(
             T buffer,
@@ -26,8 +39,20 @@ namespace teks::buffer {
             Offset at,
             Range range,
             std::string_view content,
-            u64 line
+            std::span<const Replacement> replacements,
+            const ChunkReader& reader,
+            u64 line,
+            Position position,
+            ColumnUnit unit
         ) {
+            // Buffers are allocator-aware like the `std::pmr` containers: what they hold and the temporaries
+            // of their edits come from the memory resource they were constructed with.
+            typename T::allocator_type;
+            requires std::same_as<typename T::allocator_type, std::pmr::polymorphic_allocator<>>;
+            requires std::constructible_from<T, typename T::allocator_type>;
+            requires std::constructible_from<T, std::string, typename T::allocator_type>;
+            { constBuffer.get_allocator() } -> std::same_as<typename T::allocator_type>;
+
             { constBuffer.size() } -> std::same_as<Bytes>;
             { constBuffer.empty() } -> std::same_as<bool>;
 
@@ -36,6 +61,11 @@ namespace teks::buffer {
             // Returns success.
             { buffer.insert(at, content) } -> std::same_as<bool>;
 
+            // Like inserting everything `reader` returns, with newlines split between chunks normalized as one.
+            // Only a chunk at a time is normalized, so a large paste or file needs no copy of itself.
+            // `reader` is not called on failure.
+            { buffer.insert(at, reader) } -> std::same_as<bool>;
+
             // `erase` succeeds if `range` is in `[0, size()]`.
             // On success `[range.start(), range.end())` is removed; on failure no changes are made.
             // Returns success.
@@ -46,6 +76,13 @@ namespace teks::buffer {
             // Returns success.
             { buffer.replace(range, content) } -> std::same_as<bool>;
 
+            // `replaceEach` succeeds if every range is in `[0, size()]` and each one ends at or before the next
+            // one starts, all in the buffer as it is before the call.
+            // On success every range is replaced with its content at once, so many edits cost one pass over the
+            // text between the first and the last and one move of the text after it, rather than a move of the
+            // rest of the buffer per edit; on failure no changes are made. Returns success.
+            { buffer.replaceEach(replacements) } -> std::same_as<bool>;
+
             // `readString` succeeds if `range` is in `[0, size()]`.
             // On success it returns the bytes in `range`; on failure it returns `std::nullopt`.
             { constBuffer.readString(range) } -> std::same_as<std::optional<std::string>>;
@@ -53,6 +90,31 @@ namespace teks::buffer {
             { constBuffer.lineCount() } -> std::same_as<usize>;
 
             { constBuffer.lineRange(line) } -> std::same_as<std::optional<Range>>;
+
+            // `invalidUtf8Runs` succeeds if `range` is in `[0, size()]`.
+            // On success it returns the runs of bytes in `range` that are not valid UTF-8, clipped to `range`;
+            // on failure it returns `std::nullopt`. Text outside these runs can be decoded without validation.
+            { constBuffer.invalidUtf8Runs(range) } -> std::same_as<std::optional<std::vector<Range>>>;
+
+            // `positionOf` succeeds if `at` is in `[0, size()]`.
+            // On success it returns the line containing `at` and the number of `unit`s between the line start and `at`,
+            // an offset inside a codepoint counts that codepoint. On failure it returns `std::nullopt`.
+            { constBuffer.positionOf(at, unit) } -> std::same_as<std::optional<Position>>;
+
+            // `offsetOf` succeeds if `position.line` is in `[0, lineCount())` and `position.column` is at most the
+            // number of `unit`s in that line. On success it returns the offset of the codepoint containing that
+            // unit, or the line end; on failure it returns `std::nullopt`.
+            { constBuffer.offsetOf(position, unit) } -> std::same_as<std::optional<Offset>>;
+
+            // Hashes kept up to date by the mutating methods. Equal content has an equal `contentHash()`, and
+            // `chunkHashes().diffRegions()` finds where two buffers differ without reading either of them.
+            { constBuffer.contentHash() } -> std::same_as<u64>;
+            { constBuffer.chunkHashes() } -> std::same_as<const ChunkHashTree&>;
+
+            // What the buffer holds, the text, its line index and its caches, apart from the capacity
+            // allocated past them. `shrinkToFit` releases that capacity, leaving the content as it was.
+            { constBuffer.memoryUsage() } -> std::same_as<MemoryUsage>;
+            { buffer.shrinkToFit() } -> std::same_as<void>;
         };
     } // namespace concepts
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <teks/MemoryUsage.hpp>
+#include <teks/SumTree.hpp>
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace teks::buffer {
+    // XXH64 hashes of content-defined chunks of a text, in a `SumTree` of their sizes and combined hashes.
+    // Chunk boundaries are picked by a rolling hash of the bytes since the chunk start, so the same text
+    // always has the same chunks, an edit only moves the boundaries near it, and equal regions of two
+    // texts are equal chunks even when shifted. Inner nodes hash the concatenation of their children's
+    // chunk hashes, so the root is the same however the text got to its content. Edits are O(log chunks)
+    // plus the chunks they rehash.
+    //
+    // Like `Utf8Index` it does not own the text, each update is given the text it describes.
+    struct ChunkHashTree {
+        // Chunks are cut where the rolling hash matches, never shorter than the minimum (except at the
+        // end of the text) nor longer than the maximum
+        static constexpr u64 minChunkBytes = 1024;
+        static constexpr u64 maxChunkBytes = 16 * 1024;
+
+        // A region where two texts differ, `here` in this one and `there` in the other
+        struct Region {
+            Range here;
+            Range there;
+
+            [[nodiscard]] friend bool operator==(const Region&, const Region&) = default;
+        };
+
+        ChunkHashTree();
+        explicit ChunkHashTree(std::string_view text);
+
+        // `text` is the content after `removed` bytes at `at` were replaced with `inserted` bytes.
+        // Chunks are rehashed from the one containing `at` until a boundary lines up with an old one.
+        void replaced(std::string_view text, Offset at, Bytes removed, Bytes inserted);
+
+        // `text` is the content after `replacements` (sorted, ranges in the text before them, content as
+        // inserted) were applied at once. Like `replaced` for each of them, but edits close enough that
+        // their rehashing runs into each other are rehashed together.
+        void replacedEach(std::string_view text, std::span<const Replacement> replacements);
+
+        // Hash of the whole text, O(1). Equal texts have equal hashes.
+        [[nodiscard]] u64 contentHash() const;
+        [[nodiscard]] usize chunkCount() const;
+        [[nodiscard]] HeapBytes heapBytes() const;
+        // Releases unused capacity
+        void shrinkToFit();
+
+        // The regions where this text differs from `other`'s, in order, without reading either text.
+        // Chunks are matched by hash and size. The common start and end are found by binary search on
+        // the combined hashes, O(log² chunks), and only the chunks in between are copied out and diffed.
+        // Regions are whole chunks, so they can be larger than the actual changes.
+        [[nodiscard]] std::vector<Region> diffRegions(const ChunkHashTree& other) const;
+
+    private:
+        struct Chunk {
+            u64 bytes;
+            u64 hash;
+        };
+
+        // The bytes of a run of chunks, their combined hash, and the multiplier that shifts it past one
+        // more run of as many chunks. The empty run is the identity.
+        struct Summary {
+            u64 bytes{0};
+            u64 hash{0};
+            u64 power{1};
+
+            friend Summary operator+(const Summary& left, const Summary& right) {
+                return Summary{left.bytes + right.bytes, left.hash * right.power + right.hash, left.power * right.power};
+            }
+        };
+
+        struct Summarize {
+            Summary operator()(const Chunk& chunk) const;
+        };
+
+        SumTree<Chunk, Summary, Summarize> chunks_;
+
+        [[nodiscard]] static u64 cutLength(std::string_view text);
+
+        // The chunk containing `at` and where it starts, the last chunk for the end of the text.
+        // There must be chunks.
+        [[nodiscard]] std::pair<usize, u64> chunkAt(u64 at) const;
+    };
+} // namespace teks::buffer
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/MemoryUsage.hpp>
+#include <teks/types.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace teks::buffer {
+    // Append-only log of a document's unsaved edits, for recovering them after a crash.
+    // The journal starts from the content of the last saved file, identified by its buffer's content
+    // hash, and holds edits and checkpoints (whole snapshots of the content) made since.
+    //
+    // Recording only queues: a writer thread appends what is queued every `commitInterval` and syncs
+    // it to disk once per batch, so the thread editing never waits on the disk. A crash loses at most
+    // the last interval of edits, and a record torn by a crash ends recovery rather than failing it.
+    // Only a crash leaves a journal behind: destroying it removes the file, so edits abandoned by
+    // closing without saving are not recovered the next time the file is opened.
+    struct Journal {
+        static constexpr std::chrono::milliseconds commitInterval{200};
+        // Once the edits since the last checkpoint are this large, `wantsCheckpoint` asks for one
+        static constexpr u64 checkpointBytes = 8 << 20;
+
+        // Where the journal of the file at `path` lives, beside it and hidden
+        [[nodiscard]] static std::filesystem::path pathFor(const std::filesystem::path& path);
+
+        // Replays the journal at `path` onto `buffer`, which must hold the content the journal
+        // started from, checkpoints included. Returns whether anything was recovered; nothing is
+        // changed when the journal is missing, unreadable or belongs to other content.
+        static bool recover(const std::filesystem::path& path, Buffer& buffer);
+
+        // Starts a new journal at `path` from content with `baseHash`, replacing any journal there
+        Journal(std::filesystem::path path, u64 baseHash);
+        Journal(const Journal&) = delete;
+        Journal& operator=(const Journal&) = delete;
+
+        // Drops what is queued and removes the file
+        ~Journal();
+
+        // `range` of the content was replaced with `content`, which must already be normalized
+        void recordReplace(Range range, std::string_view content);
+
+        // Edits applied together by `Buffer::replaceEach`, queued at once. They are recorded one at a
+        // time, each moved by the ones before it, so recovery replays them like any other edit.
+        void recordReplaceEach(std::span<const Replacement> replacements);
+
+        // Compacts the journal to a snapshot of the current `content`, edits before it are dropped
+        void checkpoint(std::string content);
+
+        // The content was saved or reloaded, whatever the journal holds is no longer needed
+        void restart(u64 baseHash);
+
+        // Whether the edits since the last checkpoint are large, or a write failed and the file must
+        // be rewritten whole for the edits after it to recover
+        [[nodiscard]] bool wantsCheckpoint() const;
+
+        // Blocks until everything recorded so far is written and synced, rather than within
+        // `commitInterval`
+        void flush();
+
+        // What is recorded but not written yet. The edit history itself is on disk.
+        [[nodiscard]] HeapBytes queuedBytes() const;
+
+    private:
+        // Bytes to write, or when `restart` is set, a new journal file to replace the old one with
+        struct Pending {
+            std::string bytes;
+            bool restart;
+            bool holdsEdits;
+        };
+
+        std::filesystem::path path_;
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        // notified once the writer has written everything queued
+        std::condition_variable idle_;
+        std::vector<Pending> pending_;
+        bool stopping_{false};
+        bool flushing_{false};
+        bool writing_{false};
+        // only touched by the thread recording
+        u64 baseHash_;
+        u64 bytesSinceCheckpoint_{0};
+        // set by the writer thread when a write fails, cleared by the thread recording as it queues a
+        // checkpoint or restart
+        std::atomic<bool> writeFailed_{false};
+        // only touched by the writer thread: after a failed write, records are dropped until the next
+        // checkpoint or restart, as the file lacks what they apply to
+        bool broken_{false};
+        std::string heldHeader_;
+        std::thread writer_;
+
+        void enqueue(Pending pending);
+        void run();
+        void write(std::vector<Pending>& batch);
+    };
+} // namespace teks::buffer
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/types.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace teks::buffer {
+    // The lines of a buffer containing a pattern, a read-only projection that keeps only the indices
+    // of the matching lines, 8 bytes per match, rather than a copy of their text.
+    //
+    // Building it splits the buffer's lines into contiguous slices scanned by separate threads.
+    // Afterwards it is kept up to date from the lines each edit replaced, rescanning only those.
+    // A pattern never spans lines, one containing a newline matches nothing.
+    struct LineFilter {
+        // Lines `[first, first + removed)` of the filter were replaced with `inserted` lines
+        struct LinesReplaced {
+            usize first;
+            usize removed;
+            usize inserted;
+        };
+
+        // Up to `threads` threads scan the buffer, 0 picks one per hardware thread
+        LineFilter(const Buffer& buffer, std::string pattern, usize threads = 0);
+
+        [[nodiscard]] const std::string& pattern() const;
+
+        // Number of matching lines
+        [[nodiscard]] usize lineCount() const;
+
+        // The buffer line shown as `line`, which must be less than `lineCount()`
+        [[nodiscard]] usize sourceLine(usize line) const;
+
+        // The first line showing `sourceLine` or a buffer line after it, `lineCount()` when none does
+        [[nodiscard]] usize lineAtOrAfter(usize sourceLine) const;
+
+        // Buffer lines `[first, first + removed)` were replaced with `inserted` lines, `buffer` is the
+        // buffer after the change. Returns how the filter's lines changed.
+        LinesReplaced replaceLines(const Buffer& buffer, usize first, usize removed, usize inserted);
+
+    private:
+        std::string pattern_;
+        usize threads_;
+        // sorted buffer line indices
+        std::vector<usize> lines_;
+
+        // Matching buffer lines in `[first, last)`
+        [[nodiscard]] std::vector<usize> scan(const Buffer& buffer, usize first, usize last) const;
+    };
+} // namespace teks::buffer
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <teks/MemoryUsage.hpp>
+#include <teks/SumTree.hpp>
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <array>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace teks::buffer {
+    // Start offsets of the lines of a text, compressed to about a byte and a half per line instead of
+    // the 8 of a `std::vector<Offset>`.
+    //
+    // The lengths of the lines, newline included, are grouped into blocks of at most `blockLines` as
+    // LEB128 varints, one byte for lines up to 127 bytes. The last line, which has no newline, is not
+    // kept. The blocks are the items of a `SumTree` summing their lines and bytes, so a block only
+    // knows its own lines and no edit moves the blocks after it. Finding a line is O(log blocks) plus
+    // decoding at most one block, an edit re-encodes the blocks it touches, O(log blocks) plus the
+    // lines it inserts.
+    //
+    // Like `Utf8Index` it does not own the text, each update is given the text it describes. The tree,
+    // and the lengths and blocks decoded while editing are allocated from its allocator.
+    struct LineStartIndex {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        static constexpr usize blockLines = 64;
+        // Encoded bytes a block has room for, so that one is 96 bytes
+        static constexpr usize blockBytes = 86;
+
+        // The empty text, one line starting at 0
+        LineStartIndex();
+        explicit LineStartIndex(allocator_type allocator);
+        explicit LineStartIndex(std::string_view text, allocator_type allocator = {});
+        LineStartIndex(const LineStartIndex& other) = default;
+        LineStartIndex(const LineStartIndex& other, allocator_type allocator);
+        LineStartIndex(LineStartIndex&& other) noexcept = default;
+        LineStartIndex(LineStartIndex&& other, allocator_type allocator);
+
+        ~LineStartIndex() = default;
+
+        LineStartIndex& operator=(const LineStartIndex&) = default;
+        LineStartIndex& operator=(LineStartIndex&&) = default;
+
+        [[nodiscard]] allocator_type get_allocator() const;
+
+        [[nodiscard]] usize lineCount() const;
+
+        // `line` must be less than `lineCount()`
+        [[nodiscard]] Offset lineStart(usize line) const;
+
+        // `line` without its newline, the last line ends at `textSize`.
+        // `line` must be less than `lineCount()`.
+        [[nodiscard]] Range lineRange(usize line, Bytes textSize) const;
+
+        // The last line starting at or before `at`
+        [[nodiscard]] usize lineAt(Offset at) const;
+
+        // `text` is the content after `size` bytes were inserted at `at`
+        void inserted(std::string_view text, Offset at, Bytes size);
+
+        // `range` was erased, the lines starting inside it or just after it are merged into the line
+        // containing `range.start()`
+        void erased(Range range);
+
+        // Bytes held, including unused capacity
+        [[nodiscard]] usize memoryBytes() const;
+        [[nodiscard]] HeapBytes heapBytes() const;
+        // Releases unused capacity
+        void shrinkToFit();
+
+    private:
+        struct Block {
+            // the lengths of its lines summed
+            u64 bytes{0};
+            u8 lines{0};
+            u8 encoded{0};
+            std::array<u8, blockBytes> lengths{};
+        };
+
+        struct Summary {
+            usize lines{0};
+            u64 bytes{0};
+
+            friend Summary operator+(const Summary& left, const Summary& right) {
+                return Summary{left.lines + right.lines, left.bytes + right.bytes};
+            }
+        };
+
+        struct Summarize {
+            Summary operator()(const Block& block) const {
+                return Summary{block.lines, block.bytes};
+            }
+        };
+
+        SumTree<Block, Summary, Summarize> blocks_;
+
+        // Adds a line of `length` bytes to the last of `blocks`, or to a new one once that is full
+        static void appendLength(u64 length, std::pmr::vector<Block>& blocks);
+        static void decodeBlock(const Block& block, std::pmr::vector<u64>& lengths);
+
+        // The block holding the line that contains `at`, its index and the bytes before it. Offsets on
+        // the last line give the last block, `blocks_.size()` when there is none.
+        [[nodiscard]] std::pair<usize, u64> blockAt(u64 at) const;
+
+        // Replaces blocks `[first, last)` with blocks holding `lengths`. A few lengths are joined by the
+        // next block, so blocks stay near full.
+        void replaceBlocks(usize first, usize last, std::pmr::vector<u64> lengths);
+    };
+} // namespace teks::buffer
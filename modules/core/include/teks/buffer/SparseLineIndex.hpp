@@ -0,0 +1,64 @@
+#pragma once
+
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace teks::buffer {
+    // Line starts of a read-only text too large to index every line of, such as a mapped file.
+    // Only the start of every `interval`th line is kept, so memory is 8 bytes per `interval` lines.
+    // A line is found from the checkpoint before it by scanning at most `interval` lines.
+    //
+    // The text is indexed lazily from the start, `indexSome` a slice at a time or as far as a lookup
+    // needs. Until it is complete the line count is estimated from the lines seen so far.
+    // Like `Utf8Index` it does not own the text, each call is given the text it describes.
+    struct SparseLineIndex {
+        static constexpr usize defaultInterval = 4096;
+
+        explicit SparseLineIndex(usize interval = defaultInterval);
+
+        // Indexes up to `bytes` more of `text`. Returns whether any of it is still to be indexed.
+        bool indexSome(std::string_view text, u64 bytes);
+
+        [[nodiscard]] bool complete(std::string_view text) const;
+        [[nodiscard]] Bytes indexedBytes() const;
+
+        // The exact line count once the whole text is indexed
+        [[nodiscard]] std::optional<usize> lineCount(std::string_view text) const;
+
+        // The line count extrapolated from the average line length so far, exact once complete
+        [[nodiscard]] usize estimatedLineCount(std::string_view text) const;
+
+        // The range of `line` without its newline, indexing as far as needed to find it.
+        // Returns `std::nullopt` past the last line.
+        [[nodiscard]] std::optional<Range> lineRange(std::string_view text, usize line);
+
+        // The start of `line` like `lineRange`, without scanning to its end
+        [[nodiscard]] std::optional<Offset> lineStart(std::string_view text, usize line);
+
+        // The line containing `at`. Returns `std::nullopt` when `at` has not been indexed yet.
+        [[nodiscard]] std::optional<usize> lineOf(std::string_view text, Offset at) const;
+
+        // Start of the line containing `at`, scanning back from it rather than using an index
+        [[nodiscard]] static Offset lineStartAt(std::string_view text, Offset at);
+
+        // End of the line starting at `at`, before its newline
+        [[nodiscard]] static Offset lineEndAt(std::string_view text, Offset at);
+
+        // Like `lineStartAt` and `lineEndAt`, scanning at most `maxBytes`. A line longer than that is
+        // split into rows of `maxBytes`, cut between codepoints, and a row that does not end its line
+        // ends where the next row starts, rather than before a newline.
+        [[nodiscard]] static Offset rowStartAt(std::string_view text, Offset at, u64 maxBytes);
+        [[nodiscard]] static Offset rowEndAt(std::string_view text, Offset at, u64 maxBytes);
+
+    private:
+        usize interval_;
+        // `checkpoints_[i]` is the start of line `i * interval_`
+        std::vector<Offset> checkpoints_;
+        Offset indexed_;
+        // newlines in `[0, indexed_)`
+        usize newlines_{0};
+    };
+} // namespace teks::buffer
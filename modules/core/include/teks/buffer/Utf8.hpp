@@ -0,0 +1,57 @@
+#pragma once
+
+#include <teks/MemoryUsage.hpp>
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace teks::buffer {
+    // Length of the longest prefix of `text` that is ASCII, scanned 16 bytes at a time
+    [[nodiscard]] usize asciiPrefix(std::string_view text);
+
+    // Length of the longest prefix of `text` that is valid UTF-8.
+    // Runs of ASCII are skipped 16 bytes at a time with SSE2 or NEON where available.
+    [[nodiscard]] usize validUtf8Prefix(std::string_view text);
+
+    // Decodes `text` to UTF-16 without validating it, `out` must have room for `text.size()` units.
+    // Returns the number of units written. Only meant for text known to be valid, anything that is
+    // not (a truncated sequence at the end, a stray continuation byte) becomes U+FFFD.
+    usize decodeValidUtf8(std::string_view text, char16_t* out);
+
+    // Sorted runs of bytes that are not part of a valid UTF-8 sequence, adjacent runs are merged.
+    // Invalid bytes are grouped the way the Unicode "maximal subpart" practice does, so a truncated
+    // sequence is one unit however many of its bytes are present.
+    struct InvalidUtf8Runs {
+        InvalidUtf8Runs() = default;
+        explicit InvalidUtf8Runs(std::string_view text);
+
+        // Scans `text`, which starts at `base` and follows the text already scanned. `text` must start
+        // at a sequence boundary, so the load path scans one line at a time as it copies it.
+        void append(std::string_view text, Offset base);
+
+        // Updates the runs after `removed` bytes at `at` were replaced with `inserted` bytes, `text` is the
+        // content after the change. Only the sequences around the change are rescanned.
+        void replaced(std::string_view text, Offset at, Bytes removed, Bytes inserted);
+        // Updates the runs after each of `replacements`, sorted and not overlapping, was applied in one
+        // step, `text` is the content after them. Only the sequences around each of them are rescanned and
+        // the other runs are moved once.
+        void replacedEach(std::string_view text, std::span<const Replacement> replacements);
+
+        [[nodiscard]] bool empty() const;
+        [[nodiscard]] const std::vector<Range>& runs() const;
+        [[nodiscard]] HeapBytes heapBytes() const;
+        // Releases unused capacity
+        void shrinkToFit();
+
+        // The runs intersecting `range`, clipped to it
+        [[nodiscard]] std::vector<Range> within(Range range) const;
+
+    private:
+        std::vector<Range> runs_;
+
+        // index of the first run that ends after `at`
+        [[nodiscard]] usize firstRunEndingAfter(Offset at) const;
+    };
+} // namespace teks::buffer
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <teks/MemoryUsage.hpp>
+#include <teks/SumTree.hpp>
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace teks::buffer {
+    // Codepoint and UTF-16 code unit counts of a UTF-8 text, cached per chunk of bytes in a `SumTree`.
+    // Converting between byte offsets and unit indices is O(log chunks) plus a scan of at most one
+    // chunk, an edit is O(log chunks) plus the bytes it inserts and erases. The index does not own the
+    // text, each call is given the text it describes.
+    //
+    // Counting is per byte, so malformed UTF-8 still has well defined counts: every byte that is not
+    // a continuation byte is one codepoint, and lead bytes of 4 byte sequences are two UTF-16 units.
+    struct Utf8Index {
+        // Chunks are split once they grow past twice this
+        static constexpr u64 chunkBytes = 4096;
+
+        Utf8Index() = default;
+        explicit Utf8Index(std::string_view text);
+
+        // `text` is the content after `size` bytes were inserted at `at`
+        void inserted(std::string_view text, Offset at, Bytes size);
+
+        // `text` is the content before `range` is erased
+        void erasing(std::string_view text, Range range);
+
+        // `text` is the content after `replacements` (sorted, ranges in the content before them, content
+        // as inserted) were applied at once, and `replaced` what the content before held from the first
+        // range's start to the last one's end. Like an erase and an insert for each of them.
+        void replacedEach(std::string_view replaced, std::string_view text, std::span<const Replacement> replacements);
+
+        [[nodiscard]] Bytes size() const;
+        [[nodiscard]] HeapBytes heapBytes() const;
+        // Releases unused capacity
+        void shrinkToFit();
+
+        // Number of `unit`s in `[0, at)`, an offset inside a codepoint counts that codepoint
+        [[nodiscard]] u64 unitsBefore(std::string_view text, Offset at, ColumnUnit unit) const;
+
+        // Offset of the codepoint containing unit `index`, or the end of the text when `index` is
+        // the total. An index in the middle of a surrogate pair gives the start of its codepoint.
+        // Returns `std::nullopt` past the end.
+        [[nodiscard]] std::optional<Offset> offsetOfUnit(std::string_view text, u64 index, ColumnUnit unit) const;
+
+    private:
+        // a chunk's counts, and summed those of a run of chunks
+        struct Counts {
+            u64 bytes{0};
+            u64 codepoints{0};
+            u64 utf16{0};
+
+            friend Counts operator+(const Counts& left, const Counts& right) {
+                return Counts{left.bytes + right.bytes, left.codepoints + right.codepoints, left.utf16 + right.utf16};
+            }
+
+            friend Counts operator-(const Counts& left, const Counts& right) {
+                return Counts{left.bytes - right.bytes, left.codepoints - right.codepoints, left.utf16 - right.utf16};
+            }
+        };
+
+        struct Summarize {
+            const Counts& operator()(const Counts& counts) const {
+                return counts;
+            }
+        };
+
+        SumTree<Counts, Counts, Summarize> chunks_;
+
+        [[nodiscard]] static Counts count(std::string_view text);
+        [[nodiscard]] static u64 unitsOf(const Counts& counts, ColumnUnit unit);
+
+        // The chunk containing `at` and the counts before it. Appending goes into the last chunk, so
+        // the end of the text gives that, and `chunks_.size()` when there is none.
+        [[nodiscard]] std::pair<usize, Counts> chunkAt(u64 at) const;
+
+        // Adds what `added` counts to the chunk containing `at`, or a first chunk to an empty index
+        void add(u64 at, const Counts& added);
+        // Subtracts the counts of `erased`, the bytes at `at`, dropping the chunks it empties
+        void erase(u64 at, std::string_view erased);
+        // Splits the chunk containing `at` in `text` into `chunkBytes` pieces once it grew past twice that
+        void splitAt(std::string_view text, u64 at);
+    };
+} // namespace teks::buffer
@@ -1,43 +1,77 @@
 #pragma once
 
+#include <teks/MemoryUsage.hpp>
 #include <teks/types.hpp>
 #include <teks/buffer/types.hpp>
+#include <teks/buffer/ChunkHashTree.hpp>
+#include <teks/buffer/LineStartIndex.hpp>
 #include <teks/buffer/NewlineStyleSet.hpp>
+#include <teks/buffer/Utf8.hpp>
+#include <teks/buffer/Utf8Index.hpp>
+#include <memory_resource>
 #include <string_view>
 #include <string>
 #include <optional>
+#include <span>
 #include <vector>
 
 namespace teks::buffer {
-    // Buffer text is expected to be LF-normalized, and mutating methods must preserve that invariant
+    // Buffer text is expected to be LF-normalized, and mutating methods must preserve that invariant.
+    //
+    // Allocator-aware like the `std::pmr` containers: the text, the line index and the temporaries of
+    // edits are allocated from the buffer's memory resource, the default one unless it is given one.
+    // Copies use the default resource unless given one, moves keep the source's.
     struct StringBuffer {
-        static std::pair<StringBuffer, NewlineStyleSet> fromRawText(std::string);
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        static std::pair<StringBuffer, NewlineStyleSet> fromRawText(std::string, allocator_type allocator = {});
 
         StringBuffer() = default;
+        explicit StringBuffer(allocator_type allocator);
         StringBuffer(std::string);
+        StringBuffer(std::string text, allocator_type allocator);
         StringBuffer(const StringBuffer&) = default;
+        StringBuffer(const StringBuffer& other, allocator_type allocator);
         StringBuffer(StringBuffer&&) noexcept = default;
+        StringBuffer(StringBuffer&& other, allocator_type allocator);
 
         ~StringBuffer() = default;
 
         StringBuffer& operator=(const StringBuffer&) = default;
         StringBuffer& operator=(StringBuffer&&) noexcept = default;
 
+        [[nodiscard]] allocator_type get_allocator() const;
         [[nodiscard]] Bytes size() const;
         [[nodiscard]] bool empty() const;
         bool insert(Offset at, std::string_view content);
+        bool insert(Offset at, const ChunkReader& reader);
         bool erase(Range range);
         bool replace(Range range, std::string_view content);
+        bool replaceEach(std::span<const Replacement> replacements);
         [[nodiscard]] std::optional<std::string> readString(Range range) const;
         [[nodiscard]] usize lineCount() const;
         [[nodiscard]] std::optional<Range> lineRange(usize line) const;
+        [[nodiscard]] std::optional<std::vector<Range>> invalidUtf8Runs(Range range) const;
+        [[nodiscard]] std::optional<Position> positionOf(Offset at, ColumnUnit unit) const;
+        [[nodiscard]] std::optional<Offset> offsetOf(Position position, ColumnUnit unit) const;
+        [[nodiscard]] u64 contentHash() const;
+        [[nodiscard]] const ChunkHashTree& chunkHashes() const;
+        [[nodiscard]] MemoryUsage memoryUsage() const;
+        void shrinkToFit();
 
     private:
-        std::string value_;
-        std::vector<Offset> lineStarts_{1, Offset(0)};
+        std::pmr::string value_;
+        LineStartIndex lineStarts_;
+        Utf8Index utf8Index_;
+        InvalidUtf8Runs invalidUtf8_;
+        ChunkHashTree chunkHashes_;
 
-        StringBuffer(std::string text, std::vector<Offset> lineStarts);
+        StringBuffer(std::pmr::string text, InvalidUtf8Runs invalidUtf8);
 
-        usize firstLineIndexAfterOffset(Offset at) const;
+        // `insert` and `erase` once they are known to be in bounds
+        void insertUnchecked(Offset at, std::string_view content);
+        void eraseUnchecked(Range range);
+        // Updates the indices for `size` bytes inserted into the text at `at`
+        void inserted(Offset at, Bytes size);
     };
 } // namespace teks::buffer
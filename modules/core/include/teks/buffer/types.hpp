@@ -1,8 +1,10 @@
 #pragma once
 
 #include <compare>
+#include <functional>
 #include <limits>
 #include <optional>
+#include <string_view>
 #include <teks/assert.hpp>
 #include <teks/types.hpp>
 
@@ -97,6 +99,32 @@ namespace teks::buffer {
         Range(Offset start, Bytes size);
     };
 
+    // `range` replaced with `content`, one of several edits applied together
+    struct Replacement {
+        Range range;
+        std::string_view content;
+    };
+
+    // Returns the next chunk of text being streamed in, empty once there is no more. A chunk only has to stay
+    // valid until the reader is called again, so the text never has to be in memory all at once.
+    using ChunkReader = std::function<std::string_view()>;
+
+    // What a `Position` column counts, UTF-16 code units are what Qt uses for string indices
+    enum class ColumnUnit : u8 {
+        Codepoint,
+        Utf16,
+    };
+
+    // A line and a column within that line, in some `ColumnUnit`
+    struct Position {
+        usize line{0};
+        u64 column{0};
+
+        [[nodiscard]] friend constexpr bool operator==(const Position&, const Position&) = default;
+        [[nodiscard]] friend constexpr
+        std::strong_ordering operator<=>(const Position&, const Position&) = default;
+    };
+
     [[nodiscard]] inline constexpr bool addWillOverflow(Bytes lhs, Bytes rhs) {
         return lhs > Bytes(Bytes::maxValue()) - rhs;
     }
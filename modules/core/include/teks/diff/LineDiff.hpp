@@ -0,0 +1,34 @@
+#pragma once
+
+#include <teks/buffer/types.hpp>
+#include <teks/types.hpp>
+#include <string_view>
+#include <vector>
+
+namespace teks::diff {
+    // Lines `[first, first + removed)` of the old text are replaced with lines
+    // `[insertedFirst, insertedFirst + inserted)` of the new text
+    struct LineEdit {
+        usize first;
+        usize removed;
+        usize insertedFirst;
+        usize inserted;
+        // the same lines as bytes of the old and new text
+        buffer::Range removedBytes;
+        buffer::Range insertedBytes;
+
+        [[nodiscard]] friend bool operator==(const LineEdit&, const LineEdit&) = default;
+    };
+
+    // Past this many differing lines the search stops looking for a minimal result, and what remains
+    // between the common start and end is replaced whole
+    inline constexpr usize maxEditDistance = 1024;
+
+    // The edits turning `before` into `after`, in increasing order and separated by unchanged lines.
+    // A line includes its newline, and the text after the last newline is a line even when empty, so
+    // the lines are the lines of a buffer holding the text.
+    //
+    // The common start and end are skipped by comparing bytes, then the lines in between are hashed
+    // and diffed with Myers' algorithm, so the cost follows the size of the changed region.
+    [[nodiscard]] std::vector<LineEdit> diffLines(std::string_view before, std::string_view after);
+} // namespace teks::diff
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <functional>
+#include <vector>
+
+namespace teks::diff {
+    // Elements `[beforeStart, beforeEnd)` of the old sequence are replaced with elements
+    // `[afterStart, afterEnd)` of the new one
+    struct Hunk {
+        usize beforeStart;
+        usize beforeEnd;
+        usize afterStart;
+        usize afterEnd;
+
+        [[nodiscard]] friend constexpr bool operator==(const Hunk&, const Hunk&) = default;
+    };
+
+    // The hunks turning a sequence of `beforeSize` elements into one of `afterSize`, in increasing order
+    // and separated by equal elements. `equal(i, j)` compares element `i` of the old sequence with
+    // element `j` of the new one.
+    //
+    // Myers' O((N + M)D) algorithm finds the fewest differing elements as long as there are at most
+    // `maxEditDistance` of them, otherwise everything is one hunk.
+    [[nodiscard]] std::vector<Hunk> diffSequences(
+        usize beforeSize,
+        usize afterSize,
+        const std::function<bool(usize, usize)>& equal,
+        usize maxEditDistance
+    );
+} // namespace teks::diff
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/Journal.hpp>
+#include <teks/buffer/NewlineStyleSet.hpp>
+#include <teks/encoding/Encoding.hpp>
+#include <teks/MemoryUsage.hpp>
+#include <teks/types.hpp>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+namespace teks::editor {
+    struct Document {
+        // Lines `[first, first + removed)` were replaced with `inserted` lines
+        struct LinesReplaced {
+            usize first;
+            usize removed;
+            usize inserted;
+        };
+
+        // One or more edits, as dependents need to know them: what was replaced, in bytes and in lines
+        struct Change {
+            // in the document as it was before the change
+            buffer::Range replaced;
+            buffer::Bytes inserted;
+            LinesReplaced lines;
+            // `generation()` once the change was made
+            u64 generation;
+        };
+
+        // A cursor: the caret is at `head` and the text between it and `anchor` is selected
+        struct Selection {
+            buffer::Offset anchor;
+            buffer::Offset head;
+
+            [[nodiscard]] buffer::Range range() const;
+        };
+
+        // Detects the file's encoding and converts it to UTF-8 as it is read. Edits left unsaved by a
+        // crash are recovered from the file's journal, and edits from here on are journaled.
+        static std::optional<Document> openFile(std::filesystem::path path);
+
+        Document();
+        Document(teks::buffer::Buffer);
+        Document(teks::buffer::Buffer, std::filesystem::path);
+        Document(Document&&) = default;
+        // the buffer would be moved into memory owned by the document being replaced
+        Document& operator=(Document&&) = delete;
+
+        teks::buffer::Buffer& buffer();
+        const teks::buffer::Buffer& buffer() const;
+        const std::filesystem::path& path() const;
+        const encoding::Encoding& encoding() const;
+
+        // Replaces `range` of the buffer with `content`, recording the edit in the journal and for
+        // `takeChanges`.
+        // Returns success, like `Buffer::replace`.
+        bool replace(buffer::Range range, std::string_view content);
+
+        // The cursors, sorted by offset and never overlapping, there is always at least one. They move
+        // with edits like markers: text inserted before a cursor pushes it along, and a cursor inside
+        // replaced text ends up after what replaced it.
+        [[nodiscard]] const std::vector<Selection>& selections() const;
+
+        // Sorts `selections` and merges the ones that overlap, offsets past the end are clamped to it.
+        // No selections leaves one caret at the start.
+        void setSelections(std::vector<Selection> selections);
+
+        // Replaces every selection with `text`, leaving a caret after each copy of it. All of them are
+        // one edit of the buffer, one journal entry and one change, however many cursors there are.
+        // Returns success, like `Buffer::replaceEach`.
+        bool insertAtSelections(std::string_view text);
+
+        // Erases every selection, and for each caret the codepoint before it (`eraseBackward`) or
+        // after it (`eraseForward`), as one edit like `insertAtSelections`
+        bool eraseBackward();
+        bool eraseForward();
+
+        // Counts the changes made to the document, caches compare it with the generation they are up to date with
+        [[nodiscard]] u64 generation() const;
+
+        // What the buffer holds, and as undo history the journal's edits not written yet. Small blocks
+        // freed back to the document's pool are kept by it and not counted.
+        [[nodiscard]] MemoryUsage memoryUsage() const;
+        // Releases the capacity the buffer and the pending changes hold past what they use
+        void shrinkToFit();
+
+        // The changes made since this was last called, in the order they were made. Edits that touch
+        // the one before them, like typed characters, are coalesced into one change, so calling this
+        // once per event loop tick gives dependents one change per burst of edits.
+        [[nodiscard]] std::vector<Change> takeChanges();
+
+        // Blocks until the journal has written and synced every edit made so far, rather than within
+        // `Journal::commitInterval`. Documents without a file have no journal and return at once.
+        void flushJournal();
+
+        // Whether the buffer differs from what was last loaded or saved, O(1) by comparing content hashes
+        bool modified() const;
+
+        // Whether the file changed on disk while the buffer had unsaved edits. Those edits are kept,
+        // so saving overwrites the change. Cleared by saving, or by reloading once nothing is unsaved.
+        [[nodiscard]] bool conflicted() const;
+
+        enum class SaveResult : u8 {
+            Saved,
+            // the file could not be written, it is left as it was
+            Failed,
+            // `encoding()` cannot represent some of the text, the file is left as it was
+            Lossy,
+        };
+
+        // Writes the document to `path()` in the encoding and newline style it was loaded with. The file
+        // is replaced whole once the new one is on disk, so a crash or a full disk leaves the old one,
+        // which the journal's edits still apply to. With `allowLossy`, text the encoding cannot represent
+        // is written anyway: codepoints outside Latin-1 as '?', and invalid UTF-8 in UTF-16 as U+FFFD.
+        SaveResult save(bool allowLossy = false);
+
+        // Appends whatever was written to the end of the file since it was loaded or last read,
+        // reading, decoding and normalizing only the new bytes. A file that shrank was truncated or
+        // replaced, and is reloaded. Returns the changes in the order they were made, none when
+        // nothing changed or the file cannot be read. They are also recorded for `takeChanges`.
+        // Nothing is read while the buffer has unsaved edits, the document is `conflicted()` instead.
+        std::vector<LinesReplaced> readAppended();
+
+        // Rereads the file and applies only the lines that differ from the buffer as edits, so
+        // unchanged lines keep their layout and highlighting. Returns the changes like `readAppended`.
+        // Unsaved edits are kept: with any, nothing is reloaded and a file that changed leaves the
+        // document `conflicted()`.
+        std::vector<LinesReplaced> reload();
+
+    private:
+        // Pools what the buffer allocates, its text, line index and the temporaries of edits, apart from
+        // other documents. Declared first so it outlives the buffer, and boxed so moves keep its address.
+        std::unique_ptr<std::pmr::unsynchronized_pool_resource> memory_;
+        teks::buffer::Buffer buffer_;
+        std::filesystem::path path_;
+        buffer::NewlineStyleSet newLineStyleSet_;
+        encoding::Encoding encoding_;
+        u64 savedContentHash_;
+        // how much of the file is in `buffer_`
+        u64 fileBytesRead_{0};
+        // decodes appended bytes, a code unit split between two reads stays pending in it
+        std::optional<encoding::Utf8Decoder> appendDecoder_;
+        // a "\r\n" split between two reads must not become two newlines
+        bool endsWithCr_{false};
+        // when `endsWithCr_`, the styles of the newlines before that '\r', which was counted as Cr
+        buffer::NewlineStyleSet newlineStylesBeforeCr_;
+        bool conflicted_{false};
+        // only documents opened from a file have one
+        std::unique_ptr<buffer::Journal> journal_;
+        u64 generation_{0};
+        std::vector<Change> changes_;
+        std::vector<Selection> selections_{Selection{}};
+
+        // Reads the file at `path` as it is on disk, without its journal
+        static std::optional<Document> readFile(std::filesystem::path path);
+
+        // `buffer` is moved into `memory`, copied when it was allocated from elsewhere
+        Document(
+            std::unique_ptr<std::pmr::unsynchronized_pool_resource> memory,
+            teks::buffer::Buffer buffer,
+            std::filesystem::path path,
+            buffer::NewlineStyleSet newLineStyleSet,
+            encoding::Encoding encoding
+        );
+
+        // Records an edit for `takeChanges`, merging it into the previous change if they touch
+        void recordChange(buffer::Range replaced, buffer::Bytes inserted, LinesReplaced lines);
+
+        // Moves the selections past an edit of `replaced` into `inserted` bytes
+        void moveSelections(buffer::Range replaced, buffer::Bytes inserted);
+
+        // Applies `edits`, one per selection and each covering it, then leaves a caret after each
+        bool replaceAtSelections(std::vector<buffer::Replacement> edits);
+
+        // Erases the selections, with the codepoint before or after each caret
+        bool eraseAtSelections(bool backward);
+    };
+}
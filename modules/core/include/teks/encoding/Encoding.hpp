@@ -0,0 +1,78 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <string>
+#include <string_view>
+
+namespace teks::encoding {
+    enum class Charset : u8 {
+        Utf8,
+        Utf16Le,
+        Utf16Be,
+        Latin1,
+    };
+
+    struct Encoding {
+        Charset charset{Charset::Utf8};
+        bool bom{false};
+
+        [[nodiscard]] friend constexpr bool operator==(const Encoding&, const Encoding&) = default;
+    };
+
+    // The byte order mark of `encoding`, empty when it has none
+    [[nodiscard]] std::string_view byteOrderMark(Encoding encoding);
+
+    // Guesses the encoding of a file from its first bytes, `complete` is whether `head` is the whole file.
+    // A byte order mark decides it; otherwise NUL bytes concentrated in even or odd positions mean
+    // UTF-16, and text that is not UTF-8 is Latin-1 unless valid multibyte sequences outnumber the
+    // invalid ones (UTF-8 with some damage is still shown as UTF-8).
+    [[nodiscard]] Encoding detectEncoding(std::string_view head, bool complete);
+
+    // Streaming conversion to UTF-8, chunks may split code units and sequences anywhere.
+    // The byte order mark is dropped, malformed input becomes U+FFFD.
+    struct Utf8Decoder {
+        explicit Utf8Decoder(Encoding encoding);
+
+        void decode(std::string_view chunk, std::string& out);
+
+        // Flushes whatever an incomplete final code unit or surrogate pair left pending
+        void finish(std::string& out);
+
+    private:
+        Encoding encoding_;
+        usize bomRemaining_;
+        std::string pending_;
+        char16_t pendingHighSurrogate_{0};
+
+        void decodeUtf16(std::string_view chunk, std::string& out);
+        void decodeUnit(char16_t unit, std::string& out);
+    };
+
+    // Streaming conversion from UTF-8, the inverse of `Utf8Decoder`.
+    // The byte order mark is written first when the encoding has one. Bytes that are not valid
+    // UTF-8 become U+FFFD, and codepoints Latin-1 cannot represent become '?'.
+    struct Utf8Encoder {
+        explicit Utf8Encoder(Encoding encoding);
+
+        void encode(std::string_view chunk, std::string& out);
+        void finish(std::string& out);
+
+        // Whether anything could not be represented exactly
+        [[nodiscard]] bool lossy() const;
+
+    private:
+        Encoding encoding_;
+        bool started_{false};
+        bool lossy_{false};
+        std::string pending_;
+        std::u16string units_;
+
+        // Returns how much of `text` was consumed, only an incomplete final sequence is left unless `final`
+        usize encodeSome(std::string_view text, std::string& out, bool final);
+        void encodeUnits(std::u16string_view units, std::string& out);
+    };
+
+    // Converts a whole text, convenience for the streaming types
+    [[nodiscard]] std::string decodeToUtf8(std::string_view text, Encoding encoding);
+    [[nodiscard]] std::string encodeFromUtf8(std::string_view text, Encoding encoding);
+} // namespace teks::encoding
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <string_view>
+
+namespace teks {
+    // XXH64 of `data`, matching the reference implementation on little-endian hosts.
+    // Fast and well distributed, not meant to resist deliberate collisions.
+    [[nodiscard]] u64 xxHash64(std::string_view data, u64 seed = 0);
+} // namespace teks
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <teks/highlight/Lexer.hpp>
+#include <functional>
+#include <set>
+#include <string>
+
+namespace teks::highlight {
+    // Describes a C-like language to `ConfigurableLexer` at runtime
+    struct LanguageConfig {
+        std::set<std::string, std::less<>> keywords;
+        std::set<std::string, std::less<>> types;
+        // empty when the language has no such comment
+        std::string lineComment;
+        std::string blockCommentOpen;
+        std::string blockCommentClose;
+        // each character opens and closes a string literal
+        std::string stringDelimiters;
+        char escape{'\\'};
+        // `#word` at the start of a line is a preprocessor directive
+        bool hashDirectives{false};
+    };
+
+    [[nodiscard]] LanguageConfig cppLanguageConfig();
+    [[nodiscard]] LanguageConfig jsonLanguageConfig();
+
+    // General purpose lexer driven by a `LanguageConfig`.
+    // Keyword lookup goes through an ordered set, so this favours flexibility over speed.
+    struct ConfigurableLexer final : Lexer {
+        explicit ConfigurableLexer(LanguageConfig config);
+
+        LexerState lexLine(
+            std::string_view line,
+            LexerState state,
+            std::vector<Token>& tokens
+        ) const override;
+
+    private:
+        LanguageConfig config_;
+    };
+} // namespace teks::highlight
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <teks/buffer/Buffer.hpp>
+#include <teks/highlight/Lexer.hpp>
+#include <teks/highlight/Token.hpp>
+#include <teks/MemoryUsage.hpp>
+#include <teks/types.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace teks::highlight {
+    // Tokens and lexer states of every line of a buffer, kept up to date incrementally.
+    //
+    // Lines `[0, validLines())` are known to be correct. After an edit only the edited lines are
+    // dropped; lexing restarts at the first edited line and stops as soon as a line that was not
+    // edited is reached with the same start state it was previously lexed with, at which point the
+    // cached lines after it are valid again up to the next edited line.
+    struct HighlightCache {
+        // Lines longer than this are not tokenized, their start state is carried through unchanged
+        static constexpr u64 maxLexedLineBytes = 64 * 1024;
+
+        explicit HighlightCache(std::shared_ptr<const Lexer> lexer, usize lineCount = 1);
+
+        // Discards everything
+        void reset(usize lineCount);
+
+        // Lines `[first, first + removed)` were replaced by `inserted` lines.
+        // A single line edited in place is `replaceLines(line, 1, 1)`.
+        void replaceLines(usize first, usize removed, usize inserted);
+
+        // Lexes up to and including `line` if needed
+        [[nodiscard]] const std::vector<Token>& tokens(const buffer::Buffer& buffer, usize line);
+
+        // Lexes past `validLines()` until `budget` elapses, returns whether lines remain to be lexed
+        bool lexSome(const buffer::Buffer& buffer, std::chrono::nanoseconds budget);
+
+        [[nodiscard]] usize lineCount() const;
+        [[nodiscard]] usize validLines() const;
+        // Total number of lines passed to the lexer, for measuring how much work edits cause
+        [[nodiscard]] u64 linesLexed() const;
+
+        // The tokens and states of every line, O(lines)
+        [[nodiscard]] HeapBytes heapBytes() const;
+        // Releases unused capacity
+        void shrinkToFit();
+
+    private:
+        struct Line {
+            std::vector<Token> tokens;
+            LexerState startState{0};
+            LexerState endState{0};
+            // set when the line's content changed since it was last lexed
+            bool edited{true};
+        };
+
+        std::shared_ptr<const Lexer> lexer_;
+        std::vector<Line> lines_;
+        usize validLines_{0};
+        // lines `[validLines_, cachedLines_)` hold results from before an edit that may still be reusable
+        usize cachedLines_{0};
+        u64 linesLexed_{0};
+
+        void lexNext(const buffer::Buffer& buffer);
+    };
+} // namespace teks::highlight
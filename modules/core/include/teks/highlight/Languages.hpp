@@ -0,0 +1,10 @@
+#pragma once
+
+#include <teks/highlight/Lexer.hpp>
+#include <memory>
+#include <string_view>
+
+namespace teks::highlight {
+    // Returns the lexer for a file extension such as ".cpp", or nullptr when there is none
+    [[nodiscard]] std::shared_ptr<const Lexer> lexerForExtension(std::string_view extension);
+} // namespace teks::highlight
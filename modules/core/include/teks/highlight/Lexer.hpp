@@ -0,0 +1,29 @@
+#pragma once
+
+#include <teks/highlight/Token.hpp>
+#include <string_view>
+#include <vector>
+
+namespace teks::highlight {
+    // Line-at-a-time tokenizer.
+    // Everything a lexer needs to know about previous lines must be encoded in the `LexerState`,
+    // this is what lets `HighlightCache` stop re-lexing once states converge after an edit.
+    struct Lexer {
+        Lexer() = default;
+        Lexer(const Lexer&) = default;
+        Lexer(Lexer&&) noexcept = default;
+
+        virtual ~Lexer() = default;
+
+        Lexer& operator=(const Lexer&) = default;
+        Lexer& operator=(Lexer&&) noexcept = default;
+
+        // Appends the tokens of `line` (without its newline) to `tokens` in order,
+        // returns the state at the end of the line.
+        virtual LexerState lexLine(
+            std::string_view line,
+            LexerState state,
+            std::vector<Token>& tokens
+        ) const = 0;
+    };
+} // namespace teks::highlight
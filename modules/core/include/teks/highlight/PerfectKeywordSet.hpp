@@ -0,0 +1,98 @@
+#pragma once
+
+#include <teks/highlight/Token.hpp>
+#include <teks/types.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <optional>
+#include <string_view>
+
+namespace teks::highlight {
+    struct KeywordEntry {
+        std::string_view word;
+        TokenKind kind;
+    };
+
+    // Keyword -> kind lookup with a collision free hash found at compile time.
+    // A lookup is one hash, one table load and at most one string comparison, with no allocation.
+    template <usize N>
+    struct PerfectKeywordSet {
+        static_assert(N > 0 && N < 255, "PerfectKeywordSet slots are u8 indices");
+
+        // sparse enough that a seed without collisions is found after a handful of attempts
+        static constexpr usize tableSize = std::bit_ceil(N * 8);
+        static constexpr u32 maxSeedAttempts = 4096;
+
+        [[nodiscard]] static constexpr u32 hash(std::string_view word, u32 seed) {
+            u32 h = (seed * 0x9E3779B9u) ^ static_cast<u32>(word.size());
+            for (char c : word) {
+                h = (h ^ static_cast<u8>(c)) * 0x01000193u;
+            }
+            return h ^ (h >> 15);
+        }
+
+        constexpr explicit PerfectKeywordSet(const std::array<KeywordEntry, N>& entries)
+            : entries_(entries)
+        {
+            for (const KeywordEntry& entry : entries_) {
+                minLength_ = std::min(minLength_, entry.word.size());
+                maxLength_ = std::max(maxLength_, entry.word.size());
+            }
+            for (usize i = 0; i < N; ++i) {
+                for (usize j = i + 1; j < N; ++j) {
+                    if (entries_[i].word == entries_[j].word) {
+                        return;
+                    }
+                }
+            }
+            for (u32 seed = 1; seed < maxSeedAttempts; ++seed) {
+                if (tryBuild(seed)) {
+                    seed_ = seed;
+                    return;
+                }
+            }
+        }
+
+        [[nodiscard]] constexpr const std::array<KeywordEntry, N>& entries() const {
+            return entries_;
+        }
+
+        // False if no perfect hash was found, or the entries contain duplicates
+        [[nodiscard]] constexpr bool valid() const {
+            return seed_ != 0;
+        }
+
+        [[nodiscard]] constexpr std::optional<TokenKind> find(std::string_view word) const {
+            if (word.size() < minLength_ || word.size() > maxLength_) {
+                return std::nullopt;
+            }
+            const u8 slot = slots_[hash(word, seed_) & (tableSize - 1)];
+            if (slot != emptySlot && entries_[slot].word == word) {
+                return entries_[slot].kind;
+            }
+            return std::nullopt;
+        }
+
+    private:
+        static constexpr u8 emptySlot = 0xFF;
+
+        std::array<KeywordEntry, N> entries_;
+        std::array<u8, tableSize> slots_{};
+        usize minLength_{~usize{0}};
+        usize maxLength_{0};
+        u32 seed_{0};
+
+        constexpr bool tryBuild(u32 seed) {
+            slots_.fill(emptySlot);
+            for (usize i = 0; i < N; ++i) {
+                u8& slot = slots_[hash(entries_[i].word, seed) & (tableSize - 1)];
+                if (slot != emptySlot) {
+                    return false;
+                }
+                slot = static_cast<u8>(i);
+            }
+            return true;
+        }
+    };
+} // namespace teks::highlight
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <teks/highlight/Lexer.hpp>
+#include <teks/highlight/Token.hpp>
+#include <teks/types.hpp>
+#include <array>
+#include <string_view>
+#include <vector>
+
+namespace teks::highlight {
+    // What a byte can start, the scanner dispatches on this with a single switch
+    enum class CharLead : u8 {
+        Punctuation,
+        Space,
+        Identifier,
+        Digit,
+        Dot,
+        Quote,
+        Slash,
+        Hash,
+        Bracket,
+    };
+
+    namespace charFlags {
+        constexpr u8 identifierContinue = 1 << 0;
+        constexpr u8 numberContinue = 1 << 1;
+    } // namespace charFlags
+
+    struct CharClassTable {
+        std::array<CharLead, 256> lead{};
+        std::array<u8, 256> flags{};
+
+        [[nodiscard]] constexpr CharLead leadOf(char c) const {
+            return lead[static_cast<u8>(c)];
+        }
+
+        [[nodiscard]] constexpr bool has(char c, u8 flag) const {
+            return (flags[static_cast<u8>(c)] & flag) != 0;
+        }
+    };
+
+    // The classes shared by the C-like languages, specs adjust them from here
+    [[nodiscard]] constexpr CharClassTable makeCharClassTable(std::string_view quotes) {
+        CharClassTable table;
+        for (usize c = 0; c < 256; ++c) {
+            const bool lower = c >= 'a' && c <= 'z';
+            const bool upper = c >= 'A' && c <= 'Z';
+            const bool digit = c >= '0' && c <= '9';
+            // UTF-8 sequences are treated as identifier characters
+            const bool identifier = lower || upper || c == '_' || c >= 0x80;
+            if (identifier) {
+                table.lead[c] = CharLead::Identifier;
+            } else if (digit) {
+                table.lead[c] = CharLead::Digit;
+            } else if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r') {
+                table.lead[c] = CharLead::Space;
+            } else if (c == '.') {
+                table.lead[c] = CharLead::Dot;
+            } else {
+                table.lead[c] = CharLead::Punctuation;
+            }
+            if (identifier || digit) {
+                table.flags[c] |= charFlags::identifierContinue | charFlags::numberContinue;
+            }
+            if (c == '.' || c == '\'') {
+                table.flags[c] |= charFlags::numberContinue;
+            }
+        }
+        for (char quote : quotes) {
+            table.lead[static_cast<u8>(quote)] = CharLead::Quote;
+        }
+        return table;
+    }
+
+    // Table driven lexer, everything language specific comes from `Spec` at compile time:
+    //
+    //   static constexpr CharClassTable classes;
+    //   static constexpr PerfectKeywordSet<N> keywords;
+    //   static constexpr bool slashComments;  // `//` and `/* */`
+    //   static constexpr bool hashDirectives; // `#word` at the start of a line
+    //   static constexpr bool bracketSpans;   // `[...]` is a single `TokenKind::Type` token
+    //
+    // Branches on language features are resolved with `if constexpr`, so each instantiation is a
+    // single switch over `CharLead` plus tight class-table loops.
+    template <typename Spec>
+    struct TableLexer final : Lexer {
+        static constexpr LexerState normalState = 0;
+        static constexpr LexerState blockCommentState = 1;
+
+        LexerState lexLine(
+            std::string_view line,
+            LexerState state,
+            std::vector<Token>& tokens
+        ) const override {
+            constexpr const CharClassTable& classes = Spec::classes;
+            const usize size = line.size();
+            usize at = 0;
+
+            const auto push = [&tokens](usize start, usize end, TokenKind kind) {
+                tokens.push_back(Token{static_cast<u32>(start), static_cast<u32>(end - start), kind});
+            };
+
+            if constexpr (Spec::slashComments) {
+                if (state == blockCommentState) {
+                    const usize close = line.find("*/");
+                    if (close == std::string_view::npos) {
+                        if (size != 0) {
+                            push(0, size, TokenKind::Comment);
+                        }
+                        return blockCommentState;
+                    }
+                    at = close + 2;
+                    push(0, at, TokenKind::Comment);
+                }
+            }
+
+            bool onlySpaceBefore = at == 0;
+            while (at < size) {
+                const usize start = at;
+                switch (classes.leadOf(line[at])) {
+                    case CharLead::Space:
+                        ++at;
+                        continue;
+
+                    case CharLead::Identifier: {
+                        ++at;
+                        while (at < size && classes.has(line[at], charFlags::identifierContinue)) {
+                            ++at;
+                        }
+                        const auto keyword = Spec::keywords.find(line.substr(start, at - start));
+                        push(start, at, keyword.value_or(TokenKind::Identifier));
+                        break;
+                    }
+
+                    case CharLead::Dot:
+                        if (at + 1 >= size || classes.leadOf(line[at + 1]) != CharLead::Digit) {
+                            ++at;
+                            push(start, at, TokenKind::Punctuation);
+                            break;
+                        }
+                        [[fallthrough]];
+                    case CharLead::Digit:
+                        ++at;
+                        while (at < size && classes.has(line[at], charFlags::numberContinue)) {
+                            ++at;
+                        }
+                        push(start, at, TokenKind::Number);
+                        break;
+
+                    case CharLead::Quote: {
+                        const char quote = line[at];
+                        ++at;
+                        while (at < size && line[at] != quote) {
+                            at += line[at] == '\\' ? usize{2} : usize{1};
+                        }
+                        at = at < size ? at + 1 : size;
+                        push(start, at, TokenKind::String);
+                        break;
+                    }
+
+                    case CharLead::Slash:
+                        if constexpr (Spec::slashComments) {
+                            if (at + 1 < size && line[at + 1] == '/') {
+                                push(start, size, TokenKind::Comment);
+                                return normalState;
+                            }
+                            if (at + 1 < size && line[at + 1] == '*') {
+                                const usize close = line.find("*/", at + 2);
+                                if (close == std::string_view::npos) {
+                                    push(start, size, TokenKind::Comment);
+                                    return blockCommentState;
+                                }
+                                at = close + 2;
+                                push(start, at, TokenKind::Comment);
+                                break;
+                            }
+                        }
+                        ++at;
+                        push(start, at, TokenKind::Punctuation);
+                        break;
+
+                    case CharLead::Hash:
+                        if constexpr (Spec::hashDirectives) {
+                            if (onlySpaceBefore) {
+                                ++at;
+                                while (at < size && classes.leadOf(line[at]) == CharLead::Space) {
+                                    ++at;
+                                }
+                                while (at < size && classes.has(line[at], charFlags::identifierContinue)) {
+                                    ++at;
+                                }
+                                push(start, at, TokenKind::Preprocessor);
+                                break;
+                            }
+                        }
+                        ++at;
+                        push(start, at, TokenKind::Punctuation);
+                        break;
+
+                    case CharLead::Bracket:
+                        if constexpr (Spec::bracketSpans) {
+                            const usize close = line.find(']', at + 1);
+                            if (close != std::string_view::npos) {
+                                at = close + 1;
+                                push(start, at, TokenKind::Type);
+                                break;
+                            }
+                        }
+                        ++at;
+                        push(start, at, TokenKind::Punctuation);
+                        break;
+
+                    case CharLead::Punctuation:
+                        ++at;
+                        push(start, at, TokenKind::Punctuation);
+                        break;
+                }
+                onlySpaceBefore = false;
+            }
+
+            return normalState;
+        }
+    };
+} // namespace teks::highlight
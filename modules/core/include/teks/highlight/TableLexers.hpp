@@ -0,0 +1,163 @@
+#pragma once
+
+#include <teks/highlight/PerfectKeywordSet.hpp>
+#include <teks/highlight/TableLexer.hpp>
+#include <array>
+
+namespace teks::highlight {
+    struct CppLexerSpec {
+        static constexpr CharClassTable classes = [] {
+            CharClassTable table = makeCharClassTable("\"'");
+            table.lead['/'] = CharLead::Slash;
+            table.lead['#'] = CharLead::Hash;
+            return table;
+        }();
+
+        static constexpr PerfectKeywordSet keywords{std::array{
+            KeywordEntry{"alignas", TokenKind::Keyword},
+            KeywordEntry{"alignof", TokenKind::Keyword},
+            KeywordEntry{"auto", TokenKind::Keyword},
+            KeywordEntry{"break", TokenKind::Keyword},
+            KeywordEntry{"case", TokenKind::Keyword},
+            KeywordEntry{"catch", TokenKind::Keyword},
+            KeywordEntry{"class", TokenKind::Keyword},
+            KeywordEntry{"co_await", TokenKind::Keyword},
+            KeywordEntry{"co_return", TokenKind::Keyword},
+            KeywordEntry{"co_yield", TokenKind::Keyword},
+            KeywordEntry{"concept", TokenKind::Keyword},
+            KeywordEntry{"const", TokenKind::Keyword},
+            KeywordEntry{"consteval", TokenKind::Keyword},
+            KeywordEntry{"constexpr", TokenKind::Keyword},
+            KeywordEntry{"constinit", TokenKind::Keyword},
+            KeywordEntry{"const_cast", TokenKind::Keyword},
+            KeywordEntry{"continue", TokenKind::Keyword},
+            KeywordEntry{"decltype", TokenKind::Keyword},
+            KeywordEntry{"default", TokenKind::Keyword},
+            KeywordEntry{"delete", TokenKind::Keyword},
+            KeywordEntry{"do", TokenKind::Keyword},
+            KeywordEntry{"dynamic_cast", TokenKind::Keyword},
+            KeywordEntry{"else", TokenKind::Keyword},
+            KeywordEntry{"enum", TokenKind::Keyword},
+            KeywordEntry{"explicit", TokenKind::Keyword},
+            KeywordEntry{"export", TokenKind::Keyword},
+            KeywordEntry{"extern", TokenKind::Keyword},
+            KeywordEntry{"false", TokenKind::Keyword},
+            KeywordEntry{"final", TokenKind::Keyword},
+            KeywordEntry{"for", TokenKind::Keyword},
+            KeywordEntry{"friend", TokenKind::Keyword},
+            KeywordEntry{"goto", TokenKind::Keyword},
+            KeywordEntry{"if", TokenKind::Keyword},
+            KeywordEntry{"inline", TokenKind::Keyword},
+            KeywordEntry{"mutable", TokenKind::Keyword},
+            KeywordEntry{"namespace", TokenKind::Keyword},
+            KeywordEntry{"new", TokenKind::Keyword},
+            KeywordEntry{"noexcept", TokenKind::Keyword},
+            KeywordEntry{"nullptr", TokenKind::Keyword},
+            KeywordEntry{"operator", TokenKind::Keyword},
+            KeywordEntry{"override", TokenKind::Keyword},
+            KeywordEntry{"private", TokenKind::Keyword},
+            KeywordEntry{"protected", TokenKind::Keyword},
+            KeywordEntry{"public", TokenKind::Keyword},
+            KeywordEntry{"register", TokenKind::Keyword},
+            KeywordEntry{"reinterpret_cast", TokenKind::Keyword},
+            KeywordEntry{"requires", TokenKind::Keyword},
+            KeywordEntry{"return", TokenKind::Keyword},
+            KeywordEntry{"sizeof", TokenKind::Keyword},
+            KeywordEntry{"static", TokenKind::Keyword},
+            KeywordEntry{"static_assert", TokenKind::Keyword},
+            KeywordEntry{"static_cast", TokenKind::Keyword},
+            KeywordEntry{"struct", TokenKind::Keyword},
+            KeywordEntry{"switch", TokenKind::Keyword},
+            KeywordEntry{"template", TokenKind::Keyword},
+            KeywordEntry{"this", TokenKind::Keyword},
+            KeywordEntry{"thread_local", TokenKind::Keyword},
+            KeywordEntry{"throw", TokenKind::Keyword},
+            KeywordEntry{"true", TokenKind::Keyword},
+            KeywordEntry{"try", TokenKind::Keyword},
+            KeywordEntry{"typedef", TokenKind::Keyword},
+            KeywordEntry{"typeid", TokenKind::Keyword},
+            KeywordEntry{"typename", TokenKind::Keyword},
+            KeywordEntry{"union", TokenKind::Keyword},
+            KeywordEntry{"using", TokenKind::Keyword},
+            KeywordEntry{"virtual", TokenKind::Keyword},
+            KeywordEntry{"volatile", TokenKind::Keyword},
+            KeywordEntry{"while", TokenKind::Keyword},
+            KeywordEntry{"bool", TokenKind::Type},
+            KeywordEntry{"char", TokenKind::Type},
+            KeywordEntry{"char8_t", TokenKind::Type},
+            KeywordEntry{"char16_t", TokenKind::Type},
+            KeywordEntry{"char32_t", TokenKind::Type},
+            KeywordEntry{"double", TokenKind::Type},
+            KeywordEntry{"float", TokenKind::Type},
+            KeywordEntry{"int", TokenKind::Type},
+            KeywordEntry{"long", TokenKind::Type},
+            KeywordEntry{"short", TokenKind::Type},
+            KeywordEntry{"signed", TokenKind::Type},
+            KeywordEntry{"unsigned", TokenKind::Type},
+            KeywordEntry{"void", TokenKind::Type},
+            KeywordEntry{"wchar_t", TokenKind::Type},
+        }};
+
+        static constexpr bool slashComments = true;
+        static constexpr bool hashDirectives = true;
+        static constexpr bool bracketSpans = false;
+    };
+
+    struct JsonLexerSpec {
+        static constexpr CharClassTable classes = makeCharClassTable("\"");
+
+        static constexpr PerfectKeywordSet keywords{std::array{
+            KeywordEntry{"true", TokenKind::Keyword},
+            KeywordEntry{"false", TokenKind::Keyword},
+            KeywordEntry{"null", TokenKind::Keyword},
+        }};
+
+        static constexpr bool slashComments = false;
+        static constexpr bool hashDirectives = false;
+        static constexpr bool bracketSpans = false;
+    };
+
+    // Typical `<timestamp> <LEVEL> [<context>] <message>` log lines
+    struct LogLexerSpec {
+        static constexpr CharClassTable classes = [] {
+            CharClassTable table = makeCharClassTable("\"");
+            table.lead['['] = CharLead::Bracket;
+            // timestamps such as 2024-01-31T12:00:00,123+01:00 are a single number
+            for (char c : std::string_view("-:+,")) {
+                table.flags[static_cast<u8>(c)] |= charFlags::numberContinue;
+            }
+            return table;
+        }();
+
+        static constexpr PerfectKeywordSet keywords{std::array{
+            KeywordEntry{"TRACE", TokenKind::Keyword},
+            KeywordEntry{"DEBUG", TokenKind::Keyword},
+            KeywordEntry{"INFO", TokenKind::Keyword},
+            KeywordEntry{"NOTICE", TokenKind::Keyword},
+            KeywordEntry{"WARN", TokenKind::Keyword},
+            KeywordEntry{"WARNING", TokenKind::Keyword},
+            KeywordEntry{"ERROR", TokenKind::Keyword},
+            KeywordEntry{"FATAL", TokenKind::Keyword},
+            KeywordEntry{"CRITICAL", TokenKind::Keyword},
+            KeywordEntry{"trace", TokenKind::Keyword},
+            KeywordEntry{"debug", TokenKind::Keyword},
+            KeywordEntry{"info", TokenKind::Keyword},
+            KeywordEntry{"warn", TokenKind::Keyword},
+            KeywordEntry{"warning", TokenKind::Keyword},
+            KeywordEntry{"error", TokenKind::Keyword},
+            KeywordEntry{"fatal", TokenKind::Keyword},
+        }};
+
+        static constexpr bool slashComments = false;
+        static constexpr bool hashDirectives = false;
+        static constexpr bool bracketSpans = true;
+    };
+
+    static_assert(CppLexerSpec::keywords.valid());
+    static_assert(JsonLexerSpec::keywords.valid());
+    static_assert(LogLexerSpec::keywords.valid());
+
+    using CppLexer = TableLexer<CppLexerSpec>;
+    using JsonLexer = TableLexer<JsonLexerSpec>;
+    using LogLexer = TableLexer<LogLexerSpec>;
+} // namespace teks::highlight
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <teks/types.hpp>
+
+namespace teks::highlight {
+    enum class TokenKind : u8 {
+        Identifier,
+        Keyword,
+        Type,
+        Number,
+        String,
+        Comment,
+        Preprocessor,
+        Punctuation,
+    };
+
+    // A span of a single line, offsets are bytes from the start of the line.
+    // Bytes not covered by any token are plain text.
+    struct Token {
+        u32 start;
+        u32 length;
+        TokenKind kind;
+
+        [[nodiscard]] friend constexpr bool operator==(const Token&, const Token&) = default;
+    };
+
+    // Opaque per-lexer state carried from the end of one line to the start of the next,
+    // `0` is always the state at the start of a document
+    using LexerState = u32;
+} // namespace teks::highlight
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <teks/SumTree.hpp>
+#include <teks/types.hpp>
+#include <optional>
+
+namespace teks::layout {
+    // Number of visual rows each logical line occupies when soft-wrapped, and which lines' row counts are
+    // stale estimates still to be rewrapped. Every line occupies at least one row.
+    // Row <-> line mapping, per-line updates, and inserting or removing lines are O(log n) plus the lines
+    // inserted or removed, without touching any other line's rows.
+    struct VisualLineIndex {
+        struct RowLocation {
+            usize line;
+            u64 rowInLine;
+
+            [[nodiscard]] friend constexpr bool operator==(const RowLocation&, const RowLocation&) = default;
+        };
+
+        VisualLineIndex();
+        // Stale lines of one row each
+        explicit VisualLineIndex(usize lineCount);
+
+        [[nodiscard]] usize lineCount() const;
+        [[nodiscard]] u64 rowCount() const;
+
+        [[nodiscard]] u64 rows(usize line) const;
+        // Sets the rows of `line` and marks it as not stale
+        void setRows(usize line, u64 rows);
+
+        [[nodiscard]] bool stale(usize line) const;
+        [[nodiscard]] usize staleCount() const;
+        // The first stale line at or after `line`
+        [[nodiscard]] std::optional<usize> nextStale(usize line) const;
+        // Keeps every line's rows as an estimate until it is set again
+        void markAllStale();
+
+        // The first visual row of `line`, `line == lineCount()` gives `rowCount()`
+        [[nodiscard]] u64 firstRow(usize line) const;
+
+        // Rows past the end are clamped to the last row of the last line
+        [[nodiscard]] RowLocation locate(u64 row) const;
+
+        // Replaces lines `[first, first + removed)` with `inserted` stale lines of one row each
+        void replaceLines(usize first, usize removed, usize inserted);
+
+    private:
+        struct Line {
+            u64 rows;
+            bool stale;
+        };
+
+        struct Summary {
+            u64 rows{0};
+            usize stale{0};
+
+            friend Summary operator+(const Summary& left, const Summary& right) {
+                return Summary{left.rows + right.rows, left.stale + right.stale};
+            }
+        };
+
+        struct Summarize {
+            Summary operator()(const Line& line) const {
+                return Summary{line.rows, line.stale ? usize{1} : usize{0}};
+            }
+        };
+
+        SumTree<Line, Summary, Summarize> lines_;
+    };
+} // namespace teks::layout
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#ifndef TEKS_METRICS
+#error "TEKS_METRICS must be defined by build configuration"
+#endif
+
+namespace teks::metrics {
+    // Whether `TEKS_MEASURE_LATENCY` records anything, the rest of this header works either way
+    inline constexpr bool enabled = TEKS_METRICS;
+
+    enum class Operation : u8 {
+        Insert,
+        Erase,
+        Replace,
+        ReadString,
+        LineRange,
+        FileOpen,
+        FileSave,
+        Paint,
+        // from a key event to the end of painting the frame that shows its edit
+        KeyToPaint,
+    };
+
+    inline constexpr usize operationCount = 9;
+
+    [[nodiscard]] std::string_view operationName(Operation operation);
+
+    // How many calls of `operation` one is timed in, on average. Reading the clock twice costs about
+    // as much as `lineRange` or a short `readString` takes, so only a random sample of those is timed,
+    // and their histograms count the samples. Every call of the others is timed.
+    [[nodiscard]] constexpr u32 samplingPeriod(Operation operation) {
+        return operation == Operation::ReadString || operation == Operation::LineRange ? 64 : 1;
+    }
+
+    // One thread's histograms, defined in metrics.cpp
+    struct ThreadLatencies;
+
+    // Latencies in nanoseconds, counted in buckets that are exact below 16 and within 1/16 of the
+    // value above, like an HDR histogram: every power of two is split into 16 linear buckets.
+    struct LatencyHistogram {
+        static constexpr u32 subBucketBits = 4;
+        static constexpr u64 subBucketCount = u64(1) << subBucketBits;
+        static constexpr usize bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+        [[nodiscard]] static usize bucketOf(u64 nanoseconds);
+        // The smallest and the largest latency counted in `bucket`
+        [[nodiscard]] static u64 bucketLowest(usize bucket);
+        [[nodiscard]] static u64 bucketHighest(usize bucket);
+
+        void record(u64 nanoseconds);
+        void merge(const LatencyHistogram& other);
+
+        [[nodiscard]] u64 count() const;
+        [[nodiscard]] u64 bucketCountAt(usize bucket) const;
+        // 0 when nothing was recorded
+        [[nodiscard]] u64 min() const;
+        [[nodiscard]] u64 max() const;
+        [[nodiscard]] u64 mean() const;
+        // The highest latency in the bucket holding the `percentile`th latency, at most `max()`
+        [[nodiscard]] u64 percentile(double percentile) const;
+
+    private:
+        friend struct ThreadLatencies;
+
+        std::array<u64, bucketCount> counts_{};
+        u64 count_{0};
+        u64 sum_{0};
+        u64 min_{0};
+        u64 max_{0};
+    };
+
+    // Counted in a histogram of the calling thread's own, which only it writes to, so recording takes
+    // no locks and shares no cache lines with other threads
+    void record(Operation operation, u64 nanoseconds);
+
+    // Every thread's latencies for `operation` so far, including threads that have exited.
+    // Safe to call from any thread while others record.
+    [[nodiscard]] LatencyHistogram histogram(Operation operation);
+
+    // Forgets what every thread has recorded
+    void reset();
+
+    // Every operation's count, min, mean, max, percentiles, sampling period and non-empty buckets, in
+    // nanoseconds
+    [[nodiscard]] std::string toJson();
+
+    namespace detail {
+        // calls of each operation left until the calling thread times the next one, constant
+        // initialized so reading it needs no guard
+        inline thread_local std::array<u32, operationCount> untilSample{};
+
+        // A random gap averaging `samplingPeriod(operation)`, so calls made in a fixed pattern, like
+        // one per visible line, are not always timed at the same point of it
+        [[nodiscard]] u32 nextSampleGap(Operation operation);
+
+        [[nodiscard]] inline bool sampled(Operation operation) {
+            if (samplingPeriod(operation) == 1) {
+                return true;
+            }
+            u32& until = untilSample[static_cast<usize>(operation)];
+            if (until > 1) {
+                --until;
+                return false;
+            }
+            until = nextSampleGap(operation);
+            return true;
+        }
+    } // namespace detail
+
+    // Records the time from its construction to its destruction, for the calls `samplingPeriod` samples
+    struct ScopedLatency {
+        explicit ScopedLatency(Operation operation)
+            : operation_(operation)
+            , sampled_(detail::sampled(operation))
+        {
+            if (sampled_) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ScopedLatency(const ScopedLatency&) = delete;
+        ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+        ~ScopedLatency() {
+            if (sampled_) {
+                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                record(operation_, static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        }
+
+    private:
+        Operation operation_;
+        bool sampled_;
+        std::chrono::steady_clock::time_point start_;
+    };
+} // namespace teks::metrics
+
+#define TEKS_METRICS_CONCAT_INNER(a, b) a##b
+#define TEKS_METRICS_CONCAT(a, b) TEKS_METRICS_CONCAT_INNER(a, b)
+
+// Records how long the rest of the enclosing scope takes as a `teks::metrics::Operation`
+#if TEKS_METRICS
+#define TEKS_MEASURE_LATENCY(operation) \
+    const ::teks::metrics::ScopedLatency TEKS_METRICS_CONCAT(teksLatency, __LINE__)(::teks::metrics::Operation::operation)
+#else
+#define TEKS_MEASURE_LATENCY(operation) ((void)0)
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <teks/types.hpp>
+#include <string>
+
+#ifndef TEKS_TRACE
+#error "TEKS_TRACE must be defined by build configuration"
+#endif
+
+namespace teks::trace {
+    // Whether `TEKS_TRACE_SCOPE` records anything, the rest of this header works either way
+    inline constexpr bool enabled = TEKS_TRACE;
+
+    // Events kept per thread, older ones are overwritten
+    inline constexpr usize ringEvents = 1 << 15;
+
+    // Records the start (`begin`) or the end of a scope named `name` on the calling thread, into a ring
+    // buffer only it writes to. `name` must outlive the trace, a string literal.
+    void begin(const char* name);
+    void end(const char* name);
+
+    // Every thread's events still in its ring, as Chrome trace event JSON for `chrome://tracing` and
+    // Perfetto. Safe to call from any thread while others record.
+    [[nodiscard]] std::string toChromeJson();
+
+    // Forgets every thread's events
+    void clear();
+
+    struct Scope {
+        explicit Scope(const char* name)
+            : name_(name)
+        {
+            begin(name_);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            end(name_);
+        }
+
+    private:
+        const char* name_;
+    };
+} // namespace teks::trace
+
+#define TEKS_TRACE_CONCAT_INNER(a, b) a##b
+#define TEKS_TRACE_CONCAT(a, b) TEKS_TRACE_CONCAT_INNER(a, b)
+
+// Traces the rest of the enclosing scope as `name`, a string literal
+#if TEKS_TRACE
+#define TEKS_TRACE_SCOPE(name) const ::teks::trace::Scope TEKS_TRACE_CONCAT(teksTraceScope, __LINE__)(name)
+#else
+#define TEKS_TRACE_SCOPE(name) ((void)0)
+#endif
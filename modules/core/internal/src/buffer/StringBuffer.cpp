@@ -1,31 +1,38 @@
 #include <teks/buffer/internal/StringBuffer.hpp>
+#include <teks/metrics.hpp>
+#include <teks/trace.hpp>
 #include <optional>
 #include <vector>
 #include <algorithm>
-#include <tuple>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
 
 namespace {
-    inline std::tuple<
-        std::string,
-        std::vector<teks::buffer::Offset>,
-        teks::buffer::NewlineStyleSet
-    > normalizeLineEndings(std::string s) {
-        std::vector<teks::buffer::Offset> lineStarts;
-        lineStarts.push_back(teks::buffer::Offset(0));
+    // the temporaries of an edit this small live on the stack
+    constexpr std::size_t scratchBytes = 1024;
+
+    // Appends `s` to `result` with its newlines normalized, returns the newline styles it had
+    teks::buffer::NewlineStyleSet appendNormalized(
+        std::string_view s,
+        std::pmr::string& result,
+        teks::buffer::InvalidUtf8Runs* invalidUtf8 = nullptr
+    ) {
         teks::buffer::NewlineStyleSet newlineStyleSet;
         constexpr const char* newlineChars = "\r\n";
         std::size_t newlineIndex = s.find_first_of(newlineChars);
-        if (newlineIndex == std::string::npos) {
-            return std::tuple(std::move(s), std::move(lineStarts), newlineStyleSet);
-        }
-
-        std::string result;
-        result.reserve(s.size());
         std::size_t fromIndex = 0;
-        do {
+        while (newlineIndex != std::string::npos) {
+            if (invalidUtf8 != nullptr) {
+                // validated line by line while it is in cache, no sequence can span a newline
+                invalidUtf8->append(
+                    s.substr(fromIndex, newlineIndex - fromIndex),
+                    teks::buffer::Offset(result.size())
+                );
+            }
             result.append(s, fromIndex, newlineIndex - fromIndex);
             result.push_back('\n');
-            lineStarts.push_back(teks::buffer::Offset(result.size()));
 
             const std::size_t afterNewlineIndex = newlineIndex + 1;
             if (s[newlineIndex] == '\r') {
@@ -42,27 +49,82 @@ namespace {
             }
 
             newlineIndex = s.find_first_of(newlineChars, fromIndex);
-        } while (newlineIndex != std::string::npos);
+        }
+        if (invalidUtf8 != nullptr) {
+            invalidUtf8->append(s.substr(fromIndex), teks::buffer::Offset(result.size()));
+        }
         result.append(s, fromIndex, s.size() - fromIndex);
-        return std::tuple(std::move(result), std::move(lineStarts), newlineStyleSet);
+        return newlineStyleSet;
+    }
+
+    inline std::pair<
+        std::pmr::string,
+        teks::buffer::NewlineStyleSet
+    > normalizeLineEndings(
+        std::string_view s,
+        std::pmr::polymorphic_allocator<> allocator,
+        teks::buffer::InvalidUtf8Runs* invalidUtf8 = nullptr
+    ) {
+        TEKS_TRACE_SCOPE("normalizeLineEndings");
+        std::pmr::string result(allocator);
+        result.reserve(s.size());
+        const teks::buffer::NewlineStyleSet newlineStyleSet = appendNormalized(s, result, invalidUtf8);
+        return std::pair(std::move(result), newlineStyleSet);
     }
 }
 
 namespace teks::buffer {
-    std::pair<StringBuffer, NewlineStyleSet> StringBuffer::fromRawText(std::string text) {
-        auto [content, lineStarts, newlineStyleSet] = normalizeLineEndings(std::move(text));
-        return std::pair(StringBuffer(std::move(content), std::move(lineStarts)), newlineStyleSet);
+    std::pair<StringBuffer, NewlineStyleSet> StringBuffer::fromRawText(std::string text, allocator_type allocator) {
+        TEKS_TRACE_SCOPE("StringBuffer::fromRawText");
+        InvalidUtf8Runs invalidUtf8;
+        auto [content, newlineStyleSet] = normalizeLineEndings(text, allocator, &invalidUtf8);
+        return std::pair(
+            StringBuffer(std::move(content), std::move(invalidUtf8)),
+            newlineStyleSet
+        );
     }
 
+    StringBuffer::StringBuffer(allocator_type allocator)
+        : value_(allocator)
+        , lineStarts_(allocator)
+    {}
+
     StringBuffer::StringBuffer(std::string text)
-        : StringBuffer(fromRawText(text).first)
+        : StringBuffer(fromRawText(std::move(text)).first)
+    {}
+
+    StringBuffer::StringBuffer(std::string text, allocator_type allocator)
+        : StringBuffer(fromRawText(std::move(text), allocator).first)
+    {}
+
+    StringBuffer::StringBuffer(const StringBuffer& other, allocator_type allocator)
+        : value_(other.value_, allocator)
+        , lineStarts_(other.lineStarts_, allocator)
+        , utf8Index_(other.utf8Index_)
+        , invalidUtf8_(other.invalidUtf8_)
+        , chunkHashes_(other.chunkHashes_)
     {}
 
-    StringBuffer::StringBuffer(std::string text, std::vector<Offset> lineStarts)
+    StringBuffer::StringBuffer(StringBuffer&& other, allocator_type allocator)
+        : value_(std::move(other.value_), allocator)
+        , lineStarts_(std::move(other.lineStarts_), allocator)
+        , utf8Index_(std::move(other.utf8Index_))
+        , invalidUtf8_(std::move(other.invalidUtf8_))
+        , chunkHashes_(std::move(other.chunkHashes_))
+    {}
+
+    StringBuffer::StringBuffer(std::pmr::string text, InvalidUtf8Runs invalidUtf8)
         : value_(std::move(text))
-        , lineStarts_(std::move(lineStarts))
+        , lineStarts_(value_, value_.get_allocator())
+        , utf8Index_(value_)
+        , invalidUtf8_(std::move(invalidUtf8))
+        , chunkHashes_(value_)
     {}
 
+    StringBuffer::allocator_type StringBuffer::get_allocator() const {
+        return value_.get_allocator();
+    }
+
     Bytes StringBuffer::size() const {
         return Bytes(value_.size());
     }
@@ -71,72 +133,46 @@ namespace teks::buffer {
         return value_.empty();
     }
 
-    usize StringBuffer::firstLineIndexAfterOffset(Offset at) const {
-        for (usize i = 1; i < lineStarts_.size(); ++i) {
-            if (lineStarts_[i] > at) {
-                return i;
-            }
+    bool StringBuffer::insert(Offset at, std::string_view content) {
+        TEKS_MEASURE_LATENCY(Insert);
+        if (at.raw() > value_.size()) {
+            return false;
         }
-
-        return lineStarts_.size();
+        insertUnchecked(at, content);
+        return true;
     }
 
-    bool StringBuffer::insert(Offset at, std::string_view content) {
-        if (at.raw() <= value_.size()) {
-            std::string contentString(content);
-            auto [normalizedContent, contentLineStarts, _]
-                = normalizeLineEndings(contentString);
-            for (Offset& lineStart : contentLineStarts) {
-                lineStart += Bytes(at);
-            }
-            const usize insertLineStartsAt = firstLineIndexAfterOffset(at);
-            for (usize i = insertLineStartsAt; i < lineStarts_.size(); ++i) {
-                lineStarts_[i] += Bytes(normalizedContent.size());
+    bool StringBuffer::insert(Offset at, const ChunkReader& reader) {
+        TEKS_MEASURE_LATENCY(Insert);
+        if (at.raw() > value_.size()) {
+            return false;
+        }
+        // Chunks are normalized onto the end of the text and then rotated into place, so the text after
+        // `at` is moved once rather than once per chunk, and nothing is copied anywhere else first.
+        TEKS_TRACE_SCOPE("StringBuffer::insert(reader)");
+        const usize sizeBefore = value_.size();
+        bool afterCr = false;
+        for (std::string_view chunk = reader(); !chunk.empty(); chunk = reader()) {
+            if (afterCr && chunk.front() == '\n') {
+                // the rest of a CRLF, its '\r' was already normalized
+                chunk.remove_prefix(1);
             }
-            lineStarts_.insert(
-                lineStarts_.begin() + static_cast<decltype(lineStarts_)::difference_type>(insertLineStartsAt),
-                // +1 to drop the initial lineStart that is not a newline
-                contentLineStarts.begin() + 1,
-                contentLineStarts.end()
-            );
-            value_.insert(at.raw(), normalizedContent);
-            return true;
+            afterCr = chunk.ends_with('\r');
+            (void)appendNormalized(chunk, value_);
         }
-        return false;
+        std::rotate(
+            value_.begin() + static_cast<std::ptrdiff_t>(at.raw()),
+            value_.begin() + static_cast<std::ptrdiff_t>(sizeBefore),
+            value_.end()
+        );
+        inserted(at, Bytes(value_.size() - sizeBefore));
+        return true;
     }
 
     bool StringBuffer::erase(Range range) {
+        TEKS_MEASURE_LATENCY(Erase);
         if (range.end().raw() <= value_.size()) {
-            const Offset start = range.start();
-            const Offset end = range.end();
-            const Bytes size = range.size();
-            const auto left = std::find_if(
-                lineStarts_.begin(),
-                lineStarts_.end(),
-                // x is the line start, the newline is at x - 1 (as long as its not the fist line start), that is why > is used rather than >=
-                [start](Offset x) { return x > start; }
-            );
-            if (left != lineStarts_.end()) {
-                const auto rLeft = std::make_reverse_iterator(left);
-                const auto rRight = std::find_if(
-                    lineStarts_.rbegin(),
-                    rLeft,
-                    // x is the line start, the newline is at x - 1 (as long as its not the fist line start), that is why <= is used rather than <
-                    [end](Offset x) { return x <= end; }
-                );
-                if (rRight != rLeft) {
-                    const auto right = rRight.base();
-                    const auto firstAfterErase = lineStarts_.erase(left, right);
-                    for (auto i = firstAfterErase; i != lineStarts_.end(); ++i) {
-                        *i -= size;
-                    }
-                } else {
-                    for (auto i = left; i != lineStarts_.end(); ++i) {
-                        *i -= size;
-                    }
-                }
-            }
-            value_.erase(range.start().raw(), range.size().raw());
+            eraseUnchecked(range);
             return true;
         }
 
@@ -144,43 +180,188 @@ namespace teks::buffer {
     }
 
     bool StringBuffer::replace(Range range, std::string_view content) {
+        TEKS_MEASURE_LATENCY(Replace);
         if (range.end().raw() <= value_.size()) {
-            erase(range);
-            insert(range.start(), content);
+            eraseUnchecked(range);
+            insertUnchecked(range.start(), content);
             return true;
         }
 
         return false;
     }
 
+    bool StringBuffer::replaceEach(std::span<const Replacement> replacements) {
+        TEKS_MEASURE_LATENCY(Replace);
+        u64 previousEnd = 0;
+        for (const Replacement& replacement : replacements) {
+            if (replacement.range.start().raw() < previousEnd) {
+                return false;
+            }
+            previousEnd = replacement.range.end().raw();
+        }
+        if (replacements.empty() || previousEnd > value_.size()) {
+            return previousEnd <= value_.size();
+        }
+
+        // the indices need the content as inserted, with its newlines normalized
+        std::array<std::byte, scratchBytes> scratch;
+        std::pmr::monotonic_buffer_resource arena(scratch.data(), scratch.size(), get_allocator().resource());
+        std::pmr::vector<Replacement> edits(replacements.begin(), replacements.end(), &arena);
+        std::pmr::vector<std::pmr::string> normalized(&arena);
+        const auto hasCr = [](const Replacement& edit) { return edit.content.find('\r') != std::string_view::npos; };
+        // reserved so the views into it stay valid
+        normalized.reserve(static_cast<usize>(std::count_if(edits.begin(), edits.end(), hasCr)));
+        u64 size = value_.size();
+        for (Replacement& edit : edits) {
+            if (hasCr(edit)) {
+                normalized.push_back(normalizeLineEndings(edit.content, &arena).first);
+                edit.content = normalized.back();
+            }
+            size = size - edit.range.size().raw() + edit.content.size();
+        }
+
+        // The text from the first edit to the last is rebuilt aside and spliced in, so the text after it is
+        // moved once and the text before it not at all. The indices are then updated around each edit
+        // only, not over the unchanged text between them.
+        const Range span = Range::makeUnchecked(edits.front().range.start(), edits.back().range.end());
+        const Bytes inserted(span.size().raw() + size - value_.size());
+        std::pmr::string spliced(&arena);
+        spliced.reserve(inserted.raw());
+        u64 at = span.start().raw();
+        for (const Replacement& edit : edits) {
+            spliced.append(value_, at, edit.range.start().raw() - at);
+            spliced.append(edit.content);
+            at = edit.range.end().raw();
+        }
+        // what the edits replaced, Utf8Index subtracts its counts
+        const std::pmr::string replaced(value_, span.start().raw(), span.size().raw(), &arena);
+        value_.replace(span.start().raw(), span.size().raw(), spliced);
+
+        // In order, so the text up to the end of each edit's content is already as in `value_`
+        u64 removed = 0;
+        u64 added = 0;
+        for (const Replacement& edit : edits) {
+            const Offset editAt(edit.range.start().raw() - removed + added);
+            lineStarts_.erased(Range::makeUnchecked(editAt, edit.range.size()));
+            lineStarts_.inserted(value_, editAt, Bytes(edit.content.size()));
+            removed += edit.range.size().raw();
+            added += edit.content.size();
+        }
+        utf8Index_.replacedEach(replaced, value_, edits);
+        invalidUtf8_.replacedEach(value_, edits);
+        chunkHashes_.replacedEach(value_, edits);
+        return true;
+    }
+
+    void StringBuffer::insertUnchecked(Offset at, std::string_view content) {
+        const usize sizeBefore = value_.size();
+        if (content.find('\r') == std::string_view::npos) {
+            // already normalized, so it goes straight into the text
+            value_.insert(at.raw(), content);
+        } else {
+            std::array<std::byte, scratchBytes> scratch;
+            std::pmr::monotonic_buffer_resource arena(scratch.data(), scratch.size(), get_allocator().resource());
+            value_.insert(at.raw(), normalizeLineEndings(content, &arena).first);
+        }
+        inserted(at, Bytes(value_.size() - sizeBefore));
+    }
+
+    void StringBuffer::eraseUnchecked(Range range) {
+        lineStarts_.erased(range);
+        utf8Index_.erasing(value_, range);
+        value_.erase(range.start().raw(), range.size().raw());
+        invalidUtf8_.replaced(value_, range.start(), range.size(), Bytes(0));
+        chunkHashes_.replaced(value_, range.start(), range.size(), Bytes(0));
+    }
+
+    void StringBuffer::inserted(Offset at, Bytes size) {
+        lineStarts_.inserted(value_, at, size);
+        utf8Index_.inserted(value_, at, size);
+        invalidUtf8_.replaced(value_, at, Bytes(0), size);
+        chunkHashes_.replaced(value_, at, Bytes(0), size);
+    }
+
     std::optional<std::string> StringBuffer::readString(Range range) const {
+        TEKS_MEASURE_LATENCY(ReadString);
         if (range.end().raw() <= value_.size()) {
-            return value_.substr(range.start().raw(), range.size().raw());
+            return std::string(std::string_view(value_).substr(range.start().raw(), range.size().raw()));
         }
         return std::nullopt;
     }
 
     usize StringBuffer::lineCount() const {
-        return lineStarts_.size();
+        return lineStarts_.lineCount();
     }
 
     std::optional<buffer::Range> StringBuffer::lineRange(usize line) const {
-        // `lineStarts_.size() - 1` is safe because `lineStarts_.size()` >= 1
-        if (line < lineStarts_.size() - 1) {
-            // not the last line
-            const Offset start = lineStarts_[line];
-            // minus 1 gets to the newline, range end is exclusive so that newline is excluded
-            const Offset end = lineStarts_[line + 1] - Bytes(1);
-            return Range::makeUnchecked(start, end);
+        TEKS_MEASURE_LATENCY(LineRange);
+        if (line >= lineStarts_.lineCount()) {
+            return std::nullopt;
         }
+        return lineStarts_.lineRange(line, size());
+    }
 
-        if (line < lineStarts_.size()) {
-            // the last line
-            const Offset start = lineStarts_[line];
-            const auto end = Offset(size());
-            return Range::makeUnchecked(start, end);
+    std::optional<std::vector<Range>> StringBuffer::invalidUtf8Runs(Range range) const {
+        if (range.end().raw() <= value_.size()) {
+            return invalidUtf8_.within(range);
         }
-
         return std::nullopt;
     }
+
+    std::optional<Position> StringBuffer::positionOf(Offset at, ColumnUnit unit) const {
+        if (at.raw() > value_.size()) {
+            return std::nullopt;
+        }
+        const usize line = lineStarts_.lineAt(at);
+        const u64 column = utf8Index_.unitsBefore(value_, at, unit)
+            - utf8Index_.unitsBefore(value_, lineStarts_.lineStart(line), unit);
+        return Position{line, column};
+    }
+
+    std::optional<Offset> StringBuffer::offsetOf(Position position, ColumnUnit unit) const {
+        const std::optional<Range> line = lineRange(position.line);
+        if (!line.has_value()) {
+            return std::nullopt;
+        }
+        const u64 lineStartUnits = utf8Index_.unitsBefore(value_, line->start(), unit);
+        if (position.column > std::numeric_limits<u64>::max() - lineStartUnits) {
+            return std::nullopt;
+        }
+        const std::optional<Offset> at = utf8Index_.offsetOfUnit(value_, lineStartUnits + position.column, unit);
+        if (!at.has_value() || at.value() > line->end()) {
+            return std::nullopt;
+        }
+        return at;
+    }
+
+    u64 StringBuffer::contentHash() const {
+        return chunkHashes_.contentHash();
+    }
+
+    const ChunkHashTree& StringBuffer::chunkHashes() const {
+        return chunkHashes_;
+    }
+
+    MemoryUsage StringBuffer::memoryUsage() const {
+        const HeapBytes text = heapBytesOf(value_);
+        const HeapBytes lineIndex = lineStarts_.heapBytes();
+        HeapBytes caches = utf8Index_.heapBytes();
+        caches += chunkHashes_.heapBytes();
+        caches += invalidUtf8_.heapBytes();
+
+        MemoryUsage usage;
+        usage.text = text.used;
+        usage.lineIndex = lineIndex.used;
+        usage.caches = caches.used;
+        usage.slack = text.slack + lineIndex.slack + caches.slack;
+        return usage;
+    }
+
+    void StringBuffer::shrinkToFit() {
+        value_.shrink_to_fit();
+        lineStarts_.shrinkToFit();
+        utf8Index_.shrinkToFit();
+        chunkHashes_.shrinkToFit();
+        invalidUtf8_.shrinkToFit();
+    }
 } // namespace teks::buffer
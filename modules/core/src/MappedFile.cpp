@@ -0,0 +1,211 @@
+#include <teks/MappedFile.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32)
+namespace {
+    using teks::usize;
+
+    // A mapping whose pages past the end of a truncated file are replaced rather than crash the
+    // reader, empty when `begin` is 0. Read by the signal handler, so only atomics.
+    struct GuardedRange {
+        std::atomic<std::uintptr_t> begin{0};
+        std::atomic<std::uintptr_t> end{0};
+    };
+
+    // mappings past this many at once are not guarded, a viewer maps one or two
+    std::array<GuardedRange, 64> guardedRanges;
+    std::mutex guardedRangesMutex;
+    struct sigaction previousBusHandler;
+    usize pageBytes = 0;
+
+    void onBusError(int signal, siginfo_t* info, void* context) {
+        const auto address = reinterpret_cast<std::uintptr_t>(info->si_addr);
+        for (const GuardedRange& range : guardedRanges) {
+            if (address < range.begin.load() || address >= range.end.load()) {
+                continue;
+            }
+            // the page is past the end of the file now, zeros replace it and the read is retried
+            void* page = reinterpret_cast<void*>(address & ~(std::uintptr_t{pageBytes} - 1));
+            if (mmap(page, pageBytes, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED) {
+                return;
+            }
+            break;
+        }
+        // not a mapped file's fault: whoever handled it before does, or it crashes like it would have
+        if ((previousBusHandler.sa_flags & SA_SIGINFO) != 0) {
+            previousBusHandler.sa_sigaction(signal, info, context);
+        } else if (previousBusHandler.sa_handler != SIG_DFL && previousBusHandler.sa_handler != SIG_IGN) {
+            previousBusHandler.sa_handler(signal);
+        } else {
+            std::signal(signal, SIG_DFL);
+        }
+    }
+
+    void guard(const char* data, usize size) {
+        const std::lock_guard lock(guardedRangesMutex);
+        if (pageBytes == 0) {
+            pageBytes = static_cast<usize>(sysconf(_SC_PAGESIZE));
+            struct sigaction action{};
+            action.sa_sigaction = onBusError;
+            action.sa_flags = SA_SIGINFO | SA_NODEFER;
+            sigemptyset(&action.sa_mask);
+            (void)sigaction(SIGBUS, &action, &previousBusHandler);
+        }
+        for (GuardedRange& range : guardedRanges) {
+            if (range.begin.load() == 0) {
+                range.end = reinterpret_cast<std::uintptr_t>(data) + size;
+                range.begin = reinterpret_cast<std::uintptr_t>(data);
+                return;
+            }
+        }
+    }
+
+    void unguard(const char* data) {
+        const std::lock_guard lock(guardedRangesMutex);
+        for (GuardedRange& range : guardedRanges) {
+            if (range.begin.load() == reinterpret_cast<std::uintptr_t>(data)) {
+                range.begin = 0;
+                range.end = 0;
+                return;
+            }
+        }
+    }
+}
+#endif
+
+namespace teks {
+    std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        const HANDLE file = CreateFileW(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE) {
+            return std::nullopt;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            return std::nullopt;
+        }
+        if (size.QuadPart == 0) {
+            // empty files cannot be mapped
+            CloseHandle(file);
+            return MappedFile(nullptr, 0, -1);
+        }
+        const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            return std::nullopt;
+        }
+        const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        // the view keeps the mapping alive
+        CloseHandle(mapping);
+        if (data == nullptr) {
+            return std::nullopt;
+        }
+        return MappedFile(static_cast<const char*>(data), static_cast<usize>(size.QuadPart), -1);
+#else
+        const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file == -1) {
+            return std::nullopt;
+        }
+        struct stat status;
+        if (fstat(file, &status) == -1 || !S_ISREG(status.st_mode)) {
+            close(file);
+            return std::nullopt;
+        }
+        const auto size = static_cast<usize>(status.st_size);
+        if (size == 0) {
+            // empty files cannot be mapped
+            close(file);
+            return MappedFile(nullptr, 0, -1);
+        }
+        void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+        if (data == MAP_FAILED) {
+            close(file);
+            return std::nullopt;
+        }
+        // viewers mostly read forwards, let the OS read ahead
+        (void)madvise(data, size, MADV_SEQUENTIAL);
+        guard(static_cast<const char*>(data), size);
+        return MappedFile(static_cast<const char*>(data), size, file);
+#endif
+    }
+
+    MappedFile::MappedFile(const char* data, usize size, int file)
+        : data_(data)
+        , size_(size)
+        , file_(file)
+    {}
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , file_(std::exchange(other.file_, -1))
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            file_ = std::exchange(other.file_, -1);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        unmap();
+    }
+
+    std::string_view MappedFile::bytes() const {
+        return std::string_view(data_, size_);
+    }
+
+    bool MappedFile::truncated() const {
+#if defined(_WIN32)
+        return false;
+#else
+        struct stat status;
+        return file_ != -1 && fstat(file_, &status) == 0 && static_cast<usize>(status.st_size) < size_;
+#endif
+    }
+
+    void MappedFile::unmap() {
+        if (data_ == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        UnmapViewOfFile(data_);
+#else
+        unguard(data_);
+        munmap(const_cast<char*>(data_), size_);
+        close(file_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        file_ = -1;
+    }
+} // namespace teks
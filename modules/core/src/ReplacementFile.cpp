@@ -0,0 +1,112 @@
+#include <teks/ReplacementFile.hpp>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace teks {
+    bool syncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#if defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#elif defined(__APPLE__)
+        // fsync on macOS leaves the data in the drive's cache
+        return fcntl(fileno(file), F_FULLFSYNC) != -1;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    std::optional<ReplacementFile> ReplacementFile::create(const std::filesystem::path& path) {
+        // renaming over a symlink would replace the link rather than the file it points at
+        std::error_code error;
+        std::filesystem::path target = path;
+        if (std::filesystem::is_symlink(std::filesystem::symlink_status(path, error))) {
+            target = std::filesystem::canonical(path, error);
+            if (error) {
+                return std::nullopt;
+            }
+        }
+        std::filesystem::path temporary = target;
+        temporary += ".tmp";
+        std::FILE* file = std::fopen(temporary.string().c_str(), "wb");
+        if (file == nullptr) {
+            return std::nullopt;
+        }
+        return ReplacementFile(std::move(target), std::move(temporary), file);
+    }
+
+    ReplacementFile::ReplacementFile(std::filesystem::path path, std::filesystem::path temporary, std::FILE* file)
+        : path_(std::move(path))
+        , temporary_(std::move(temporary))
+        , file_(file)
+    {}
+
+    ReplacementFile::ReplacementFile(ReplacementFile&& other) noexcept
+        : path_(std::move(other.path_))
+        , temporary_(std::exchange(other.temporary_, {}))
+        , file_(std::exchange(other.file_, nullptr))
+        , failed_(other.failed_)
+    {}
+
+    ReplacementFile& ReplacementFile::operator=(ReplacementFile&& other) noexcept {
+        if (this != &other) {
+            discard();
+            path_ = std::move(other.path_);
+            temporary_ = std::exchange(other.temporary_, {});
+            file_ = std::exchange(other.file_, nullptr);
+            failed_ = other.failed_;
+        }
+        return *this;
+    }
+
+    ReplacementFile::~ReplacementFile() {
+        discard();
+    }
+
+    bool ReplacementFile::write(std::string_view bytes) {
+        failed_ = failed_ || file_ == nullptr || std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size();
+        return !failed_;
+    }
+
+    bool ReplacementFile::commit() {
+        if (failed_ || file_ == nullptr || !syncFile(file_)) {
+            discard();
+            return false;
+        }
+        const bool closed = std::fclose(std::exchange(file_, nullptr)) == 0;
+        std::error_code error;
+        // best effort, the file may be new or owned by someone else
+        const auto status = std::filesystem::status(path_, error);
+        if (!error && std::filesystem::exists(status)) {
+            std::filesystem::permissions(temporary_, status.permissions(), error);
+        }
+        error.clear();
+        if (closed) {
+            std::filesystem::rename(temporary_, path_, error);
+        }
+        if (!closed || error) {
+            discard();
+            return false;
+        }
+        temporary_.clear();
+        return true;
+    }
+
+    void ReplacementFile::discard() {
+        if (file_ != nullptr) {
+            std::fclose(std::exchange(file_, nullptr));
+        }
+        if (!temporary_.empty()) {
+            std::error_code error;
+            std::filesystem::remove(std::exchange(temporary_, {}), error);
+        }
+    }
+} // namespace teks
@@ -0,0 +1,293 @@
+#include <teks/buffer/ChunkHashTree.hpp>
+#include <teks/assert.hpp>
+#include <teks/diff/SequenceDiff.hpp>
+#include <teks/hash.hpp>
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace {
+    using teks::u64;
+    using teks::usize;
+
+    // Random values per byte for the gear rolling hash, from splitmix64
+    constexpr std::array<u64, 256> gear = []() {
+        std::array<u64, 256> table{};
+        u64 state = 0x7465'6B73'6765'6172ull;
+        for (u64& value : table) {
+            state += 0x9E3779B97F4A7C15ull;
+            u64 z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            value = z ^ (z >> 31);
+        }
+        return table;
+    }();
+
+    // The gear hash shifts one bit per byte, so it only depends on the last 64 bytes
+    constexpr usize gearWindow = 64;
+    // 12 bits: a cut every 4 KiB past the minimum on average. The high bits mix the most bytes.
+    constexpr u64 cutMask = u64{0xFFF} << 52;
+
+    // any odd multiplier keeps the combined hash a bijection of each chunk hash
+    constexpr u64 chunkMultiplier = 0x9E3779B185EBCA87ull;
+
+    // Past this many differing chunks the regions between the common start and end are one region
+    constexpr usize maxChangedChunks = 1024;
+}
+
+namespace teks::buffer {
+    ChunkHashTree::ChunkHashTree() = default;
+
+    ChunkHashTree::ChunkHashTree(std::string_view text) {
+        std::vector<Chunk> chunks;
+        for (u64 at = 0; at < text.size();) {
+            const u64 length = cutLength(text.substr(at));
+            chunks.push_back(Chunk{length, xxHash64(text.substr(at, length))});
+            at += length;
+        }
+        chunks_.assign(chunks);
+    }
+
+    u64 ChunkHashTree::cutLength(std::string_view text) {
+        if (text.size() <= minChunkBytes) {
+            return text.size();
+        }
+        const usize limit = std::min<usize>(text.size(), maxChunkBytes);
+        u64 hash = 0;
+        for (usize at = minChunkBytes - gearWindow; at < limit; ++at) {
+            hash = (hash << 1) + gear[static_cast<unsigned char>(text[at])];
+            if (at + 1 >= minChunkBytes && (hash & cutMask) == 0) {
+                return at + 1;
+            }
+        }
+        return limit;
+    }
+
+    ChunkHashTree::Summary ChunkHashTree::Summarize::operator()(const Chunk& chunk) const {
+        return Summary{chunk.bytes, chunk.hash, chunkMultiplier};
+    }
+
+    std::pair<usize, u64> ChunkHashTree::chunkAt(u64 at) const {
+        TEKS_ASSERT(!chunks_.empty());
+        const auto found = chunks_.find([at](const Summary& sum) { return sum.bytes > at; });
+        if (found.item != nullptr) {
+            return {found.index, found.before.bytes};
+        }
+        const usize last = chunks_.size() - 1;
+        return {last, found.before.bytes - chunks_[last].bytes};
+    }
+
+    void ChunkHashTree::replaced(std::string_view text, Offset at, Bytes removed, Bytes inserted) {
+        TEKS_ASSERT(at.raw() + inserted.raw() <= text.size());
+        if (chunks_.empty()) {
+            *this = ChunkHashTree(text);
+            return;
+        }
+
+        // bytes before the chunk containing `at` are unchanged, so is where that chunk starts
+        const auto [first, start] = chunkAt(at.raw());
+
+        // Old boundaries at or after the end of the change, shifted to the new text, are where the new
+        // chunks can line up with the old ones. From there on the chunks are the same.
+        const u64 oldChangeEnd = at.raw() + removed.raw();
+        const auto shifted = [&](u64 oldEnd) { return oldEnd - removed.raw() + inserted.raw(); };
+        usize next = first;
+        u64 oldEnd = start + chunks_[first].bytes;
+        bool lined = false;
+        std::vector<Chunk> fresh;
+        for (u64 position = start; position < text.size() && !lined;) {
+            const u64 length = cutLength(text.substr(position));
+            fresh.push_back(Chunk{length, xxHash64(text.substr(position, length))});
+            position += length;
+            while (next < chunks_.size() && (oldEnd < oldChangeEnd || shifted(oldEnd) < position)) {
+                ++next;
+                oldEnd += next < chunks_.size() ? chunks_[next].bytes : 0;
+            }
+            if (next < chunks_.size() && position < text.size() && shifted(oldEnd) == position) {
+                ++next;
+                lined = true;
+            }
+        }
+        if (!lined) {
+            next = chunks_.size();
+        }
+
+        if (fresh.size() == next - first) {
+            for (usize i = 0; i < fresh.size(); ++i) {
+                chunks_.set(first + i, fresh[i]);
+            }
+        } else {
+            chunks_.replace(first, next, fresh);
+        }
+    }
+
+    void ChunkHashTree::replacedEach(std::string_view text, std::span<const Replacement> replacements) {
+        if (chunks_.empty()) {
+            *this = ChunkHashTree(text);
+            return;
+        }
+
+        // Chunks are rehashed from the one containing an edit until a boundary lines up with an old one
+        // between the end of that edit and the start of the next. Edits the rehashing reaches before it
+        // lines up are taken into it. What replaces each run of old chunks is spliced in once all of them
+        // are known, back to front so the runs before keep their indices.
+        struct Splice {
+            usize first;
+            usize last;
+            std::vector<Chunk> chunks;
+        };
+        std::vector<Splice> splices;
+        // what the edits taken so far inserted and removed, old boundaries after them move by that
+        u64 inserted = 0;
+        u64 removed = 0;
+        usize edit = 0;
+        while (edit < replacements.size()) {
+            auto [next, oldStart] = chunkAt(replacements[edit].range.start().raw());
+            const usize first = next;
+
+            u64 changeEnd = 0;
+            const auto take = [&]() {
+                inserted += replacements[edit].content.size();
+                removed += replacements[edit].range.size().raw();
+                changeEnd = replacements[edit].range.end().raw();
+                ++edit;
+            };
+            const auto shifted = [&](u64 boundary) { return boundary + inserted - removed; };
+            // the chunk starts before the edit, only the ones before it moved it
+            u64 position = shifted(oldStart);
+            take();
+
+            std::vector<Chunk> fresh;
+            u64 oldEnd = oldStart + chunks_[next].bytes;
+            bool lined = false;
+            while (position < text.size() && !lined) {
+                const u64 length = cutLength(text.substr(position));
+                fresh.push_back(Chunk{length, xxHash64(text.substr(position, length))});
+                position += length;
+                while (next < chunks_.size()) {
+                    while (edit < replacements.size() && replacements[edit].range.start().raw() < oldEnd) {
+                        take();
+                    }
+                    if (oldEnd >= changeEnd && shifted(oldEnd) >= position) {
+                        break;
+                    }
+                    ++next;
+                    oldEnd += next < chunks_.size() ? chunks_[next].bytes : 0;
+                }
+                // not at the end of the old text: with edits left there, the rehashing has to take them
+                if (next + 1 < chunks_.size() && position < text.size() && shifted(oldEnd) == position) {
+                    ++next;
+                    lined = true;
+                }
+            }
+            if (!lined) {
+                // rehashed to the end of the text, whatever edits were left are in it
+                next = chunks_.size();
+                edit = replacements.size();
+            }
+            splices.push_back(Splice{first, next, std::move(fresh)});
+        }
+        for (auto splice = splices.rbegin(); splice != splices.rend(); ++splice) {
+            chunks_.replace(splice->first, splice->last, splice->chunks);
+        }
+    }
+
+    u64 ChunkHashTree::contentHash() const {
+        return chunks_.total().hash;
+    }
+
+    usize ChunkHashTree::chunkCount() const {
+        return chunks_.size();
+    }
+
+    HeapBytes ChunkHashTree::heapBytes() const {
+        return chunks_.heapBytes();
+    }
+
+    void ChunkHashTree::shrinkToFit() {
+        chunks_.shrinkToFit();
+    }
+
+    std::vector<ChunkHashTree::Region> ChunkHashTree::diffRegions(const ChunkHashTree& other) const {
+        if (chunks_.total().bytes == other.chunks_.total().bytes && contentHash() == other.contentHash()) {
+            return {};
+        }
+        // The combined hashes of the first or last `count` chunks are compared, each O(log chunks), so
+        // the common start and end are found by binary search without walking them. Equal runs have
+        // equal combined hashes, and the combined hash of the last `count` chunks is what is left of the
+        // whole text's once the hash of the ones before it is shifted past them.
+        const auto suffixHash = [](const ChunkHashTree& tree, usize count) {
+            u64 power = 1;
+            for (u64 base = chunkMultiplier, exponent = count; exponent > 0; exponent >>= 1, base *= base) {
+                if ((exponent & 1) != 0) {
+                    power *= base;
+                }
+            }
+            return tree.chunks_.total().hash - tree.chunks_.prefixSum(tree.chunks_.size() - count).hash * power;
+        };
+        const usize hereCount = chunks_.size();
+        const usize thereCount = other.chunks_.size();
+        const usize common = std::min(hereCount, thereCount);
+        // the largest count in `[0, limit]` for which `same` holds, `same` holds up to it and not past it
+        const auto longest = [](usize limit, const auto& same) {
+            usize low = 0;
+            usize high = limit;
+            while (low < high) {
+                const usize middle = low + (high - low + 1) / 2;
+                if (same(middle)) {
+                    low = middle;
+                } else {
+                    high = middle - 1;
+                }
+            }
+            return low;
+        };
+        const usize prefix = longest(common, [this, &other](usize count) {
+            const Summary here = chunks_.prefixSum(count);
+            const Summary there = other.chunks_.prefixSum(count);
+            return here.bytes == there.bytes && here.hash == there.hash;
+        });
+        const usize suffix = longest(common - prefix, [&](usize count) {
+            const u64 hereBytes = chunks_.total().bytes - chunks_.prefixSum(hereCount - count).bytes;
+            const u64 thereBytes = other.chunks_.total().bytes - other.chunks_.prefixSum(thereCount - count).bytes;
+            return hereBytes == thereBytes && suffixHash(*this, count) == suffixHash(other, count);
+        });
+
+        // only the chunks in between are diffed, walked in order many times over, so copied out once
+        const auto chunksOf = [prefix, suffix](const ChunkHashTree& tree) {
+            std::vector<Chunk> chunks;
+            chunks.reserve(tree.chunks_.size() - prefix - suffix);
+            tree.chunks_.forEach(prefix, tree.chunks_.size() - suffix, [&chunks](const Chunk& chunk) { chunks.push_back(chunk); });
+            return chunks;
+        };
+        const std::vector<Chunk> hereChunks = chunksOf(*this);
+        const std::vector<Chunk> thereChunks = chunksOf(other);
+
+        const auto hunks = diff::diffSequences(
+            hereChunks.size(),
+            thereChunks.size(),
+            [&hereChunks, &thereChunks](usize here, usize there) {
+                return hereChunks[here].hash == thereChunks[there].hash && hereChunks[here].bytes == thereChunks[there].bytes;
+            },
+            maxChangedChunks
+        );
+
+        std::vector<Region> regions;
+        regions.reserve(hunks.size());
+        for (const diff::Hunk& hunk : hunks) {
+            regions.push_back(Region{
+                Range::makeUnchecked(
+                    Offset(chunks_.prefixSum(prefix + hunk.beforeStart).bytes),
+                    Offset(chunks_.prefixSum(prefix + hunk.beforeEnd).bytes)
+                ),
+                Range::makeUnchecked(
+                    Offset(other.chunks_.prefixSum(prefix + hunk.afterStart).bytes),
+                    Offset(other.chunks_.prefixSum(prefix + hunk.afterEnd).bytes)
+                )
+            });
+        }
+        return regions;
+    }
+} // namespace teks::buffer
@@ -0,0 +1,299 @@
+#include <teks/buffer/Journal.hpp>
+#include <teks/hash.hpp>
+#include <teks/ReplacementFile.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+namespace {
+    using teks::u8;
+    using teks::u64;
+    using teks::usize;
+
+    // Journals never leave the machine that wrote them, so numbers are in its byte order
+    constexpr std::string_view magic = "TEKSJNL1";
+    constexpr usize headerBytes = 16;
+    // kind, offset, removed and content size, then the content and a checksum of all of it
+    constexpr usize recordFixedBytes = 1 + 3 * sizeof(u64) + sizeof(u64);
+
+    enum class RecordKind : u8 {
+        Edit = 1,
+        Checkpoint = 2,
+    };
+
+    void appendU64(std::string& out, u64 value) {
+        char bytes[sizeof(u64)];
+        std::memcpy(bytes, &value, sizeof(u64));
+        out.append(bytes, sizeof(u64));
+    }
+
+    u64 readU64(std::string_view data, usize at) {
+        u64 value;
+        std::memcpy(&value, data.data() + at, sizeof(u64));
+        return value;
+    }
+
+    std::string header(u64 baseHash) {
+        std::string result(magic);
+        appendU64(result, baseHash);
+        return result;
+    }
+
+    void appendRecord(std::string& out, RecordKind kind, u64 offset, u64 removed, std::string_view content) {
+        const usize start = out.size();
+        out.push_back(static_cast<char>(kind));
+        appendU64(out, offset);
+        appendU64(out, removed);
+        appendU64(out, content.size());
+        out.append(content);
+        appendU64(out, teks::xxHash64(std::string_view(out).substr(start)));
+    }
+
+    struct Record {
+        RecordKind kind;
+        u64 offset;
+        u64 removed;
+        std::string_view content;
+    };
+
+    // The record at `at`, std::nullopt at the end or where a crash tore the journal
+    std::optional<Record> readRecord(std::string_view data, usize& at) {
+        if (data.size() - at < recordFixedBytes) {
+            return std::nullopt;
+        }
+        const u64 size = readU64(data, at + 1 + 2 * sizeof(u64));
+        if (size > data.size() - at - recordFixedBytes) {
+            return std::nullopt;
+        }
+        const usize checked = 1 + 3 * sizeof(u64) + size;
+        if (teks::xxHash64(data.substr(at, checked)) != readU64(data, at + checked)) {
+            return std::nullopt;
+        }
+        const auto kind = static_cast<RecordKind>(data[at]);
+        if (kind != RecordKind::Edit && kind != RecordKind::Checkpoint) {
+            return std::nullopt;
+        }
+        const Record record{
+            kind,
+            readU64(data, at + 1),
+            readU64(data, at + 1 + sizeof(u64)),
+            data.substr(at + 1 + 3 * sizeof(u64), size)
+        };
+        at += checked + sizeof(u64);
+        return record;
+    }
+}
+
+namespace teks::buffer {
+    std::filesystem::path Journal::pathFor(const std::filesystem::path& path) {
+        return path.parent_path() / ("." + path.filename().string() + ".teks-journal");
+    }
+
+    bool Journal::recover(const std::filesystem::path& path, Buffer& buffer) {
+        std::ifstream file(path, std::ios::binary);
+        std::error_code error;
+        const auto fileSize = std::filesystem::file_size(path, error);
+        if (!file || error) {
+            return false;
+        }
+        std::string data(static_cast<usize>(fileSize), '\0');
+        if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+        // a checkpoint was taken of edits to the content the journal started from too, replayed onto
+        // a file changed since it would replace the change
+        if (data.size() < headerBytes || std::string_view(data).substr(0, magic.size()) != magic
+            || readU64(data, magic.size()) != buffer.contentHash()) {
+            return false;
+        }
+
+        usize at = headerBytes;
+        const std::optional<Record> first = readRecord(data, at);
+        if (!first.has_value()) {
+            return false;
+        }
+
+        for (std::optional<Record> record = first; record.has_value(); record = readRecord(data, at)) {
+            if (record->kind == RecordKind::Checkpoint) {
+                buffer = Buffer(std::string(record->content), buffer.get_allocator());
+                continue;
+            }
+            const u64 size = buffer.size().raw();
+            if (record->offset > size || record->removed > size - record->offset) {
+                // cannot be an edit of this content, keep what was recovered so far
+                break;
+            }
+            (void)buffer.replace(
+                Range::makeUnchecked(Offset(record->offset), Bytes(record->removed)),
+                record->content
+            );
+        }
+        return true;
+    }
+
+    Journal::Journal(std::filesystem::path path, u64 baseHash)
+        : path_(std::move(path))
+        , baseHash_(baseHash)
+    {
+        enqueue(Pending{header(baseHash), true, false});
+        writer_ = std::thread([this]() { run(); });
+    }
+
+    Journal::~Journal() {
+        {
+            const std::lock_guard lock(mutex_);
+            pending_.clear();
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        writer_.join();
+        std::error_code error;
+        std::filesystem::remove(path_, error);
+    }
+
+    void Journal::recordReplace(Range range, std::string_view content) {
+        std::string bytes;
+        appendRecord(bytes, RecordKind::Edit, range.start().raw(), range.size().raw(), content);
+        bytesSinceCheckpoint_ += bytes.size();
+        enqueue(Pending{std::move(bytes), false, true});
+    }
+
+    void Journal::recordReplaceEach(std::span<const Replacement> replacements) {
+        std::string bytes;
+        // what the edits before the one recorded inserted and removed, which moved it
+        u64 inserted = 0;
+        u64 removed = 0;
+        for (const Replacement& replacement : replacements) {
+            const u64 start = replacement.range.start().raw() + inserted - removed;
+            appendRecord(bytes, RecordKind::Edit, start, replacement.range.size().raw(), replacement.content);
+            inserted += replacement.content.size();
+            removed += replacement.range.size().raw();
+        }
+        bytesSinceCheckpoint_ += bytes.size();
+        enqueue(Pending{std::move(bytes), false, true});
+    }
+
+    void Journal::checkpoint(std::string content) {
+        std::string bytes = header(baseHash_);
+        appendRecord(bytes, RecordKind::Checkpoint, 0, 0, content);
+        bytesSinceCheckpoint_ = 0;
+        writeFailed_ = false;
+        enqueue(Pending{std::move(bytes), true, true});
+    }
+
+    void Journal::restart(u64 baseHash) {
+        baseHash_ = baseHash;
+        bytesSinceCheckpoint_ = 0;
+        writeFailed_ = false;
+        enqueue(Pending{header(baseHash), true, false});
+    }
+
+    bool Journal::wantsCheckpoint() const {
+        return bytesSinceCheckpoint_ >= checkpointBytes || writeFailed_;
+    }
+
+    void Journal::flush() {
+        std::unique_lock lock(mutex_);
+        flushing_ = true;
+        wake_.notify_all();
+        idle_.wait(lock, [this]() { return pending_.empty() && !writing_; });
+        flushing_ = false;
+    }
+
+    HeapBytes Journal::queuedBytes() const {
+        const std::lock_guard lock(mutex_);
+        HeapBytes bytes = heapBytesOf(pending_);
+        for (const Pending& pending : pending_) {
+            bytes += heapBytesOf(pending.bytes);
+        }
+        return bytes;
+    }
+
+    void Journal::enqueue(Pending pending) {
+        {
+            const std::lock_guard lock(mutex_);
+            pending_.push_back(std::move(pending));
+        }
+        wake_.notify_one();
+    }
+
+    void Journal::run() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+            if (!stopping_ && !flushing_) {
+                // group commit: whatever else is recorded in the interval is synced with it
+                wake_.wait_for(lock, commitInterval, [this]() { return stopping_ || flushing_; });
+            }
+            std::vector<Pending> batch;
+            batch.swap(pending_);
+            const bool stopping = stopping_;
+            writing_ = true;
+            lock.unlock();
+            write(batch);
+            lock.lock();
+            writing_ = false;
+            idle_.notify_all();
+            if (stopping && pending_.empty()) {
+                return;
+            }
+        }
+    }
+
+    void Journal::write(std::vector<Pending>& batch) {
+        // Best effort: a journal that cannot be written only means there is nothing to recover.
+        // A header without edits is held back until the first edit, so unedited files get no journal.
+        std::FILE* file = nullptr;
+        const auto fail = [this]() {
+            broken_ = true;
+            writeFailed_ = true;
+        };
+        for (Pending& pending : batch) {
+            if (pending.restart) {
+                if (file != nullptr) {
+                    std::fclose(file);
+                    file = nullptr;
+                }
+                broken_ = false;
+                if (!pending.holdsEdits) {
+                    std::error_code error;
+                    std::filesystem::remove(path_, error);
+                    heldHeader_ = std::move(pending.bytes);
+                    continue;
+                }
+                heldHeader_.clear();
+                // written aside and renamed over the journal, so a crash leaves the old one whole
+                std::optional<ReplacementFile> replacement = ReplacementFile::create(path_);
+                if (!replacement.has_value() || !replacement->write(pending.bytes) || !replacement->commit()) {
+                    fail();
+                }
+                continue;
+            }
+
+            if (broken_) {
+                continue;
+            }
+            if (file == nullptr) {
+                file = std::fopen(path_.string().c_str(), heldHeader_.empty() ? "ab" : "wb");
+                if (file == nullptr
+                    || std::fwrite(heldHeader_.data(), 1, heldHeader_.size(), file) != heldHeader_.size()) {
+                    fail();
+                    continue;
+                }
+                heldHeader_.clear();
+            }
+            if (std::fwrite(pending.bytes.data(), 1, pending.bytes.size(), file) != pending.bytes.size()) {
+                fail();
+            }
+        }
+        if (file != nullptr) {
+            if (!syncFile(file)) {
+                fail();
+            }
+            std::fclose(file);
+        }
+    }
+} // namespace teks::buffer
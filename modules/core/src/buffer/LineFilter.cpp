@@ -0,0 +1,120 @@
+#include <teks/buffer/LineFilter.hpp>
+#include <teks/assert.hpp>
+#include <teks/trace.hpp>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+
+namespace {
+    using teks::usize;
+
+    // fewer lines than this are not worth a thread
+    constexpr usize minThreadLines = 16 * 1024;
+    // lines read from the buffer at once, bounds the text copied per thread
+    constexpr usize sliceLines = 4096;
+
+    // Appends the lines of `text`, whose first line is `firstLine`, that contain `pattern`
+    void appendMatches(std::string_view text, std::string_view pattern, usize firstLine, std::vector<usize>& lines) {
+        usize line = firstLine;
+        usize lineStart = 0;
+        for (usize found = text.find(pattern); found != std::string_view::npos; found = text.find(pattern, lineStart)) {
+            // jump over the lines before the match without looking for the pattern in them again
+            for (usize newline = text.find('\n', lineStart); newline < found; newline = text.find('\n', newline + 1)) {
+                ++line;
+                lineStart = newline + 1;
+            }
+            lines.push_back(line);
+
+            const usize newline = text.find('\n', found);
+            if (newline == std::string_view::npos) {
+                break;
+            }
+            ++line;
+            lineStart = newline + 1;
+        }
+    }
+}
+
+namespace teks::buffer {
+    LineFilter::LineFilter(const Buffer& buffer, std::string pattern, usize threads)
+        : pattern_(std::move(pattern))
+        , threads_(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+        , lines_(scan(buffer, 0, buffer.lineCount()))
+    {}
+
+    const std::string& LineFilter::pattern() const {
+        return pattern_;
+    }
+
+    usize LineFilter::lineCount() const {
+        return lines_.size();
+    }
+
+    usize LineFilter::sourceLine(usize line) const {
+        TEKS_ASSERT(line < lines_.size());
+        return lines_[line];
+    }
+
+    usize LineFilter::lineAtOrAfter(usize sourceLine) const {
+        return static_cast<usize>(std::lower_bound(lines_.begin(), lines_.end(), sourceLine) - lines_.begin());
+    }
+
+    LineFilter::LinesReplaced LineFilter::replaceLines(const Buffer& buffer, usize first, usize removed, usize inserted) {
+        const auto begin = std::lower_bound(lines_.begin(), lines_.end(), first);
+        const auto end = std::lower_bound(begin, lines_.end(), first + removed);
+        for (auto line = end; line != lines_.end(); ++line) {
+            *line = *line - removed + inserted;
+        }
+
+        const std::vector<usize> matches = scan(buffer, first, first + inserted);
+        const LinesReplaced result{
+            static_cast<usize>(begin - lines_.begin()),
+            static_cast<usize>(end - begin),
+            matches.size(),
+        };
+        lines_.insert(lines_.erase(begin, end), matches.begin(), matches.end());
+        return result;
+    }
+
+    std::vector<usize> LineFilter::scan(const Buffer& buffer, usize first, usize last) const {
+        TEKS_TRACE_SCOPE("LineFilter::scan");
+        TEKS_ASSERT(last <= buffer.lineCount());
+        if (first >= last || pattern_.find('\n') != std::string::npos) {
+            return {};
+        }
+
+        const auto scanSlices = [this, &buffer](usize from, usize to, std::vector<usize>& lines) {
+            TEKS_TRACE_SCOPE("LineFilter::scanSlices");
+            for (usize slice = from; slice < to; slice += sliceLines) {
+                const usize sliceEnd = std::min(to, slice + sliceLines);
+                const Range range = Range::makeUnchecked(
+                    buffer.lineRange(slice).value().start(),
+                    buffer.lineRange(sliceEnd - 1).value().end()
+                );
+                appendMatches(buffer.readString(range).value(), pattern_, slice, lines);
+            }
+        };
+
+        const usize threads = std::min(threads_, (last - first) / minThreadLines + 1);
+        std::vector<std::vector<usize>> matches(threads);
+        std::vector<std::thread> workers;
+        const usize linesPerThread = (last - first + threads - 1) / threads;
+        // the calling thread scans the first slice itself
+        for (usize i = 1; i < threads; ++i) {
+            const usize from = first + i * linesPerThread;
+            const usize to = std::min(last, from + linesPerThread);
+            workers.emplace_back(scanSlices, from, to, std::ref(matches[i]));
+        }
+        scanSlices(first, std::min(last, first + linesPerThread), matches[0]);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        std::vector<usize> lines = std::move(matches[0]);
+        for (usize i = 1; i < threads; ++i) {
+            lines.insert(lines.end(), matches[i].begin(), matches[i].end());
+        }
+        return lines;
+    }
+} // namespace teks::buffer
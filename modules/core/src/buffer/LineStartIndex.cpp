@@ -0,0 +1,280 @@
+#include <teks/buffer/LineStartIndex.hpp>
+#include <teks/assert.hpp>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+    using teks::u8;
+    using teks::u64;
+    using teks::usize;
+
+    usize encodedSize(u64 length) {
+        usize size = 1;
+        for (; length >= 0x80; length >>= 7) {
+            ++size;
+        }
+        return size;
+    }
+
+    void encodeLength(u64 length, u8* out) {
+        while (length >= 0x80) {
+            *out++ = static_cast<u8>(length | 0x80);
+            length >>= 7;
+        }
+        *out = static_cast<u8>(length);
+    }
+
+    u64 decodeLength(const u8*& at) {
+        u64 length = 0;
+        unsigned shift = 0;
+        while ((*at & 0x80) != 0) {
+            length |= static_cast<u64>(*at & 0x7Fu) << shift;
+            shift += 7;
+            ++at;
+        }
+        length |= static_cast<u64>(*at) << shift;
+        ++at;
+        return length;
+    }
+
+    // Adds the next `count` lengths at `at` to `start`. Runs of 8 lengths under 128 bytes, the common
+    // case, are summed 8 bytes at a time without decoding them one by one.
+    u64 skipLengths(u64 start, usize count, const u8*& at) {
+        constexpr u64 highBits = 0x8080'8080'8080'8080ull;
+        constexpr u64 evenBytes = 0x00FF'00FF'00FF'00FFull;
+        while (count >= 8) {
+            // there are at least 8 more encoded bytes, one per length at least
+            u64 word;
+            std::memcpy(&word, at, sizeof(word));
+            if ((word & highBits) != 0) {
+                break;
+            }
+            // bytes summed pairwise into 16 bit lanes, then the lanes into the top one
+            const u64 pairs = (word & evenBytes) + ((word >> 8) & evenBytes);
+            start += (pairs * 0x0001'0001'0001'0001ull) >> 48;
+            at += 8;
+            count -= 8;
+        }
+        for (; count > 0; --count) {
+            start += decodeLength(at);
+        }
+        return start;
+    }
+}
+
+namespace teks::buffer {
+    LineStartIndex::LineStartIndex()
+        : LineStartIndex(allocator_type())
+    {}
+
+    LineStartIndex::LineStartIndex(allocator_type allocator)
+        : blocks_(allocator)
+    {}
+
+    LineStartIndex::LineStartIndex(std::string_view text, allocator_type allocator)
+        : LineStartIndex(allocator)
+    {
+        std::pmr::vector<Block> blocks(allocator);
+        u64 start = 0;
+        for (usize newline = text.find('\n'); newline != std::string_view::npos; newline = text.find('\n', newline + 1)) {
+            appendLength(newline + 1 - start, blocks);
+            start = newline + 1;
+        }
+        blocks_.assign(blocks);
+    }
+
+    LineStartIndex::LineStartIndex(const LineStartIndex& other, allocator_type allocator)
+        : blocks_(other.blocks_, allocator)
+    {}
+
+    LineStartIndex::LineStartIndex(LineStartIndex&& other, allocator_type allocator)
+        : blocks_(std::move(other.blocks_), allocator)
+    {}
+
+    LineStartIndex::allocator_type LineStartIndex::get_allocator() const {
+        return blocks_.get_allocator();
+    }
+
+    usize LineStartIndex::lineCount() const {
+        return blocks_.total().lines + 1;
+    }
+
+    Offset LineStartIndex::lineStart(usize line) const {
+        TEKS_ASSERT(line < lineCount());
+        const auto found = blocks_.find([line](const Summary& sum) { return sum.lines > line; });
+        if (found.item == nullptr) {
+            return Offset(found.before.bytes);
+        }
+        const u8* at = found.item->lengths.data();
+        return Offset(skipLengths(found.before.bytes, line - found.before.lines, at));
+    }
+
+    Range LineStartIndex::lineRange(usize line, Bytes textSize) const {
+        TEKS_ASSERT(line < lineCount());
+        const auto found = blocks_.find([line](const Summary& sum) { return sum.lines > line; });
+        if (found.item == nullptr) {
+            return Range::makeUnchecked(Offset(found.before.bytes), Offset(textSize));
+        }
+        const u8* at = found.item->lengths.data();
+        const u64 start = skipLengths(found.before.bytes, line - found.before.lines, at);
+        // the length includes the newline
+        return Range::makeUnchecked(Offset(start), Offset(start + decodeLength(at) - 1));
+    }
+
+    usize LineStartIndex::lineAt(Offset at) const {
+        const auto found = blocks_.find([at](const Summary& sum) { return sum.bytes > at.raw(); });
+        if (found.item == nullptr) {
+            return found.before.lines;
+        }
+        u64 end = found.before.bytes;
+        usize line = found.before.lines;
+        const u8* encoded = found.item->lengths.data();
+        for (usize i = 0; i < found.item->lines; ++i) {
+            end += decodeLength(encoded);
+            if (end > at.raw()) {
+                break;
+            }
+            ++line;
+        }
+        return line;
+    }
+
+    void LineStartIndex::inserted(std::string_view text, Offset at, Bytes size) {
+        TEKS_ASSERT(at.raw() + size.raw() <= text.size());
+        if (size.raw() == 0) {
+            return;
+        }
+
+        const auto [block, blockStart] = blockAt(at.raw());
+        std::pmr::vector<u64> lengths(get_allocator());
+        if (block < blocks_.size()) {
+            decodeBlock(blocks_[block], lengths);
+        }
+        // the line containing `at`, `lengths.size()` for the last line. A line starting at `at` gets the
+        // inserted text, so it keeps its start.
+        usize line = 0;
+        u64 lineStart = blockStart;
+        while (line < lengths.size() && lineStart + lengths[line] <= at.raw()) {
+            lineStart += lengths[line];
+            ++line;
+        }
+
+        // the line is split at each inserted newline
+        std::pmr::vector<u64> added(get_allocator());
+        u64 previous = lineStart;
+        const std::string_view content = text.substr(at.raw(), size.raw());
+        for (usize newline = content.find('\n'); newline != std::string_view::npos; newline = content.find('\n', newline + 1)) {
+            const u64 end = at.raw() + newline + 1;
+            added.push_back(end - previous);
+            previous = end;
+        }
+        if (line < lengths.size()) {
+            // what follows the last newline inserted
+            lengths[line] = lineStart + lengths[line] + size.raw() - previous;
+        } else if (added.empty()) {
+            // the last line grew, it is not kept
+            return;
+        }
+        lengths.insert(lengths.begin() + static_cast<ssize>(line), added.begin(), added.end());
+        replaceBlocks(block, std::min(block + 1, blocks_.size()), std::move(lengths));
+    }
+
+    void LineStartIndex::erased(Range range) {
+        const u64 start = range.start().raw();
+        const u64 end = range.end().raw();
+        if (range.size().raw() == 0 || start >= blocks_.total().bytes) {
+            // nothing or only the end of the last line, which is not kept
+            return;
+        }
+
+        // Line ends of the block containing the start and of the one containing the end. Every block in
+        // between ends inside the range, so they are erased without decoding them.
+        const auto [first, firstStart] = blockAt(start);
+        const auto [last, lastStart] = blockAt(end);
+        std::pmr::vector<u64> ends(get_allocator());
+        const auto addEnds = [this, &ends](usize block, u64 lineEnd) {
+            const usize from = ends.size();
+            decodeBlock(blocks_[block], ends);
+            for (usize i = from; i < ends.size(); ++i) {
+                lineEnd += ends[i];
+                ends[i] = lineEnd;
+            }
+        };
+        addEnds(first, firstStart);
+        if (last != first) {
+            addEnds(last, lastStart);
+        }
+        // a line ends just after its newline, so the line ending just after the range goes with it
+        std::erase_if(ends, [start, end](u64 lineEnd) { return lineEnd > start && lineEnd <= end; });
+
+        // back to lengths, in place
+        u64 previous = firstStart;
+        for (u64& lineEnd : ends) {
+            const u64 moved = lineEnd > end ? lineEnd - range.size().raw() : lineEnd;
+            lineEnd = moved - previous;
+            previous = moved;
+        }
+        replaceBlocks(first, last + 1, std::move(ends));
+    }
+
+    usize LineStartIndex::memoryBytes() const {
+        const HeapBytes bytes = heapBytes();
+        return bytes.used + bytes.slack;
+    }
+
+    HeapBytes LineStartIndex::heapBytes() const {
+        return blocks_.heapBytes();
+    }
+
+    void LineStartIndex::shrinkToFit() {
+        blocks_.shrinkToFit();
+    }
+
+    void LineStartIndex::appendLength(u64 length, std::pmr::vector<Block>& blocks) {
+        const usize size = encodedSize(length);
+        if (blocks.empty() || blocks.back().lines == blockLines || blocks.back().encoded + size > blockBytes) {
+            blocks.emplace_back();
+        }
+        Block& block = blocks.back();
+        encodeLength(length, block.lengths.data() + block.encoded);
+        block.encoded = static_cast<u8>(block.encoded + size);
+        block.bytes += length;
+        ++block.lines;
+    }
+
+    void LineStartIndex::decodeBlock(const Block& block, std::pmr::vector<u64>& lengths) {
+        const u8* at = block.lengths.data();
+        for (usize i = 0; i < block.lines; ++i) {
+            lengths.push_back(decodeLength(at));
+        }
+    }
+
+    std::pair<usize, u64> LineStartIndex::blockAt(u64 at) const {
+        const auto found = blocks_.find([at](const Summary& sum) { return sum.bytes > at; });
+        if (found.item != nullptr || blocks_.empty()) {
+            return {found.index, found.before.bytes};
+        }
+        const usize last = blocks_.size() - 1;
+        return {last, found.before.bytes - blocks_[last].bytes};
+    }
+
+    void LineStartIndex::replaceBlocks(usize first, usize last, std::pmr::vector<u64> lengths) {
+        if (lengths.size() < blockLines / 2 && last < blocks_.size()) {
+            decodeBlock(blocks_[last], lengths);
+            ++last;
+        }
+        std::pmr::vector<Block> fresh(get_allocator());
+        for (const u64 length : lengths) {
+            appendLength(length, fresh);
+        }
+        if (fresh.size() == last - first) {
+            // as typing without newlines does, the blocks are only updated
+            for (usize i = 0; i < fresh.size(); ++i) {
+                blocks_.set(first + i, fresh[i]);
+            }
+        } else {
+            blocks_.replace(first, last, fresh);
+        }
+    }
+} // namespace teks::buffer
@@ -0,0 +1,189 @@
+#include <teks/buffer/SparseLineIndex.hpp>
+#include <teks/assert.hpp>
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    using teks::u32;
+    using teks::u64;
+    using teks::usize;
+
+    // how far a lookup past the indexed text indexes at a time
+    constexpr u64 lookupSliceBytes = 1 << 24;
+
+    struct Skipped {
+        // just past the last newline passed, or the end when fewer were found
+        usize at;
+        usize newlines;
+    };
+
+    // Scans `[from, end)` of `text` until `count` newlines were passed, 16 bytes at a time where SSE2 is
+    // available: whole blocks are only counted, and the block holding the last newline is searched.
+    Skipped skipNewlines(std::string_view text, usize from, usize end, usize count) {
+        usize at = from;
+        usize found = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i newline = _mm_set1_epi8('\n');
+        while (found < count && end - at >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + at));
+            auto mask = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+            const auto inBlock = static_cast<usize>(std::popcount(mask));
+            if (found + inBlock < count) {
+                found += inBlock;
+                at += 16;
+                continue;
+            }
+            for (usize skip = count - found - 1; skip > 0; --skip) {
+                mask &= mask - 1;
+            }
+            return Skipped{at + static_cast<usize>(std::countr_zero(mask)) + 1, count};
+        }
+#endif
+        for (; found < count && at < end; ++at) {
+            if (text[at] == '\n') {
+                ++found;
+            }
+        }
+        return Skipped{at, found};
+    }
+
+    usize countNewlines(std::string_view text, usize from, usize end) {
+        return skipNewlines(text, from, end, std::numeric_limits<usize>::max()).newlines;
+    }
+
+    bool isContinuation(char byte) {
+        return (static_cast<unsigned char>(byte) & 0xc0) == 0x80;
+    }
+}
+
+namespace teks::buffer {
+    SparseLineIndex::SparseLineIndex(usize interval)
+        : interval_(interval)
+        , checkpoints_{Offset(0)}
+    {
+        TEKS_ASSERT(interval > 0);
+    }
+
+    bool SparseLineIndex::indexSome(std::string_view text, u64 bytes) {
+        const usize end = static_cast<usize>(std::min<u64>(text.size(), indexed_.raw() + bytes));
+        usize at = static_cast<usize>(indexed_.raw());
+        while (at < end) {
+            const usize toCheckpoint = checkpoints_.size() * interval_ - newlines_;
+            const Skipped skipped = skipNewlines(text, at, end, toCheckpoint);
+            newlines_ += skipped.newlines;
+            at = skipped.at;
+            if (skipped.newlines == toCheckpoint) {
+                checkpoints_.push_back(Offset(at));
+            }
+        }
+        indexed_ = Offset(at);
+        return at < text.size();
+    }
+
+    bool SparseLineIndex::complete(std::string_view text) const {
+        return indexed_.raw() == text.size();
+    }
+
+    Bytes SparseLineIndex::indexedBytes() const {
+        return Bytes(indexed_);
+    }
+
+    std::optional<usize> SparseLineIndex::lineCount(std::string_view text) const {
+        if (!complete(text)) {
+            return std::nullopt;
+        }
+        return newlines_ + 1;
+    }
+
+    usize SparseLineIndex::estimatedLineCount(std::string_view text) const {
+        if (complete(text) || indexed_.raw() == 0) {
+            return newlines_ + 1;
+        }
+        const double linesPerByte = static_cast<double>(newlines_) / static_cast<double>(indexed_.raw());
+        const double remaining = static_cast<double>(text.size() - indexed_.raw());
+        return newlines_ + 1 + static_cast<usize>(remaining * linesPerByte);
+    }
+
+    std::optional<Range> SparseLineIndex::lineRange(std::string_view text, usize line) {
+        const std::optional<Offset> start = lineStart(text, line);
+        if (!start.has_value()) {
+            return std::nullopt;
+        }
+        return Range::makeUnchecked(*start, lineEndAt(text, *start));
+    }
+
+    std::optional<Offset> SparseLineIndex::lineStart(std::string_view text, usize line) {
+        // the start of `line` is known once `line` newlines were seen
+        while (newlines_ < line && indexSome(text, lookupSliceBytes)) {}
+        if (newlines_ < line) {
+            return std::nullopt;
+        }
+
+        const usize checkpoint = line / interval_;
+        const usize skip = line - checkpoint * interval_;
+        const Skipped start = skipNewlines(text, static_cast<usize>(checkpoints_[checkpoint].raw()), text.size(), skip);
+        TEKS_ASSERT(start.newlines == skip);
+        return Offset(start.at);
+    }
+
+    std::optional<usize> SparseLineIndex::lineOf(std::string_view text, Offset at) const {
+        if (at > indexed_) {
+            return std::nullopt;
+        }
+        const auto after = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), at);
+        const auto checkpoint = static_cast<usize>(after - checkpoints_.begin()) - 1;
+        return checkpoint * interval_
+            + countNewlines(text, static_cast<usize>(checkpoints_[checkpoint].raw()), static_cast<usize>(at.raw()));
+    }
+
+    Offset SparseLineIndex::lineStartAt(std::string_view text, Offset at) {
+        TEKS_ASSERT(at.raw() <= text.size());
+        if (at.raw() == 0) {
+            return at;
+        }
+        const usize newline = text.rfind('\n', static_cast<usize>(at.raw()) - 1);
+        return Offset(newline == std::string_view::npos ? 0 : newline + 1);
+    }
+
+    Offset SparseLineIndex::lineEndAt(std::string_view text, Offset at) {
+        TEKS_ASSERT(at.raw() <= text.size());
+        const usize newline = text.find('\n', static_cast<usize>(at.raw()));
+        return Offset(newline == std::string_view::npos ? text.size() : newline);
+    }
+
+    Offset SparseLineIndex::rowStartAt(std::string_view text, Offset at, u64 maxBytes) {
+        TEKS_ASSERT(at.raw() <= text.size());
+        const auto end = static_cast<usize>(at.raw());
+        const usize from = end - static_cast<usize>(std::min<u64>(end, maxBytes));
+        const usize newline = text.substr(from, end - from).rfind('\n');
+        if (newline != std::string_view::npos) {
+            return Offset(from + newline + 1);
+        }
+        usize start = from;
+        while (start > 0 && start < end && isContinuation(text[start])) {
+            ++start;
+        }
+        return Offset(start);
+    }
+
+    Offset SparseLineIndex::rowEndAt(std::string_view text, Offset at, u64 maxBytes) {
+        TEKS_ASSERT(at.raw() <= text.size());
+        const auto start = static_cast<usize>(at.raw());
+        const usize to = start + static_cast<usize>(std::min<u64>(text.size() - start, maxBytes));
+        const usize newline = text.substr(start, to - start).find('\n');
+        if (newline != std::string_view::npos) {
+            return Offset(start + newline);
+        }
+        usize end = to;
+        while (end > start && end < text.size() && isContinuation(text[end])) {
+            --end;
+        }
+        // a row of nothing but continuation bytes is cut anywhere, every row must move on
+        return Offset(end == start ? to : end);
+    }
+} // namespace teks::buffer
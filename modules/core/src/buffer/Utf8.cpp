@@ -0,0 +1,427 @@
+#include <teks/buffer/Utf8.hpp>
+#include <teks/assert.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEKS_UTF8_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TEKS_UTF8_NEON 1
+#endif
+
+namespace {
+    using teks::u8;
+    using teks::u32;
+    using teks::u64;
+    using teks::usize;
+
+    constexpr usize blockBytes = 16;
+    constexpr char16_t replacementCharacter = u'\uFFFD';
+
+    bool isAsciiBlock(const char* block) {
+#if defined(TEKS_UTF8_SSE2)
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block))) == 0;
+#elif defined(TEKS_UTF8_NEON)
+        return vmaxvq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(block))) < 0x80;
+#else
+        u64 words[2];
+        std::memcpy(words, block, blockBytes);
+        return ((words[0] | words[1]) & 0x8080808080808080ull) == 0;
+#endif
+    }
+
+    bool isContinuation(char c) {
+        return (static_cast<u8>(c) & 0xC0) == 0x80;
+    }
+
+    struct Sequence {
+        usize length;
+        bool valid;
+    };
+
+    // The sequence starting at `at`. Invalid sequences are the maximal subpart: the lead byte and
+    // the continuation bytes that were acceptable before the mismatch.
+    Sequence scanSequence(std::string_view text, usize at) {
+        const auto lead = static_cast<u8>(text[at]);
+        if (lead < 0x80) {
+            return Sequence{1, true};
+        }
+
+        usize needed = 0;
+        u8 low = 0x80;
+        u8 high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            needed = 1;
+        } else if (lead == 0xE0) {
+            needed = 2;
+            low = 0xA0;
+        } else if (lead == 0xED) {
+            // excludes the surrogates
+            needed = 2;
+            high = 0x9F;
+        } else if (lead >= 0xE1 && lead <= 0xEF) {
+            needed = 2;
+        } else if (lead == 0xF0) {
+            needed = 3;
+            low = 0x90;
+        } else if (lead >= 0xF1 && lead <= 0xF3) {
+            needed = 3;
+        } else if (lead == 0xF4) {
+            // up to U+10FFFF
+            needed = 3;
+            high = 0x8F;
+        } else {
+            return Sequence{1, false};
+        }
+
+        usize length = 1;
+        while (length <= needed) {
+            if (at + length >= text.size()) {
+                return Sequence{length, false};
+            }
+            const auto c = static_cast<u8>(text[at + length]);
+            if (c < low || c > high) {
+                return Sequence{length, false};
+            }
+            low = 0x80;
+            high = 0xBF;
+            ++length;
+        }
+        return Sequence{length, true};
+    }
+
+    usize sequenceLength(u8 lead) {
+        if (lead < 0xC0) {
+            return 1;
+        }
+        if (lead < 0xE0) {
+            return 2;
+        }
+        if (lead < 0xF0) {
+            return 3;
+        }
+        return 4;
+    }
+}
+
+namespace teks::buffer {
+    usize asciiPrefix(std::string_view text) {
+        usize at = 0;
+        while (at + blockBytes <= text.size() && isAsciiBlock(text.data() + at)) {
+            at += blockBytes;
+        }
+        while (at < text.size() && static_cast<u8>(text[at]) < 0x80) {
+            ++at;
+        }
+        return at;
+    }
+
+    usize validUtf8Prefix(std::string_view text) {
+        const usize size = text.size();
+        usize at = 0;
+        while (at < size) {
+            if (at + blockBytes <= size) {
+                if (isAsciiBlock(text.data() + at)) {
+                    at += blockBytes;
+                    continue;
+                }
+            }
+            // finish the block one sequence at a time before trying whole blocks again,
+            // so text with few ASCII runs does not retry a block per codepoint
+            const usize blockEnd = std::min(size, at + blockBytes);
+            while (at < blockEnd) {
+                const Sequence sequence = scanSequence(text, at);
+                if (!sequence.valid) {
+                    return at;
+                }
+                at += sequence.length;
+            }
+        }
+        return size;
+    }
+
+    usize decodeValidUtf8(std::string_view text, char16_t* out) {
+        const usize size = text.size();
+        const char16_t* const begin = out;
+        usize at = 0;
+        while (at < size) {
+            if (at + blockBytes <= size && isAsciiBlock(text.data() + at)) {
+                for (usize i = 0; i < blockBytes; ++i) {
+                    *out++ = static_cast<char16_t>(text[at + i]);
+                }
+                at += blockBytes;
+                continue;
+            }
+
+            const auto lead = static_cast<u8>(text[at]);
+            if (lead < 0x80) {
+                *out++ = lead;
+                ++at;
+                continue;
+            }
+            const usize length = sequenceLength(lead);
+            if (isContinuation(text[at]) || at + length > size) {
+                *out++ = replacementCharacter;
+                ++at;
+                continue;
+            }
+
+            u32 codepoint = lead & (0xFFu >> (length + 1));
+            for (usize i = 1; i < length; ++i) {
+                codepoint = (codepoint << 6) | (static_cast<u8>(text[at + i]) & 0x3Fu);
+            }
+            if (codepoint >= 0x10000) {
+                codepoint -= 0x10000;
+                *out++ = static_cast<char16_t>(0xD800 + (codepoint >> 10));
+                *out++ = static_cast<char16_t>(0xDC00 + (codepoint & 0x3FF));
+            } else {
+                *out++ = static_cast<char16_t>(codepoint);
+            }
+            at += length;
+        }
+        return static_cast<usize>(out - begin);
+    }
+
+    InvalidUtf8Runs::InvalidUtf8Runs(std::string_view text) {
+        append(text, Offset(0));
+    }
+
+    void InvalidUtf8Runs::append(std::string_view text, Offset base) {
+        usize at = 0;
+        while (at < text.size()) {
+            at += validUtf8Prefix(text.substr(at));
+            if (at == text.size()) {
+                break;
+            }
+            const usize length = scanSequence(text, at).length;
+            const Offset start = base + Bytes(at);
+            const Offset end = start + Bytes(length);
+            if (!runs_.empty() && runs_.back().end() == start) {
+                runs_.back() = Range::makeUnchecked(runs_.back().start(), end);
+            } else {
+                runs_.push_back(Range::makeUnchecked(start, end));
+            }
+            at += length;
+        }
+    }
+
+    usize InvalidUtf8Runs::firstRunEndingAfter(Offset at) const {
+        const auto found = std::upper_bound(
+            runs_.begin(),
+            runs_.end(),
+            at,
+            [](Offset offset, const Range& run) { return offset < run.end(); }
+        );
+        return static_cast<usize>(found - runs_.begin());
+    }
+
+    void InvalidUtf8Runs::replaced(std::string_view text, Offset at, Bytes removed, Bytes inserted) {
+        TEKS_ASSERT(at.raw() + inserted.raw() <= text.size());
+
+        // Widen the change to sequence boundaries: the start of whatever contains the byte before it,
+        // and the end of whatever contains the first byte after it. Every byte that is not a
+        // continuation byte starts a sequence, valid or not, so the rescan falls back into step there.
+        Offset start = at;
+        if (at.raw() > 0) {
+            const usize before = firstRunEndingAfter(at - Bytes(1));
+            if (before < runs_.size() && runs_[before].start() < at) {
+                start = runs_[before].start();
+            } else {
+                // the byte before is part of a valid sequence, at most 3 bytes from its lead
+                start -= Bytes(1);
+                for (usize back = 0; back < 3 && start.raw() > 0 && isContinuation(text[start.raw()]); ++back) {
+                    start -= Bytes(1);
+                }
+            }
+        }
+
+        // in the coordinates from before the change
+        const Offset oldChangeEnd = at + removed;
+        Offset oldEnd = oldChangeEnd;
+        const usize after = firstRunEndingAfter(oldChangeEnd);
+        if (after < runs_.size() && runs_[after].start() <= oldChangeEnd) {
+            oldEnd = runs_[after].end();
+        } else {
+            usize newAt = at.raw() + inserted.raw();
+            for (usize skip = 0; skip < 3 && newAt < text.size() && isContinuation(text[newAt]); ++skip) {
+                ++newAt;
+                oldEnd += Bytes(1);
+            }
+            // the skipped bytes may run into stray continuation bytes
+            const usize straddling = firstRunEndingAfter(oldEnd);
+            if (straddling < runs_.size() && runs_[straddling].start() < oldEnd) {
+                oldEnd = runs_[straddling].end();
+            }
+        }
+        const Offset newEnd = Offset(oldEnd.raw() - removed.raw() + inserted.raw());
+
+        const auto first = runs_.begin() + static_cast<std::vector<Range>::difference_type>(firstRunEndingAfter(start));
+        auto last = first;
+        while (last != runs_.end() && last->start() < oldEnd) {
+            ++last;
+        }
+        for (auto run = last; run != runs_.end(); ++run) {
+            *run = Range::makeUnchecked(
+                Offset(run->start().raw() - removed.raw() + inserted.raw()),
+                Offset(run->end().raw() - removed.raw() + inserted.raw())
+            );
+        }
+
+        InvalidUtf8Runs rescanned;
+        rescanned.append(text.substr(start.raw(), (newEnd - start).raw()), start);
+        const auto position = runs_.insert(
+            runs_.erase(first, last),
+            rescanned.runs_.begin(),
+            rescanned.runs_.end()
+        );
+
+        // merge with the neighbours the window touches
+        const auto index = static_cast<usize>(position - runs_.begin());
+        usize kept = index == 0 ? 0 : index - 1;
+        const usize end = std::min(runs_.size(), index + rescanned.runs_.size() + 1);
+        for (usize i = kept + 1; i < end; ++i) {
+            if (runs_[kept].end() == runs_[i].start()) {
+                runs_[kept] = Range::makeUnchecked(runs_[kept].start(), runs_[i].end());
+            } else {
+                runs_[++kept] = runs_[i];
+            }
+        }
+        if (end > 0) {
+            const auto difference = [](usize value) { return static_cast<std::vector<Range>::difference_type>(value); };
+            runs_.erase(runs_.begin() + difference(kept + 1), runs_.begin() + difference(end));
+        }
+    }
+
+    void InvalidUtf8Runs::replacedEach(std::string_view text, std::span<const Replacement> replacements) {
+        // The runs moved to the coordinates after the edits, cut where the edits removed bytes
+        std::vector<Range> moved;
+        moved.reserve(runs_.size());
+        {
+            usize next = 0;
+            u64 removed = 0;
+            u64 inserted = 0;
+            for (const Range& run : runs_) {
+                u64 start = run.start().raw();
+                while (start < run.end().raw()) {
+                    while (next < replacements.size() && replacements[next].range.end().raw() <= start) {
+                        removed += replacements[next].range.size().raw();
+                        inserted += replacements[next].content.size();
+                        ++next;
+                    }
+                    const bool cut = next < replacements.size();
+                    const u64 end = cut ? std::min(run.end().raw(), replacements[next].range.start().raw()) : run.end().raw();
+                    if (start < end) {
+                        moved.push_back(Range::makeUnchecked(Offset(start - removed + inserted), Offset(end - removed + inserted)));
+                    }
+                    start = cut ? std::max(end, replacements[next].range.end().raw()) : end;
+                }
+            }
+        }
+
+        // The windows to rescan, each edit widened to sequence boundaries as replaced() does. Windows that
+        // touch are merged, so each rescan starts in step.
+        std::vector<Range> windows;
+        windows.reserve(replacements.size());
+        u64 removed = 0;
+        u64 inserted = 0;
+        for (const Replacement& replacement : replacements) {
+            const u64 at = replacement.range.start().raw() - removed + inserted;
+            removed += replacement.range.size().raw();
+            inserted += replacement.content.size();
+
+            u64 start = at;
+            const bool joins = !windows.empty() && at <= windows.back().end().raw();
+            if (joins) {
+                start = windows.back().start().raw();
+            } else if (at > 0) {
+                const auto before = std::upper_bound(
+                    moved.begin(),
+                    moved.end(),
+                    Offset(at - 1),
+                    [](Offset offset, const Range& run) { return offset < run.end(); }
+                );
+                if (before != moved.end() && before->start().raw() < at) {
+                    start = before->start().raw();
+                } else {
+                    // the byte before is part of a valid sequence, at most 3 bytes from its lead
+                    --start;
+                    for (usize back = 0; back < 3 && start > 0 && isContinuation(text[start]); ++back) {
+                        --start;
+                    }
+                }
+            }
+            u64 end = at + replacement.content.size();
+            for (usize skip = 0; skip < 3 && end < text.size() && isContinuation(text[end]); ++skip) {
+                ++end;
+            }
+
+            if (!windows.empty() && start <= windows.back().end().raw()) {
+                windows.back() = Range::makeUnchecked(windows.back().start(), std::max(windows.back().end(), Offset(end)));
+            } else {
+                windows.push_back(Range::makeUnchecked(Offset(start), Offset(end)));
+            }
+        }
+
+        // The bytes outside the windows are classified as before, so the moved runs are kept there
+        std::vector<Range> runs;
+        runs.reserve(moved.size());
+        const auto add = [&runs](Range run) {
+            if (!runs.empty() && runs.back().end() >= run.start()) {
+                runs.back() = Range::makeUnchecked(runs.back().start(), std::max(runs.back().end(), run.end()));
+            } else {
+                runs.push_back(run);
+            }
+        };
+        usize next = 0;
+        for (const Range& window : windows) {
+            for (; next < moved.size() && moved[next].start() < window.end(); ++next) {
+                if (moved[next].start() < window.start()) {
+                    add(Range::makeUnchecked(moved[next].start(), std::min(moved[next].end(), window.start())));
+                }
+                if (moved[next].end() > window.end()) {
+                    // what follows the window is kept with the runs after it
+                    moved[next] = Range::makeUnchecked(window.end(), moved[next].end());
+                    break;
+                }
+            }
+            InvalidUtf8Runs rescanned;
+            rescanned.append(text.substr(window.start().raw(), window.size().raw()), window.start());
+            for (const Range& run : rescanned.runs_) {
+                add(run);
+            }
+        }
+        for (; next < moved.size(); ++next) {
+            add(moved[next]);
+        }
+        runs_ = std::move(runs);
+    }
+
+    bool InvalidUtf8Runs::empty() const {
+        return runs_.empty();
+    }
+
+    const std::vector<Range>& InvalidUtf8Runs::runs() const {
+        return runs_;
+    }
+
+    HeapBytes InvalidUtf8Runs::heapBytes() const {
+        return heapBytesOf(runs_);
+    }
+
+    void InvalidUtf8Runs::shrinkToFit() {
+        runs_.shrink_to_fit();
+    }
+
+    std::vector<Range> InvalidUtf8Runs::within(Range range) const {
+        std::vector<Range> result;
+        for (usize i = firstRunEndingAfter(range.start()); i < runs_.size() && runs_[i].start() < range.end(); ++i) {
+            result.push_back(Range::makeUnchecked(
+                std::max(runs_[i].start(), range.start()),
+                std::min(runs_[i].end(), range.end())
+            ));
+        }
+        return result;
+    }
+} // namespace teks::buffer
@@ -0,0 +1,184 @@
+#include <teks/buffer/Utf8Index.hpp>
+#include <teks/assert.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    bool isCodepointStart(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+
+    // a codepoint outside the BMP is a surrogate pair in UTF-16
+    bool isFourByteLead(char c) {
+        return (static_cast<unsigned char>(c) & 0xF8) == 0xF0;
+    }
+
+    teks::u64 unitsOfByte(char c, teks::buffer::ColumnUnit unit) {
+        if (!isCodepointStart(c)) {
+            return 0;
+        }
+        return unit == teks::buffer::ColumnUnit::Utf16 && isFourByteLead(c) ? 2 : 1;
+    }
+}
+
+namespace teks::buffer {
+    Utf8Index::Utf8Index(std::string_view text) {
+        std::vector<Counts> chunks;
+        for (usize at = 0; at < text.size(); at += chunkBytes) {
+            chunks.push_back(count(text.substr(at, chunkBytes)));
+        }
+        chunks_.assign(chunks);
+    }
+
+    Utf8Index::Counts Utf8Index::count(std::string_view text) {
+        Counts counts{text.size(), 0, 0};
+        for (char c : text) {
+            const u64 start = isCodepointStart(c) ? 1 : 0;
+            counts.codepoints += start;
+            counts.utf16 += start + (isFourByteLead(c) ? 1 : 0);
+        }
+        return counts;
+    }
+
+    u64 Utf8Index::unitsOf(const Counts& counts, ColumnUnit unit) {
+        return unit == ColumnUnit::Utf16 ? counts.utf16 : counts.codepoints;
+    }
+
+    std::pair<usize, Utf8Index::Counts> Utf8Index::chunkAt(u64 at) const {
+        const auto found = chunks_.find([at](const Counts& sum) { return sum.bytes > at; });
+        if (found.item != nullptr || chunks_.empty()) {
+            return {found.index, found.before};
+        }
+        const usize last = chunks_.size() - 1;
+        return {last, found.before - chunks_[last]};
+    }
+
+    void Utf8Index::add(u64 at, const Counts& added) {
+        if (added.bytes == 0) {
+            return;
+        }
+        const usize chunk = chunkAt(at).first;
+        if (chunk == chunks_.size()) {
+            chunks_.push(added);
+        } else {
+            chunks_.set(chunk, chunks_[chunk] + added);
+        }
+    }
+
+    void Utf8Index::erase(u64 at, std::string_view erased) {
+        // the bytes after each chunk's part move up to `at`, so the next part is in the chunk found there
+        while (!erased.empty()) {
+            const auto [chunk, before] = chunkAt(at);
+            const Counts counts = chunks_[chunk];
+            const usize part = std::min<usize>(erased.size(), before.bytes + counts.bytes - at);
+            const Counts left = counts - count(erased.substr(0, part));
+            if (left.bytes == 0) {
+                chunks_.erase(chunk, chunk + 1);
+            } else {
+                chunks_.set(chunk, left);
+            }
+            erased.remove_prefix(part);
+        }
+    }
+
+    void Utf8Index::splitAt(std::string_view text, u64 at) {
+        const auto [chunk, before] = chunkAt(at);
+        if (chunk == chunks_.size() || chunks_[chunk].bytes <= chunkBytes * 2) {
+            return;
+        }
+        const std::string_view grown = text.substr(before.bytes, chunks_[chunk].bytes);
+        std::vector<Counts> pieces;
+        for (usize piece = 0; piece < grown.size(); piece += chunkBytes) {
+            pieces.push_back(count(grown.substr(piece, chunkBytes)));
+        }
+        chunks_.replace(chunk, chunk + 1, pieces);
+    }
+
+    void Utf8Index::inserted(std::string_view text, Offset at, Bytes size) {
+        TEKS_ASSERT(at.raw() + size.raw() <= text.size());
+        add(at.raw(), count(text.substr(at.raw(), size.raw())));
+        splitAt(text, at.raw());
+    }
+
+    void Utf8Index::erasing(std::string_view text, Range range) {
+        TEKS_ASSERT(range.end().raw() <= text.size());
+        erase(range.start().raw(), text.substr(range.start().raw(), range.size().raw()));
+    }
+
+    void Utf8Index::replacedEach(
+        std::string_view replaced,
+        std::string_view text,
+        std::span<const Replacement> replacements
+    ) {
+        if (replacements.empty()) {
+            return;
+        }
+        const u64 replacedStart = replacements.front().range.start().raw();
+        TEKS_ASSERT(replaced.size() == replacements.back().range.end().raw() - replacedStart);
+
+        // Counts are per byte, so each edit only changes the counts of the chunks it falls in. The edits
+        // are applied in order, each where the ones before it moved it to, which is also where it is in
+        // `text`. Chunks that grew too large are split once all of them are in.
+        // what the edits before one inserted and removed, modulo 2^64 as it may be a wrapped negative
+        u64 shift = 0;
+        for (const Replacement& replacement : replacements) {
+            const u64 start = replacement.range.start().raw();
+            erase(start + shift, replaced.substr(start - replacedStart, replacement.range.size().raw()));
+            add(start + shift, count(replacement.content));
+            shift += replacement.content.size() - replacement.range.size().raw();
+        }
+        TEKS_ASSERT(size().raw() == text.size());
+        shift = 0;
+        for (const Replacement& replacement : replacements) {
+            splitAt(text, replacement.range.start().raw() + shift);
+            shift += replacement.content.size() - replacement.range.size().raw();
+        }
+    }
+
+    Bytes Utf8Index::size() const {
+        return Bytes(chunks_.total().bytes);
+    }
+
+    HeapBytes Utf8Index::heapBytes() const {
+        return chunks_.heapBytes();
+    }
+
+    void Utf8Index::shrinkToFit() {
+        chunks_.shrinkToFit();
+    }
+
+    u64 Utf8Index::unitsBefore(std::string_view text, Offset at, ColumnUnit unit) const {
+        TEKS_ASSERT(at <= size());
+        const auto found = chunks_.find([at](const Counts& sum) { return sum.bytes > at.raw(); });
+        const u64 before = unitsOf(found.before, unit);
+        if (found.item == nullptr) {
+            return before;
+        }
+        const std::string_view head = text.substr(found.before.bytes, at.raw() - found.before.bytes);
+        return before + unitsOf(count(head), unit);
+    }
+
+    std::optional<Offset> Utf8Index::offsetOfUnit(std::string_view text, u64 index, ColumnUnit unit) const {
+        const u64 total = unitsOf(chunks_.total(), unit);
+        if (index > total) {
+            return std::nullopt;
+        }
+        if (index == total) {
+            return Offset(size());
+        }
+
+        const auto found = chunks_.find([index, unit](const Counts& sum) { return unitsOf(sum, unit) > index; });
+        const u64 chunkStart = found.before.bytes;
+        const u64 chunkEnd = chunkStart + found.item->bytes;
+        u64 remaining = index - unitsOf(found.before, unit);
+        for (u64 at = chunkStart; at < chunkEnd; ++at) {
+            const u64 units = unitsOfByte(text[at], unit);
+            if (units > remaining) {
+                return Offset(at);
+            }
+            remaining -= units;
+        }
+        TEKS_ASSERT_MSG(false, "Utf8Index chunk counts do not match the text");
+        return Offset(chunkEnd);
+    }
+} // namespace teks::buffer
@@ -0,0 +1,98 @@
+#include <teks/diff/LineDiff.hpp>
+#include <teks/diff/SequenceDiff.hpp>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using teks::u64;
+    using teks::usize;
+    using teks::ssize;
+
+    struct Line {
+        usize start;
+        usize size;
+        u64 hash;
+    };
+
+    struct Lines {
+        std::string_view text;
+        std::vector<Line> lines;
+        // where the lines end in `text`
+        usize end;
+
+        [[nodiscard]] usize size() const {
+            return lines.size();
+        }
+
+        // byte offset of line `index`, the end of the lines when `index` is `size()`
+        [[nodiscard]] usize offset(usize index) const {
+            return index < lines.size() ? lines[index].start : end;
+        }
+    };
+
+    // The lines of `text` in `[from, to)`, `from` is a line start and `to` a line start or the end of the text
+    Lines splitLines(std::string_view text, usize from, usize to) {
+        const std::hash<std::string_view> hash;
+        Lines result{text, {}, to};
+        usize start = from;
+        while (start < to) {
+            const usize newline = text.find('\n', start);
+            const usize end = newline == std::string_view::npos || newline >= to ? to : newline + 1;
+            const std::string_view line = text.substr(start, end - start);
+            result.lines.push_back(Line{start, line.size(), hash(line)});
+            start = end;
+        }
+        // the line after the last newline
+        if (to == text.size() && (to == 0 || text[to - 1] == '\n')) {
+            result.lines.push_back(Line{to, 0, hash(std::string_view())});
+        }
+        return result;
+    }
+}
+
+namespace teks::diff {
+    std::vector<LineEdit> diffLines(std::string_view before, std::string_view after) {
+        const usize common = static_cast<usize>(
+            std::mismatch(before.begin(), before.end(), after.begin(), after.end()).first - before.begin()
+        );
+        if (common == before.size() && common == after.size()) {
+            return {};
+        }
+
+        // the common start, back to the start of the line the texts first differ in
+        const usize lastNewline = common == 0 ? std::string_view::npos : before.rfind('\n', common - 1);
+        const usize start = lastNewline == std::string_view::npos ? 0 : lastNewline + 1;
+        const auto startLines = static_cast<usize>(std::count(before.begin(), before.begin() + static_cast<ssize>(start), '\n'));
+
+        // the common end, forward to a line start, not overlapping the common start
+        const usize limit = std::min(before.size(), after.size()) - common;
+        const usize commonEnd = static_cast<usize>(
+            std::mismatch(before.rbegin(), before.rbegin() + static_cast<ssize>(limit), after.rbegin()).first - before.rbegin()
+        );
+        const usize newline = before.find('\n', before.size() - commonEnd);
+        const usize keptEnd = newline == std::string_view::npos ? 0 : before.size() - newline - 1;
+
+        const Lines a = splitLines(before, start, before.size() - keptEnd);
+        const Lines b = splitLines(after, start, after.size() - keptEnd);
+        std::vector<LineEdit> edits;
+        const auto equal = [&a, &b](usize i, usize j) {
+            const Line& left = a.lines[i];
+            const Line& right = b.lines[j];
+            return left.hash == right.hash
+                && a.text.substr(left.start, left.size) == b.text.substr(right.start, right.size);
+        };
+        for (const Hunk& hunk : diffSequences(a.size(), b.size(), equal, maxEditDistance)) {
+            edits.push_back(LineEdit{
+                startLines + hunk.beforeStart,
+                hunk.beforeEnd - hunk.beforeStart,
+                startLines + hunk.afterStart,
+                hunk.afterEnd - hunk.afterStart,
+                buffer::Range::makeUnchecked(buffer::Offset(a.offset(hunk.beforeStart)), buffer::Offset(a.offset(hunk.beforeEnd))),
+                buffer::Range::makeUnchecked(buffer::Offset(b.offset(hunk.afterStart)), buffer::Offset(b.offset(hunk.afterEnd)))
+            });
+        }
+        return edits;
+    }
+} // namespace teks::diff
@@ -0,0 +1,91 @@
+#include <teks/diff/SequenceDiff.hpp>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace {
+    using teks::usize;
+    using teks::ssize;
+
+    // Walks the furthest reaching paths back from the end, collecting the matched elements
+    std::vector<std::pair<usize, usize>> backtrack(const std::vector<std::vector<ssize>>& trace, ssize x, ssize y) {
+        std::vector<std::pair<usize, usize>> matches;
+        const auto match = [&matches, &x, &y]() {
+            --x;
+            --y;
+            matches.emplace_back(static_cast<usize>(x), static_cast<usize>(y));
+        };
+        for (ssize d = static_cast<ssize>(trace.size()) - 1; d > 0; --d) {
+            const std::vector<ssize>& previous = trace[static_cast<usize>(d - 1)];
+            const auto furthest = [&previous, d](ssize k) { return previous[static_cast<usize>(k + d - 1)]; };
+            const ssize k = x - y;
+            const bool down = k == -d || (k != d && furthest(k - 1) < furthest(k + 1));
+            const ssize previousK = down ? k + 1 : k - 1;
+            const ssize previousX = furthest(previousK);
+            const ssize snakeStart = down ? previousX : previousX + 1;
+            while (x > snakeStart) {
+                match();
+            }
+            x = previousX;
+            y = previousX - previousK;
+        }
+        while (x > 0 && y > 0) {
+            match();
+        }
+        std::reverse(matches.begin(), matches.end());
+        return matches;
+    }
+}
+
+namespace teks::diff {
+    std::vector<Hunk> diffSequences(
+        usize beforeSize,
+        usize afterSize,
+        const std::function<bool(usize, usize)>& equal,
+        usize maxEditDistance
+    ) {
+        const auto n = static_cast<ssize>(beforeSize);
+        const auto m = static_cast<ssize>(afterSize);
+        const ssize maxD = std::min(n + m, static_cast<ssize>(maxEditDistance));
+        const ssize center = maxD + 1;
+        std::vector<ssize> v(static_cast<usize>(2 * maxD + 3), 0);
+        const auto at = [&v, center](ssize k) -> ssize& { return v[static_cast<usize>(center + k)]; };
+
+        // the diagonals each step could reach, for the backtrack
+        std::vector<std::vector<ssize>> trace;
+        bool found = false;
+        for (ssize d = 0; d <= maxD && !found; ++d) {
+            for (ssize k = -d; k <= d; k += 2) {
+                ssize x = k == -d || (k != d && at(k - 1) < at(k + 1)) ? at(k + 1) : at(k - 1) + 1;
+                ssize y = x - k;
+                while (x < n && y < m && equal(static_cast<usize>(x), static_cast<usize>(y))) {
+                    ++x;
+                    ++y;
+                }
+                at(k) = x;
+                if (x >= n && y >= m) {
+                    found = true;
+                    break;
+                }
+            }
+            trace.emplace_back(v.begin() + center - d, v.begin() + center + d + 1);
+        }
+        if (!found) {
+            return {Hunk{0, beforeSize, 0, afterSize}};
+        }
+        std::vector<std::pair<usize, usize>> matches = backtrack(trace, n, m);
+
+        std::vector<Hunk> hunks;
+        usize beforeAt = 0;
+        usize afterAt = 0;
+        matches.emplace_back(beforeSize, afterSize);
+        for (const auto& [i, j] : matches) {
+            if (i > beforeAt || j > afterAt) {
+                hunks.push_back(Hunk{beforeAt, i, afterAt, j});
+            }
+            beforeAt = i + 1;
+            afterAt = j + 1;
+        }
+        return hunks;
+    }
+} // namespace teks::diff
@@ -0,0 +1,659 @@
+#include <teks/editor/Document.hpp>
+#include <teks/assert.hpp>
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/NewlineStyleSet.hpp>
+#include <teks/diff/LineDiff.hpp>
+#include <teks/encoding/Encoding.hpp>
+#include <teks/metrics.hpp>
+#include <teks/ReplacementFile.hpp>
+#include <teks/trace.hpp>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace {
+    constexpr std::streamsize readChunkBytes = 1 << 20;
+    constexpr teks::u64 writeChunkBytes = 1 << 20;
+    // how much of the start of a file the encoding is guessed from
+    constexpr teks::usize detectionBytes = 64 * 1024;
+
+    bool readChunk(std::ifstream& file, std::string& chunk) {
+        chunk.resize(static_cast<teks::usize>(readChunkBytes));
+        file.read(chunk.data(), readChunkBytes);
+        chunk.resize(static_cast<teks::usize>(file.gcount()));
+        return !chunk.empty();
+    }
+
+    std::string_view newlineFor(const teks::buffer::NewlineStyleSet& styles) {
+        using Style = teks::buffer::NewlineStyleSet::Style;
+        if (styles.hasExactly({Style::Crlf})) {
+            return "\r\n";
+        }
+        if (styles.hasExactly({Style::Cr})) {
+            return "\r";
+        }
+        return "\n";
+    }
+
+    void addNewlineStyles(std::string_view text, teks::buffer::NewlineStyleSet& styles) {
+        using Style = teks::buffer::NewlineStyleSet::Style;
+        for (teks::usize at = text.find_first_of("\r\n"); at != std::string_view::npos; at = text.find_first_of("\r\n", at + 1)) {
+            if (text[at] == '\n') {
+                styles.add(Style::Lf);
+            } else if (at + 1 < text.size() && text[at + 1] == '\n') {
+                styles.add(Style::Crlf);
+                ++at;
+            } else {
+                styles.add(Style::Cr);
+            }
+        }
+    }
+
+    // `text` with its newlines as the buffer stores them, so what is inserted is known up front
+    std::string normalizedNewlines(std::string_view text) {
+        std::string result;
+        result.reserve(text.size());
+        for (teks::usize at = 0; at < text.size(); ++at) {
+            if (text[at] != '\r') {
+                result.push_back(text[at]);
+                continue;
+            }
+            result.push_back('\n');
+            if (at + 1 < text.size() && text[at + 1] == '\n') {
+                ++at;
+            }
+        }
+        return result;
+    }
+
+    // Where `at` is after `replaced` became `inserted` bytes: text before it stays, text after it
+    // moves, and an offset inside it, or at an insertion, ends up after what was inserted
+    teks::buffer::Offset movedOffset(teks::buffer::Offset at, teks::buffer::Range replaced, teks::buffer::Bytes inserted) {
+        if (at >= replaced.end()) {
+            return teks::buffer::Offset(at.raw() - replaced.size().raw() + inserted.raw());
+        }
+        if (at <= replaced.start()) {
+            return at;
+        }
+        return replaced.start() + inserted;
+    }
+
+    // Sorts `selections` and merges the ones that overlap, or that meet where one of them is a caret
+    void mergeSelections(std::vector<teks::editor::Document::Selection>& selections) {
+        using Selection = teks::editor::Document::Selection;
+        const auto byRange = [](const Selection& lhs, const Selection& rhs) {
+            const teks::buffer::Range left = lhs.range();
+            const teks::buffer::Range right = rhs.range();
+            return left.start() < right.start() || (left.start() == right.start() && left.end() < right.end());
+        };
+        // edits keep them sorted, only `setSelections` has to sort
+        if (!std::is_sorted(selections.begin(), selections.end(), byRange)) {
+            std::sort(selections.begin(), selections.end(), byRange);
+        }
+
+        teks::usize kept = 0;
+        for (teks::usize i = 1; i < selections.size(); ++i) {
+            Selection& previous = selections[kept];
+            const teks::buffer::Range previousRange = previous.range();
+            const teks::buffer::Range range = selections[i].range();
+            const bool merges = range.start() < previousRange.end()
+                || (range.start() == previousRange.end() && (range.size().raw() == 0 || previousRange.size().raw() == 0));
+            if (!merges) {
+                selections[++kept] = selections[i];
+                continue;
+            }
+            const teks::buffer::Offset end = std::max(previousRange.end(), range.end());
+            if (previous.head < previous.anchor) {
+                previous = Selection{end, previousRange.start()};
+            } else {
+                previous = Selection{previousRange.start(), end};
+            }
+        }
+        selections.resize(std::min(selections.size(), kept + 1));
+    }
+
+    // The codepoint before or after `at`, going back over continuation bytes, empty at either end
+    teks::buffer::Range codepointBeside(const teks::buffer::Buffer& buffer, teks::buffer::Offset at, bool backward) {
+        using teks::buffer::Offset;
+        using teks::buffer::Range;
+        constexpr teks::u64 maxSequenceBytes = 4;
+        const auto isContinuation = [](char c) { return (static_cast<unsigned char>(c) & 0xC0) == 0x80; };
+        if (backward) {
+            const Offset from(at.raw() - std::min(at.raw(), maxSequenceBytes));
+            const std::string bytes = buffer.readString(Range::makeUnchecked(from, at)).value();
+            teks::usize start = bytes.size();
+            while (start > 0 && isContinuation(bytes[--start])) {}
+            return Range::makeUnchecked(from + teks::buffer::Bytes(start), at);
+        }
+        const Offset to(std::min(buffer.size().raw(), at.raw() + maxSequenceBytes));
+        const std::string bytes = buffer.readString(Range::makeUnchecked(at, to)).value();
+        teks::usize end = std::min<teks::usize>(bytes.size(), 1);
+        while (end < bytes.size() && isContinuation(bytes[end])) {
+            ++end;
+        }
+        return Range::makeUnchecked(at, teks::buffer::Bytes(end));
+    }
+}
+
+namespace teks::editor {
+    std::optional<Document> Document::openFile(std::filesystem::path path) {
+        TEKS_MEASURE_LATENCY(FileOpen);
+        std::optional<Document> document = readFile(std::move(path));
+        if (!document.has_value()) {
+            return std::nullopt;
+        }
+        // the journal is replayed before a new one replaces it
+        const std::filesystem::path journalPath = buffer::Journal::pathFor(document->path_);
+        const bool recovered = buffer::Journal::recover(journalPath, document->buffer_);
+        document->journal_ = std::make_unique<buffer::Journal>(journalPath, document->savedContentHash_);
+        if (recovered) {
+            document->journal_->checkpoint(buffer::readAllString(document->buffer_));
+        }
+        return document;
+    }
+
+    std::optional<Document> Document::readFile(std::filesystem::path path) {
+        TEKS_TRACE_SCOPE("Document::readFile");
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+
+        std::string chunk;
+        readChunk(file, chunk);
+        const encoding::Encoding encoding = encoding::detectEncoding(
+            std::string_view(chunk).substr(0, detectionBytes),
+            file.eof() && chunk.size() <= detectionBytes
+        );
+
+        // decoded before newlines are normalized, so UTF-16 newlines are found like any other
+        std::string text;
+        std::error_code error;
+        const auto fileSize = std::filesystem::file_size(path, error);
+        if (!error) {
+            text.reserve(static_cast<usize>(fileSize));
+        }
+        encoding::Utf8Decoder decoder(encoding);
+        u64 bytesRead = 0;
+        do {
+            bytesRead += chunk.size();
+            decoder.decode(chunk, text);
+        } while (readChunk(file, chunk));
+        decoder.finish(text);
+        const bool endsWithCr = !text.empty() && text.back() == '\r';
+        buffer::NewlineStyleSet newlineStylesBeforeCr;
+        if (endsWithCr) {
+            addNewlineStyles(std::string_view(text).substr(0, text.size() - 1), newlineStylesBeforeCr);
+        }
+
+        auto memory = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+        auto [buffer, newlineStyleSet] = buffer::Buffer::fromRawText(std::move(text), memory.get());
+
+        Document document(
+            std::move(memory),
+            std::move(buffer),
+            std::move(path),
+            newlineStyleSet,
+            encoding
+        );
+        document.fileBytesRead_ = bytesRead;
+        document.endsWithCr_ = endsWithCr;
+        document.newlineStylesBeforeCr_ = newlineStylesBeforeCr;
+        return std::optional<Document>(std::move(document));
+    }
+
+    Document::Document()
+        : Document(buffer::Buffer())
+    {}
+
+    Document::Document(teks::buffer::Buffer buffer)
+        : Document(std::move(buffer), std::filesystem::path())
+    {}
+
+    Document::Document(teks::buffer::Buffer buffer, std::filesystem::path path)
+        : Document(
+            std::make_unique<std::pmr::unsynchronized_pool_resource>(),
+            std::move(buffer),
+            std::move(path),
+            buffer::NewlineStyleSet::of({buffer::NewlineStyleSet::Style::Lf}),
+            encoding::Encoding()
+        )
+    {}
+
+    Document::Document(
+        std::unique_ptr<std::pmr::unsynchronized_pool_resource> memory,
+        teks::buffer::Buffer buffer,
+        std::filesystem::path path,
+        buffer::NewlineStyleSet newLineStyleSet,
+        encoding::Encoding encoding
+    ) : memory_(std::move(memory))
+        , buffer_(std::move(buffer), memory_.get())
+        , path_(std::move(path))
+        , newLineStyleSet_(newLineStyleSet)
+        , encoding_(encoding)
+        , savedContentHash_(buffer_.contentHash())
+    {}
+
+    teks::buffer::Buffer& Document::buffer() {
+        return buffer_;
+    }
+
+    const teks::buffer::Buffer& Document::buffer() const {
+        return buffer_;
+    }
+
+    const std::filesystem::path& Document::path() const {
+        return path_;
+    }
+
+    const encoding::Encoding& Document::encoding() const {
+        return encoding_;
+    }
+
+    buffer::Range Document::Selection::range() const {
+        return buffer::Range::makeUnchecked(std::min(anchor, head), std::max(anchor, head));
+    }
+
+    const std::vector<Document::Selection>& Document::selections() const {
+        return selections_;
+    }
+
+    void Document::setSelections(std::vector<Selection> selections) {
+        const buffer::Offset end(buffer_.size());
+        for (Selection& selection : selections) {
+            selection = Selection{std::min(selection.anchor, end), std::min(selection.head, end)};
+        }
+        if (selections.empty()) {
+            selections.push_back(Selection{});
+        }
+        mergeSelections(selections);
+        selections_ = std::move(selections);
+    }
+
+    bool Document::insertAtSelections(std::string_view text) {
+        const std::string normalized = text.find('\r') == std::string_view::npos ? std::string() : normalizedNewlines(text);
+        const std::string_view content = normalized.empty() ? text : normalized;
+        std::vector<buffer::Replacement> edits;
+        edits.reserve(selections_.size());
+        for (const Selection& selection : selections_) {
+            edits.push_back(buffer::Replacement{selection.range(), content});
+        }
+        return replaceAtSelections(std::move(edits));
+    }
+
+    bool Document::eraseBackward() {
+        return eraseAtSelections(true);
+    }
+
+    bool Document::eraseForward() {
+        return eraseAtSelections(false);
+    }
+
+    bool Document::eraseAtSelections(bool backward) {
+        std::vector<buffer::Replacement> edits;
+        edits.reserve(selections_.size());
+        for (usize i = 0; i < selections_.size(); ++i) {
+            buffer::Range range = selections_[i].range();
+            if (range.size().raw() == 0) {
+                range = codepointBeside(buffer_, range.start(), backward);
+                // a selection starting inside the codepoint keeps what it selects
+                if (backward && i > 0) {
+                    const buffer::Offset previousEnd = edits.back().range.end();
+                    range = buffer::Range::makeUnchecked(std::max(range.start(), previousEnd), range.end());
+                } else if (!backward && i + 1 < selections_.size()) {
+                    const buffer::Offset nextStart = selections_[i + 1].range().start();
+                    range = buffer::Range::makeUnchecked(range.start(), std::min(range.end(), nextStart));
+                }
+            }
+            edits.push_back(buffer::Replacement{range, {}});
+        }
+        return replaceAtSelections(std::move(edits));
+    }
+
+    bool Document::replaceAtSelections(std::vector<buffer::Replacement> edits) {
+        TEKS_ASSERT(edits.size() == selections_.size());
+        const bool changesNothing = std::all_of(edits.begin(), edits.end(), [](const buffer::Replacement& edit) {
+            return edit.range.size().raw() == 0 && edit.content.empty();
+        });
+        if (changesNothing) {
+            return true;
+        }
+
+        const auto span = buffer::Range::makeUnchecked(edits.front().range.start(), edits.back().range.end());
+        const auto first = buffer_.positionOf(span.start(), buffer::ColumnUnit::Codepoint);
+        const auto last = buffer_.positionOf(span.end(), buffer::ColumnUnit::Codepoint);
+        if (!first.has_value() || !last.has_value() || !buffer_.replaceEach(edits)) {
+            return false;
+        }
+
+        // each caret goes after its edit's content, moved by what the edits before it inserted and removed
+        u64 inserted = 0;
+        u64 removed = 0;
+        for (usize i = 0; i < edits.size(); ++i) {
+            inserted += edits[i].content.size();
+            const buffer::Offset caret(edits[i].range.start().raw() + inserted - removed);
+            removed += edits[i].range.size().raw();
+            selections_[i] = Selection{caret, caret};
+        }
+        mergeSelections(selections_);
+
+        // dependents see the edits as one change from the first to the last
+        const buffer::Bytes insertedBytes(span.size().raw() + inserted - removed);
+        const usize insertedLastLine = buffer_.positionOf(span.start() + insertedBytes, buffer::ColumnUnit::Codepoint)->line;
+        recordChange(span, insertedBytes, LinesReplaced{
+            first->line,
+            last->line - first->line + 1,
+            insertedLastLine - first->line + 1,
+        });
+        if (journal_ != nullptr) {
+            journal_->recordReplaceEach(edits);
+            if (journal_->wantsCheckpoint()) {
+                journal_->checkpoint(buffer::readAllString(buffer_));
+            }
+        }
+        return true;
+    }
+
+    void Document::moveSelections(buffer::Range replaced, buffer::Bytes inserted) {
+        for (Selection& selection : selections_) {
+            selection = Selection{
+                movedOffset(selection.anchor, replaced, inserted),
+                movedOffset(selection.head, replaced, inserted),
+            };
+        }
+        mergeSelections(selections_);
+    }
+
+    bool Document::replace(buffer::Range range, std::string_view content) {
+        const u64 oldSize = buffer_.size().raw();
+        const auto first = buffer_.positionOf(range.start(), buffer::ColumnUnit::Codepoint);
+        const auto last = buffer_.positionOf(range.end(), buffer::ColumnUnit::Codepoint);
+        if (!first.has_value() || !last.has_value() || !buffer_.replace(range, content)) {
+            return false;
+        }
+
+        // the buffer normalized the content, dependents and the journal see what the buffer holds
+        const auto insertedRange = buffer::Range::makeUnchecked(
+            range.start(),
+            buffer::Bytes(buffer_.size().raw() + range.size().raw() - oldSize)
+        );
+        const std::string inserted = buffer_.readString(insertedRange).value();
+        moveSelections(range, insertedRange.size());
+        recordChange(range, insertedRange.size(), LinesReplaced{
+            first->line,
+            last->line - first->line + 1,
+            static_cast<usize>(std::count(inserted.begin(), inserted.end(), '\n')) + 1,
+        });
+        if (journal_ != nullptr) {
+            journal_->recordReplace(range, inserted);
+            if (journal_->wantsCheckpoint()) {
+                journal_->checkpoint(buffer::readAllString(buffer_));
+            }
+        }
+        return true;
+    }
+
+    u64 Document::generation() const {
+        return generation_;
+    }
+
+    MemoryUsage Document::memoryUsage() const {
+        MemoryUsage usage = buffer_.memoryUsage();
+        if (journal_) {
+            const HeapBytes queued = journal_->queuedBytes();
+            usage.undoHistory += queued.used;
+            usage.slack += queued.slack;
+        }
+        return usage;
+    }
+
+    void Document::shrinkToFit() {
+        buffer_.shrinkToFit();
+        changes_.shrink_to_fit();
+        selections_.shrink_to_fit();
+    }
+
+    std::vector<Document::Change> Document::takeChanges() {
+        return std::exchange(changes_, {});
+    }
+
+    void Document::recordChange(buffer::Range replaced, buffer::Bytes inserted, LinesReplaced lines) {
+        ++generation_;
+        if (!changes_.empty()) {
+            // `previous` is in the document before it, the new change in the document after it
+            Change& previous = changes_.back();
+            const u64 previousStart = previous.replaced.start().raw();
+            const u64 previousEnd = previousStart + previous.inserted.raw();
+            const usize previousLinesEnd = previous.lines.first + previous.lines.inserted;
+            const bool touches = replaced.start().raw() <= previousEnd && replaced.end().raw() >= previousStart
+                && lines.first <= previousLinesEnd && lines.first + lines.removed >= previous.lines.first;
+            if (touches) {
+                // the union of both, mapped back to before `previous` where it reaches past it
+                const u64 start = std::min(previousStart, replaced.start().raw());
+                const u64 end = std::max(previousEnd, replaced.end().raw());
+                previous.replaced = buffer::Range::makeUnchecked(
+                    buffer::Offset(start),
+                    buffer::Offset(end - previous.inserted.raw() + previous.replaced.size().raw())
+                );
+                previous.inserted = buffer::Bytes(end - start - replaced.size().raw() + inserted.raw());
+
+                const usize first = std::min(previous.lines.first, lines.first);
+                const usize linesEnd = std::max(previousLinesEnd, lines.first + lines.removed);
+                previous.lines = LinesReplaced{
+                    first,
+                    linesEnd - previous.lines.inserted + previous.lines.removed - first,
+                    linesEnd - first - lines.removed + lines.inserted,
+                };
+                previous.generation = generation_;
+                return;
+            }
+        }
+        changes_.push_back(Change{replaced, inserted, lines, generation_});
+    }
+
+    void Document::flushJournal() {
+        if (journal_ != nullptr) {
+            journal_->flush();
+        }
+    }
+
+    bool Document::modified() const {
+        return buffer_.contentHash() != savedContentHash_;
+    }
+
+    bool Document::conflicted() const {
+        return conflicted_;
+    }
+
+    Document::SaveResult Document::save(bool allowLossy) {
+        TEKS_MEASURE_LATENCY(FileSave);
+        if (path_.empty()) {
+            return SaveResult::Failed;
+        }
+        std::optional<ReplacementFile> file = ReplacementFile::create(path_);
+        if (!file.has_value()) {
+            return SaveResult::Failed;
+        }
+
+        const std::string_view newline = newlineFor(newLineStyleSet_);
+        encoding::Utf8Encoder encoder(encoding_);
+        std::string raw;
+        std::string encoded;
+        u64 written = 0;
+        const u64 size = buffer_.size().raw();
+        for (u64 at = 0; at < size; at += writeChunkBytes) {
+            const auto range = buffer::Range::makeUnchecked(
+                buffer::Offset(at),
+                buffer::Offset(std::min(size, at + writeChunkBytes))
+            );
+            const std::string chunk = buffer_.readString(range).value();
+            raw.clear();
+            for (char c : chunk) {
+                if (c == '\n') {
+                    raw.append(newline);
+                } else {
+                    raw.push_back(c);
+                }
+            }
+            encoded.clear();
+            encoder.encode(raw, encoded);
+            // the old file is kept, the temporary one is removed
+            if (encoder.lossy() && !allowLossy) {
+                return SaveResult::Lossy;
+            }
+            if (!file->write(encoded)) {
+                return SaveResult::Failed;
+            }
+            written += encoded.size();
+        }
+        encoded.clear();
+        encoder.finish(encoded);
+        if (encoder.lossy() && !allowLossy) {
+            return SaveResult::Lossy;
+        }
+        if (!file->write(encoded)) {
+            return SaveResult::Failed;
+        }
+        written += encoded.size();
+        // the journal is only restarted once its base is replaced by what was saved
+        if (!file->commit()) {
+            return SaveResult::Failed;
+        }
+
+        savedContentHash_ = buffer_.contentHash();
+        conflicted_ = false;
+        // what is appended to the file from here on follows what was written
+        fileBytesRead_ = written;
+        endsWithCr_ = newline == "\r" && buffer_.size().raw() > 0
+            && buffer_.readString(buffer::Range::makeUnchecked(buffer::Offset(size - 1), buffer::Offset(size))) == "\n";
+        // every newline written was a Cr, whether there are any before the last one is in the line count
+        newlineStylesBeforeCr_ = endsWithCr_ && buffer_.lineCount() > 2
+            ? buffer::NewlineStyleSet::of({buffer::NewlineStyleSet::Style::Cr})
+            : buffer::NewlineStyleSet();
+        appendDecoder_.reset();
+        if (journal_ != nullptr) {
+            journal_->restart(savedContentHash_);
+        }
+        return SaveResult::Saved;
+    }
+
+    std::vector<Document::LinesReplaced> Document::readAppended() {
+        if (path_.empty()) {
+            return {};
+        }
+        std::error_code error;
+        const auto fileSize = std::filesystem::file_size(path_, error);
+        if (error || fileSize == fileBytesRead_) {
+            return {};
+        }
+
+        if (fileSize < fileBytesRead_) {
+            return reload();
+        }
+        if (modified()) {
+            // the journal's edits apply to the file as it was, the unsaved edits are kept as they are
+            conflicted_ = true;
+            return {};
+        }
+
+        std::ifstream file(path_, std::ios::binary);
+        if (!file || !file.seekg(static_cast<std::streamoff>(fileBytesRead_))) {
+            return {};
+        }
+        if (!appendDecoder_.has_value()) {
+            // the byte order mark, if any, was at the start of the file
+            appendDecoder_.emplace(encoding::Encoding{encoding_.charset, false});
+        }
+        // streamed into the buffer a chunk at a time, however much was appended
+        std::string chunk;
+        std::string decoded;
+        const buffer::ChunkReader reader = [&]() {
+            while (readChunk(file, chunk)) {
+                fileBytesRead_ += chunk.size();
+                decoded.clear();
+                appendDecoder_->decode(chunk, decoded);
+                std::string_view appended = decoded;
+                if (endsWithCr_ && appended.starts_with('\n')) {
+                    // the '\r' already ended the last line, and was counted as Cr rather than Crlf
+                    newLineStyleSet_ = newlineStylesBeforeCr_;
+                    newLineStyleSet_.add(buffer::NewlineStyleSet::Style::Crlf);
+                    appended.remove_prefix(1);
+                }
+                if (!appended.empty()) {
+                    endsWithCr_ = appended.back() == '\r';
+                    if (endsWithCr_) {
+                        newlineStylesBeforeCr_ = newLineStyleSet_;
+                        addNewlineStyles(appended.substr(0, appended.size() - 1), newlineStylesBeforeCr_);
+                    }
+                    addNewlineStyles(appended, newLineStyleSet_);
+                    return appended;
+                }
+            }
+            return std::string_view();
+        };
+
+        // the last line grows, and every newline appended starts another
+        const usize oldLineCount = buffer_.lineCount();
+        const buffer::Offset oldEnd(buffer_.size());
+        (void)buffer_.insert(oldEnd, reader);
+        if (buffer::Offset(buffer_.size()) == oldEnd) {
+            return {};
+        }
+        const LinesReplaced lines{oldLineCount - 1, 1, buffer_.lineCount() - oldLineCount + 1};
+        moveSelections(buffer::Range::makeUnchecked(oldEnd, oldEnd), buffer::Offset(buffer_.size()) - oldEnd);
+        recordChange(buffer::Range::makeUnchecked(oldEnd, oldEnd), buffer::Offset(buffer_.size()) - oldEnd, lines);
+        savedContentHash_ = buffer_.contentHash();
+        if (journal_ != nullptr) {
+            journal_->restart(savedContentHash_);
+        }
+        return {lines};
+    }
+
+    std::vector<Document::LinesReplaced> Document::reload() {
+        if (path_.empty()) {
+            return {};
+        }
+        std::optional<Document> reloaded = readFile(path_);
+        if (!reloaded.has_value()) {
+            return {};
+        }
+        if (modified()) {
+            // unsaved edits are never discarded, nor is the journal that recovers them
+            conflicted_ = conflicted_ || reloaded->savedContentHash_ != savedContentHash_;
+            return {};
+        }
+
+        const std::string before = buffer::readAllString(buffer_);
+        const std::string after = buffer::readAllString(reloaded->buffer_);
+        std::vector<LinesReplaced> replaced;
+        const std::vector<diff::LineEdit> edits = diff::diffLines(before, after);
+        for (const diff::LineEdit& edit : edits) {
+            // everything before the edit already matches the new text, so its coordinates apply
+            const buffer::Offset at = edit.insertedBytes.start();
+            const auto range = buffer::Range::makeUnchecked(at, edit.removedBytes.size());
+            (void)buffer_.replace(range, std::string_view(after).substr(at.raw(), edit.insertedBytes.size().raw()));
+            replaced.push_back(LinesReplaced{edit.insertedFirst, edit.removed, edit.inserted});
+            moveSelections(range, edit.insertedBytes.size());
+            recordChange(range, edit.insertedBytes.size(), replaced.back());
+        }
+
+        newLineStyleSet_ = reloaded->newLineStyleSet_;
+        encoding_ = reloaded->encoding_;
+        fileBytesRead_ = reloaded->fileBytesRead_;
+        endsWithCr_ = reloaded->endsWithCr_;
+        newlineStylesBeforeCr_ = reloaded->newlineStylesBeforeCr_;
+        appendDecoder_.reset();
+        savedContentHash_ = buffer_.contentHash();
+        conflicted_ = false;
+        if (journal_ != nullptr) {
+            journal_->restart(savedContentHash_);
+        }
+        return replaced;
+    }
+}
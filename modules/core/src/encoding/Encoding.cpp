@@ -0,0 +1,379 @@
+#include <teks/encoding/Encoding.hpp>
+#include <teks/assert.hpp>
+#include <teks/buffer/Utf8.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+    using teks::u8;
+    using teks::u32;
+    using teks::u64;
+    using teks::usize;
+    using teks::encoding::Charset;
+
+    constexpr char16_t replacementCharacter = u'\uFFFD';
+    // UTF-8 is transcoded through a UTF-16 scratch buffer of at most this many bytes at a time
+    constexpr usize sliceBytes = 64 * 1024;
+    // 8 UTF-16 code units
+    constexpr usize utf16BlockBytes = 16;
+
+    void appendCodepoint(u32 codepoint, std::string& out) {
+        if (codepoint < 0x80) {
+            out.push_back(static_cast<char>(codepoint));
+        } else if (codepoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        } else if (codepoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    bool isHighSurrogate(char16_t unit) {
+        return unit >= 0xD800 && unit <= 0xDBFF;
+    }
+
+    bool isLowSurrogate(char16_t unit) {
+        return unit >= 0xDC00 && unit <= 0xDFFF;
+    }
+
+    char16_t readUnit(const char* bytes, Charset charset) {
+        const auto first = static_cast<u8>(bytes[0]);
+        const auto second = static_cast<u8>(bytes[1]);
+        return charset == Charset::Utf16Le
+            ? static_cast<char16_t>(first | (second << 8))
+            : static_cast<char16_t>((first << 8) | second);
+    }
+
+    // Whether the 8 code units at `block` are all ASCII, checked a word at a time
+    bool isAsciiUtf16Block(const char* block, Charset charset) {
+        u64 words[2];
+        std::memcpy(words, block, utf16BlockBytes);
+        const u64 bytes = words[0] | words[1];
+        // the high byte of each unit comes second in little endian data
+        const bool highBytesOdd = (charset == Charset::Utf16Le) == (std::endian::native == std::endian::little);
+        const u64 highBytes = highBytesOdd ? 0xFF00FF00FF00FF00ull : 0x00FF00FF00FF00FFull;
+        return (bytes & (highBytes | 0x8080808080808080ull)) == 0;
+    }
+
+    usize utf8SequenceLength(u8 lead) {
+        if (lead >= 0xF0) {
+            return 4;
+        }
+        if (lead >= 0xE0) {
+            return 3;
+        }
+        return lead >= 0xC0 ? 2 : 1;
+    }
+
+    // Whether `rest` could be the start of a sequence that continues in the next chunk
+    bool isIncompleteSequence(std::string_view rest) {
+        const auto lead = static_cast<u8>(rest[0]);
+        if (lead < 0xC2 || lead > 0xF4 || rest.size() >= utf8SequenceLength(lead)) {
+            return false;
+        }
+        return std::all_of(rest.begin() + 1, rest.end(), [](char c) {
+            return (static_cast<u8>(c) & 0xC0) == 0x80;
+        });
+    }
+}
+
+namespace teks::encoding {
+    std::string_view byteOrderMark(Encoding encoding) {
+        if (!encoding.bom) {
+            return {};
+        }
+        switch (encoding.charset) {
+            case Charset::Utf8: return "\xEF\xBB\xBF";
+            case Charset::Utf16Le: return "\xFF\xFE";
+            case Charset::Utf16Be: return "\xFE\xFF";
+            case Charset::Latin1: break;
+        }
+        return {};
+    }
+
+    Encoding detectEncoding(std::string_view head, bool complete) {
+        for (Charset charset : {Charset::Utf8, Charset::Utf16Le, Charset::Utf16Be}) {
+            const Encoding withBom{charset, true};
+            if (head.starts_with(byteOrderMark(withBom))) {
+                return withBom;
+            }
+        }
+
+        usize evenZeros = 0;
+        usize oddZeros = 0;
+        for (usize i = 0; i + 1 < head.size(); i += 2) {
+            evenZeros += head[i] == '\0' ? usize{1} : usize{0};
+            oddZeros += head[i + 1] == '\0' ? usize{1} : usize{0};
+        }
+        const usize units = head.size() / 2;
+        if (units > 0 && oddZeros * 4 >= units && evenZeros * 4 < oddZeros) {
+            return Encoding{Charset::Utf16Le, false};
+        }
+        if (units > 0 && evenZeros * 4 >= units && oddZeros * 4 < evenZeros) {
+            return Encoding{Charset::Utf16Be, false};
+        }
+
+        const buffer::InvalidUtf8Runs invalid(head);
+        usize invalidBytes = 0;
+        usize invalidLeads = 0;
+        for (const buffer::Range& run : invalid.runs()) {
+            const std::string_view bytes = head.substr(run.start().raw(), run.size().raw());
+            // a sequence cut off by the end of the sample is not evidence either way
+            if (!complete && run.end().raw() == head.size() && isIncompleteSequence(bytes)) {
+                continue;
+            }
+            invalidBytes += bytes.size();
+            invalidLeads += static_cast<usize>(std::count_if(bytes.begin(), bytes.end(), [](char c) {
+                return static_cast<u8>(c) >= 0xC0;
+            }));
+        }
+        if (invalidBytes == 0) {
+            return Encoding{Charset::Utf8, false};
+        }
+        const auto leads = static_cast<usize>(std::count_if(head.begin(), head.end(), [](char c) {
+            return static_cast<u8>(c) >= 0xC0;
+        }));
+        return leads - invalidLeads > invalidBytes
+            ? Encoding{Charset::Utf8, false}
+            : Encoding{Charset::Latin1, false};
+    }
+
+    // #region Utf8Decoder
+    Utf8Decoder::Utf8Decoder(Encoding encoding)
+        : encoding_(encoding)
+        , bomRemaining_(byteOrderMark(encoding).size())
+    {}
+
+    void Utf8Decoder::decode(std::string_view chunk, std::string& out) {
+        const usize bom = std::min(bomRemaining_, chunk.size());
+        chunk.remove_prefix(bom);
+        bomRemaining_ -= bom;
+
+        switch (encoding_.charset) {
+            case Charset::Utf8:
+                out.append(chunk);
+                break;
+            case Charset::Latin1:
+                while (!chunk.empty()) {
+                    const usize ascii = buffer::asciiPrefix(chunk);
+                    out.append(chunk.substr(0, ascii));
+                    chunk.remove_prefix(ascii);
+                    if (!chunk.empty()) {
+                        appendCodepoint(static_cast<u8>(chunk[0]), out);
+                        chunk.remove_prefix(1);
+                    }
+                }
+                break;
+            case Charset::Utf16Le:
+            case Charset::Utf16Be:
+                decodeUtf16(chunk, out);
+                break;
+        }
+    }
+
+    void Utf8Decoder::decodeUtf16(std::string_view chunk, std::string& out) {
+        const Charset charset = encoding_.charset;
+        if (chunk.empty()) {
+            return;
+        }
+        if (!pending_.empty()) {
+            const char bytes[2]{pending_[0], chunk[0]};
+            decodeUnit(readUnit(bytes, charset), out);
+            pending_.clear();
+            chunk.remove_prefix(1);
+        }
+
+        const usize lowByte = charset == Charset::Utf16Le ? 0 : 1;
+        while (chunk.size() >= 2) {
+            if (pendingHighSurrogate_ == 0 && chunk.size() >= utf16BlockBytes && isAsciiUtf16Block(chunk.data(), charset)) {
+                for (usize i = 0; i < utf16BlockBytes; i += 2) {
+                    out.push_back(chunk[i + lowByte]);
+                }
+                chunk.remove_prefix(utf16BlockBytes);
+                continue;
+            }
+            decodeUnit(readUnit(chunk.data(), charset), out);
+            chunk.remove_prefix(2);
+        }
+        pending_.assign(chunk);
+    }
+
+    void Utf8Decoder::decodeUnit(char16_t unit, std::string& out) {
+        if (pendingHighSurrogate_ != 0) {
+            const char16_t high = pendingHighSurrogate_;
+            pendingHighSurrogate_ = 0;
+            if (isLowSurrogate(unit)) {
+                appendCodepoint(0x10000 + ((u32{high} - 0xD800) << 10) + (u32{unit} - 0xDC00), out);
+                return;
+            }
+            appendCodepoint(replacementCharacter, out);
+        }
+        if (isHighSurrogate(unit)) {
+            pendingHighSurrogate_ = unit;
+        } else if (isLowSurrogate(unit)) {
+            appendCodepoint(replacementCharacter, out);
+        } else {
+            appendCodepoint(unit, out);
+        }
+    }
+
+    void Utf8Decoder::finish(std::string& out) {
+        if (pendingHighSurrogate_ != 0) {
+            appendCodepoint(replacementCharacter, out);
+            pendingHighSurrogate_ = 0;
+        }
+        if (!pending_.empty()) {
+            appendCodepoint(replacementCharacter, out);
+            pending_.clear();
+        }
+    }
+    // #endregion Utf8Decoder
+
+    // #region Utf8Encoder
+    Utf8Encoder::Utf8Encoder(Encoding encoding)
+        : encoding_(encoding)
+    {}
+
+    void Utf8Encoder::encode(std::string_view chunk, std::string& out) {
+        if (!started_) {
+            out.append(byteOrderMark(encoding_));
+            started_ = true;
+        }
+        if (encoding_.charset == Charset::Utf8) {
+            out.append(chunk);
+            return;
+        }
+
+        if (!pending_.empty()) {
+            // a sequence split by the previous chunk needs at most 3 more bytes
+            const usize take = std::min<usize>(chunk.size(), 3);
+            std::string head = std::move(pending_);
+            pending_.clear();
+            const usize before = head.size();
+            head.append(chunk.substr(0, take));
+            const usize used = encodeSome(head, out, false);
+            if (used < before) {
+                pending_ = head.substr(used);
+                return;
+            }
+            chunk.remove_prefix(used - before);
+        }
+        pending_.assign(chunk.substr(encodeSome(chunk, out, false)));
+    }
+
+    void Utf8Encoder::finish(std::string& out) {
+        if (!started_) {
+            out.append(byteOrderMark(encoding_));
+            started_ = true;
+        }
+        if (!pending_.empty()) {
+            (void)encodeSome(pending_, out, true);
+            pending_.clear();
+        }
+    }
+
+    bool Utf8Encoder::lossy() const {
+        return lossy_;
+    }
+
+    usize Utf8Encoder::encodeSome(std::string_view text, std::string& out, bool final) {
+        usize at = 0;
+        while (at < text.size()) {
+            const std::string_view rest = text.substr(at);
+            const usize ascii = buffer::asciiPrefix(rest);
+            if (ascii > 0) {
+                if (encoding_.charset == Charset::Latin1) {
+                    out.append(rest.substr(0, ascii));
+                } else {
+                    const bool little = encoding_.charset == Charset::Utf16Le;
+                    for (usize i = 0; i < ascii; ++i) {
+                        out.push_back(little ? rest[i] : '\0');
+                        out.push_back(little ? '\0' : rest[i]);
+                    }
+                }
+                at += ascii;
+                continue;
+            }
+
+            const std::string_view slice = rest.substr(0, sliceBytes);
+            const usize valid = buffer::validUtf8Prefix(slice);
+            if (valid > 0) {
+                units_.resize(valid);
+                units_.resize(buffer::decodeValidUtf8(slice.substr(0, valid), units_.data()));
+                encodeUnits(units_, out);
+                at += valid;
+                continue;
+            }
+
+            if (!final && isIncompleteSequence(rest)) {
+                break;
+            }
+            const char16_t replacement = replacementCharacter;
+            encodeUnits(std::u16string_view(&replacement, 1), out);
+            lossy_ = true;
+            ++at;
+        }
+        return at;
+    }
+
+    void Utf8Encoder::encodeUnits(std::u16string_view units, std::string& out) {
+        switch (encoding_.charset) {
+            case Charset::Utf16Le:
+                for (char16_t unit : units) {
+                    out.push_back(static_cast<char>(unit & 0xFF));
+                    out.push_back(static_cast<char>(unit >> 8));
+                }
+                break;
+            case Charset::Utf16Be:
+                for (char16_t unit : units) {
+                    out.push_back(static_cast<char>(unit >> 8));
+                    out.push_back(static_cast<char>(unit & 0xFF));
+                }
+                break;
+            case Charset::Latin1:
+                for (usize i = 0; i < units.size(); ++i) {
+                    if (units[i] <= 0xFF) {
+                        out.push_back(static_cast<char>(units[i]));
+                        continue;
+                    }
+                    // one '?' for a whole surrogate pair
+                    if (isHighSurrogate(units[i]) && i + 1 < units.size() && isLowSurrogate(units[i + 1])) {
+                        ++i;
+                    }
+                    out.push_back('?');
+                    lossy_ = true;
+                }
+                break;
+            case Charset::Utf8:
+                TEKS_ASSERT_MSG(false, "UTF-8 is passed through without decoding");
+                break;
+        }
+    }
+    // #endregion Utf8Encoder
+
+    std::string decodeToUtf8(std::string_view text, Encoding encoding) {
+        std::string result;
+        result.reserve(text.size());
+        Utf8Decoder decoder(encoding);
+        decoder.decode(text, result);
+        decoder.finish(result);
+        return result;
+    }
+
+    std::string encodeFromUtf8(std::string_view text, Encoding encoding) {
+        std::string result;
+        result.reserve(text.size());
+        Utf8Encoder encoder(encoding);
+        encoder.encode(text, result);
+        encoder.finish(result);
+        return result;
+    }
+} // namespace teks::encoding
@@ -0,0 +1,84 @@
+#include <teks/hash.hpp>
+#include <bit>
+#include <cstring>
+
+namespace {
+    using teks::u32;
+    using teks::u64;
+    using teks::usize;
+
+    constexpr u64 prime1 = 0x9E3779B185EBCA87ull;
+    constexpr u64 prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr u64 prime3 = 0x165667B19E3779F9ull;
+    constexpr u64 prime4 = 0x85EBCA77C2B2AE63ull;
+    constexpr u64 prime5 = 0x27D4EB2F165667C5ull;
+
+    u64 read64(const char* at) {
+        u64 value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    u32 read32(const char* at) {
+        u32 value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    u64 round(u64 accumulator, u64 input) {
+        accumulator += input * prime2;
+        accumulator = std::rotl(accumulator, 31);
+        return accumulator * prime1;
+    }
+
+    u64 mergeRound(u64 accumulator, u64 value) {
+        accumulator ^= round(0, value);
+        return accumulator * prime1 + prime4;
+    }
+}
+
+namespace teks {
+    u64 xxHash64(std::string_view data, u64 seed) {
+        const char* at = data.data();
+        const char* const end = at + data.size();
+        u64 hash;
+
+        if (data.size() >= 32) {
+            // four independent lanes over 32 byte stripes
+            u64 lanes[4] = {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+            for (; end - at >= 32; at += 32) {
+                for (usize lane = 0; lane < 4; ++lane) {
+                    lanes[lane] = round(lanes[lane], read64(at + lane * 8));
+                }
+            }
+            hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+            for (u64 lane : lanes) {
+                hash = mergeRound(hash, lane);
+            }
+        } else {
+            hash = seed + prime5;
+        }
+        hash += data.size();
+
+        for (; end - at >= 8; at += 8) {
+            hash ^= round(0, read64(at));
+            hash = std::rotl(hash, 27) * prime1 + prime4;
+        }
+        if (end - at >= 4) {
+            hash ^= read32(at) * prime1;
+            hash = std::rotl(hash, 23) * prime2 + prime3;
+            at += 4;
+        }
+        for (; at < end; ++at) {
+            hash ^= static_cast<unsigned char>(*at) * prime5;
+            hash = std::rotl(hash, 11) * prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        hash *= prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+} // namespace teks
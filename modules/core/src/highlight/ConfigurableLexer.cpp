@@ -0,0 +1,165 @@
+#include <teks/highlight/ConfigurableLexer.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace {
+    using teks::highlight::LexerState;
+    using teks::highlight::Token;
+    using teks::highlight::TokenKind;
+
+    constexpr LexerState normalState = 0;
+    constexpr LexerState blockCommentState = 1;
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r';
+    }
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool isIdentifierStart(char c) {
+        // UTF-8 sequences are treated as identifier characters
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+            || (static_cast<unsigned char>(c) & 0x80) != 0;
+    }
+
+    bool isIdentifierContinue(char c) {
+        return isIdentifierStart(c) || isDigit(c);
+    }
+
+    bool startsWith(std::string_view line, teks::usize at, std::string_view prefix) {
+        return !prefix.empty() && line.substr(at, prefix.size()) == prefix;
+    }
+
+    void push(std::vector<Token>& tokens, teks::usize start, teks::usize end, TokenKind kind) {
+        tokens.push_back(Token{
+            static_cast<teks::u32>(start),
+            static_cast<teks::u32>(end - start),
+            kind
+        });
+    }
+}
+
+namespace teks::highlight {
+    LanguageConfig cppLanguageConfig() {
+        LanguageConfig config;
+        config.keywords = {
+            "alignas", "alignof", "auto", "break", "case", "catch", "class", "co_await", "co_return",
+            "co_yield", "concept", "const", "consteval", "constexpr", "constinit", "const_cast",
+            "continue", "decltype", "default", "delete", "do", "dynamic_cast", "else", "enum",
+            "explicit", "export", "extern", "false", "final", "for", "friend", "goto", "if", "inline",
+            "mutable", "namespace", "new", "noexcept", "nullptr", "operator", "override", "private",
+            "protected", "public", "register", "reinterpret_cast", "requires", "return", "sizeof",
+            "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+            "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using",
+            "virtual", "volatile", "while",
+        };
+        config.types = {
+            "bool", "char", "char8_t", "char16_t", "char32_t", "double", "float", "int", "long",
+            "short", "signed", "unsigned", "void", "wchar_t",
+        };
+        config.lineComment = "//";
+        config.blockCommentOpen = "/*";
+        config.blockCommentClose = "*/";
+        config.stringDelimiters = "\"'";
+        config.hashDirectives = true;
+        return config;
+    }
+
+    LanguageConfig jsonLanguageConfig() {
+        LanguageConfig config;
+        config.keywords = {"true", "false", "null"};
+        config.stringDelimiters = "\"";
+        return config;
+    }
+
+    ConfigurableLexer::ConfigurableLexer(LanguageConfig config)
+        : config_(std::move(config))
+    {}
+
+    LexerState ConfigurableLexer::lexLine(
+        std::string_view line,
+        LexerState state,
+        std::vector<Token>& tokens
+    ) const {
+        usize at = 0;
+
+        if (state == blockCommentState) {
+            const usize close = line.find(config_.blockCommentClose);
+            if (close == std::string_view::npos) {
+                if (!line.empty()) {
+                    push(tokens, 0, line.size(), TokenKind::Comment);
+                }
+                return blockCommentState;
+            }
+            at = close + config_.blockCommentClose.size();
+            push(tokens, 0, at, TokenKind::Comment);
+        }
+
+        bool onlySpaceBefore = at == 0;
+        while (at < line.size()) {
+            const char c = line[at];
+            const usize start = at;
+
+            if (isSpace(c)) {
+                ++at;
+                continue;
+            }
+
+            if (startsWith(line, at, config_.lineComment)) {
+                push(tokens, start, line.size(), TokenKind::Comment);
+                break;
+            }
+
+            if (startsWith(line, at, config_.blockCommentOpen)) {
+                const usize close = line.find(config_.blockCommentClose, at + config_.blockCommentOpen.size());
+                if (close == std::string_view::npos) {
+                    push(tokens, start, line.size(), TokenKind::Comment);
+                    return blockCommentState;
+                }
+                at = close + config_.blockCommentClose.size();
+                push(tokens, start, at, TokenKind::Comment);
+            } else if (config_.hashDirectives && onlySpaceBefore && c == '#') {
+                ++at;
+                while (at < line.size() && isSpace(line[at])) {
+                    ++at;
+                }
+                while (at < line.size() && isIdentifierContinue(line[at])) {
+                    ++at;
+                }
+                push(tokens, start, at, TokenKind::Preprocessor);
+            } else if (config_.stringDelimiters.find(c) != std::string::npos) {
+                ++at;
+                while (at < line.size() && line[at] != c) {
+                    at += line[at] == config_.escape ? usize{2} : usize{1};
+                }
+                at = std::min(at + 1, line.size());
+                push(tokens, start, at, TokenKind::String);
+            } else if (isDigit(c) || (c == '.' && at + 1 < line.size() && isDigit(line[at + 1]))) {
+                while (at < line.size() && (isIdentifierContinue(line[at]) || line[at] == '.' || line[at] == '\'')) {
+                    ++at;
+                }
+                push(tokens, start, at, TokenKind::Number);
+            } else if (isIdentifierStart(c)) {
+                while (at < line.size() && isIdentifierContinue(line[at])) {
+                    ++at;
+                }
+                const std::string_view word = line.substr(start, at - start);
+                TokenKind kind = TokenKind::Identifier;
+                if (config_.keywords.contains(word)) {
+                    kind = TokenKind::Keyword;
+                } else if (config_.types.contains(word)) {
+                    kind = TokenKind::Type;
+                }
+                push(tokens, start, at, kind);
+            } else {
+                ++at;
+                push(tokens, start, at, TokenKind::Punctuation);
+            }
+            onlySpaceBefore = false;
+        }
+
+        return normalState;
+    }
+} // namespace teks::highlight
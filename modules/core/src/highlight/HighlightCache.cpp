@@ -0,0 +1,123 @@
+#include <teks/highlight/HighlightCache.hpp>
+#include <teks/assert.hpp>
+#include <teks/trace.hpp>
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace teks::highlight {
+    HighlightCache::HighlightCache(std::shared_ptr<const Lexer> lexer, usize lineCount)
+        : lexer_(std::move(lexer))
+    {
+        TEKS_REQUIRE(lexer_ != nullptr);
+        reset(lineCount);
+    }
+
+    void HighlightCache::reset(usize lineCount) {
+        lines_.clear();
+        lines_.resize(std::max<usize>(lineCount, 1));
+        validLines_ = 0;
+        cachedLines_ = 0;
+    }
+
+    void HighlightCache::replaceLines(usize first, usize removed, usize inserted) {
+        TEKS_ASSERT(first <= lines_.size());
+        TEKS_ASSERT(removed <= lines_.size() - first);
+
+        using Difference = std::vector<Line>::difference_type;
+        const auto begin = lines_.begin() + static_cast<Difference>(first);
+        lines_.erase(begin, begin + static_cast<Difference>(removed));
+        lines_.insert(lines_.begin() + static_cast<Difference>(first), inserted, Line{});
+        if (lines_.empty()) {
+            lines_.emplace_back();
+        }
+
+        validLines_ = std::min(validLines_, first);
+        if (cachedLines_ >= first + removed) {
+            cachedLines_ = cachedLines_ - removed + inserted;
+        } else {
+            cachedLines_ = std::min(cachedLines_, first);
+        }
+        cachedLines_ = std::min(cachedLines_, lines_.size());
+    }
+
+    const std::vector<Token>& HighlightCache::tokens(const buffer::Buffer& buffer, usize line) {
+        TEKS_ASSERT(line < lines_.size());
+        if (validLines_ <= line) {
+            TEKS_TRACE_SCOPE("HighlightCache::tokens");
+            while (validLines_ <= line) {
+                lexNext(buffer);
+            }
+        }
+        return lines_[line].tokens;
+    }
+
+    bool HighlightCache::lexSome(const buffer::Buffer& buffer, std::chrono::nanoseconds budget) {
+        TEKS_TRACE_SCOPE("HighlightCache::lexSome");
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        while (validLines_ < lines_.size()) {
+            lexNext(buffer);
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+        return validLines_ < lines_.size();
+    }
+
+    usize HighlightCache::lineCount() const {
+        return lines_.size();
+    }
+
+    usize HighlightCache::validLines() const {
+        return validLines_;
+    }
+
+    u64 HighlightCache::linesLexed() const {
+        return linesLexed_;
+    }
+
+    HeapBytes HighlightCache::heapBytes() const {
+        HeapBytes bytes = heapBytesOf(lines_);
+        for (const Line& line : lines_) {
+            bytes += heapBytesOf(line.tokens);
+        }
+        return bytes;
+    }
+
+    void HighlightCache::shrinkToFit() {
+        lines_.shrink_to_fit();
+        for (Line& line : lines_) {
+            line.tokens.shrink_to_fit();
+        }
+    }
+
+    void HighlightCache::lexNext(const buffer::Buffer& buffer) {
+        const usize index = validLines_;
+        Line& line = lines_[index];
+        const LexerState startState = index == 0 ? LexerState{0} : lines_[index - 1].endState;
+
+        if (index < cachedLines_ && !line.edited && line.startState == startState) {
+            // Converged, cached lines from here up to the next edited one were lexed in one pass
+            // starting from this same state, so they can all be reused as they are.
+            do {
+                ++validLines_;
+            } while (validLines_ < cachedLines_ && !lines_[validLines_].edited);
+            return;
+        }
+
+        line.tokens.clear();
+        line.startState = startState;
+        line.endState = startState;
+        line.edited = false;
+
+        const auto range = buffer.lineRange(index);
+        if (range.has_value() && range->size() <= buffer::Bytes(maxLexedLineBytes)) {
+            const std::string text = buffer.readString(*range).value();
+            line.endState = lexer_->lexLine(text, startState, line.tokens);
+            ++linesLexed_;
+        }
+
+        ++validLines_;
+        cachedLines_ = std::max(cachedLines_, validLines_);
+    }
+} // namespace teks::highlight
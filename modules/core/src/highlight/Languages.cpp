@@ -0,0 +1,27 @@
+#include <teks/highlight/Languages.hpp>
+#include <teks/highlight/TableLexers.hpp>
+#include <array>
+
+namespace teks::highlight {
+    std::shared_ptr<const Lexer> lexerForExtension(std::string_view extension) {
+        static constexpr std::array cppExtensions{".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".hxx", ".inl"};
+        for (std::string_view cppExtension : cppExtensions) {
+            if (extension == cppExtension) {
+                static const auto lexer = std::make_shared<const CppLexer>();
+                return lexer;
+            }
+        }
+
+        if (extension == ".json") {
+            static const auto lexer = std::make_shared<const JsonLexer>();
+            return lexer;
+        }
+
+        if (extension == ".log") {
+            static const auto lexer = std::make_shared<const LogLexer>();
+            return lexer;
+        }
+
+        return nullptr;
+    }
+} // namespace teks::highlight
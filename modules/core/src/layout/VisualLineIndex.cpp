@@ -0,0 +1,79 @@
+#include <teks/layout/VisualLineIndex.hpp>
+#include <teks/assert.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace teks::layout {
+    VisualLineIndex::VisualLineIndex()
+        : VisualLineIndex(1)
+    {}
+
+    VisualLineIndex::VisualLineIndex(usize lineCount)
+        : lines_(std::vector<Line>(std::max<usize>(lineCount, 1), Line{1, true}))
+    {}
+
+    usize VisualLineIndex::lineCount() const {
+        return lines_.size();
+    }
+
+    u64 VisualLineIndex::rowCount() const {
+        return lines_.total().rows;
+    }
+
+    u64 VisualLineIndex::rows(usize line) const {
+        TEKS_ASSERT(line < lines_.size());
+        return lines_[line].rows;
+    }
+
+    void VisualLineIndex::setRows(usize line, u64 rows) {
+        TEKS_ASSERT(line < lines_.size());
+        lines_.set(line, Line{std::max<u64>(rows, 1), false});
+    }
+
+    bool VisualLineIndex::stale(usize line) const {
+        TEKS_ASSERT(line < lines_.size());
+        return lines_[line].stale;
+    }
+
+    usize VisualLineIndex::staleCount() const {
+        return lines_.total().stale;
+    }
+
+    std::optional<usize> VisualLineIndex::nextStale(usize line) const {
+        TEKS_ASSERT(line <= lines_.size());
+        const usize before = lines_.prefixSum(line).stale;
+        const auto found = lines_.find([before](const Summary& sum) { return sum.stale > before; });
+        if (found.item == nullptr) {
+            return std::nullopt;
+        }
+        return found.index;
+    }
+
+    void VisualLineIndex::markAllStale() {
+        std::vector<Line> lines;
+        lines.reserve(lines_.size());
+        lines_.forEach(0, lines_.size(), [&lines](const Line& line) { lines.push_back(Line{line.rows, true}); });
+        lines_.assign(lines);
+    }
+
+    u64 VisualLineIndex::firstRow(usize line) const {
+        return lines_.prefixSum(line).rows;
+    }
+
+    VisualLineIndex::RowLocation VisualLineIndex::locate(u64 row) const {
+        const auto found = lines_.find([row](const Summary& sum) { return sum.rows > row; });
+        if (found.item != nullptr) {
+            return RowLocation{found.index, row - found.before.rows};
+        }
+        return RowLocation{lines_.size() - 1, lines_[lines_.size() - 1].rows - 1};
+    }
+
+    void VisualLineIndex::replaceLines(usize first, usize removed, usize inserted) {
+        TEKS_ASSERT(first <= lines_.size());
+        TEKS_ASSERT(removed <= lines_.size() - first);
+        lines_.replace(first, first + removed, std::vector<Line>(inserted, Line{1, true}));
+        if (lines_.size() == 0) {
+            lines_.push(Line{1, true});
+        }
+    }
+} // namespace teks::layout
@@ -0,0 +1,319 @@
+#include <teks/metrics.hpp>
+#include <teks/assert.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace teks::metrics {
+    // Only the owning thread writes, with relaxed loads and stores rather than read-modify-writes, so
+    // recording costs no more than plain arithmetic. Other threads only read.
+    //
+    // `reset` bumps a global epoch instead of touching other threads' counts: each thread clears its
+    // own when it next records, and until then readers skip it.
+    struct ThreadLatencies {
+        struct Counts {
+            std::array<std::atomic<u64>, LatencyHistogram::bucketCount> buckets{};
+            std::atomic<u64> sum{0};
+            std::atomic<u64> min{std::numeric_limits<u64>::max()};
+            std::atomic<u64> max{0};
+        };
+
+        std::array<Counts, operationCount> operations;
+        std::atomic<u64> epoch{0};
+
+        ThreadLatencies();
+        ThreadLatencies(const ThreadLatencies&) = delete;
+        ThreadLatencies& operator=(const ThreadLatencies&) = delete;
+        ~ThreadLatencies();
+
+        void record(Operation operation, u64 nanoseconds);
+        void clear();
+        void addTo(Operation operation, LatencyHistogram& histogram) const;
+    };
+}
+
+namespace {
+    using teks::u64;
+    using teks::usize;
+    using teks::metrics::LatencyHistogram;
+    using teks::metrics::Operation;
+    using teks::metrics::ThreadLatencies;
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadLatencies*> threads;
+        // what threads that have exited recorded
+        std::array<LatencyHistogram, teks::metrics::operationCount> exited;
+        std::atomic<u64> epoch{0};
+    };
+
+    // never destroyed, threads may exit after static destructors have run
+    Registry& registry() {
+        static Registry* const instance = new Registry;
+        return *instance;
+    }
+
+    void appendJson(std::string& json, std::string_view key, u64 value) {
+        json += '"';
+        json += key;
+        json += "\":";
+        json += std::to_string(value);
+    }
+}
+
+namespace teks::metrics {
+    std::string_view operationName(Operation operation) {
+        switch (operation) {
+            case Operation::Insert: return "insert";
+            case Operation::Erase: return "erase";
+            case Operation::Replace: return "replace";
+            case Operation::ReadString: return "readString";
+            case Operation::LineRange: return "lineRange";
+            case Operation::FileOpen: return "fileOpen";
+            case Operation::FileSave: return "fileSave";
+            case Operation::Paint: return "paint";
+            case Operation::KeyToPaint: return "keyToPaint";
+        }
+        TEKS_ASSERT(false);
+        return "";
+    }
+
+    usize LatencyHistogram::bucketOf(u64 nanoseconds) {
+        if (nanoseconds < subBucketCount) {
+            return static_cast<usize>(nanoseconds);
+        }
+        // the top `subBucketBits + 1` bits pick the bucket, the first of them is always set
+        const auto shift = static_cast<u32>(std::bit_width(nanoseconds)) - subBucketBits - 1;
+        return static_cast<usize>((shift + 1) * subBucketCount + ((nanoseconds >> shift) - subBucketCount));
+    }
+
+    u64 LatencyHistogram::bucketLowest(usize bucket) {
+        if (bucket < subBucketCount) {
+            return bucket;
+        }
+        const u64 shift = bucket / subBucketCount - 1;
+        return (subBucketCount + bucket % subBucketCount) << shift;
+    }
+
+    u64 LatencyHistogram::bucketHighest(usize bucket) {
+        if (bucket < subBucketCount) {
+            return bucket;
+        }
+        const u64 shift = bucket / subBucketCount - 1;
+        return bucketLowest(bucket) + ((u64(1) << shift) - 1);
+    }
+
+    void LatencyHistogram::record(u64 nanoseconds) {
+        ++counts_[bucketOf(nanoseconds)];
+        min_ = count_ == 0 ? nanoseconds : std::min(min_, nanoseconds);
+        max_ = std::max(max_, nanoseconds);
+        ++count_;
+        sum_ += nanoseconds;
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other) {
+        if (other.count_ == 0) {
+            return;
+        }
+        for (usize bucket = 0; bucket < bucketCount; ++bucket) {
+            counts_[bucket] += other.counts_[bucket];
+        }
+        min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        count_ += other.count_;
+        sum_ += other.sum_;
+    }
+
+    u64 LatencyHistogram::count() const {
+        return count_;
+    }
+
+    u64 LatencyHistogram::bucketCountAt(usize bucket) const {
+        return counts_[bucket];
+    }
+
+    u64 LatencyHistogram::min() const {
+        return min_;
+    }
+
+    u64 LatencyHistogram::max() const {
+        return max_;
+    }
+
+    u64 LatencyHistogram::mean() const {
+        return count_ == 0 ? 0 : sum_ / count_;
+    }
+
+    u64 LatencyHistogram::percentile(double percentile) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        const double clamped = std::clamp(percentile, 0.0, 100.0);
+        const auto rank = std::max(u64(1), static_cast<u64>(std::ceil(clamped / 100.0 * static_cast<double>(count_))));
+        u64 seen = 0;
+        for (usize bucket = 0; bucket < bucketCount; ++bucket) {
+            seen += counts_[bucket];
+            if (seen >= rank) {
+                return std::clamp(bucketHighest(bucket), min_, max_);
+            }
+        }
+        return max_;
+    }
+
+    ThreadLatencies::ThreadLatencies() {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        epoch.store(shared.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        shared.threads.push_back(this);
+    }
+
+    ThreadLatencies::~ThreadLatencies() {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        if (epoch.load(std::memory_order_relaxed) == shared.epoch.load(std::memory_order_relaxed)) {
+            for (usize operation = 0; operation < operationCount; ++operation) {
+                addTo(static_cast<Operation>(operation), shared.exited[operation]);
+            }
+        }
+        std::erase(shared.threads, this);
+    }
+
+    void ThreadLatencies::record(Operation operation, u64 nanoseconds) {
+        const u64 current = registry().epoch.load(std::memory_order_relaxed);
+        if (epoch.load(std::memory_order_relaxed) != current) {
+            clear();
+            // readers that see the new epoch see the cleared counts
+            epoch.store(current, std::memory_order_release);
+        }
+
+        Counts& counts = operations[static_cast<usize>(operation)];
+        std::atomic<u64>& bucket = counts.buckets[LatencyHistogram::bucketOf(nanoseconds)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counts.sum.store(counts.sum.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+        if (nanoseconds < counts.min.load(std::memory_order_relaxed)) {
+            counts.min.store(nanoseconds, std::memory_order_relaxed);
+        }
+        if (nanoseconds > counts.max.load(std::memory_order_relaxed)) {
+            counts.max.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    void ThreadLatencies::clear() {
+        for (Counts& counts : operations) {
+            for (std::atomic<u64>& bucket : counts.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            counts.sum.store(0, std::memory_order_relaxed);
+            counts.min.store(std::numeric_limits<u64>::max(), std::memory_order_relaxed);
+            counts.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void ThreadLatencies::addTo(Operation operation, LatencyHistogram& histogram) const {
+        // read while the thread may be recording, so the count is summed from the buckets to keep
+        // percentiles consistent with it
+        const Counts& counts = operations[static_cast<usize>(operation)];
+        LatencyHistogram added;
+        for (usize bucket = 0; bucket < LatencyHistogram::bucketCount; ++bucket) {
+            added.counts_[bucket] = counts.buckets[bucket].load(std::memory_order_relaxed);
+            added.count_ += added.counts_[bucket];
+        }
+        if (added.count_ == 0) {
+            return;
+        }
+        added.sum_ = counts.sum.load(std::memory_order_relaxed);
+        added.min_ = counts.min.load(std::memory_order_relaxed);
+        added.max_ = counts.max.load(std::memory_order_relaxed);
+        histogram.merge(added);
+    }
+
+    u32 detail::nextSampleGap(Operation operation) {
+        // xorshift, seeded apart for each thread, as the gaps only need to break up patterns
+        thread_local u64 state = 0x9e3779b97f4a7c15 ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        // uniform in [1, 2 * period - 1], averaging the period
+        const u32 period = samplingPeriod(operation);
+        return 1 + static_cast<u32>(state % (2 * u64(period) - 1));
+    }
+
+    void record(Operation operation, u64 nanoseconds) {
+        thread_local ThreadLatencies latencies;
+        latencies.record(operation, nanoseconds);
+    }
+
+    LatencyHistogram histogram(Operation operation) {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        const u64 current = shared.epoch.load(std::memory_order_relaxed);
+        LatencyHistogram result = shared.exited[static_cast<usize>(operation)];
+        for (const ThreadLatencies* thread : shared.threads) {
+            // a thread that has not recorded since `reset` still holds what it recorded before
+            if (thread->epoch.load(std::memory_order_acquire) == current) {
+                thread->addTo(operation, result);
+            }
+        }
+        return result;
+    }
+
+    void reset() {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        shared.epoch.fetch_add(1, std::memory_order_relaxed);
+        shared.exited = {};
+    }
+
+    std::string toJson() {
+        std::string json = "{\"unit\":\"ns\",\"operations\":{";
+        for (usize index = 0; index < operationCount; ++index) {
+            const auto operation = static_cast<Operation>(index);
+            const LatencyHistogram latencies = histogram(operation);
+            if (index != 0) {
+                json += ',';
+            }
+            json += '"';
+            json += operationName(operation);
+            json += "\":{";
+            appendJson(json, "count", latencies.count());
+            json += ',';
+            appendJson(json, "min", latencies.min());
+            json += ',';
+            appendJson(json, "mean", latencies.mean());
+            json += ',';
+            appendJson(json, "p50", latencies.percentile(50.0));
+            json += ',';
+            appendJson(json, "p90", latencies.percentile(90.0));
+            json += ',';
+            appendJson(json, "p99", latencies.percentile(99.0));
+            json += ',';
+            appendJson(json, "p999", latencies.percentile(99.9));
+            json += ',';
+            appendJson(json, "max", latencies.max());
+            json += ',';
+            appendJson(json, "sampledOneIn", samplingPeriod(operation));
+            // [lowest latency in the bucket, count] for each bucket anything was counted in
+            json += ",\"buckets\":[";
+            bool first = true;
+            for (usize bucket = 0; bucket < LatencyHistogram::bucketCount; ++bucket) {
+                if (latencies.bucketCountAt(bucket) != 0) {
+                    json += first ? "[" : ",[";
+                    json += std::to_string(LatencyHistogram::bucketLowest(bucket));
+                    json += ',';
+                    json += std::to_string(latencies.bucketCountAt(bucket));
+                    json += ']';
+                    first = false;
+                }
+            }
+            json += "]}";
+        }
+        json += "}}";
+        return json;
+    }
+} // namespace teks::metrics
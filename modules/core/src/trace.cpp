@@ -0,0 +1,186 @@
+#include <teks/trace.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using teks::u32;
+    using teks::u64;
+    using teks::usize;
+    using teks::trace::ringEvents;
+
+    struct Event {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<u64> nanoseconds{0};
+        std::atomic<u32> thread{0};
+        std::atomic<bool> isBegin{false};
+    };
+
+    // Written by one thread at a time, with relaxed stores published by `written`, so recording takes no
+    // locks. Readers copy events out and then drop the ones that may have been overwritten meanwhile.
+    //
+    // When its thread exits the ring is kept, events and all, for the next thread that starts tracing.
+    struct Ring {
+        std::array<Event, ringEvents> events;
+        // events pushed so far, the last `ringEvents` of them are still in `events`
+        std::atomic<u64> written{0};
+        // events before this were cleared, only changed under the registry's mutex
+        std::atomic<u64> clearedAt{0};
+
+        void push(const char* name, u32 thread, bool isBegin) {
+            const u64 index = written.load(std::memory_order_relaxed);
+            // a reader that sees any of what follows also sees `written` at least at `index`
+            std::atomic_thread_fence(std::memory_order_release);
+            Event& event = events[index % ringEvents];
+            event.name.store(name, std::memory_order_relaxed);
+            event.nanoseconds.store(now(), std::memory_order_relaxed);
+            event.thread.store(thread, std::memory_order_relaxed);
+            event.isBegin.store(isBegin, std::memory_order_relaxed);
+            written.store(index + 1, std::memory_order_release);
+        }
+
+        static u64 now() {
+            const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count());
+        }
+    };
+
+    // An event as it was when copied out of a ring
+    struct EventCopy {
+        const char* name;
+        u64 nanoseconds;
+        u32 thread;
+        bool isBegin;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Ring>> rings;
+        // rings of threads that have exited
+        std::vector<Ring*> unused;
+        u32 nextThread{1};
+    };
+
+    // never destroyed, threads may exit after static destructors have run
+    Registry& registry() {
+        static Registry* const instance = new Registry;
+        return *instance;
+    }
+
+    // The calling thread's ring, taken when it first traces and given back when it exits
+    struct ThreadRing {
+        Ring* ring;
+        u32 thread;
+
+        ThreadRing() {
+            Registry& shared = registry();
+            const std::lock_guard lock(shared.mutex);
+            if (shared.unused.empty()) {
+                shared.rings.push_back(std::make_unique<Ring>());
+                ring = shared.rings.back().get();
+            } else {
+                ring = shared.unused.back();
+                shared.unused.pop_back();
+            }
+            thread = shared.nextThread++;
+        }
+
+        ThreadRing(const ThreadRing&) = delete;
+        ThreadRing& operator=(const ThreadRing&) = delete;
+
+        ~ThreadRing() {
+            Registry& shared = registry();
+            const std::lock_guard lock(shared.mutex);
+            shared.unused.push_back(ring);
+        }
+    };
+
+    void push(const char* name, bool isBegin) {
+        thread_local ThreadRing local;
+        local.ring->push(name, local.thread, isBegin);
+    }
+
+    void appendEscaped(std::string& json, std::string_view text) {
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                json += '\\';
+            }
+            json += c;
+        }
+    }
+
+    // Chrome trace timestamps are in microseconds
+    void appendMicroseconds(std::string& json, u64 nanoseconds) {
+        json += std::to_string(nanoseconds / 1000);
+        const u64 fraction = nanoseconds % 1000;
+        json += '.';
+        json += static_cast<char>('0' + fraction / 100);
+        json += static_cast<char>('0' + fraction / 10 % 10);
+        json += static_cast<char>('0' + fraction % 10);
+    }
+}
+
+namespace teks::trace {
+    void begin(const char* name) {
+        push(name, true);
+    }
+
+    void end(const char* name) {
+        push(name, false);
+    }
+
+    std::string toChromeJson() {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const std::unique_ptr<Ring>& ring : shared.rings) {
+            const u64 written = ring->written.load(std::memory_order_acquire);
+            const u64 start = std::max(ring->clearedAt.load(std::memory_order_relaxed), written > ringEvents ? written - ringEvents : 0);
+            std::vector<EventCopy> copied;
+            copied.reserve(static_cast<usize>(written - start));
+            for (u64 index = start; index < written; ++index) {
+                const Event& event = ring->events[index % ringEvents];
+                copied.push_back(EventCopy{
+                    event.name.load(std::memory_order_relaxed),
+                    event.nanoseconds.load(std::memory_order_relaxed),
+                    event.thread.load(std::memory_order_relaxed),
+                    event.isBegin.load(std::memory_order_relaxed),
+                });
+            }
+
+            // What was written while copying may have overwritten the oldest events copied, including the
+            // event being written now, which replaces the one `ringEvents` before it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const u64 writtenAfter = ring->written.load(std::memory_order_relaxed) + 1;
+            const u64 valid = writtenAfter > ringEvents ? writtenAfter - ringEvents : 0;
+            for (u64 index = std::max(start, valid); index < written; ++index) {
+                const EventCopy& event = copied[static_cast<usize>(index - start)];
+                json += first ? "{\"name\":\"" : ",{\"name\":\"";
+                appendEscaped(json, event.name);
+                json += event.isBegin ? "\",\"ph\":\"B\"" : "\",\"ph\":\"E\"";
+                json += ",\"pid\":1,\"tid\":";
+                json += std::to_string(event.thread);
+                json += ",\"ts\":";
+                appendMicroseconds(json, event.nanoseconds);
+                json += '}';
+                first = false;
+            }
+        }
+        json += "]}";
+        return json;
+    }
+
+    void clear() {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        for (const std::unique_ptr<Ring>& ring : shared.rings) {
+            ring->clearedAt.store(ring->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+    }
+} // namespace teks::trace
@@ -0,0 +1,76 @@
+#include <teks/MappedFile.hpp>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+
+using namespace teks;
+
+namespace {
+    std::filesystem::path writeTemporary(const std::string& name, const std::string& content) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+        return path;
+    }
+}
+
+TEST(teksMappedFile, mapsContent) {
+    std::string content;
+    for (int i = 0; i < 10000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    const auto path = writeTemporary("teks_mapped_file_test", content);
+    {
+        const auto file = MappedFile::open(path);
+        ASSERT_TRUE(file.has_value());
+        ASSERT_EQ(file->bytes(), content);
+    }
+    // a mapped file cannot be removed everywhere
+    std::filesystem::remove(path);
+}
+
+TEST(teksMappedFile, emptyFile) {
+    const auto path = writeTemporary("teks_mapped_file_test_empty", "");
+    {
+        const auto file = MappedFile::open(path);
+        ASSERT_TRUE(file.has_value());
+        ASSERT_TRUE(file->bytes().empty());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(teksMappedFile, missingFile) {
+    ASSERT_FALSE(MappedFile::open(std::filesystem::temp_directory_path() / "teks_mapped_file_test_missing").has_value());
+}
+
+TEST(teksMappedFile, moveTransfersMapping) {
+    const auto path = writeTemporary("teks_mapped_file_test_move", "abc");
+    {
+        auto file = MappedFile::open(path);
+        ASSERT_TRUE(file.has_value());
+        const MappedFile moved = std::move(*file);
+        ASSERT_EQ(moved.bytes(), "abc");
+        ASSERT_TRUE(file->bytes().empty());
+    }
+    std::filesystem::remove(path);
+}
+
+#if !defined(_WIN32)
+TEST(teksMappedFile, truncatedFileReadsAsZeros) {
+    const std::string content(3 * 65536, 'x');
+    const auto path = writeTemporary("teks_mapped_file_test_truncated", content);
+    {
+        const auto file = MappedFile::open(path);
+        ASSERT_TRUE(file.has_value());
+        ASSERT_FALSE(file->truncated());
+        // what logrotate's copytruncate does to a log being viewed
+        std::filesystem::resize_file(path, 100);
+        ASSERT_TRUE(file->truncated());
+        const std::string_view bytes = file->bytes();
+        ASSERT_EQ(bytes[0], 'x');
+        ASSERT_EQ(bytes[bytes.size() - 1], '\0');
+    }
+    std::filesystem::remove(path);
+}
+#endif
@@ -0,0 +1,101 @@
+#include <teks/ReplacementFile.hpp>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+using namespace teks;
+
+namespace {
+    std::filesystem::path writeTemporary(const std::string& name, const std::string& content) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+        return path;
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return std::move(content).str();
+    }
+
+    std::filesystem::path temporaryOf(std::filesystem::path path) {
+        path += ".tmp";
+        return path;
+    }
+}
+
+TEST(teksReplacementFile, commitReplacesTheFile) {
+    const auto path = writeTemporary("teks_replacement_file_test", "old content");
+    {
+        std::optional<ReplacementFile> file = ReplacementFile::create(path);
+        ASSERT_TRUE(file.has_value());
+        ASSERT_TRUE(file->write("new "));
+        ASSERT_TRUE(file->write("content"));
+        // nothing is replaced before the commit
+        ASSERT_EQ(readFile(path), "old content");
+        ASSERT_TRUE(file->commit());
+    }
+    ASSERT_EQ(readFile(path), "new content");
+    ASSERT_FALSE(std::filesystem::exists(temporaryOf(path)));
+    std::filesystem::remove(path);
+}
+
+TEST(teksReplacementFile, createsAFileThatDidNotExist) {
+    const auto path = std::filesystem::temp_directory_path() / "teks_replacement_file_test_new";
+    std::filesystem::remove(path);
+    std::optional<ReplacementFile> file = ReplacementFile::create(path);
+    ASSERT_TRUE(file.has_value());
+    ASSERT_TRUE(file->write("content"));
+    ASSERT_TRUE(file->commit());
+    ASSERT_EQ(readFile(path), "content");
+    std::filesystem::remove(path);
+}
+
+TEST(teksReplacementFile, withoutACommitTheOldFileStays) {
+    const auto path = writeTemporary("teks_replacement_file_test_abandoned", "old content");
+    {
+        std::optional<ReplacementFile> file = ReplacementFile::create(path);
+        ASSERT_TRUE(file.has_value());
+        ASSERT_TRUE(file->write("half of the new"));
+        ASSERT_TRUE(std::filesystem::exists(temporaryOf(path)));
+    }
+    ASSERT_EQ(readFile(path), "old content");
+    ASSERT_FALSE(std::filesystem::exists(temporaryOf(path)));
+    std::filesystem::remove(path);
+}
+
+TEST(teksReplacementFile, failsWhereNoFileCanBeCreated) {
+    const auto path = std::filesystem::temp_directory_path() / "teks_replacement_file_test_missing" / "file";
+    ASSERT_FALSE(ReplacementFile::create(path).has_value());
+}
+
+TEST(teksReplacementFile, keepsPermissionsAndSymlinks) {
+    const auto path = writeTemporary("teks_replacement_file_test_target", "old content");
+    const auto link = std::filesystem::temp_directory_path() / "teks_replacement_file_test_link";
+    std::filesystem::remove(link);
+    std::error_code error;
+    std::filesystem::create_symlink(path, link, error);
+    if (error) {
+        std::filesystem::remove(path);
+        GTEST_SKIP() << "symlinks cannot be created here";
+    }
+    using std::filesystem::perms;
+    std::filesystem::permissions(path, perms::owner_read | perms::owner_write | perms::owner_exec);
+    {
+        std::optional<ReplacementFile> file = ReplacementFile::create(link);
+        ASSERT_TRUE(file.has_value());
+        ASSERT_TRUE(file->write("new content"));
+        ASSERT_TRUE(file->commit());
+    }
+    ASSERT_TRUE(std::filesystem::is_symlink(link));
+    ASSERT_EQ(readFile(path), "new content");
+    ASSERT_EQ(std::filesystem::status(path).permissions(), perms::owner_read | perms::owner_write | perms::owner_exec);
+    std::filesystem::remove(link);
+    std::filesystem::remove(path);
+}
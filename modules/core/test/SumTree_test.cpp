@@ -0,0 +1,165 @@
+#include <teks/SumTree.hpp>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace teks;
+
+namespace {
+    struct Identity {
+        u64 operator()(u64 value) const {
+            return value;
+        }
+    };
+
+    using Tree = SumTree<u64, u64, Identity>;
+
+    // A summary that depends on the order of the items, to catch runs combined out of order
+    struct Ordered {
+        u64 count{0};
+        u64 hash{0};
+        u64 power{1};
+
+        friend Ordered operator+(const Ordered& left, const Ordered& right) {
+            return Ordered{left.count + right.count, left.hash * right.power + right.hash, left.power * right.power};
+        }
+    };
+
+    struct Hashed {
+        Ordered operator()(u64 value) const {
+            return Ordered{1, value, 31};
+        }
+    };
+
+    using OrderedTree = SumTree<u64, Ordered, Hashed>;
+
+    void expectMatches(const Tree& tree, const std::vector<u64>& values) {
+        ASSERT_EQ(tree.size(), values.size());
+        u64 sum = 0;
+        for (usize i = 0; i < values.size(); ++i) {
+            ASSERT_EQ(tree[i], values[i]) << i;
+            ASSERT_EQ(tree.prefixSum(i), sum) << i;
+            sum += values[i];
+        }
+        ASSERT_EQ(tree.total(), sum);
+        std::vector<u64> visited;
+        tree.forEach(0, tree.size(), [&visited](u64 value) { visited.push_back(value); });
+        ASSERT_EQ(visited, values);
+    }
+}
+
+TEST(teksSumTree, defaultConstructorIsEmpty) {
+    const Tree tree;
+    ASSERT_EQ(tree.size(), 0);
+    ASSERT_EQ(tree.total(), 0);
+    const auto found = tree.find([](u64 sum) { return sum > 0; });
+    ASSERT_EQ(found.index, 0);
+    ASSERT_EQ(found.item, nullptr);
+}
+
+TEST(teksSumTree, buildsFromItems) {
+    std::vector<u64> values(1000);
+    std::iota(values.begin(), values.end(), u64{0});
+    const Tree tree(values);
+    ASSERT_NO_FATAL_FAILURE(expectMatches(tree, values));
+}
+
+TEST(teksSumTree, findReturnsContainingItemAndSummaryBefore) {
+    const std::vector<u64> values{2, 0, 3, 1};
+    const Tree tree(values);
+    const auto containing = [&tree](u64 target) {
+        return tree.find([target](u64 sum) { return sum > target; });
+    };
+    ASSERT_EQ(containing(1).index, 0);
+    ASSERT_EQ(containing(1).before, 0);
+    // the empty item is skipped
+    ASSERT_EQ(containing(2).index, 2);
+    ASSERT_EQ(containing(2).before, 2);
+    ASSERT_EQ(*containing(4).item, 3);
+    ASSERT_EQ(containing(5).index, 3);
+    ASSERT_EQ(containing(6).index, 4);
+    ASSERT_EQ(containing(6).before, 6);
+    ASSERT_EQ(containing(6).item, nullptr);
+}
+
+TEST(teksSumTree, randomEditsMatchAVector) {
+    std::mt19937 random(1);
+    std::vector<u64> values;
+    Tree tree;
+    for (int edit = 0; edit < 3000; ++edit) {
+        const usize at = random() % (values.size() + 1);
+        const u32 kind = random() % 8;
+        if (kind < 4) {
+            // mostly single items, sometimes enough to split many nodes at once
+            std::vector<u64> inserted(kind == 0 ? random() % 2000 : 1 + random() % 3);
+            for (u64& value : inserted) {
+                value = random() % 100;
+            }
+            values.insert(values.begin() + static_cast<ssize>(at), inserted.begin(), inserted.end());
+            tree.insert(at, inserted);
+        } else if (kind < 7) {
+            const usize erased = std::min<usize>(values.size() - at, kind == 4 ? random() % 3000 : random() % 4);
+            values.erase(values.begin() + static_cast<ssize>(at), values.begin() + static_cast<ssize>(at + erased));
+            tree.erase(at, at + erased);
+        } else if (at < values.size()) {
+            values[at] = random() % 100;
+            tree.set(at, values[at]);
+        }
+        if (edit % 100 == 0) {
+            ASSERT_NO_FATAL_FAILURE(expectMatches(tree, values)) << edit;
+        }
+    }
+    ASSERT_NO_FATAL_FAILURE(expectMatches(tree, values));
+}
+
+TEST(teksSumTree, keepsTheOrderOfItemsInSummaries) {
+    std::mt19937 random(2);
+    std::vector<u64> values;
+    OrderedTree tree;
+    for (int edit = 0; edit < 500; ++edit) {
+        const usize at = random() % (values.size() + 1);
+        if (random() % 3 != 0) {
+            const std::vector<u64> inserted(1 + random() % 50, random() % 1000);
+            values.insert(values.begin() + static_cast<ssize>(at), inserted.begin(), inserted.end());
+            tree.insert(at, inserted);
+        } else {
+            const usize erased = std::min<usize>(values.size() - at, random() % 60);
+            values.erase(values.begin() + static_cast<ssize>(at), values.begin() + static_cast<ssize>(at + erased));
+            tree.erase(at, at + erased);
+        }
+    }
+    // rebuilt in one go the tree has different nodes, the summaries are the same
+    const OrderedTree built(values);
+    ASSERT_EQ(tree.total().count, values.size());
+    ASSERT_EQ(tree.total().hash, built.total().hash);
+    for (usize count = 0; count <= values.size(); count += 7) {
+        ASSERT_EQ(tree.prefixSum(count).hash, built.prefixSum(count).hash) << count;
+    }
+}
+
+TEST(teksSumTree, copiesAndMovesKeepItems) {
+    std::vector<u64> values(300, 4);
+    Tree tree(values);
+    Tree copied(tree);
+    tree.set(5, 9);
+    ASSERT_NO_FATAL_FAILURE(expectMatches(copied, values));
+
+    std::pmr::monotonic_buffer_resource pool;
+    const Tree moved(std::move(copied), &pool);
+    ASSERT_EQ(moved.get_allocator().resource(), &pool);
+    ASSERT_NO_FATAL_FAILURE(expectMatches(moved, values));
+    copied = tree;
+    values[5] = 9;
+    ASSERT_NO_FATAL_FAILURE(expectMatches(copied, values));
+}
+
+TEST(teksSumTree, erasingEverythingLeavesItEmpty) {
+    Tree tree(std::vector<u64>(5000, 1));
+    tree.erase(0, tree.size());
+    ASSERT_EQ(tree.size(), 0);
+    ASSERT_EQ(tree.heapBytes().used, 0);
+    tree.push(3);
+    ASSERT_NO_FATAL_FAILURE(expectMatches(tree, {3}));
+}
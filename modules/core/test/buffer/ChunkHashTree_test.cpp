@@ -0,0 +1,169 @@
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/ChunkHashTree.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+
+namespace {
+    std::string randomText(std::mt19937& random, usize size) {
+        std::string text;
+        while (text.size() < size) {
+            text += "line " + std::to_string(random() % 100000) + (random() % 7 == 0 ? "\n\n" : "\n");
+        }
+        return text;
+    }
+
+    // applies `regions` of `other` over `text`, back to front
+    std::string patch(std::string text, std::string_view other, const std::vector<ChunkHashTree::Region>& regions) {
+        for (auto region = regions.rbegin(); region != regions.rend(); ++region) {
+            text.replace(
+                region->here.start().raw(),
+                region->here.size().raw(),
+                other.substr(region->there.start().raw(), region->there.size().raw())
+            );
+        }
+        return text;
+    }
+}
+
+TEST(teksBufferChunkHashTree, equalTextsHaveEqualHashes) {
+    std::mt19937 random(3);
+    const std::string text = randomText(random, 100000);
+    const ChunkHashTree tree(text);
+    ASSERT_EQ(tree.contentHash(), ChunkHashTree(text).contentHash());
+    ASSERT_GT(tree.chunkCount(), 100000 / ChunkHashTree::maxChunkBytes);
+    ASSERT_LT(tree.chunkCount(), 100000 / ChunkHashTree::minChunkBytes);
+
+    std::string changed = text;
+    changed[50000] = changed[50000] == 'x' ? 'y' : 'x';
+    ASSERT_NE(ChunkHashTree(changed).contentHash(), tree.contentHash());
+    ASSERT_EQ(ChunkHashTree().contentHash(), ChunkHashTree("").contentHash());
+}
+
+TEST(teksBufferChunkHashTree, editsMatchHashingFromScratch) {
+    std::mt19937 random(4);
+    std::string text = randomText(random, 60000);
+    ChunkHashTree tree(text);
+    for (int edit = 0; edit < 300; ++edit) {
+        const usize at = random() % (text.size() + 1);
+        const usize removed = std::min<usize>(text.size() - at, random() % 3 == 0 ? random() % 20000 : random() % 50);
+        const std::string inserted = random() % 4 == 0 ? randomText(random, random() % 5000) : std::string(random() % 3, 'q');
+        text.replace(at, removed, inserted);
+        tree.replaced(text, Offset(at), Bytes(removed), Bytes(inserted.size()));
+
+        const ChunkHashTree fresh(text);
+        ASSERT_EQ(tree.contentHash(), fresh.contentHash()) << edit;
+        ASSERT_EQ(tree.chunkCount(), fresh.chunkCount()) << edit;
+        ASSERT_TRUE(tree.diffRegions(fresh).empty());
+    }
+}
+
+TEST(teksBufferChunkHashTree, editsAppliedAtOnceMatchHashingFromScratch) {
+    std::mt19937 random(8);
+    std::string text = randomText(random, 80000);
+    ChunkHashTree tree(text);
+    for (int round = 0; round < 100; ++round) {
+        // clustered edits run into each other's rehashing, spread ones do not
+        const usize spread = random() % 2 == 0 ? 200 : text.size() + 1;
+        const usize base = random() % (text.size() + 1);
+        std::vector<usize> offsets;
+        for (unsigned i = 0; i < 2 * (random() % 30); ++i) {
+            offsets.push_back(std::min<usize>(text.size(), base / 2 + random() % spread));
+        }
+        std::sort(offsets.begin(), offsets.end());
+        std::vector<std::string> contents;
+        for (usize i = 0; i < offsets.size() / 2; ++i) {
+            contents.push_back(random() % 5 == 0 ? randomText(random, random() % 3000) : std::string(random() % 3, 'q'));
+        }
+        std::vector<Replacement> replacements;
+        std::string edited;
+        usize at = 0;
+        for (usize i = 0; i < contents.size(); ++i) {
+            replacements.push_back({Range::makeUnchecked(Offset(offsets[2 * i]), Offset(offsets[2 * i + 1])), contents[i]});
+            edited += text.substr(at, offsets[2 * i] - at) + contents[i];
+            at = offsets[2 * i + 1];
+        }
+        text = edited + text.substr(at);
+        tree.replacedEach(text, replacements);
+
+        const ChunkHashTree fresh(text);
+        ASSERT_EQ(tree.contentHash(), fresh.contentHash()) << round;
+        ASSERT_EQ(tree.chunkCount(), fresh.chunkCount()) << round;
+        ASSERT_TRUE(tree.diffRegions(fresh).empty()) << round;
+    }
+}
+
+TEST(teksBufferChunkHashTree, appendingMatchesHashingFromScratch) {
+    std::mt19937 random(5);
+    std::string text;
+    ChunkHashTree tree(text);
+    for (int edit = 0; edit < 200; ++edit) {
+        const std::string appended = randomText(random, random() % 3000);
+        text += appended;
+        tree.replaced(text, Offset(text.size() - appended.size()), Bytes(0), Bytes(appended.size()));
+    }
+    ASSERT_EQ(tree.contentHash(), ChunkHashTree(text).contentHash());
+    ASSERT_EQ(tree.chunkCount(), ChunkHashTree(text).chunkCount());
+}
+
+TEST(teksBufferChunkHashTree, diffRegionsCoverTheChangesOnly) {
+    std::mt19937 random(6);
+    const std::string before = randomText(random, 200000);
+    std::string after = before;
+    after.insert(30000, "inserted text\n");
+    after.erase(120000, 500);
+    after[190000] = '#';
+
+    const ChunkHashTree here(before);
+    const ChunkHashTree there(after);
+    const auto regions = here.diffRegions(there);
+    ASSERT_GE(regions.size(), 1);
+    ASSERT_LE(regions.size(), 3);
+    u64 changedBytes = 0;
+    for (const auto& region : regions) {
+        changedBytes += region.here.size().raw();
+    }
+    ASSERT_LE(changedBytes, 3 * 3 * ChunkHashTree::maxChunkBytes);
+    ASSERT_EQ(patch(before, after, regions), after);
+    ASSERT_TRUE(here.diffRegions(ChunkHashTree(before)).empty());
+}
+
+TEST(teksBufferChunkHashTree, diffRegionsPatchOneTextIntoTheOther) {
+    std::mt19937 random(8);
+    const std::string before = randomText(random, 100000);
+    for (int step = 0; step < 40; ++step) {
+        // at the very start and end too, where the common start or end is empty
+        std::string after = before;
+        for (usize count = 1 + random() % 3; count > 0; --count) {
+            const usize at = random() % 4 == 0 ? (random() % 2 == 0 ? 0 : after.size()) : random() % after.size();
+            const usize erased = std::min<usize>(after.size() - at, random() % 2 == 0 ? random() % 5000 : 0);
+            after.replace(at, erased, randomText(random, random() % 3000));
+        }
+        if (step % 10 == 0) {
+            after = before.substr(0, random() % before.size());
+        }
+        const ChunkHashTree here(before);
+        const ChunkHashTree there(after);
+        ASSERT_EQ(patch(before, after, here.diffRegions(there)), after) << "step " << step;
+        ASSERT_EQ(patch(after, before, there.diffRegions(here)), before) << "step " << step;
+    }
+}
+
+TEST(teksBufferChunkHashTree, buffersKeepTheirHashUpToDate) {
+    std::mt19937 random(7);
+    const std::string text = randomText(random, 40000);
+    Buffer buffer(text);
+    ASSERT_EQ(buffer.contentHash(), Buffer(text).contentHash());
+
+    ASSERT_TRUE(buffer.insert(Offset(20000), "hello\n"));
+    ASSERT_NE(buffer.contentHash(), Buffer(text).contentHash());
+    ASSERT_TRUE(buffer.erase(Range::makeUnchecked(Offset(20000), Bytes(6))));
+    ASSERT_EQ(buffer.contentHash(), Buffer(text).contentHash());
+    ASSERT_TRUE(buffer.chunkHashes().diffRegions(Buffer(text).chunkHashes()).empty());
+}
@@ -0,0 +1,149 @@
+#include <teks/buffer/Journal.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <utility>
+
+using namespace teks::buffer;
+
+namespace {
+    std::filesystem::path journalPath(const std::string& name) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return std::move(content).str();
+    }
+
+    void writeFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+    }
+
+    // Records `edits` into a journal of `base` and returns the file a crash would leave behind,
+    // put back at `path` once the journal is gone, as destroying it removes the file
+    template <typename Edits>
+    std::string journalOf(const std::filesystem::path& path, const std::string& base, Edits edits) {
+        std::string left;
+        {
+            Journal journal(path, Buffer(base).contentHash());
+            edits(journal);
+            journal.flush();
+            left = readFile(path);
+        }
+        writeFile(path, left);
+        return left;
+    }
+
+    Range range(teks::u64 start, teks::u64 end) {
+        return Range::makeUnchecked(Offset(start), Offset(end));
+    }
+}
+
+TEST(teksBufferJournal, pathIsHiddenBesideTheFile) {
+    ASSERT_EQ(Journal::pathFor("dir/notes.txt"), std::filesystem::path("dir/.notes.txt.teks-journal"));
+}
+
+TEST(teksBufferJournal, recoversEditsAfterACrash) {
+    const auto path = journalPath("teks_journal_test_edits");
+    (void)journalOf(path, "hello world", [](Journal& journal) {
+        journal.recordReplace(range(0, 5), "goodbye");
+        journal.recordReplace(range(8, 8), "cruel ");
+        const std::array<Replacement, 2> each{Replacement{range(0, 1), "G"}, Replacement{range(14, 19), "moon"}};
+        journal.recordReplaceEach(each);
+    });
+
+    Buffer buffer("hello world");
+    ASSERT_TRUE(Journal::recover(path, buffer));
+    ASSERT_EQ(readAllString(buffer), "Goodbye cruel moon");
+    std::filesystem::remove(path);
+}
+
+TEST(teksBufferJournal, tornTailEndsRecovery) {
+    const auto path = journalPath("teks_journal_test_torn");
+    const std::string left = journalOf(path, "abc", [](Journal& journal) {
+        journal.recordReplace(range(3, 3), "d");
+        journal.recordReplace(range(4, 4), "efgh");
+    });
+    // the last record lost its checksum and part of its content
+    writeFile(path, left.substr(0, left.size() - 10));
+
+    Buffer buffer("abc");
+    ASSERT_TRUE(Journal::recover(path, buffer));
+    ASSERT_EQ(readAllString(buffer), "abcd");
+    std::filesystem::remove(path);
+}
+
+TEST(teksBufferJournal, checkpointReplacesTheEditsBeforeIt) {
+    const auto path = journalPath("teks_journal_test_checkpoint");
+    const std::string left = journalOf(path, "one", [](Journal& journal) {
+        journal.recordReplace(range(3, 3), " two");
+        journal.checkpoint("one two");
+        journal.recordReplace(range(7, 7), " three");
+    });
+    // the edit before the checkpoint was compacted away
+    ASSERT_EQ(left.find(" two"), left.rfind(" two"));
+
+    std::pmr::unsynchronized_pool_resource pool;
+    Buffer buffer("one", &pool);
+    ASSERT_TRUE(Journal::recover(path, buffer));
+    ASSERT_EQ(readAllString(buffer), "one two three");
+    // the snapshot is allocated where the buffer was
+    ASSERT_EQ(buffer.get_allocator().resource(), &pool);
+    std::filesystem::remove(path);
+}
+
+TEST(teksBufferJournal, journalOfOtherContentIsNotRecovered) {
+    const auto path = journalPath("teks_journal_test_other");
+    (void)journalOf(path, "saved", [](Journal& journal) {
+        journal.checkpoint("saved and edited");
+    });
+
+    // the file changed since the journal started, a snapshot of the old one must not replace it
+    Buffer buffer("changed on disk");
+    ASSERT_FALSE(Journal::recover(path, buffer));
+    ASSERT_EQ(readAllString(buffer), "changed on disk");
+    std::filesystem::remove(path);
+}
+
+TEST(teksBufferJournal, restartDropsWhatWasRecorded) {
+    const auto path = journalPath("teks_journal_test_restart");
+    Journal journal(path, Buffer("text").contentHash());
+    journal.recordReplace(range(0, 4), "edited");
+    journal.flush();
+    ASSERT_TRUE(std::filesystem::exists(path));
+    // saved: nothing is left to recover, even before the journal is gone
+    journal.restart(Buffer("edited").contentHash());
+    journal.flush();
+    ASSERT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(teksBufferJournal, closingRemovesTheJournal) {
+    const auto path = journalPath("teks_journal_test_close");
+    {
+        Journal journal(path, Buffer("text").contentHash());
+        journal.recordReplace(range(0, 0), "unsaved ");
+        journal.flush();
+        ASSERT_TRUE(std::filesystem::exists(path));
+    }
+    // edits abandoned by closing without saving are not recovered
+    ASSERT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(teksBufferJournal, missingOrForeignFilesRecoverNothing) {
+    const auto path = journalPath("teks_journal_test_foreign");
+    Buffer buffer("text");
+    ASSERT_FALSE(Journal::recover(path, buffer));
+    writeFile(path, "not a journal at all");
+    ASSERT_FALSE(Journal::recover(path, buffer));
+    ASSERT_EQ(readAllString(buffer), "text");
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,94 @@
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/LineFilter.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+
+namespace {
+    std::vector<usize> naiveMatches(const Buffer& buffer, std::string_view pattern) {
+        std::vector<usize> lines;
+        for (usize line = 0; line < buffer.lineCount(); ++line) {
+            if (readLine(buffer, line).value().find(pattern) != std::string::npos) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    }
+
+    void expectMatchesNaive(const LineFilter& filter, const Buffer& buffer) {
+        const auto lines = naiveMatches(buffer, filter.pattern());
+        ASSERT_EQ(filter.lineCount(), lines.size());
+        for (usize line = 0; line < lines.size(); ++line) {
+            ASSERT_EQ(filter.sourceLine(line), lines[line]) << line;
+        }
+    }
+
+    std::string randomLog(std::mt19937& random, usize lines) {
+        static constexpr const char* levels[] = {"INFO", "WARN", "ERROR", "DEBUG"};
+        std::string text;
+        for (usize i = 0; i < lines; ++i) {
+            text += std::string(levels[random() % 4]) + " request " + std::to_string(random() % 1000) + "\n";
+        }
+        return text;
+    }
+}
+
+TEST(teksBufferLineFilter, findsLinesContainingThePattern) {
+    const Buffer buffer("alpha\nbeta\n\nalphabet\ngamma alpha");
+    const LineFilter filter(buffer, "alpha");
+    ASSERT_EQ(filter.lineCount(), 3);
+    ASSERT_EQ(filter.sourceLine(0), 0);
+    ASSERT_EQ(filter.sourceLine(1), 3);
+    ASSERT_EQ(filter.sourceLine(2), 4);
+    ASSERT_EQ(filter.lineAtOrAfter(0), 0);
+    ASSERT_EQ(filter.lineAtOrAfter(1), 1);
+    ASSERT_EQ(filter.lineAtOrAfter(4), 2);
+    ASSERT_EQ(filter.lineAtOrAfter(5), 3);
+
+    ASSERT_EQ(LineFilter(buffer, "").lineCount(), buffer.lineCount());
+    ASSERT_EQ(LineFilter(buffer, "a\nb").lineCount(), 0);
+}
+
+TEST(teksBufferLineFilter, parallelScanMatchesSerialScan) {
+    std::mt19937 random(1);
+    const Buffer buffer(randomLog(random, 100000));
+    const LineFilter serial(buffer, "ERROR request 1", 1);
+    const LineFilter parallel(buffer, "ERROR request 1", 4);
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(serial, buffer));
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(parallel, buffer));
+}
+
+TEST(teksBufferLineFilter, followsEditsAndAppends) {
+    std::mt19937 random(2);
+    Buffer buffer(randomLog(random, 2000));
+    LineFilter filter(buffer, "WARN", 2);
+    for (int edit = 0; edit < 200; ++edit) {
+        const usize start = random() % (buffer.size().raw() + 1);
+        const usize end = std::min<usize>(buffer.size().raw(), start + random() % 200);
+        const std::string content = edit % 5 == 0 ? randomLog(random, random() % 20) : "WARN";
+        const Range range = Range::makeUnchecked(Offset(start), Offset(end));
+
+        const usize first = buffer.positionOf(range.start(), ColumnUnit::Codepoint).value().line;
+        const usize removed = buffer.positionOf(range.end(), ColumnUnit::Codepoint).value().line - first + 1;
+        ASSERT_TRUE(buffer.replace(range, content));
+        const usize inserted = static_cast<usize>(std::count(content.begin(), content.end(), '\n')) + 1;
+
+        const auto before = filter.lineCount();
+        const auto replaced = filter.replaceLines(buffer, first, removed, inserted);
+        ASSERT_EQ(filter.lineCount(), before - replaced.removed + replaced.inserted);
+        if (edit % 20 == 0) {
+            ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(filter, buffer)) << edit;
+        }
+    }
+
+    const usize lines = buffer.lineCount();
+    ASSERT_TRUE(insertEnd(buffer, "\n" + randomLog(random, 500)));
+    const auto appended = filter.replaceLines(buffer, lines - 1, 1, buffer.lineCount() - lines + 1);
+    ASSERT_EQ(appended.first + appended.inserted, filter.lineCount());
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(filter, buffer));
+}
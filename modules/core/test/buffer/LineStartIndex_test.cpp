@@ -0,0 +1,112 @@
+#include <teks/buffer/LineStartIndex.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+
+namespace {
+    std::vector<Offset> naiveLineStarts(std::string_view text) {
+        std::vector<Offset> starts{Offset(0)};
+        for (usize i = 0; i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                starts.push_back(Offset(i + 1));
+            }
+        }
+        return starts;
+    }
+
+    void expectMatchesNaive(const LineStartIndex& index, std::string_view text) {
+        const auto starts = naiveLineStarts(text);
+        ASSERT_EQ(index.lineCount(), starts.size());
+        for (usize line = 0; line < starts.size(); ++line) {
+            ASSERT_EQ(index.lineStart(line), starts[line]) << line;
+            const Offset end = line + 1 < starts.size() ? starts[line + 1] - Bytes(1) : Offset(text.size());
+            ASSERT_EQ(index.lineRange(line, Bytes(text.size())), Range::makeUnchecked(starts[line], end)) << line;
+        }
+
+        const auto expectLineAt = [&](usize at) {
+            const auto after = std::upper_bound(starts.begin(), starts.end(), Offset(at));
+            ASSERT_EQ(index.lineAt(Offset(at)), static_cast<usize>(after - starts.begin()) - 1) << at;
+        };
+        // around every line start, where an off by one would show, and a sample of offsets in between
+        for (const Offset start : starts) {
+            for (usize at = start.raw() > 0 ? start.raw() - 1 : 0; at <= std::min(start.raw() + 1, text.size()); ++at) {
+                ASSERT_NO_FATAL_FAILURE(expectLineAt(at));
+            }
+        }
+        std::mt19937 random(static_cast<u32>(text.size()));
+        for (usize sample = 0; sample < 200; ++sample) {
+            ASSERT_NO_FATAL_FAILURE(expectLineAt(random() % (text.size() + 1)));
+        }
+        ASSERT_NO_FATAL_FAILURE(expectLineAt(text.size()));
+    }
+
+    std::string randomText(std::mt19937& random, usize lines, u32 maxLineBytes) {
+        std::string text;
+        for (usize i = 0; i < lines; ++i) {
+            text.append(random() % (maxLineBytes + 1), 'x');
+            text.push_back('\n');
+        }
+        return text;
+    }
+}
+
+TEST(teksBufferLineStartIndex, emptyText) {
+    const LineStartIndex index;
+    ASSERT_EQ(index.lineCount(), 1);
+    ASSERT_EQ(index.lineStart(0), Offset(0));
+    ASSERT_EQ(index.lineAt(Offset(0)), 0);
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(LineStartIndex(""), ""));
+}
+
+TEST(teksBufferLineStartIndex, spansBlocksAndLongLines) {
+    std::mt19937 random(1);
+    // lines longer than 127 bytes take more than one byte to encode
+    const std::string text = randomText(random, LineStartIndex::blockLines * 5 + 3, 300) + "last";
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(LineStartIndex(text), text));
+}
+
+TEST(teksBufferLineStartIndex, randomEditsMatchNaive) {
+    std::mt19937 random(2);
+    std::string text = randomText(random, 500, 20);
+    LineStartIndex index(text);
+    for (int edit = 0; edit < 400; ++edit) {
+        const usize at = random() % (text.size() + 1);
+        if (random() % 2 == 0) {
+            const std::string inserted = randomText(random, random() % (LineStartIndex::blockLines * 3), 150)
+                + std::string(random() % 5, 'y');
+            text.insert(at, inserted);
+            index.inserted(text, Offset(at), Bytes(inserted.size()));
+        } else {
+            // mostly short erases, sometimes across many blocks
+            const usize size = std::min<usize>(text.size() - at, random() % 4 == 0 ? random() % 4000 : random() % 30);
+            text.erase(at, size);
+            index.erased(Range::makeUnchecked(Offset(at), Bytes(size)));
+        }
+        if (edit % 40 == 0) {
+            ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text)) << edit;
+        }
+    }
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text));
+}
+
+TEST(teksBufferLineStartIndex, erasingEverythingLeavesOneLine) {
+    std::mt19937 random(3);
+    std::string text = randomText(random, 1000, 40);
+    LineStartIndex index(text);
+    index.erased(Range::makeUnchecked(Offset(0), Offset(text.size())));
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, ""));
+}
+
+TEST(teksBufferLineStartIndex, usesAQuarterOfAnOffsetVector) {
+    std::mt19937 random(4);
+    // typical source and log lines are well under 127 bytes
+    const std::string text = randomText(random, 100000, 120);
+    const LineStartIndex index(text);
+    ASSERT_LE(index.memoryBytes() * 4, index.lineCount() * sizeof(Offset));
+}
@@ -0,0 +1,64 @@
+#include <teks/buffer/types.hpp>
+#include <teks/buffer/Buffer.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace teks::buffer;
+
+namespace {
+    // "é" is 2 bytes, "😀" is 4 bytes and 2 UTF-16 units
+    const std::string text = "a\xC3\xA9" "b\n\xF0\x9F\x98\x80" "c\n";
+}
+
+TEST(teksBufferPosition, comparison) {
+    ASSERT_EQ((Position{1, 2}), (Position{1, 2}));
+    ASSERT_LT((Position{1, 5}), (Position{2, 0}));
+    ASSERT_LT((Position{1, 2}), (Position{1, 3}));
+}
+
+TEST(teksBufferPosition, positionOfCountsColumnsInUnits) {
+    const Buffer buffer(text);
+    ASSERT_EQ(buffer.positionOf(Offset(0), ColumnUnit::Codepoint), (Position{0, 0}));
+    ASSERT_EQ(buffer.positionOf(Offset(3), ColumnUnit::Codepoint), (Position{0, 2}));
+    ASSERT_EQ(buffer.positionOf(Offset(4), ColumnUnit::Codepoint), (Position{0, 3}));
+    ASSERT_EQ(buffer.positionOf(Offset(5), ColumnUnit::Codepoint), (Position{1, 0}));
+    ASSERT_EQ(buffer.positionOf(Offset(9), ColumnUnit::Codepoint), (Position{1, 1}));
+    ASSERT_EQ(buffer.positionOf(Offset(9), ColumnUnit::Utf16), (Position{1, 2}));
+    ASSERT_EQ(buffer.positionOf(Offset(11), ColumnUnit::Utf16), (Position{2, 0}));
+    ASSERT_EQ(buffer.positionOf(Offset(12), ColumnUnit::Utf16), std::nullopt);
+}
+
+TEST(teksBufferPosition, offsetOfRoundTrips) {
+    const Buffer buffer(text);
+    for (ColumnUnit unit : {ColumnUnit::Codepoint, ColumnUnit::Utf16}) {
+        for (teks::u64 at : {0u, 1u, 3u, 4u, 5u, 9u, 10u, 11u}) {
+            const Position position = buffer.positionOf(Offset(at), unit).value();
+            ASSERT_EQ(buffer.offsetOf(position, unit), Offset(at));
+        }
+    }
+}
+
+TEST(teksBufferPosition, offsetOfRejectsColumnsPastTheLineEnd) {
+    const Buffer buffer(text);
+    ASSERT_EQ(buffer.offsetOf(Position{0, 3}, ColumnUnit::Codepoint), Offset(4));
+    ASSERT_EQ(buffer.offsetOf(Position{0, 4}, ColumnUnit::Codepoint), std::nullopt);
+    ASSERT_EQ(buffer.offsetOf(Position{1, 3}, ColumnUnit::Utf16), Offset(10));
+    ASSERT_EQ(buffer.offsetOf(Position{1, 4}, ColumnUnit::Utf16), std::nullopt);
+    ASSERT_EQ(buffer.offsetOf(Position{2, 0}, ColumnUnit::Utf16), Offset(11));
+    ASSERT_EQ(buffer.offsetOf(Position{3, 0}, ColumnUnit::Utf16), std::nullopt);
+    ASSERT_EQ(buffer.offsetOf(Position{0, ~teks::u64{0}}, ColumnUnit::Utf16), std::nullopt);
+}
+
+TEST(teksBufferPosition, offsetOfInsideSurrogatePairGivesCodepointStart) {
+    const Buffer buffer(text);
+    ASSERT_EQ(buffer.offsetOf(Position{1, 1}, ColumnUnit::Utf16), Offset(5));
+}
+
+TEST(teksBufferPosition, conversionsFollowEdits) {
+    Buffer buffer(text);
+    ASSERT_TRUE(buffer.insert(Offset(0), "\xE2\x82\xAC"));
+    ASSERT_EQ(buffer.positionOf(Offset(7), ColumnUnit::Codepoint), (Position{0, 4}));
+    ASSERT_TRUE(buffer.erase(Range::makeUnchecked(Offset(0), Offset(6))));
+    ASSERT_EQ(buffer.positionOf(Offset(1), ColumnUnit::Codepoint), (Position{0, 1}));
+    ASSERT_EQ(buffer.offsetOf(Position{1, 1}, ColumnUnit::Codepoint), Offset(6));
+}
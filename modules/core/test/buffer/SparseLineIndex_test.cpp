@@ -0,0 +1,140 @@
+#include <teks/buffer/SparseLineIndex.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+
+namespace {
+    std::vector<Range> naiveLineRanges(std::string_view text) {
+        std::vector<Range> ranges;
+        usize start = 0;
+        for (usize newline = text.find('\n'); newline != std::string_view::npos; newline = text.find('\n', start)) {
+            ranges.push_back(Range::makeUnchecked(Offset(start), Offset(newline)));
+            start = newline + 1;
+        }
+        ranges.push_back(Range::makeUnchecked(Offset(start), Offset(text.size())));
+        return ranges;
+    }
+
+    std::string randomLines(u32 seed, usize lines) {
+        std::mt19937 random(seed);
+        std::string text;
+        for (usize i = 0; i < lines; ++i) {
+            // runs of empty lines, short lines and lines spanning several 16 byte blocks
+            text.append(random() % 4 == 0 ? 0 : random() % 40, static_cast<char>('a' + random() % 26));
+            text.push_back('\n');
+        }
+        return text;
+    }
+
+    void expectMatchesNaive(SparseLineIndex& index, std::string_view text) {
+        const auto ranges = naiveLineRanges(text);
+        for (usize line = 0; line < ranges.size(); ++line) {
+            ASSERT_EQ(index.lineRange(text, line), ranges[line]) << line;
+        }
+        ASSERT_EQ(index.lineRange(text, ranges.size()), std::nullopt);
+        ASSERT_EQ(index.lineCount(text), ranges.size());
+        for (usize line = 0; line < ranges.size(); ++line) {
+            ASSERT_EQ(index.lineOf(text, ranges[line].start()), line);
+            ASSERT_EQ(index.lineOf(text, ranges[line].end()), line);
+        }
+    }
+}
+
+TEST(teksBufferSparseLineIndex, emptyText) {
+    SparseLineIndex index;
+    ASSERT_FALSE(index.indexSome("", 100));
+    ASSERT_EQ(index.lineCount(""), 1);
+    ASSERT_EQ(index.lineRange("", 0), Range::makeUnchecked(Offset(0), Offset(0)));
+    ASSERT_EQ(index.lineRange("", 1), std::nullopt);
+    ASSERT_EQ(index.lineOf("", Offset(0)), 0);
+}
+
+TEST(teksBufferSparseLineIndex, findsLinesBetweenCheckpoints) {
+    const std::string text = randomLines(3, 2000);
+    for (usize interval : {usize{1}, usize{7}, usize{64}, SparseLineIndex::defaultInterval}) {
+        SparseLineIndex index(interval);
+        ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text)) << interval;
+    }
+}
+
+TEST(teksBufferSparseLineIndex, lastLineWithoutNewline) {
+    const std::string text = randomLines(5, 300) + "unterminated";
+    SparseLineIndex index(16);
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text));
+}
+
+TEST(teksBufferSparseLineIndex, indexesInSlices) {
+    const std::string text = randomLines(9, 5000);
+    SparseLineIndex index(32);
+    ASSERT_EQ(index.lineCount(text), std::nullopt);
+    ASSERT_EQ(index.lineOf(text, Offset(text.size())), std::nullopt);
+
+    usize slices = 0;
+    while (index.indexSome(text, 1000)) {
+        ++slices;
+        ASSERT_EQ(index.indexedBytes(), Bytes(slices * 1000));
+        ASSERT_FALSE(index.complete(text));
+        // lines so far are exact, the rest extrapolated
+        const usize estimate = index.estimatedLineCount(text);
+        ASSERT_GT(estimate, 4000);
+        ASSERT_LT(estimate, 6000);
+    }
+    ASSERT_TRUE(index.complete(text));
+    ASSERT_EQ(index.estimatedLineCount(text), 5001);
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text));
+}
+
+TEST(teksBufferSparseLineIndex, lookupIndexesOnlyAsFarAsNeeded) {
+    const std::string text = randomLines(11, 1 << 21);
+    SparseLineIndex index;
+    const auto ranges = naiveLineRanges(text);
+    ASSERT_EQ(index.lineRange(text, 10), ranges[10]);
+    ASSERT_FALSE(index.complete(text));
+    ASSERT_EQ(index.lineRange(text, ranges.size() - 1), ranges.back());
+    ASSERT_TRUE(index.complete(text));
+}
+
+TEST(teksBufferSparseLineIndex, lineStartAndEndAround) {
+    constexpr std::string_view text = "one\n\nthree";
+    ASSERT_EQ(SparseLineIndex::lineStartAt(text, Offset(0)), Offset(0));
+    ASSERT_EQ(SparseLineIndex::lineStartAt(text, Offset(2)), Offset(0));
+    // the newline belongs to the line it ends
+    ASSERT_EQ(SparseLineIndex::lineStartAt(text, Offset(3)), Offset(0));
+    ASSERT_EQ(SparseLineIndex::lineStartAt(text, Offset(4)), Offset(4));
+    ASSERT_EQ(SparseLineIndex::lineStartAt(text, Offset(10)), Offset(5));
+    ASSERT_EQ(SparseLineIndex::lineEndAt(text, Offset(0)), Offset(3));
+    ASSERT_EQ(SparseLineIndex::lineEndAt(text, Offset(4)), Offset(4));
+    ASSERT_EQ(SparseLineIndex::lineEndAt(text, Offset(5)), Offset(10));
+    ASSERT_EQ(SparseLineIndex::lineEndAt(text, Offset(10)), Offset(10));
+}
+
+TEST(teksBufferSparseLineIndex, rowsSplitLongLinesBetweenCodepoints) {
+    // "é" is two bytes, a row of at most 4 bytes cannot end in the middle of one
+    constexpr std::string_view text = "ab\xc3\xa9\xc3\xa9x\nshort\n";
+    ASSERT_EQ(SparseLineIndex::rowEndAt(text, Offset(0), 4), Offset(4));
+    ASSERT_EQ(SparseLineIndex::rowEndAt(text, Offset(0), 3), Offset(2));
+    // the newline is within reach, the row ends the line
+    ASSERT_EQ(SparseLineIndex::rowEndAt(text, Offset(4), 4), Offset(7));
+    ASSERT_EQ(SparseLineIndex::rowEndAt(text, Offset(8), 8), Offset(13));
+    ASSERT_EQ(SparseLineIndex::rowEndAt(text, Offset(14), 4), Offset(14));
+
+    ASSERT_EQ(SparseLineIndex::rowStartAt(text, Offset(3), 4), Offset(0));
+    // 4 bytes back from 7 is inside "é", the row starts after it
+    ASSERT_EQ(SparseLineIndex::rowStartAt(text, Offset(7), 4), Offset(4));
+    ASSERT_EQ(SparseLineIndex::rowStartAt(text, Offset(12), 8), Offset(8));
+    ASSERT_EQ(SparseLineIndex::rowStartAt(text, Offset(14), 4), Offset(14));
+}
+
+TEST(teksBufferSparseLineIndex, lineStartMatchesLineRange) {
+    const std::string text = randomLines(7, 1000);
+    SparseLineIndex index(16);
+    for (usize line = 0; line <= 1000; line += 37) {
+        ASSERT_EQ(index.lineStart(text, line), index.lineRange(text, line)->start()) << line;
+    }
+    ASSERT_EQ(index.lineStart(text, 5000), std::nullopt);
+}
@@ -0,0 +1,161 @@
+#include <teks/buffer/Utf8Index.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+
+namespace {
+    // "aé€😀": 1, 2, 3 and 4 byte codepoints
+    constexpr std::string_view mixed = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+
+    u64 naiveUnitsOf(char c, ColumnUnit unit) {
+        const auto byte = static_cast<unsigned char>(c);
+        if ((byte & 0xC0) == 0x80) {
+            return 0;
+        }
+        return unit == ColumnUnit::Utf16 && (byte & 0xF8) == 0xF0 ? 2 : 1;
+    }
+
+    u64 naiveUnitsBefore(std::string_view text, usize at, ColumnUnit unit) {
+        u64 units = 0;
+        for (usize i = 0; i < at; ++i) {
+            units += naiveUnitsOf(text[i], unit);
+        }
+        return units;
+    }
+
+    void expectMatchesNaive(const Utf8Index& index, std::string_view text) {
+        ASSERT_EQ(index.size(), Bytes(text.size()));
+        for (ColumnUnit unit : {ColumnUnit::Codepoint, ColumnUnit::Utf16}) {
+            // every 7th offset of short texts and about 128 spread over longer ones, since each lookup
+            // scans into its chunk, checked against a naive count kept running rather than recounted
+            // from the start for each
+            const usize stride = std::max<usize>(7, text.size() / 128);
+            u64 units = 0;
+            for (usize at = 0; at <= text.size(); ++at) {
+                if (at % stride == 0 || at == text.size()) {
+                    ASSERT_EQ(index.unitsBefore(text, Offset(at), unit), units) << at;
+                }
+                if (at < text.size()) {
+                    units += naiveUnitsOf(text[at], unit);
+                }
+            }
+        }
+    }
+}
+
+TEST(teksBufferUtf8Index, emptyText) {
+    const Utf8Index index("");
+    ASSERT_EQ(index.size(), Bytes(0));
+    ASSERT_EQ(index.unitsBefore("", Offset(0), ColumnUnit::Codepoint), 0);
+    ASSERT_EQ(index.offsetOfUnit("", 0, ColumnUnit::Codepoint), Offset(0));
+    ASSERT_EQ(index.offsetOfUnit("", 1, ColumnUnit::Codepoint), std::nullopt);
+}
+
+TEST(teksBufferUtf8Index, countsCodepointsAndUtf16Units) {
+    const Utf8Index index(mixed);
+    ASSERT_EQ(index.unitsBefore(mixed, Offset(mixed.size()), ColumnUnit::Codepoint), 4);
+    ASSERT_EQ(index.unitsBefore(mixed, Offset(mixed.size()), ColumnUnit::Utf16), 5);
+    ASSERT_EQ(index.unitsBefore(mixed, Offset(3), ColumnUnit::Codepoint), 2);
+    // inside "é", which is counted
+    ASSERT_EQ(index.unitsBefore(mixed, Offset(2), ColumnUnit::Codepoint), 2);
+}
+
+TEST(teksBufferUtf8Index, offsetOfUnitFindsCodepointStarts) {
+    const Utf8Index index(mixed);
+    ASSERT_EQ(index.offsetOfUnit(mixed, 0, ColumnUnit::Codepoint), Offset(0));
+    ASSERT_EQ(index.offsetOfUnit(mixed, 1, ColumnUnit::Codepoint), Offset(1));
+    ASSERT_EQ(index.offsetOfUnit(mixed, 2, ColumnUnit::Codepoint), Offset(3));
+    ASSERT_EQ(index.offsetOfUnit(mixed, 3, ColumnUnit::Codepoint), Offset(6));
+    ASSERT_EQ(index.offsetOfUnit(mixed, 4, ColumnUnit::Codepoint), Offset(10));
+    ASSERT_EQ(index.offsetOfUnit(mixed, 5, ColumnUnit::Codepoint), std::nullopt);
+
+    ASSERT_EQ(index.offsetOfUnit(mixed, 3, ColumnUnit::Utf16), Offset(6));
+    // the low surrogate of the emoji gives the start of its codepoint
+    ASSERT_EQ(index.offsetOfUnit(mixed, 4, ColumnUnit::Utf16), Offset(6));
+    ASSERT_EQ(index.offsetOfUnit(mixed, 5, ColumnUnit::Utf16), Offset(10));
+}
+
+TEST(teksBufferUtf8Index, spansManyChunks) {
+    std::string text;
+    while (text.size() < Utf8Index::chunkBytes * 5) {
+        text += mixed;
+    }
+    const Utf8Index index(text);
+    expectMatchesNaive(index, text);
+
+    const u64 codepoints = naiveUnitsBefore(text, text.size(), ColumnUnit::Codepoint);
+    for (u64 unit = 0; unit < codepoints; unit += 13) {
+        const Offset at = index.offsetOfUnit(text, unit, ColumnUnit::Codepoint).value();
+        ASSERT_EQ(naiveUnitsBefore(text, at.raw(), ColumnUnit::Codepoint), unit);
+    }
+}
+
+TEST(teksBufferUtf8Index, editsKeepCountsInSync) {
+    std::mt19937 random(1234);
+    std::string text;
+    Utf8Index index(text);
+    const std::string pieces[] = {"x", std::string(mixed), std::string(3000, 'y'), "\xE2\x82\xAC\n"};
+    for (int edit = 0; edit < 400; ++edit) {
+        const usize at = text.empty() ? 0 : random() % (text.size() + 1);
+        if (random() % 3 != 0 || text.empty()) {
+            const std::string& piece = pieces[random() % std::size(pieces)];
+            text.insert(at, piece);
+            index.inserted(text, Offset(at), Bytes(piece.size()));
+        } else {
+            const usize end = std::min(text.size(), at + random() % 5000);
+            index.erasing(text, Range::makeUnchecked(Offset(at), Offset(end)));
+            text.erase(at, end - at);
+        }
+        ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text));
+    }
+}
+
+TEST(teksBufferUtf8Index, appendingSplitsTheLastChunk) {
+    std::string text;
+    Utf8Index index(text);
+    const std::string pieces[] = {std::string(mixed), std::string(5000, 'z'), std::string(9000, 'w') + std::string(mixed)};
+    for (usize edit = 0; edit < 12; ++edit) {
+        const std::string& piece = pieces[edit % std::size(pieces)];
+        text += piece;
+        index.inserted(text, Offset(text.size() - piece.size()), Bytes(piece.size()));
+    }
+    ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text));
+}
+
+TEST(teksBufferUtf8Index, editsAppliedAtOnceMatchCountingFromScratch) {
+    std::mt19937 random(99);
+    std::string text;
+    while (text.size() < Utf8Index::chunkBytes * 6) {
+        text += mixed;
+        text += "plain ";
+    }
+    Utf8Index index(text);
+    const std::string contents[] = {"", "x", std::string(mixed), std::string(9000, 'v')};
+    for (int round = 0; round < 60; ++round) {
+        // sometimes across whole chunks, emptying them, and sometimes growing one past splitting
+        std::vector<usize> offsets(2 * (1 + random() % 8));
+        for (usize& offset : offsets) {
+            offset = random() % (text.size() + 1);
+        }
+        std::sort(offsets.begin(), offsets.end());
+        std::vector<Replacement> replacements;
+        std::string edited;
+        usize at = 0;
+        for (usize i = 0; i < offsets.size(); i += 2) {
+            const std::string& content = contents[random() % std::size(contents)];
+            replacements.push_back({Range::makeUnchecked(Offset(offsets[i]), Offset(offsets[i + 1])), content});
+            edited += text.substr(at, offsets[i] - at) + content;
+            at = offsets[i + 1];
+        }
+        const std::string replaced = text.substr(offsets.front(), offsets.back() - offsets.front());
+        text = edited + text.substr(at);
+        index.replacedEach(replaced, text, replacements);
+        ASSERT_NO_FATAL_FAILURE(expectMatchesNaive(index, text)) << round;
+    }
+}
@@ -0,0 +1,129 @@
+#include <teks/buffer/Utf8.hpp>
+#include <teks/buffer/Buffer.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+
+namespace {
+    Range makeRange(u64 start, u64 end) {
+        return Range::makeUnchecked(Offset(start), Offset(end));
+    }
+
+    std::u16string decode(std::string_view text) {
+        std::u16string result(text.size(), u'\0');
+        result.resize(decodeValidUtf8(text, result.data()));
+        return result;
+    }
+}
+
+TEST(teksBufferUtf8, validUtf8PrefixAcceptsValidText) {
+    ASSERT_EQ(validUtf8Prefix(""), 0);
+    ASSERT_EQ(validUtf8Prefix("plain ascii that is longer than a block"), 39);
+    const std::string_view mixed = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80 and some more ascii \xF4\x8F\xBF\xBF";
+    ASSERT_EQ(validUtf8Prefix(mixed), mixed.size());
+}
+
+TEST(teksBufferUtf8, validUtf8PrefixStopsAtInvalidSequences) {
+    // stray continuation byte after a full ASCII block
+    ASSERT_EQ(validUtf8Prefix("0123456789abcdefg\x80"), 17);
+    // overlong encodings
+    ASSERT_EQ(validUtf8Prefix("a\xC0\xAF"), 1);
+    ASSERT_EQ(validUtf8Prefix("a\xE0\x80\xAF"), 1);
+    // surrogate
+    ASSERT_EQ(validUtf8Prefix("ab\xED\xA0\x80"), 2);
+    // past U+10FFFF
+    ASSERT_EQ(validUtf8Prefix("\xF4\x90\x80\x80"), 0);
+    ASSERT_EQ(validUtf8Prefix("\xF5\x80\x80\x80"), 0);
+    // truncated at the end
+    ASSERT_EQ(validUtf8Prefix("abc\xE2\x82"), 3);
+}
+
+TEST(teksBufferUtf8, decodeValidUtf8ProducesUtf16) {
+    ASSERT_EQ(decode(""), u"");
+    ASSERT_EQ(decode("a longer ascii run than one block"), u"a longer ascii run than one block");
+    ASSERT_EQ(decode("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"), u"aé€\U0001F600");
+}
+
+TEST(teksBufferUtf8, decodeValidUtf8DoesNotReadPastTruncatedSequences) {
+    ASSERT_EQ(decode("a\xE2\x82"), u"a��");
+    ASSERT_EQ(decode("\x80" "b"), u"�b");
+}
+
+TEST(teksBufferUtf8, invalidRunsUseMaximalSubparts) {
+    const InvalidUtf8Runs runs("ok\xE2\x82" "x\x80\x80y\xC3");
+    ASSERT_EQ(runs.runs(), (std::vector<Range>{makeRange(2, 4), makeRange(5, 7), makeRange(8, 9)}));
+    // a truncated sequence directly followed by a new lead is two units in one run
+    const InvalidUtf8Runs adjacent("\xE2\x82\xE2\x82");
+    ASSERT_EQ(adjacent.runs(), (std::vector<Range>{makeRange(0, 4)}));
+}
+
+TEST(teksBufferUtf8, withinClipsRuns) {
+    const InvalidUtf8Runs runs("a\x80\x80\x80" "b\xFF");
+    ASSERT_EQ(runs.within(makeRange(2, 6)), (std::vector<Range>{makeRange(2, 4), makeRange(5, 6)}));
+    ASSERT_TRUE(runs.within(makeRange(0, 1)).empty());
+}
+
+TEST(teksBufferUtf8, replacedMatchesAFullScan) {
+    std::mt19937 random(31);
+    const std::vector<std::string> pieces{
+        "a", "\xC3", "\xA9", "\xE2\x82", "\xAC", "\xF0\x9F\x98\x80", "\x80\x80\x80\x80", "hello world\n", "\xFF",
+    };
+    std::string text;
+    InvalidUtf8Runs runs(text);
+    for (int edit = 0; edit < 2000; ++edit) {
+        const usize at = text.empty() ? 0 : random() % (text.size() + 1);
+        const usize removed = std::min<usize>(text.size() - at, random() % 3 == 0 ? random() % 8 : 0);
+        const std::string& piece = pieces[random() % pieces.size()];
+        const std::string inserted = random() % 4 == 0 ? std::string() : piece;
+        text.replace(at, removed, inserted);
+        runs.replaced(text, Offset(at), Bytes(removed), Bytes(inserted.size()));
+        ASSERT_EQ(runs.runs(), InvalidUtf8Runs(text).runs()) << "edit " << edit;
+    }
+}
+
+TEST(teksBufferUtf8, replacedEachMatchesAFullScan) {
+    std::mt19937 random(37);
+    const std::vector<std::string> pieces{
+        "a", "\xC3", "\xA9", "\xE2\x82", "\xAC", "\xF0\x9F\x98\x80", "\x80\x80\x80\x80", "hello world\n", "\xFF",
+    };
+    std::string text;
+    InvalidUtf8Runs runs(text);
+    for (int step = 0; step < 500; ++step) {
+        // a few edits, sorted, some of them touching
+        std::vector<Replacement> edits;
+        usize at = 0;
+        for (usize count = random() % 5; count > 0 && at <= text.size(); --count) {
+            const usize start = at + (text.size() == at || random() % 3 == 0 ? 0 : random() % std::min<usize>(6, text.size() - at + 1));
+            const usize removed = std::min<usize>(text.size() - start, random() % 3 == 0 ? random() % 6 : 0);
+            const std::string_view inserted = random() % 4 == 0 ? std::string_view() : pieces[random() % pieces.size()];
+            edits.push_back(Replacement{makeRange(start, start + removed), inserted});
+            at = start + removed;
+        }
+        std::string edited;
+        usize copied = 0;
+        for (const Replacement& edit : edits) {
+            edited.append(text, copied, edit.range.start().raw() - copied);
+            edited.append(edit.content);
+            copied = edit.range.end().raw();
+        }
+        edited.append(text, copied);
+        text = edited;
+        runs.replacedEach(text, edits);
+        ASSERT_EQ(runs.runs(), InvalidUtf8Runs(text).runs()) << "step " << step;
+    }
+}
+
+TEST(teksBufferUtf8, bufferTracksInvalidRunsThroughEdits) {
+    Buffer buffer(std::string("ab\r\n\xFF" "cd\r\xE2\x82"));
+    ASSERT_EQ(buffer.invalidUtf8Runs(range(buffer)), (std::vector<Range>{makeRange(3, 4), makeRange(7, 9)}));
+    ASSERT_TRUE(buffer.insert(Offset(9), "\xAC"));
+    ASSERT_EQ(buffer.invalidUtf8Runs(range(buffer)), (std::vector<Range>{makeRange(3, 4)}));
+    ASSERT_TRUE(buffer.erase(makeRange(3, 4)));
+    ASSERT_TRUE(buffer.invalidUtf8Runs(range(buffer))->empty());
+    ASSERT_EQ(buffer.invalidUtf8Runs(makeRange(0, 100)), std::nullopt);
+}
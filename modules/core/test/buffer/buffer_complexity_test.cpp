@@ -0,0 +1,270 @@
+#include <teks/buffer/types.hpp>
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/ChunkHashTree.hpp>
+#include <teks/buffer/LineStartIndex.hpp>
+#include <teks/buffer/Utf8Index.hpp>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks::buffer;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Buffer sizes every operation is timed at, 16 KiB to 1 MiB
+    constexpr std::array<teks::u64, 4> sizes{teks::u64(1) << 14, teks::u64(1) << 16, teks::u64(1) << 18, teks::u64(1) << 20};
+    // Text sizes index edits are timed at, 256 KiB to 16 MiB. Their constant part, re-encoding a block or
+    // rehashing a chunk, would hide a linear part that is a few bytes per line at the buffer sizes.
+    constexpr std::array<teks::u64, 4> indexSizes{teks::u64(1) << 18, teks::u64(1) << 20, teks::u64(1) << 22, teks::u64(1) << 24};
+    // An operation is run for at least this long per timing, and the fastest of the timings is kept
+    constexpr Clock::duration minTiming = std::chrono::milliseconds(2);
+    constexpr teks::usize timings = 5;
+    // How far the fitted exponent may go past its bound. O(1) and O(log n) fit close to 0 and O(n) close
+    // to 1, so half way to the next power of n is noise and cache effects rather than a worse algorithm.
+    constexpr double exponentSlack = 0.5;
+
+    // keeps the results of operations without side effects from being optimized away
+    volatile teks::u64 sink = 0;
+
+    // `bytes` of lines of `shortest` to `longest` codepoints, with multi-byte codepoints and now and then
+    // an invalid byte
+    std::string makeText(teks::u64 bytes, teks::u64 shortest = 20, teks::u64 longest = 119) {
+        std::mt19937_64 random(bytes);
+        std::string text;
+        text.reserve(bytes);
+        while (text.size() < bytes) {
+            const teks::u64 length = shortest + random() % (longest - shortest + 1);
+            for (teks::u64 i = 0; i < length; ++i) {
+                const teks::u64 kind = random() % 64;
+                if (kind == 0) {
+                    text += "\xc3\xa9";
+                } else if (kind == 1) {
+                    text += "\xf0\x9f\x98\x80";
+                } else {
+                    text.push_back(static_cast<char>('a' + random() % 26));
+                }
+            }
+            if (random() % 32 == 0) {
+                text.push_back('\xff');
+            }
+            text.push_back('\n');
+        }
+        text.resize(bytes);
+        return text;
+    }
+
+    template <typename B>
+    struct Operation {
+        const char* name;
+        // the power of n in the documented bound, O(log n) counts as 0
+        double boundExponent;
+        // Runs the operation once on `buffer`, made from `text`, keeping the buffer's size
+        std::function<void(B& buffer, const std::string& text)> run;
+    };
+
+    template <typename B>
+    std::vector<Operation<B>> makeOperations() {
+        const auto middle = [](const B& buffer) { return Offset(buffer.size().raw() / 2); };
+        return {
+            {"construct", 1.0, [](B&, const std::string& text) {
+                const B built(text, typename B::allocator_type{});
+                sink = sink + built.lineCount();
+            }},
+            {"insertThenErase", 1.0, [middle](B& buffer, const std::string&) {
+                const Offset at = middle(buffer);
+                buffer.insert(at, "typed\n");
+                buffer.erase(Range::makeUnchecked(at, Bytes(6)));
+            }},
+            {"insertStreamedThenErase", 1.0, [middle](B& buffer, const std::string&) {
+                const Offset at = middle(buffer);
+                teks::usize chunk = 0;
+                const ChunkReader reader = [&chunk]() {
+                    constexpr std::array<std::string_view, 3> chunks{"streamed\r", "\nchunks", ""};
+                    return chunks[std::min(chunk++, chunks.size() - 1)];
+                };
+                buffer.insert(at, reader);
+                buffer.erase(Range::makeUnchecked(at, Bytes(15)));
+            }},
+            {"replace", 1.0, [middle](B& buffer, const std::string&) {
+                buffer.replace(Range::makeUnchecked(middle(buffer), Bytes(8)), "replaced");
+            }},
+            {"replaceEach", 1.0, [](B& buffer, const std::string&) {
+                std::array<Replacement, 16> replacements;
+                const teks::u64 stride = buffer.size().raw() / replacements.size();
+                for (teks::usize i = 0; i < replacements.size(); ++i) {
+                    replacements[i] = Replacement{Range::makeUnchecked(Offset(i * stride), Bytes(4)), "edit"};
+                }
+                buffer.replaceEach(replacements);
+            }},
+            {"readString", 0.0, [middle](B& buffer, const std::string&) {
+                sink = sink + buffer.readString(Range::makeUnchecked(middle(buffer), Bytes(64))).value().size();
+            }},
+            {"invalidUtf8Runs", 0.0, [middle](B& buffer, const std::string&) {
+                sink = sink + buffer.invalidUtf8Runs(Range::makeUnchecked(middle(buffer), Bytes(4096))).value().size();
+            }},
+            {"lineCount", 0.0, [](B& buffer, const std::string&) {
+                sink = sink + buffer.lineCount();
+            }},
+            {"lineRange", 0.0, [](B& buffer, const std::string&) {
+                sink = sink + buffer.lineRange(buffer.lineCount() / 2).value().size().raw();
+            }},
+            {"positionOf", 0.0, [middle](B& buffer, const std::string&) {
+                sink = sink + buffer.positionOf(middle(buffer), ColumnUnit::Utf16).value().column;
+            }},
+            {"offsetOf", 0.0, [](B& buffer, const std::string&) {
+                const Position position{buffer.lineCount() / 2, 10};
+                sink = sink + buffer.offsetOf(position, ColumnUnit::Codepoint).value().raw();
+            }},
+            {"contentHash", 0.0, [](B& buffer, const std::string&) {
+                sink = sink + buffer.contentHash();
+            }},
+        };
+    }
+
+    // Seconds per call of `run`, the fastest of `timings` timings
+    template <typename Run>
+    double secondsPerRun(Run&& run) {
+        double fastest = std::numeric_limits<double>::infinity();
+        for (teks::usize timing = 0; timing < timings; ++timing) {
+            teks::u64 runs = 0;
+            const Clock::time_point start = Clock::now();
+            Clock::duration elapsed{};
+            do {
+                run();
+                ++runs;
+                elapsed = Clock::now() - start;
+            } while (elapsed < minTiming);
+            fastest = std::min(fastest, std::chrono::duration<double>(elapsed).count() / static_cast<double>(runs));
+        }
+        return fastest;
+    }
+
+    // The slope of the least squares line through log(seconds) over log(size), the `k` of O(n^k)
+    double fittedExponent(const std::array<double, sizes.size()>& seconds, const std::array<teks::u64, sizes.size()>& at = sizes) {
+        double meanX = 0.0;
+        double meanY = 0.0;
+        for (teks::usize i = 0; i < at.size(); ++i) {
+            meanX += std::log(static_cast<double>(at[i]));
+            meanY += std::log(seconds[i]);
+        }
+        meanX /= static_cast<double>(at.size());
+        meanY /= static_cast<double>(at.size());
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (teks::usize i = 0; i < at.size(); ++i) {
+            const double x = std::log(static_cast<double>(at[i])) - meanX;
+            covariance += x * (std::log(seconds[i]) - meanY);
+            variance += x * x;
+        }
+        return covariance / variance;
+    }
+
+    // Times edits of an `Index` of a text of each of `indexSizes`, expecting them to grow like O(log n).
+    // A run types a line over 6 bytes at one of 64 places spread over the text and puts the bytes back,
+    // so the content the edits fall in averages out. `replace(index, text, at, content)` replaces the
+    // bytes at `at` of `text` with `content` and updates the index, `matches(index, text)` checks the
+    // index describes the text once the runs are done.
+    template <typename Index, typename Replace, typename Matches>
+    void expectLogarithmicEdits(const char* name, Replace replace, Matches matches) {
+        constexpr std::string_view typed = "typed\n";
+        std::array<double, indexSizes.size()> seconds{};
+        std::string timed;
+        for (teks::usize i = 0; i < indexSizes.size(); ++i) {
+            // short lines, as the line starts grow with the lines rather than the bytes
+            std::string text = makeText(indexSizes[i], 0, 15);
+            Index index(text);
+            teks::u64 run = 0;
+            seconds[i] = secondsPerRun([&]() {
+                const Offset at(text.size() * (2 * (run++ % 64) + 1) / 128);
+                const std::string saved = text.substr(at.raw(), typed.size());
+                replace(index, text, at, typed);
+                replace(index, text, at, saved);
+            });
+            timed += " " + std::to_string(indexSizes[i]) + " bytes: " + std::to_string(seconds[i] * 1e9) + " ns,";
+            ASSERT_TRUE(matches(index, text)) << name;
+        }
+        EXPECT_LE(fittedExponent(seconds, indexSizes), exponentSlack)
+            << name << " edits grow like n^" << fittedExponent(seconds, indexSizes) << "," << timed;
+    }
+}
+
+// Every backend built is listed, each build selects one with `TEKS_BUFFER_IMPL`
+template <typename B>
+struct TeksBufferBufferComplexityTest : ::testing::Test {};
+
+using BufferBackends = ::testing::Types<Buffer>;
+TYPED_TEST_SUITE(TeksBufferBufferComplexityTest, BufferBackends);
+
+TYPED_TEST(TeksBufferBufferComplexityTest, operationsGrowNoFasterThanTheirDocumentedBounds) {
+    using B = TypeParam;
+    static_assert(concepts::Buffer<B>);
+
+    std::vector<std::string> texts;
+    std::vector<B> buffers;
+    for (const teks::u64 size : sizes) {
+        texts.push_back(makeText(size));
+        buffers.emplace_back(texts.back(), typename B::allocator_type{});
+    }
+
+    for (const Operation<B>& operation : makeOperations<B>()) {
+        std::array<double, sizes.size()> seconds{};
+        std::string timed;
+        for (teks::usize i = 0; i < sizes.size(); ++i) {
+            seconds[i] = secondsPerRun([&]() { operation.run(buffers[i], texts[i]); });
+            timed += " " + std::to_string(sizes[i]) + " bytes: " + std::to_string(seconds[i] * 1e9) + " ns,";
+            ASSERT_EQ(buffers[i].size().raw(), texts[i].size()) << operation.name;
+        }
+        EXPECT_LE(fittedExponent(seconds), operation.boundExponent + exponentSlack)
+            << operation.name << " grows like n^" << fittedExponent(seconds) << "," << timed;
+    }
+}
+
+// The buffer's edits are O(n) as they move the text, which would hide indexes whose edits are linear too.
+// Each index is timed on its own, updated as the buffer updates it.
+TEST(teksBufferIndexComplexity, editsGrowNoFasterThanLogN) {
+    expectLogarithmicEdits<LineStartIndex>(
+        "LineStartIndex",
+        [](LineStartIndex& index, std::string& text, Offset at, std::string_view content) {
+            text.replace(at.raw(), content.size(), content);
+            index.erased(Range::makeUnchecked(at, Bytes(content.size())));
+            index.inserted(text, at, Bytes(content.size()));
+        },
+        [](const LineStartIndex& index, const std::string& text) {
+            const LineStartIndex fresh(text);
+            return index.lineCount() == fresh.lineCount()
+                && index.lineStart(index.lineCount() / 2) == fresh.lineStart(fresh.lineCount() / 2);
+        }
+    );
+    expectLogarithmicEdits<Utf8Index>(
+        "Utf8Index",
+        [](Utf8Index& index, std::string& text, Offset at, std::string_view content) {
+            index.erasing(text, Range::makeUnchecked(at, Bytes(content.size())));
+            text.replace(at.raw(), content.size(), content);
+            index.inserted(text, at, Bytes(content.size()));
+        },
+        [](const Utf8Index& index, const std::string& text) {
+            return index.unitsBefore(text, Offset(text.size()), ColumnUnit::Utf16)
+                == Utf8Index(text).unitsBefore(text, Offset(text.size()), ColumnUnit::Utf16);
+        }
+    );
+    expectLogarithmicEdits<ChunkHashTree>(
+        "ChunkHashTree",
+        [](ChunkHashTree& index, std::string& text, Offset at, std::string_view content) {
+            text.replace(at.raw(), content.size(), content);
+            index.replaced(text, at, Bytes(content.size()), Bytes(content.size()));
+        },
+        [](const ChunkHashTree& index, const std::string& text) {
+            return index.contentHash() == ChunkHashTree(text).contentHash();
+        }
+    );
+}
@@ -2,11 +2,14 @@
 #include <teks/buffer/Buffer.hpp>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <functional>
+#include <memory_resource>
+#include <random>
 
 using namespace teks::buffer;
 
@@ -661,6 +664,54 @@ TEST(teksBufferBuffer, insertMixedNewLineStyles) {
     assertLineRangesSizesPlusNewlineCountEqualsContentSize(buffer);
 }
 
+TEST(teksBufferBuffer, insertFromReaderMatchesInsertingEverythingAtOnce) {
+    std::mt19937 random(7);
+    std::string text;
+    for (int line = 0; line < 200; ++line) {
+        text += "pasted \xC3\xA9 " + std::to_string(line) + (line % 5 == 0 ? "\xFF" : "") + (line % 3 == 0 ? "\r\n" : "\r");
+    }
+
+    for (int round = 0; round < 20; ++round) {
+        // chunks of up to 8 bytes, so many CRLFs and codepoints are split between chunks
+        std::vector<std::string> chunks;
+        for (teks::usize at = 0; at < text.size();) {
+            const teks::usize size = 1 + random() % 8;
+            chunks.push_back(text.substr(at, size));
+            at += size;
+        }
+        teks::usize next = 0;
+        const ChunkReader reader = [&]() {
+            return next < chunks.size() ? std::string_view(chunks[next++]) : std::string_view();
+        };
+
+        Buffer streamed("first\nlast\n");
+        Buffer whole("first\nlast\n");
+        const Offset at(random() % (whole.size().raw() + 1));
+        ASSERT_TRUE(streamed.insert(at, reader));
+        ASSERT_TRUE(whole.insert(at, text));
+
+        const std::string content = readAllString(whole);
+        ASSERT_EQ(readAllString(streamed), content) << round;
+        ASSERT_EQ(calcLineRanges(streamed), calcLineRanges(whole)) << round;
+        ASSERT_EQ(streamed.invalidUtf8Runs(range(streamed)), whole.invalidUtf8Runs(range(whole))) << round;
+        ASSERT_EQ(streamed.contentHash(), Buffer(content).contentHash()) << round;
+    }
+}
+
+TEST(teksBufferBuffer, insertFromReaderOutOfBoundsDoesNotRead) {
+    Buffer buffer("1234");
+    bool read = false;
+    ASSERT_FALSE(buffer.insert(Offset(5), [&]() {
+        read = true;
+        return std::string_view();
+    }));
+    ASSERT_FALSE(read);
+    ASSERT_EQ(readAllString(buffer), "1234");
+
+    ASSERT_TRUE(buffer.insert(Offset(2), []() { return std::string_view(); }));
+    ASSERT_EQ(readAllString(buffer), "1234");
+}
+
 namespace { // erase
     struct BufferEraseCase {
         BufferEraseCase(Labeled<std::string> initialAndLabel, LabeledRange makeRangeAndLabel)
@@ -1070,6 +1121,174 @@ TEST(teksBufferBuffer, replaceMultipleNewlinesWithContentContainingMixedNewlineS
     assertLineRangesSizesPlusNewlineCountEqualsContentSize(buffer);
 }
 
+TEST(teksBufferBuffer, replaceEachAppliesEveryEditInTheBufferBeforeTheCall) {
+    Buffer buffer("ab\ncd\nef");
+    const std::vector<Replacement> replacements{
+        {makeRangeStartEmpty(0), "<"},
+        {makeRangeStartSize(1, 2), "\r\n"},
+        {makeRangeStartEmpty(3), "x"},
+        {makeRangeStartSize(5, 2), ""},
+        {makeRangeStartEmpty(8), ">"},
+    };
+    ASSERT_TRUE(buffer.replaceEach(replacements));
+    ASSERT_EQ(readAllString(buffer), "<a\nxcdf>");
+    ASSERT_EQ(calcLineRanges(buffer), (std::vector{makeRangeStartSize(0, 2), makeRangeStartSize(3, 5)}));
+    assertLineRangesSizesPlusNewlineCountEqualsContentSize(buffer);
+    ASSERT_EQ(buffer.contentHash(), Buffer("<a\nxcdf>").contentHash());
+
+    ASSERT_TRUE(buffer.replaceEach({}));
+    ASSERT_EQ(readAllString(buffer), "<a\nxcdf>");
+}
+
+TEST(teksBufferBuffer, replaceEachRejectsUnsortedOverlappingOrOutOfBoundsEdits) {
+    Buffer buffer("Hello World");
+    auto assertFailedReplaceEachNoMutation = [&](std::vector<Replacement> replacements) {
+        ASSERT_NO_MUTATION(buffer);
+        ASSERT_FALSE(buffer.replaceEach(replacements));
+    };
+    assertFailedReplaceEachNoMutation({{makeRangeStartEmpty(6), "a"}, {makeRangeStartEmpty(5), "b"}});
+    assertFailedReplaceEachNoMutation({{makeRangeStartSize(0, 3), "a"}, {makeRangeStartSize(2, 3), "b"}});
+    assertFailedReplaceEachNoMutation({{makeRangeStartEmpty(0), "a"}, {makeRangeStartEmpty(12), "b"}});
+
+    // edits that only touch are in order
+    ASSERT_TRUE(buffer.replaceEach(std::vector<Replacement>{
+        {makeRangeStartSize(0, 5), "Howdy"},
+        {makeRangeStartEmpty(5), ","},
+        {makeRangeStartEmpty(5), "!"},
+    }));
+    ASSERT_EQ(readAllString(buffer), "Howdy,! World");
+}
+
+TEST(teksBufferBuffer, replaceEachMatchesReplacingOneEditAtATime) {
+    std::mt19937 random(42);
+    std::string text;
+    for (int line = 0; line < 300; ++line) {
+        text += "line \xC3\xA9 " + std::to_string(random()) + (line % 7 == 0 ? "\xFF" : "") + "\n";
+    }
+    static constexpr const char* contents[] = {"", "x", "\n", "ab\ncd", "\xE2\x82", "\xAC", "\r\n"};
+
+    Buffer batched(text);
+    Buffer sequential(text);
+    for (int round = 0; round < 50; ++round) {
+        std::vector<Offset::ValueType> offsets;
+        for (unsigned i = 0; i < random() % 40; ++i) {
+            offsets.push_back(random() % (batched.size().raw() + 1));
+        }
+        std::sort(offsets.begin(), offsets.end());
+        std::vector<Replacement> replacements;
+        for (teks::usize i = 0; i + 1 < offsets.size(); i += 2) {
+            replacements.push_back({makeRangeStartEnd(offsets[i], offsets[i + 1]), contents[random() % 7]});
+        }
+
+        ASSERT_TRUE(batched.replaceEach(replacements));
+        // one at a time from the back, so the ranges before each edit still apply
+        for (auto replacement = replacements.rbegin(); replacement != replacements.rend(); ++replacement) {
+            ASSERT_TRUE(sequential.replace(replacement->range, replacement->content));
+        }
+
+        const std::string content = readAllString(sequential);
+        ASSERT_EQ(readAllString(batched), content) << round;
+        ASSERT_EQ(calcLineRanges(batched), calcLineRanges(sequential)) << round;
+        ASSERT_EQ(batched.invalidUtf8Runs(range(batched)), sequential.invalidUtf8Runs(range(sequential))) << round;
+        ASSERT_EQ(batched.contentHash(), Buffer(content).contentHash()) << round;
+        for (teks::usize line = 0; line < batched.lineCount(); line += 13) {
+            const Offset end = batched.lineRange(line)->end();
+            ASSERT_EQ(batched.positionOf(end, ColumnUnit::Utf16), sequential.positionOf(end, ColumnUnit::Utf16));
+        }
+    }
+}
+
+namespace {
+    // Counts what is allocated from it, passing the allocations on to the default resource
+    struct CountingResource : std::pmr::memory_resource {
+        teks::usize allocations{0};
+        teks::usize liveBytes{0};
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            liveBytes += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+            liveBytes -= bytes;
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+}
+
+TEST(teksBufferBuffer, allocatesFromItsMemoryResource) {
+    CountingResource resource;
+    std::string text;
+    for (int line = 0; line < 1000; ++line) {
+        text += "line " + std::to_string(line) + "\r\n";
+    }
+    {
+        Buffer buffer(text, &resource);
+        ASSERT_EQ(buffer.get_allocator().resource(), &resource);
+        ASSERT_GE(resource.liveBytes, buffer.size().raw());
+        ASSERT_EQ(readAllString(buffer), Buffer(text).readString(range(Buffer(text))));
+
+        const teks::usize allocations = resource.allocations;
+        ASSERT_TRUE(buffer.insert(Offset(100), "typed"));
+        ASSERT_TRUE(buffer.replace(makeRangeStartSize(5000, 300), "pasted\r\ntext"));
+        ASSERT_GT(resource.allocations, allocations);
+
+        // moves keep the resource, copies take the one they are given
+        const Buffer moved(std::move(buffer));
+        ASSERT_EQ(moved.get_allocator().resource(), &resource);
+        const Buffer copied(moved, std::pmr::new_delete_resource());
+        ASSERT_EQ(copied.get_allocator().resource(), std::pmr::new_delete_resource());
+        ASSERT_EQ(readAllString(copied), readAllString(moved));
+        ASSERT_EQ(copied.lineCount(), moved.lineCount());
+    }
+    ASSERT_EQ(resource.liveBytes, 0);
+}
+
+TEST(teksBufferBuffer, memoryUsageSeparatesSlackThatShrinkToFitReleases) {
+    CountingResource resource;
+    std::string text;
+    for (int line = 0; line < 1000; ++line) {
+        text += "line " + std::to_string(line) + "\n";
+    }
+    Buffer buffer(text, &resource);
+    const teks::MemoryUsage loaded = buffer.memoryUsage();
+    ASSERT_EQ(loaded.text, buffer.size().raw());
+    ASSERT_GT(loaded.lineIndex, 0);
+    ASSERT_GT(loaded.caches, 0);
+    ASSERT_EQ(loaded.undoHistory, 0);
+    // the text and line index come from the buffer's resource
+    ASSERT_LE(loaded.text + loaded.lineIndex, resource.liveBytes);
+
+    // erasing keeps the capacity the text had
+    ASSERT_TRUE(buffer.erase(makeRangeStartEnd(100, buffer.size().raw() - 100)));
+    const teks::MemoryUsage erased = buffer.memoryUsage();
+    ASSERT_EQ(erased.text, 200);
+    ASSERT_GE(erased.slack, text.size() - 200);
+
+    const std::string content = readAllString(buffer);
+    const teks::usize lineCount = buffer.lineCount();
+    const teks::usize liveBytes = resource.liveBytes;
+    buffer.shrinkToFit();
+    const teks::MemoryUsage shrunk = buffer.memoryUsage();
+    ASSERT_EQ(shrunk.text, erased.text);
+    ASSERT_EQ(shrunk.lineIndex, erased.lineIndex);
+    ASSERT_EQ(shrunk.caches, erased.caches);
+    ASSERT_LT(shrunk.slack * 10, erased.slack);
+    ASSERT_LT(resource.liveBytes, liveBytes);
+
+    ASSERT_EQ(readAllString(buffer), content);
+    ASSERT_EQ(buffer.lineCount(), lineCount);
+    ASSERT_EQ(buffer.contentHash(), Buffer(content).contentHash());
+    ASSERT_TRUE(buffer.insert(Offset(0), "still\nediting\n"));
+    ASSERT_EQ(buffer.lineCount(), lineCount + 2);
+}
+
 namespace { // readString
     struct BufferReadStringCase {
         BufferReadStringCase(Labeled<std::string> initial, LabeledRange makeRange)
@@ -0,0 +1,155 @@
+#include <teks/diff/LineDiff.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::diff;
+using teks::buffer::Offset;
+using teks::buffer::Range;
+
+namespace {
+    // applies `edits` back to front, as a buffer would
+    std::string apply(std::string before, std::string_view after, const std::vector<LineEdit>& edits) {
+        for (auto edit = edits.rbegin(); edit != edits.rend(); ++edit) {
+            before.replace(
+                edit->removedBytes.start().raw(),
+                edit->removedBytes.size().raw(),
+                after.substr(edit->insertedBytes.start().raw(), edit->insertedBytes.size().raw())
+            );
+        }
+        return before;
+    }
+
+    usize lineCount(std::string_view text) {
+        return static_cast<usize>(std::count(text.begin(), text.end(), '\n')) + 1;
+    }
+
+    std::vector<std::string_view> lines(std::string_view text) {
+        std::vector<std::string_view> result;
+        usize start = 0;
+        for (usize newline = text.find('\n'); newline != std::string_view::npos; newline = text.find('\n', start)) {
+            result.push_back(text.substr(start, newline + 1 - start));
+            start = newline + 1;
+        }
+        result.push_back(text.substr(start));
+        return result;
+    }
+
+    usize longestCommonSubsequence(std::string_view before, std::string_view after) {
+        const auto a = lines(before);
+        const auto b = lines(after);
+        std::vector<std::vector<usize>> table(a.size() + 1, std::vector<usize>(b.size() + 1, 0));
+        for (usize i = 1; i <= a.size(); ++i) {
+            for (usize j = 1; j <= b.size(); ++j) {
+                table[i][j] = a[i - 1] == b[j - 1]
+                    ? table[i - 1][j - 1] + 1
+                    : std::max(table[i - 1][j], table[i][j - 1]);
+            }
+        }
+        return table[a.size()][b.size()];
+    }
+
+    void expectValidDiff(std::string_view before, std::string_view after) {
+        const auto edits = diffLines(before, after);
+        ASSERT_EQ(apply(std::string(before), after, edits), after);
+
+        usize removed = 0;
+        usize inserted = 0;
+        for (usize i = 0; i < edits.size(); ++i) {
+            const LineEdit& edit = edits[i];
+            removed += edit.removed;
+            inserted += edit.inserted;
+            if (i > 0) {
+                // separated by at least one unchanged line
+                ASSERT_GT(edit.first, edits[i - 1].first + edits[i - 1].removed);
+            }
+            ASSERT_EQ(lineCount(before.substr(0, edit.removedBytes.start().raw())) - 1, edit.first);
+            ASSERT_EQ(lineCount(after.substr(0, edit.insertedBytes.start().raw())) - 1, edit.insertedFirst);
+        }
+        ASSERT_EQ(lineCount(before) - removed + inserted, lineCount(after));
+        // minimal: everything not in the longest common subsequence of lines
+        const usize common = longestCommonSubsequence(before, after);
+        ASSERT_EQ(removed, lineCount(before) - common);
+        ASSERT_EQ(inserted, lineCount(after) - common);
+    }
+}
+
+TEST(teksDiffLineDiff, identicalTextsHaveNoEdits) {
+    ASSERT_TRUE(diffLines("", "").empty());
+    ASSERT_TRUE(diffLines("a\nb\n", "a\nb\n").empty());
+}
+
+TEST(teksDiffLineDiff, changedLineIsReplaced) {
+    const auto edits = diffLines("one\ntwo\nthree\n", "one\n2\nthree\n");
+    ASSERT_EQ(edits.size(), 1);
+    ASSERT_EQ(edits[0], (LineEdit{
+        1,
+        1,
+        1,
+        1,
+        Range::makeUnchecked(Offset(4), Offset(8)),
+        Range::makeUnchecked(Offset(4), Offset(6))
+    }));
+}
+
+TEST(teksDiffLineDiff, insertionAndRemovalAreSeparateEdits) {
+    const auto edits = diffLines("a\nb\nc\nd\ne\n", "a\nx\nb\nc\ne\n");
+    ASSERT_EQ(edits.size(), 2);
+    ASSERT_EQ(edits[0].first, 1);
+    ASSERT_EQ(edits[0].removed, 0);
+    ASSERT_EQ(edits[0].inserted, 1);
+    ASSERT_EQ(edits[1].first, 3);
+    ASSERT_EQ(edits[1].removed, 1);
+    ASSERT_EQ(edits[1].inserted, 0);
+}
+
+TEST(teksDiffLineDiff, lastLineWithoutNewline) {
+    ASSERT_NO_FATAL_FAILURE(expectValidDiff("a\nb", "a\nb\nc"));
+    ASSERT_NO_FATAL_FAILURE(expectValidDiff("a\n", "a\nb"));
+    ASSERT_NO_FATAL_FAILURE(expectValidDiff("a\nb\n", "a\nb"));
+    ASSERT_NO_FATAL_FAILURE(expectValidDiff("", "a"));
+    ASSERT_NO_FATAL_FAILURE(expectValidDiff("a", ""));
+}
+
+TEST(teksDiffLineDiff, randomEditsAreMinimal) {
+    std::mt19937 random(77);
+    const std::string_view words[] = {"a\n", "b\n", "c\n", "dd\n", "\n", "e"};
+    for (int round = 0; round < 300; ++round) {
+        std::string before;
+        const auto size = random() % 30;
+        for (usize i = 0; i < size; ++i) {
+            before += words[random() % std::size(words)];
+        }
+        std::string after = before;
+        for (auto edit = random() % 4; edit > 0; --edit) {
+            const usize at = after.empty() ? 0 : random() % after.size();
+            if (random() % 2 == 0) {
+                after.insert(at, words[random() % std::size(words)]);
+            } else {
+                after.erase(at, random() % 6);
+            }
+        }
+        ASSERT_NO_FATAL_FAILURE(expectValidDiff(before, after)) << before << "\n---\n" << after;
+    }
+}
+
+TEST(teksDiffLineDiff, tooManyDifferencesReplaceTheDifferingRegion) {
+    std::string before = "start\n";
+    std::string after = "start\n";
+    for (usize i = 0; i < maxEditDistance; ++i) {
+        before += "a" + std::to_string(i) + "\n";
+        after += "b" + std::to_string(i) + "\n";
+    }
+    before += "end\n";
+    after += "end\n";
+    const auto edits = diffLines(before, after);
+    ASSERT_EQ(edits.size(), 1);
+    ASSERT_EQ(edits[0].first, 1);
+    ASSERT_EQ(edits[0].removed, maxEditDistance);
+    ASSERT_EQ(edits[0].inserted, maxEditDistance);
+    ASSERT_EQ(apply(before, after, edits), after);
+}
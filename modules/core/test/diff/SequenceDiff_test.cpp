@@ -0,0 +1,43 @@
+#include <teks/diff/SequenceDiff.hpp>
+#include <gtest/gtest.h>
+#include <string_view>
+#include <vector>
+
+using namespace teks;
+using namespace teks::diff;
+
+namespace {
+    std::vector<Hunk> diffStrings(std::string_view before, std::string_view after, usize maxEditDistance = 100) {
+        return diffSequences(
+            before.size(),
+            after.size(),
+            [before, after](usize i, usize j) { return before[i] == after[j]; },
+            maxEditDistance
+        );
+    }
+}
+
+TEST(teksDiffSequenceDiff, equalSequencesHaveNoHunks) {
+    ASSERT_TRUE(diffStrings("", "").empty());
+    ASSERT_TRUE(diffStrings("abc", "abc").empty());
+}
+
+TEST(teksDiffSequenceDiff, findsMinimalHunks) {
+    // the classic example from Myers' paper, 5 differences
+    const auto hunks = diffStrings("abcabba", "cbabac");
+    usize differences = 0;
+    for (const Hunk& hunk : hunks) {
+        differences += hunk.beforeEnd - hunk.beforeStart + hunk.afterEnd - hunk.afterStart;
+    }
+    ASSERT_EQ(differences, 5);
+}
+
+TEST(teksDiffSequenceDiff, hunksAreSeparatedByEqualElements) {
+    ASSERT_EQ(diffStrings("axbyc", "azbc"), (std::vector<Hunk>{Hunk{1, 2, 1, 2}, Hunk{3, 4, 3, 3}}));
+    ASSERT_EQ(diffStrings("", "ab"), (std::vector<Hunk>{Hunk{0, 0, 0, 2}}));
+    ASSERT_EQ(diffStrings("ab", ""), (std::vector<Hunk>{Hunk{0, 2, 0, 0}}));
+}
+
+TEST(teksDiffSequenceDiff, tooManyDifferencesAreOneHunk) {
+    ASSERT_EQ(diffStrings("aaaaxbbbb", "ccccxdddd", 4), (std::vector<Hunk>{Hunk{0, 9, 0, 9}}));
+}
@@ -0,0 +1,604 @@
+#include <teks/editor/Document.hpp>
+#include <teks/buffer/Buffer.hpp>
+#include <teks/buffer/Journal.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace teks;
+using namespace teks::buffer;
+using teks::editor::Document;
+
+namespace {
+    using Selection = Document::Selection;
+
+    std::filesystem::path filePath(const std::string& name) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(path);
+        std::filesystem::remove(Journal::pathFor(path));
+        return path;
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return std::move(content).str();
+    }
+
+    void writeFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+    }
+
+    void appendFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream(path, std::ios::binary | std::ios::app) << content;
+    }
+
+    Selection caret(u64 at) {
+        return Selection{Offset(at), Offset(at)};
+    }
+
+    Selection selection(u64 anchor, u64 head) {
+        return Selection{Offset(anchor), Offset(head)};
+    }
+
+    std::vector<std::pair<u64, u64>> selectionsOf(const Document& document) {
+        std::vector<std::pair<u64, u64>> selections;
+        for (const Selection& each : document.selections()) {
+            selections.emplace_back(each.anchor.raw(), each.head.raw());
+        }
+        return selections;
+    }
+
+    bool isContinuation(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    // An edit of a plain string, `[start, end)` replaced with `content`
+    struct NaiveEdit {
+        u64 start;
+        u64 end;
+        std::string content;
+    };
+
+    // What erasing `selections` of `text` should remove: each selection, and for a caret the
+    // codepoint beside it, up to 4 bytes, without reaching into the edit before or the selection after
+    std::vector<NaiveEdit> naiveErase(std::string_view text, const std::vector<Selection>& selections, bool backward) {
+        std::vector<NaiveEdit> edits;
+        for (usize i = 0; i < selections.size(); ++i) {
+            u64 start = selections[i].range().start().raw();
+            u64 end = selections[i].range().end().raw();
+            if (start == end && backward) {
+                if (start > 0) {
+                    --start;
+                    while (start > 0 && end - start < 4 && isContinuation(text[start])) {
+                        --start;
+                    }
+                }
+                if (i > 0) {
+                    start = std::max(start, edits.back().end);
+                }
+            } else if (start == end) {
+                if (end < text.size()) {
+                    ++end;
+                    while (end < text.size() && end - start < 4 && isContinuation(text[end])) {
+                        ++end;
+                    }
+                }
+                if (i + 1 < selections.size()) {
+                    end = std::min(end, selections[i + 1].range().start().raw());
+                }
+            }
+            edits.push_back(NaiveEdit{start, end, {}});
+        }
+        return edits;
+    }
+
+    // Applies `edits`, sorted and apart, to `text` by copying it around them, and returns the caret
+    // after each edit's content, carets that meet counted once
+    std::vector<std::pair<u64, u64>> applyNaive(std::string& text, const std::vector<NaiveEdit>& edits) {
+        std::string result;
+        std::vector<std::pair<u64, u64>> carets;
+        u64 copied = 0;
+        for (const NaiveEdit& edit : edits) {
+            result.append(text, copied, edit.start - copied);
+            result.append(edit.content);
+            if (carets.empty() || carets.back().second != result.size()) {
+                carets.emplace_back(result.size(), result.size());
+            }
+            copied = edit.end;
+        }
+        result.append(text, copied);
+        text = std::move(result);
+        return carets;
+    }
+
+    std::vector<std::string> linesOf(std::string_view text) {
+        std::vector<std::string> lines(1);
+        for (char c : text) {
+            if (c == '\n') {
+                lines.emplace_back();
+            } else {
+                lines.back().push_back(c);
+            }
+        }
+        return lines;
+    }
+
+    // Replaces `[first, first + removed)` of `items` with `inserted` copies of `value`
+    template <typename T>
+    void replaceItems(std::vector<T>& items, usize first, usize removed, usize inserted, const T& value) {
+        items.erase(items.begin() + static_cast<std::ptrdiff_t>(first), items.begin() + static_cast<std::ptrdiff_t>(first + removed));
+        items.insert(items.begin() + static_cast<std::ptrdiff_t>(first), inserted, value);
+    }
+}
+
+TEST(teksEditorDocument, setSelectionsSortsClampsAndMerges) {
+    Document document(Buffer("0123456789"));
+    document.setSelections({selection(8, 6), selection(0, 1), caret(1), selection(3, 4), selection(4, 5), caret(20)});
+    // a caret meeting a selection joins it, two selections that only meet stay apart
+    ASSERT_EQ(selectionsOf(document), (std::vector<std::pair<u64, u64>>{{0, 1}, {3, 4}, {4, 5}, {8, 6}, {10, 10}}));
+
+    // overlapping selections merge, keeping the direction of the first
+    document.setSelections({selection(5, 9), selection(7, 2)});
+    ASSERT_EQ(selectionsOf(document), (std::vector<std::pair<u64, u64>>{{9, 2}}));
+
+    document.setSelections({});
+    ASSERT_EQ(selectionsOf(document), (std::vector<std::pair<u64, u64>>{{0, 0}}));
+}
+
+TEST(teksEditorDocument, caretsThatMeetAfterAnEditMerge) {
+    Document document(Buffer("abcd"));
+    document.setSelections({caret(1), caret(2), caret(4)});
+    ASSERT_TRUE(document.eraseBackward());
+    ASSERT_EQ(readAllString(document.buffer()), "c");
+    ASSERT_EQ(selectionsOf(document), (std::vector<std::pair<u64, u64>>{{0, 0}, {1, 1}}));
+}
+
+TEST(teksEditorDocument, erasingACodepointStopsAtTheNeighbouringCursor) {
+    // "€" is 3 bytes, a caret inside it keeps the bytes on its side
+    Document document(Buffer("a\xE2\x82\xAC" "b"));
+    document.setSelections({caret(2), caret(4)});
+    ASSERT_TRUE(document.eraseBackward());
+    ASSERT_EQ(readAllString(document.buffer()), "ab");
+    ASSERT_EQ(selectionsOf(document), (std::vector<std::pair<u64, u64>>{{1, 1}}));
+
+    Document forward(Buffer("a\xE2\x82\xAC" "b"));
+    forward.setSelections({caret(1), caret(3)});
+    ASSERT_TRUE(forward.eraseForward());
+    ASSERT_EQ(readAllString(forward.buffer()), "ab");
+    ASSERT_EQ(selectionsOf(forward), (std::vector<std::pair<u64, u64>>{{1, 1}}));
+}
+
+TEST(teksEditorDocument, multiCursorEditsMatchEditingAStringAroundEachSelection) {
+    std::mt19937 random(11);
+    // carets land inside multi-byte codepoints as well as between them
+    constexpr std::array<std::string_view, 6> pieces{"a", "bc", "\n", " ", "\xC3\xA9", "\xE2\x82\xAC"};
+    const auto randomText = [&](usize maxPieces) {
+        std::string text;
+        for (usize count = random() % (maxPieces + 1); count > 0; --count) {
+            text += pieces[random() % pieces.size()];
+        }
+        return text;
+    };
+
+    for (int round = 0; round < 100; ++round) {
+        std::string text = randomText(40);
+        Document document{Buffer(text)};
+        for (int step = 0; step < 20; ++step) {
+            std::vector<Selection> wanted(1 + random() % 6);
+            for (Selection& each : wanted) {
+                const u64 anchor = random() % (text.size() + 1);
+                each = random() % 2 == 0 ? caret(anchor) : selection(anchor, random() % (text.size() + 1));
+            }
+            document.setSelections(wanted);
+            const std::vector<Selection> selections = document.selections();
+
+            std::vector<NaiveEdit> edits;
+            switch (random() % 3) {
+            case 0: {
+                const std::string content = randomText(3);
+                ASSERT_TRUE(document.insertAtSelections(content));
+                for (const Selection& each : selections) {
+                    edits.push_back(NaiveEdit{each.range().start().raw(), each.range().end().raw(), content});
+                }
+                break;
+            }
+            case 1:
+                ASSERT_TRUE(document.eraseBackward());
+                edits = naiveErase(text, selections, true);
+                break;
+            default:
+                ASSERT_TRUE(document.eraseForward());
+                edits = naiveErase(text, selections, false);
+                break;
+            }
+            const std::vector<std::pair<u64, u64>> carets = applyNaive(text, edits);
+            ASSERT_EQ(readAllString(document.buffer()), text) << round << ' ' << step;
+            ASSERT_EQ(selectionsOf(document), carets) << round << ' ' << step;
+        }
+    }
+}
+
+TEST(teksEditorDocument, multiCursorEditIsOneChange) {
+    Document document(Buffer("ab\ncd\nef\n"));
+    document.setSelections({caret(1), caret(4), caret(7)});
+    ASSERT_TRUE(document.insertAtSelections("X\r\n"));
+    ASSERT_EQ(readAllString(document.buffer()), "aX\nb\ncX\nd\neX\nf\n");
+
+    const std::vector<Document::Change> changes = document.takeChanges();
+    ASSERT_EQ(changes.size(), 1);
+    ASSERT_EQ(changes[0].replaced, Range::makeUnchecked(Offset(1), Offset(7)));
+    ASSERT_EQ(changes[0].inserted, Bytes(12));
+    ASSERT_EQ(changes[0].lines.first, 0);
+    ASSERT_EQ(changes[0].lines.removed, 3);
+    ASSERT_EQ(changes[0].lines.inserted, 6);
+    ASSERT_EQ(changes[0].generation, document.generation());
+}
+
+TEST(teksEditorDocument, multiCursorEditsAreJournaledAtTheirOffsets) {
+    const auto path = filePath("teks_document_test_journal.txt");
+    writeFile(path, "one\ntwo\nthree\n");
+    std::string edited;
+    std::string left;
+    {
+        std::optional<Document> document = Document::openFile(path);
+        ASSERT_TRUE(document.has_value());
+        document->setSelections({caret(0), selection(4, 7), caret(14)});
+        ASSERT_TRUE(document->insertAtSelections("1\n"));
+        ASSERT_TRUE(document->eraseBackward());
+        ASSERT_TRUE(document->insertAtSelections("\xC3\xA9"));
+        document->setSelections({caret(1), caret(6)});
+        ASSERT_TRUE(document->eraseForward());
+        edited = readAllString(document->buffer());
+        document->flushJournal();
+        left = readFile(Journal::pathFor(path));
+    }
+    // as a crash would have left it, closing removes the journal
+    writeFile(Journal::pathFor(path), left);
+
+    std::optional<Document> recovered = Document::openFile(path);
+    ASSERT_TRUE(recovered.has_value());
+    ASSERT_EQ(readAllString(recovered->buffer()), edited);
+    ASSERT_TRUE(recovered->modified());
+    recovered.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, typingCoalescesIntoOneChange) {
+    Document document(Buffer("one\ntwo\n"));
+    ASSERT_TRUE(document.replace(Range::makeUnchecked(Offset(3), Offset(3)), "a"));
+    ASSERT_TRUE(document.replace(Range::makeUnchecked(Offset(4), Offset(4)), "\nb"));
+    ASSERT_TRUE(document.replace(Range::makeUnchecked(Offset(5), Offset(6)), ""));
+    const std::vector<Document::Change> typed = document.takeChanges();
+    ASSERT_EQ(typed.size(), 1);
+    ASSERT_EQ(typed[0].replaced, Range::makeUnchecked(Offset(3), Offset(3)));
+    ASSERT_EQ(typed[0].inserted, Bytes(2));
+    ASSERT_EQ(typed[0].lines.first, 0);
+    ASSERT_EQ(typed[0].lines.removed, 1);
+    ASSERT_EQ(typed[0].lines.inserted, 2);
+    ASSERT_EQ(typed[0].generation, 3);
+
+    // an edit apart from the one before it is a change of its own
+    ASSERT_TRUE(document.replace(Range::makeUnchecked(Offset(0), Offset(1)), "O"));
+    ASSERT_TRUE(document.replace(Range::makeUnchecked(Offset(8), Offset(9)), "T"));
+    ASSERT_EQ(document.takeChanges().size(), 2);
+    ASSERT_TRUE(document.takeChanges().empty());
+}
+
+TEST(teksEditorDocument, changesCoverEveryEditedByteAndLine) {
+    // what is outside every change, applied in order, must be what was there before the edits
+    std::mt19937 random(5);
+    constexpr u64 edited = ~u64{0};
+    constexpr std::array<std::string_view, 4> pieces{"a", "bc", "\n", "d\n"};
+    const auto randomText = [&](usize maxPieces) {
+        std::string text;
+        for (usize count = random() % (maxPieces + 1); count > 0; --count) {
+            text += pieces[random() % pieces.size()];
+        }
+        return text;
+    };
+
+    for (int round = 0; round < 300; ++round) {
+        const std::string before = randomText(30);
+        std::string text = before;
+        Document document{Buffer(text)};
+        // for each byte and line of `text`, the one of `before` it is, or `edited`
+        std::vector<u64> byteOrigins(text.size());
+        std::iota(byteOrigins.begin(), byteOrigins.end(), u64{0});
+        std::vector<u64> lineOrigins(linesOf(text).size());
+        std::iota(lineOrigins.begin(), lineOrigins.end(), u64{0});
+
+        u64 end = random() % (text.size() + 1);
+        for (int step = 1 + static_cast<int>(random() % 8); step > 0; --step) {
+            // mostly next to the edit before, like typing, so changes get merged
+            const u64 start = random() % 3 == 0 ? random() % (text.size() + 1) : std::min<u64>(end, text.size());
+            end = start + random() % (std::min<u64>(text.size() - start, 3) + 1);
+            const std::string content = randomText(2);
+            ASSERT_TRUE(document.replace(Range::makeUnchecked(Offset(start), Offset(end)), content));
+
+            const std::string_view replaced = std::string_view(text).substr(start, end - start);
+            const usize firstLine = linesOf(std::string_view(text).substr(0, start)).size() - 1;
+            replaceItems(
+                lineOrigins,
+                firstLine,
+                linesOf(replaced).size(),
+                linesOf(content).size(),
+                edited
+            );
+            replaceItems(byteOrigins, start, end - start, content.size(), edited);
+            text.replace(start, end - start, content);
+            end = start + content.size();
+        }
+        ASSERT_EQ(readAllString(document.buffer()), text);
+
+        std::vector<u64> changedBytes(before.size());
+        std::iota(changedBytes.begin(), changedBytes.end(), u64{0});
+        std::vector<u64> changedLines(linesOf(before).size());
+        std::iota(changedLines.begin(), changedLines.end(), u64{0});
+        const std::vector<Document::Change> changes = document.takeChanges();
+        ASSERT_FALSE(changes.empty());
+        for (const Document::Change& change : changes) {
+            ASSERT_LE(change.replaced.end().raw(), changedBytes.size()) << round;
+            replaceItems(changedBytes, change.replaced.start().raw(), change.replaced.size().raw(), change.inserted.raw(), edited);
+            ASSERT_LE(change.lines.first + change.lines.removed, changedLines.size()) << round;
+            replaceItems(changedLines, change.lines.first, change.lines.removed, change.lines.inserted, edited);
+        }
+        ASSERT_EQ(changes.back().generation, document.generation());
+
+        ASSERT_EQ(changedBytes.size(), byteOrigins.size()) << round;
+        for (usize i = 0; i < changedBytes.size(); ++i) {
+            if (changedBytes[i] != edited) {
+                ASSERT_EQ(byteOrigins[i], changedBytes[i]) << round << ' ' << i;
+            }
+        }
+        ASSERT_EQ(changedLines.size(), lineOrigins.size()) << round;
+        for (usize i = 0; i < changedLines.size(); ++i) {
+            if (changedLines[i] != edited) {
+                ASSERT_EQ(lineOrigins[i], changedLines[i]) << round << ' ' << i;
+            }
+        }
+    }
+}
+
+TEST(teksEditorDocument, readAppendedAddsWhatWasWritten) {
+    const auto path = filePath("teks_document_test_appended.txt");
+    writeFile(path, "a\nb");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_TRUE(document->readAppended().empty());
+
+    document->setSelections({caret(3)});
+    appendFile(path, "c\nd");
+    const std::vector<Document::LinesReplaced> lines = document->readAppended();
+    ASSERT_EQ(lines.size(), 1);
+    ASSERT_EQ(lines[0].first, 1);
+    ASSERT_EQ(lines[0].removed, 1);
+    ASSERT_EQ(lines[0].inserted, 2);
+    ASSERT_EQ(readAllString(document->buffer()), "a\nbc\nd");
+    ASSERT_FALSE(document->modified());
+    // a caret at the end follows what was appended
+    ASSERT_EQ(selectionsOf(*document), (std::vector<std::pair<u64, u64>>{{6, 6}}));
+    ASSERT_EQ(document->takeChanges().size(), 1);
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, readAppendedJoinsACrlfSplitBetweenReads) {
+    const auto path = filePath("teks_document_test_appended_crlf.txt");
+    writeFile(path, "x\r\ny\r");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_EQ(readAllString(document->buffer()), "x\ny\n");
+
+    appendFile(path, "\nz\r");
+    const std::vector<Document::LinesReplaced> lines = document->readAppended();
+    ASSERT_EQ(lines.size(), 1);
+    ASSERT_EQ(lines[0].inserted, 2);
+    ASSERT_EQ(readAllString(document->buffer()), "x\ny\nz\n");
+
+    appendFile(path, "\n");
+    ASSERT_TRUE(document->readAppended().empty());
+    ASSERT_EQ(readAllString(document->buffer()), "x\ny\nz\n");
+    // every newline was "\r\n", so that is what is written back
+    ASSERT_EQ(document->save(), Document::SaveResult::Saved);
+    ASSERT_EQ(readFile(path), "x\r\ny\r\nz\r\n");
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, readAppendedKeepsACodeUnitSplitBetweenReads) {
+    const auto path = filePath("teks_document_test_appended_utf16.txt");
+    writeFile(path, std::string("\xFF\xFE" "a\0", 4));
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_EQ(document->encoding().charset, encoding::Charset::Utf16Le);
+
+    appendFile(path, "b");
+    ASSERT_TRUE(document->readAppended().empty());
+    appendFile(path, std::string("\0", 1));
+    ASSERT_EQ(document->readAppended().size(), 1);
+    ASSERT_EQ(readAllString(document->buffer()), "ab");
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, readAppendedReloadsAFileThatShrank) {
+    const auto path = filePath("teks_document_test_appended_shrank.txt");
+    writeFile(path, "one\ntwo\nthree\n");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+
+    writeFile(path, "one\n");
+    ASSERT_FALSE(document->readAppended().empty());
+    ASSERT_EQ(readAllString(document->buffer()), "one\n");
+    ASSERT_FALSE(document->modified());
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, readAppendedLeavesUnsavedEditsConflicted) {
+    const auto path = filePath("teks_document_test_appended_unsaved.txt");
+    writeFile(path, "log\n");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_TRUE(document->replace(Range::makeUnchecked(Offset(0), Offset(0)), "my "));
+
+    appendFile(path, "more\n");
+    ASSERT_TRUE(document->readAppended().empty());
+    ASSERT_TRUE(document->conflicted());
+    ASSERT_EQ(readAllString(document->buffer()), "my log\n");
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, reloadAppliesOnlyTheLinesThatChanged) {
+    const auto path = filePath("teks_document_test_reload.txt");
+    std::mt19937 random(17);
+    constexpr u64 changed = ~u64{0};
+    for (int round = 0; round < 50; ++round) {
+        std::vector<std::string> lines(random() % 20);
+        for (std::string& line : lines) {
+            line = std::string(1 + random() % 3, static_cast<char>('a' + random() % 4));
+        }
+        const auto join = [](const std::vector<std::string>& parts) {
+            std::string text;
+            for (const std::string& part : parts) {
+                text += part + '\n';
+            }
+            return text;
+        };
+        const std::string before = join(lines);
+        writeFile(path, before);
+        std::optional<Document> document = Document::openFile(path);
+        ASSERT_TRUE(document.has_value());
+        document->setSelections({caret(before.size())});
+
+        for (int edit = 1 + static_cast<int>(random() % 4); edit > 0; --edit) {
+            const usize at = random() % (lines.size() + 1);
+            if (random() % 2 == 0 || at == lines.size()) {
+                lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(at), "new");
+            } else {
+                lines.erase(lines.begin() + static_cast<std::ptrdiff_t>(at));
+            }
+        }
+        const std::string after = join(lines);
+        writeFile(path, after);
+
+        const std::vector<Document::LinesReplaced> replaced = document->reload();
+        ASSERT_EQ(readAllString(document->buffer()), after) << round;
+        ASSERT_FALSE(document->modified());
+        ASSERT_FALSE(document->conflicted());
+        // the caret at the end stays there
+        ASSERT_EQ(selectionsOf(*document), (std::vector<std::pair<u64, u64>>{{after.size(), after.size()}}));
+
+        // every line left out of the changes is the line it was before
+        const std::vector<std::string> beforeLines = linesOf(before);
+        std::vector<u64> origins(beforeLines.size());
+        std::iota(origins.begin(), origins.end(), u64{0});
+        for (const Document::LinesReplaced& each : replaced) {
+            ASSERT_LE(each.first + each.removed, origins.size());
+            replaceItems(origins, each.first, each.removed, each.inserted, changed);
+        }
+        const std::vector<std::string> afterLines = linesOf(after);
+        ASSERT_EQ(origins.size(), afterLines.size()) << round;
+        for (usize i = 0; i < origins.size(); ++i) {
+            if (origins[i] != changed) {
+                ASSERT_EQ(beforeLines[origins[i]], afterLines[i]) << round << ' ' << i;
+            }
+        }
+        ASSERT_EQ(document->takeChanges().empty(), replaced.empty());
+        ASSERT_TRUE(document->reload().empty());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, reloadKeepsUnsavedEdits) {
+    const auto path = filePath("teks_document_test_reload_unsaved.txt");
+    writeFile(path, "one\ntwo\n");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_TRUE(document->replace(Range::makeUnchecked(Offset(0), Offset(3)), "1"));
+
+    // nothing changed on disk, so nothing conflicts
+    ASSERT_TRUE(document->reload().empty());
+    ASSERT_FALSE(document->conflicted());
+
+    writeFile(path, "one\nzwei\n");
+    ASSERT_TRUE(document->reload().empty());
+    ASSERT_TRUE(document->conflicted());
+    ASSERT_EQ(readAllString(document->buffer()), "1\ntwo\n");
+
+    ASSERT_EQ(document->save(), Document::SaveResult::Saved);
+    ASSERT_FALSE(document->conflicted());
+    ASSERT_EQ(readFile(path), "1\ntwo\n");
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, saveReplacesTheFileAndRestartsTheJournal) {
+    const auto path = filePath("teks_document_test_save.txt");
+    writeFile(path, "one\r\ntwo\r\n");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_TRUE(document->replace(Range::makeUnchecked(Offset(0), Offset(3)), "1"));
+    document->flushJournal();
+    ASSERT_TRUE(std::filesystem::exists(Journal::pathFor(path)));
+
+    ASSERT_EQ(document->save(), Document::SaveResult::Saved);
+    ASSERT_EQ(readFile(path), "1\r\ntwo\r\n");
+    ASSERT_FALSE(document->modified());
+    ASSERT_FALSE(std::filesystem::exists(std::filesystem::path(path).concat(".tmp")));
+    // the journal's edits are in the file now
+    document->flushJournal();
+    ASSERT_FALSE(std::filesystem::exists(Journal::pathFor(path)));
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, saveLeavesTheFileWhenTheEncodingWouldLoseText) {
+    const auto path = filePath("teks_document_test_save_latin1.txt");
+    writeFile(path, "caf\xE9\n");
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_EQ(document->encoding().charset, encoding::Charset::Latin1);
+    ASSERT_EQ(readAllString(document->buffer()), "caf\xC3\xA9\n");
+
+    // "€" is not in Latin-1
+    ASSERT_TRUE(document->replace(Range::makeUnchecked(Offset(5), Offset(5)), " 5\xE2\x82\xAC"));
+    ASSERT_EQ(document->save(), Document::SaveResult::Lossy);
+    ASSERT_EQ(readFile(path), "caf\xE9\n");
+    ASSERT_TRUE(document->modified());
+    ASSERT_FALSE(std::filesystem::exists(std::filesystem::path(path).concat(".tmp")));
+
+    ASSERT_EQ(document->save(true), Document::SaveResult::Saved);
+    ASSERT_EQ(readFile(path), "caf\xE9 5?\n");
+    ASSERT_FALSE(document->modified());
+    document.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(teksEditorDocument, saveLeavesTheFileWhenUtf16WouldReplaceInvalidBytes) {
+    const auto path = filePath("teks_document_test_save_utf16.txt");
+    writeFile(path, std::string("\xFF\xFE" "a\0", 4));
+    std::optional<Document> document = Document::openFile(path);
+    ASSERT_TRUE(document.has_value());
+    ASSERT_TRUE(document->replace(Range::makeUnchecked(Offset(1), Offset(1)), "\xFF"));
+    ASSERT_EQ(document->save(), Document::SaveResult::Lossy);
+    ASSERT_EQ(readFile(path), std::string("\xFF\xFE" "a\0", 4));
+    ASSERT_EQ(document->save(true), Document::SaveResult::Saved);
+    ASSERT_EQ(readFile(path), std::string("\xFF\xFE" "a\0\xFD\xFF", 6));
+    document.reset();
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,132 @@
+#include <teks/encoding/Encoding.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace teks;
+using namespace teks::encoding;
+
+namespace {
+    // "aé€😀 line\n" in each encoding
+    const std::string utf8 = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80 line\n";
+    const std::string utf16le = std::string(
+        "a\0\xE9\0\xAC\x20\x3D\xD8\x00\xDE \0l\0i\0n\0e\0\n\0", 22
+    );
+    const std::string utf16be = std::string(
+        "\0a\0\xE9\x20\xAC\xD8\x3D\xDE\x00\0 \0l\0i\0n\0e\0\n", 22
+    );
+
+    // Feeds `text` to a decoder in chunks of `chunkSize` bytes
+    std::string decodeInChunks(std::string_view text, Encoding encoding, usize chunkSize) {
+        std::string result;
+        Utf8Decoder decoder(encoding);
+        for (usize at = 0; at < text.size(); at += chunkSize) {
+            decoder.decode(text.substr(at, chunkSize), result);
+        }
+        decoder.finish(result);
+        return result;
+    }
+
+    std::string encodeInChunks(std::string_view text, Encoding encoding, usize chunkSize) {
+        std::string result;
+        Utf8Encoder encoder(encoding);
+        for (usize at = 0; at < text.size(); at += chunkSize) {
+            encoder.encode(text.substr(at, chunkSize), result);
+        }
+        encoder.finish(result);
+        return result;
+    }
+}
+
+TEST(teksEncodingEncoding, detectsByteOrderMarks) {
+    ASSERT_EQ(detectEncoding("\xEF\xBB\xBFtext", true), (Encoding{Charset::Utf8, true}));
+    ASSERT_EQ(detectEncoding("\xFF\xFEt\0", true), (Encoding{Charset::Utf16Le, true}));
+    ASSERT_EQ(detectEncoding("\xFE\xFF\0t", true), (Encoding{Charset::Utf16Be, true}));
+}
+
+TEST(teksEncodingEncoding, detectsUtf16WithoutByteOrderMark) {
+    ASSERT_EQ(detectEncoding(utf16le, true), (Encoding{Charset::Utf16Le, false}));
+    ASSERT_EQ(detectEncoding(utf16be, true), (Encoding{Charset::Utf16Be, false}));
+}
+
+TEST(teksEncodingEncoding, detectsUtf8AndLatin1) {
+    ASSERT_EQ(detectEncoding("", true), (Encoding{Charset::Utf8, false}));
+    ASSERT_EQ(detectEncoding(utf8, true), (Encoding{Charset::Utf8, false}));
+    ASSERT_EQ(detectEncoding("caf\xE9 cr\xE8me", true), (Encoding{Charset::Latin1, false}));
+    // mostly valid UTF-8 with one damaged byte
+    ASSERT_EQ(detectEncoding("\xC3\xA9\xC3\xA9\xC3\xA9 \xFF", true), (Encoding{Charset::Utf8, false}));
+}
+
+TEST(teksEncodingEncoding, sampleCutInsideASequenceIsStillUtf8) {
+    const std::string_view head = std::string_view(utf8).substr(0, 5);
+    ASSERT_EQ(detectEncoding(head, false), (Encoding{Charset::Utf8, false}));
+    ASSERT_EQ(detectEncoding(head, true), (Encoding{Charset::Latin1, false}));
+}
+
+TEST(teksEncodingEncoding, decodesToUtf8) {
+    ASSERT_EQ(decodeToUtf8(utf8, Encoding{Charset::Utf8, false}), utf8);
+    ASSERT_EQ(decodeToUtf8("\xEF\xBB\xBF" + utf8, Encoding{Charset::Utf8, true}), utf8);
+    ASSERT_EQ(decodeToUtf8(utf16le, Encoding{Charset::Utf16Le, false}), "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80 line\n");
+    ASSERT_EQ(decodeToUtf8(utf16be, Encoding{Charset::Utf16Be, false}), "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80 line\n");
+    ASSERT_EQ(decodeToUtf8("caf\xE9", Encoding{Charset::Latin1, false}), "caf\xC3\xA9");
+}
+
+TEST(teksEncodingEncoding, decodingIsIndependentOfChunking) {
+    std::string longUtf16 = "\xFF\xFE";
+    for (int i = 0; i < 50; ++i) {
+        longUtf16 += utf16le;
+    }
+    const std::string whole = decodeToUtf8(longUtf16, Encoding{Charset::Utf16Le, true});
+    for (usize chunkSize : {1u, 2u, 3u, 7u, 16u, 17u, 1000u}) {
+        ASSERT_EQ(decodeInChunks(longUtf16, Encoding{Charset::Utf16Le, true}, chunkSize), whole);
+    }
+}
+
+TEST(teksEncodingEncoding, malformedUtf16BecomesReplacementCharacters) {
+    // lone low surrogate, then a high surrogate without its pair, then a dangling byte
+    const std::string text("\x00\xDC" "a\0" "\x00\xD8" "b\0" "\x00\xD8" "c", 11);
+    ASSERT_EQ(
+        decodeToUtf8(text, Encoding{Charset::Utf16Le, false}),
+        "\xEF\xBF\xBD" "a" "\xEF\xBF\xBD" "b" "\xEF\xBF\xBD" "\xEF\xBF\xBD"
+    );
+}
+
+TEST(teksEncodingEncoding, encodeRoundTrips) {
+    for (Encoding encoding : {
+        Encoding{Charset::Utf8, false},
+        Encoding{Charset::Utf8, true},
+        Encoding{Charset::Utf16Le, false},
+        Encoding{Charset::Utf16Le, true},
+        Encoding{Charset::Utf16Be, true},
+    }) {
+        const std::string encoded = encodeFromUtf8(utf8, encoding);
+        ASSERT_EQ(decodeToUtf8(encoded, encoding), utf8);
+        for (usize chunkSize : {1u, 2u, 3u, 5u}) {
+            ASSERT_EQ(encodeInChunks(utf8, encoding, chunkSize), encoded);
+        }
+    }
+    ASSERT_EQ(encodeFromUtf8(utf8, Encoding{Charset::Utf16Le, false}), utf16le);
+    ASSERT_EQ(encodeFromUtf8(utf8, Encoding{Charset::Utf16Be, false}), utf16be);
+}
+
+TEST(teksEncodingEncoding, encodingToLatin1ReportsLoss) {
+    Utf8Encoder exact(Encoding{Charset::Latin1, false});
+    std::string out;
+    exact.encode("caf\xC3\xA9", out);
+    exact.finish(out);
+    ASSERT_EQ(out, "caf\xE9");
+    ASSERT_FALSE(exact.lossy());
+
+    Utf8Encoder lossy(Encoding{Charset::Latin1, false});
+    out.clear();
+    lossy.encode(utf8, out);
+    lossy.finish(out);
+    ASSERT_EQ(out, "a\xE9?? line\n");
+    ASSERT_TRUE(lossy.lossy());
+}
+
+TEST(teksEncodingEncoding, invalidUtf8IsReplacedWhenEncoding) {
+    ASSERT_EQ(encodeFromUtf8("a\xFF", Encoding{Charset::Utf16Le, false}), std::string("a\0\xFD\xFF", 4));
+    // a truncated sequence at the very end
+    ASSERT_EQ(encodeFromUtf8("a\xE2\x82", Encoding{Charset::Latin1, false}), "a??");
+}
@@ -0,0 +1,25 @@
+#include <teks/hash.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace teks;
+
+TEST(teksHash, xxHash64MatchesReferenceValues) {
+    ASSERT_EQ(xxHash64(""), 0xEF46DB3751D8E999ull);
+    ASSERT_EQ(xxHash64("a"), 0xD24EC4F1A98C6E5Bull);
+    ASSERT_EQ(xxHash64("abc"), 0x44BC2CF5AD770999ull);
+    ASSERT_EQ(xxHash64("0123456789abcdefghijklmnopqrstuvwxyz"), 0x69196C1B3AF0BFF9ull);
+    ASSERT_EQ(xxHash64("", 1), 0xD5AFBA1336A3BE4Bull);
+    ASSERT_EQ(xxHash64("abc", 1), 0xBEA9CA8199328908ull);
+}
+
+TEST(teksHash, xxHash64OfLongInput) {
+    std::string bytes;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        for (int byte = 0; byte < 256; ++byte) {
+            bytes.push_back(static_cast<char>(byte));
+        }
+    }
+    ASSERT_EQ(xxHash64(bytes), 0x8E03C838C596036Full);
+    ASSERT_EQ(xxHash64(bytes, 1), 0xA80257374B99ADE3ull);
+}
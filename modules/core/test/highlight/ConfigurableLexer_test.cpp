@@ -0,0 +1,100 @@
+#include <teks/highlight/ConfigurableLexer.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace teks::highlight;
+
+namespace {
+    std::vector<Token> lex(const Lexer& lexer, std::string_view line, LexerState state = 0) {
+        std::vector<Token> tokens;
+        (void)lexer.lexLine(line, state, tokens);
+        return tokens;
+    }
+}
+
+TEST(teksHighlightConfigurableLexer, emptyLineHasNoTokens) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    ASSERT_TRUE(lex(lexer, "").empty());
+    ASSERT_TRUE(lex(lexer, "   \t").empty());
+}
+
+TEST(teksHighlightConfigurableLexer, classifiesKeywordsTypesIdentifiersAndNumbers) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    ASSERT_EQ(lex(lexer, "return int x 42"), (std::vector<Token>{
+        {0, 6, TokenKind::Keyword},
+        {7, 3, TokenKind::Type},
+        {11, 1, TokenKind::Identifier},
+        {13, 2, TokenKind::Number},
+    }));
+}
+
+TEST(teksHighlightConfigurableLexer, utf8SequencesAreIdentifierCharacters) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    // a codepoint split into one byte tokens would be drawn as replacement characters
+    ASSERT_EQ(lex(lexer, "na\xc3\xafve \xe2\x88\x91(x)"), (std::vector<Token>{
+        {0, 6, TokenKind::Identifier},
+        {7, 3, TokenKind::Identifier},
+        {10, 1, TokenKind::Punctuation},
+        {11, 1, TokenKind::Identifier},
+        {12, 1, TokenKind::Punctuation},
+    }));
+}
+
+TEST(teksHighlightConfigurableLexer, stringsHonourEscapes) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    ASSERT_EQ(lex(lexer, R"("a\"b";)"), (std::vector<Token>{
+        {0, 6, TokenKind::String},
+        {6, 1, TokenKind::Punctuation},
+    }));
+}
+
+TEST(teksHighlightConfigurableLexer, unterminatedStringEndsAtEndOfLine) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    ASSERT_EQ(lex(lexer, "'abc"), (std::vector<Token>{{0, 4, TokenKind::String}}));
+}
+
+TEST(teksHighlightConfigurableLexer, lineCommentRunsToEndOfLine) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    ASSERT_EQ(lex(lexer, "x; // if"), (std::vector<Token>{
+        {0, 1, TokenKind::Identifier},
+        {1, 1, TokenKind::Punctuation},
+        {3, 5, TokenKind::Comment},
+    }));
+}
+
+TEST(teksHighlightConfigurableLexer, blockCommentStateCarriesAcrossLines) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    std::vector<Token> tokens;
+    const LexerState afterOpen = lexer.lexLine("a /* b", 0, tokens);
+    ASSERT_NE(afterOpen, 0);
+
+    tokens.clear();
+    const LexerState inside = lexer.lexLine("still", afterOpen, tokens);
+    ASSERT_EQ(inside, afterOpen);
+    ASSERT_EQ(tokens, (std::vector<Token>{{0, 5, TokenKind::Comment}}));
+
+    tokens.clear();
+    const LexerState afterClose = lexer.lexLine("c */ d", inside, tokens);
+    ASSERT_EQ(afterClose, 0);
+    ASSERT_EQ(tokens, (std::vector<Token>{
+        {0, 4, TokenKind::Comment},
+        {5, 1, TokenKind::Identifier},
+    }));
+}
+
+TEST(teksHighlightConfigurableLexer, directivesOnlyAtStartOfLine) {
+    const ConfigurableLexer lexer(cppLanguageConfig());
+    ASSERT_EQ(lex(lexer, "  # include <x>").front(), (Token{2, 9, TokenKind::Preprocessor}));
+    ASSERT_EQ(lex(lexer, "a #b").at(1), (Token{2, 1, TokenKind::Punctuation}));
+}
+
+TEST(teksHighlightConfigurableLexer, jsonHasNoComments) {
+    const ConfigurableLexer lexer(jsonLanguageConfig());
+    ASSERT_EQ(lex(lexer, R"({"a": null})"), (std::vector<Token>{
+        {0, 1, TokenKind::Punctuation},
+        {1, 3, TokenKind::String},
+        {4, 1, TokenKind::Punctuation},
+        {6, 4, TokenKind::Keyword},
+        {10, 1, TokenKind::Punctuation},
+    }));
+}
@@ -0,0 +1,104 @@
+#include <teks/highlight/HighlightCache.hpp>
+#include <teks/highlight/ConfigurableLexer.hpp>
+#include <teks/buffer/Buffer.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace teks;
+using namespace teks::highlight;
+
+namespace {
+    std::shared_ptr<const Lexer> cppLexer() {
+        return std::make_shared<const ConfigurableLexer>(cppLanguageConfig());
+    }
+
+    std::string manyLines(usize count) {
+        std::string text;
+        for (usize i = 0; i < count; ++i) {
+            text += "int value = 1; // line\n";
+        }
+        return text;
+    }
+
+    // Edits `line` in place the way an editor would, and tells the cache about it
+    void replaceLine(buffer::Buffer& buffer, HighlightCache& cache, usize line, std::string_view content) {
+        ASSERT_TRUE(buffer.replace(buffer.lineRange(line).value(), content));
+        cache.replaceLines(line, 1, 1);
+    }
+}
+
+TEST(teksHighlightHighlightCache, lexesLazilyUpToRequestedLine) {
+    const buffer::Buffer buffer(manyLines(100));
+    HighlightCache cache(cppLexer(), buffer.lineCount());
+    ASSERT_EQ(cache.validLines(), 0);
+    ASSERT_EQ(cache.tokens(buffer, 9).front(), (Token{0, 3, TokenKind::Type}));
+    ASSERT_EQ(cache.validLines(), 10);
+    ASSERT_EQ(cache.linesLexed(), 10);
+}
+
+TEST(teksHighlightHighlightCache, lexSomeFinishesDocument) {
+    const buffer::Buffer buffer(manyLines(100));
+    HighlightCache cache(cppLexer(), buffer.lineCount());
+    while (cache.lexSome(buffer, std::chrono::milliseconds(1))) {}
+    ASSERT_EQ(cache.validLines(), buffer.lineCount());
+}
+
+TEST(teksHighlightHighlightCache, editInPlaceRelexesOnlyEditedLine) {
+    buffer::Buffer buffer(manyLines(100000));
+    HighlightCache cache(cppLexer(), buffer.lineCount());
+    while (cache.lexSome(buffer, std::chrono::seconds(1))) {}
+
+    const u64 before = cache.linesLexed();
+    replaceLine(buffer, cache, 500, "return 2;");
+    ASSERT_EQ(cache.tokens(buffer, 500).front(), (Token{0, 6, TokenKind::Keyword}));
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+    ASSERT_EQ(cache.linesLexed() - before, 1);
+    ASSERT_EQ(cache.validLines(), buffer.lineCount());
+}
+
+TEST(teksHighlightHighlightCache, stateChangeRelexesUntilConvergence) {
+    buffer::Buffer buffer(manyLines(50));
+    HighlightCache cache(cppLexer(), buffer.lineCount());
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+
+    replaceLine(buffer, cache, 10, "/* open");
+    ASSERT_EQ(cache.tokens(buffer, 20), (std::vector<Token>{{0, 22, TokenKind::Comment}}));
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+
+    const u64 before = cache.linesLexed();
+    replaceLine(buffer, cache, 30, "*/");
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+    ASSERT_EQ(cache.tokens(buffer, 31).front(), (Token{0, 3, TokenKind::Type}));
+    ASSERT_EQ(cache.tokens(buffer, 29), (std::vector<Token>{{0, 22, TokenKind::Comment}}));
+    // line 30 plus the lines after it that had been lexed inside the comment
+    ASSERT_EQ(cache.linesLexed() - before, buffer.lineCount() - 30);
+}
+
+TEST(teksHighlightHighlightCache, separateEditsAreBothRelexed) {
+    buffer::Buffer buffer(manyLines(50));
+    HighlightCache cache(cppLexer(), buffer.lineCount());
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+
+    replaceLine(buffer, cache, 5, "return;");
+    replaceLine(buffer, cache, 40, "while");
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+    ASSERT_EQ(cache.tokens(buffer, 5).front(), (Token{0, 6, TokenKind::Keyword}));
+    ASSERT_EQ(cache.tokens(buffer, 40).front(), (Token{0, 5, TokenKind::Keyword}));
+}
+
+TEST(teksHighlightHighlightCache, insertedLinesAreLexedAndFollowingLinesReused) {
+    buffer::Buffer buffer(manyLines(50));
+    HighlightCache cache(cppLexer(), buffer.lineCount());
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+
+    ASSERT_TRUE(buffer.insert(buffer.lineRange(10).value().start(), "a\nb\n"));
+    cache.replaceLines(10, 0, 2);
+    ASSERT_EQ(cache.lineCount(), buffer.lineCount());
+
+    const u64 before = cache.linesLexed();
+    (void)cache.tokens(buffer, buffer.lineCount() - 1);
+    ASSERT_EQ(cache.linesLexed() - before, 2);
+    ASSERT_EQ(cache.tokens(buffer, 10), (std::vector<Token>{{0, 1, TokenKind::Identifier}}));
+    ASSERT_EQ(cache.tokens(buffer, 12).front(), (Token{0, 3, TokenKind::Type}));
+}
@@ -0,0 +1,39 @@
+#include <teks/highlight/PerfectKeywordSet.hpp>
+#include <teks/highlight/TableLexers.hpp>
+#include <gtest/gtest.h>
+
+using namespace teks::highlight;
+
+namespace {
+    constexpr PerfectKeywordSet smallSet{std::array{
+        KeywordEntry{"if", TokenKind::Keyword},
+        KeywordEntry{"int", TokenKind::Type},
+        KeywordEntry{"while", TokenKind::Keyword},
+    }};
+
+    static_assert(smallSet.valid());
+    static_assert(smallSet.find("int") == TokenKind::Type);
+    static_assert(!smallSet.find("in").has_value());
+}
+
+TEST(teksHighlightPerfectKeywordSet, findsEveryEntry) {
+    for (const KeywordEntry& entry : CppLexerSpec::keywords.entries()) {
+        ASSERT_EQ(CppLexerSpec::keywords.find(entry.word), entry.kind) << entry.word;
+    }
+}
+
+TEST(teksHighlightPerfectKeywordSet, rejectsNonKeywords) {
+    ASSERT_FALSE(smallSet.find("").has_value());
+    ASSERT_FALSE(smallSet.find("whilst").has_value());
+    ASSERT_FALSE(smallSet.find("If").has_value());
+    ASSERT_FALSE(CppLexerSpec::keywords.find("returns").has_value());
+    ASSERT_FALSE(CppLexerSpec::keywords.find("std").has_value());
+}
+
+TEST(teksHighlightPerfectKeywordSet, duplicateEntriesAreInvalid) {
+    constexpr PerfectKeywordSet duplicates{std::array{
+        KeywordEntry{"if", TokenKind::Keyword},
+        KeywordEntry{"if", TokenKind::Keyword},
+    }};
+    ASSERT_FALSE(duplicates.valid());
+}
@@ -0,0 +1,124 @@
+#include <teks/highlight/TableLexers.hpp>
+#include <teks/highlight/ConfigurableLexer.hpp>
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace teks::highlight;
+
+namespace {
+    std::vector<Token> lex(const Lexer& lexer, std::string_view line, LexerState state = 0) {
+        std::vector<Token> tokens;
+        (void)lexer.lexLine(line, state, tokens);
+        return tokens;
+    }
+
+    // Lexes `lines` in sequence with both lexers, asserting identical tokens and states
+    void assertSameAsConfigurable(
+        const Lexer& specialized,
+        const ConfigurableLexer& configurable,
+        const std::vector<std::string_view>& lines
+    ) {
+        LexerState specializedState = 0;
+        LexerState configurableState = 0;
+        for (std::string_view line : lines) {
+            std::vector<Token> specializedTokens;
+            std::vector<Token> configurableTokens;
+            specializedState = specialized.lexLine(line, specializedState, specializedTokens);
+            configurableState = configurable.lexLine(line, configurableState, configurableTokens);
+            ASSERT_EQ(specializedTokens, configurableTokens) << line;
+            ASSERT_EQ(specializedState, configurableState) << line;
+        }
+    }
+}
+
+TEST(teksHighlightTableLexers, cppMatchesConfigurableLexer) {
+    assertSameAsConfigurable(CppLexer(), ConfigurableLexer(cppLanguageConfig()), {
+        "#include <teks/types.hpp>",
+        "  #  define MAX(a, b) ((a) > (b) ? (a) : (b))",
+        "namespace teks::buffer {",
+        "    constexpr unsigned long value = 0x1F'FFu + .5e3 - 1.f; // trailing",
+        "    const char* s = \"esc\\\"aped\" 'c' '\\'';",
+        "    /* block */ int x = a / b; /* open",
+        "       still in comment",
+        "    */ return x; # not a directive",
+        "    auto naïve = u8\"ütf\";",
+        "\"unterminated",
+        "",
+        "   \t  \r",
+    });
+}
+
+TEST(teksHighlightTableLexers, jsonMatchesConfigurableLexer) {
+    assertSameAsConfigurable(JsonLexer(), ConfigurableLexer(jsonLanguageConfig()), {
+        R"({"key": [1, -2.5e10, true, false, null], "nested": {"s": "a\"b"}})",
+        R"(  "url": "http://example.com/a/*b*/c",)",
+        "",
+    });
+}
+
+TEST(teksHighlightTableLexers, keywordsMatchConfigurableLexer) {
+    // the runtime configs keep their own lists; the comparisons above only mean something if they agree
+    const auto assertSameVocabulary = [](const auto& keywords, const LanguageConfig& config) {
+        std::set<std::string, std::less<>> configKeywords;
+        std::set<std::string, std::less<>> configTypes;
+        for (const KeywordEntry& entry : keywords.entries()) {
+            (entry.kind == TokenKind::Type ? configTypes : configKeywords).emplace(entry.word);
+        }
+        ASSERT_EQ(configKeywords, config.keywords);
+        ASSERT_EQ(configTypes, config.types);
+    };
+    assertSameVocabulary(CppLexerSpec::keywords, cppLanguageConfig());
+    assertSameVocabulary(JsonLexerSpec::keywords, jsonLanguageConfig());
+}
+
+TEST(teksHighlightTableLexers, utf8SequencesAreIdentifierCharacters) {
+    ASSERT_EQ(lex(CppLexer(), "na\xc3\xafve \xe2\x88\x91(x)"), (std::vector<Token>{
+        {0, 6, TokenKind::Identifier},
+        {7, 3, TokenKind::Identifier},
+        {10, 1, TokenKind::Punctuation},
+        {11, 1, TokenKind::Identifier},
+        {12, 1, TokenKind::Punctuation},
+    }));
+}
+
+TEST(teksHighlightTableLexers, cppBlockCommentState) {
+    const CppLexer lexer;
+    std::vector<Token> tokens;
+    const LexerState open = lexer.lexLine("x /*", 0, tokens);
+    ASSERT_EQ(open, CppLexer::blockCommentState);
+    ASSERT_EQ(lex(lexer, "*/ y", open), (std::vector<Token>{
+        {0, 2, TokenKind::Comment},
+        {3, 1, TokenKind::Identifier},
+    }));
+}
+
+TEST(teksHighlightTableLexers, logLineTokens) {
+    const LogLexer lexer;
+    ASSERT_EQ(lex(lexer, R"(2024-01-31T12:00:00,123+01:00 ERROR [main-1] failed "x y" code=42)"), (std::vector<Token>{
+        {0, 29, TokenKind::Number},
+        {30, 5, TokenKind::Keyword},
+        {36, 8, TokenKind::Type},
+        {45, 6, TokenKind::Identifier},
+        {52, 5, TokenKind::String},
+        {58, 4, TokenKind::Identifier},
+        {62, 1, TokenKind::Punctuation},
+        {63, 2, TokenKind::Number},
+    }));
+}
+
+TEST(teksHighlightTableLexers, logUnclosedBracketIsPunctuation) {
+    const LogLexer lexer;
+    ASSERT_EQ(lex(lexer, "[warn"), (std::vector<Token>{
+        {0, 1, TokenKind::Punctuation},
+        {1, 4, TokenKind::Keyword},
+    }));
+}
+
+TEST(teksHighlightTableLexers, logHasNoMultiLineState) {
+    const LogLexer lexer;
+    std::vector<Token> tokens;
+    ASSERT_EQ(lexer.lexLine("/* not a comment", 0, tokens), 0);
+}
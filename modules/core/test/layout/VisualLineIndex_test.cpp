@@ -0,0 +1,138 @@
+#include <teks/layout/VisualLineIndex.hpp>
+#include <gtest/gtest.h>
+
+using namespace teks;
+using namespace teks::layout;
+
+TEST(teksLayoutVisualLineIndex, defaultConstructorHasOneLineOfOneRow) {
+    VisualLineIndex index;
+    ASSERT_EQ(index.lineCount(), 1);
+    ASSERT_EQ(index.rowCount(), 1);
+    ASSERT_EQ(index.locate(0), (VisualLineIndex::RowLocation{0, 0}));
+}
+
+TEST(teksLayoutVisualLineIndex, linesStartWithOneRowEach) {
+    VisualLineIndex index(4);
+    ASSERT_EQ(index.rowCount(), 4);
+    ASSERT_EQ(index.firstRow(3), 3);
+    ASSERT_EQ(index.locate(2), (VisualLineIndex::RowLocation{2, 0}));
+}
+
+TEST(teksLayoutVisualLineIndex, setRowsUpdatesMapping) {
+    VisualLineIndex index(4);
+    index.setRows(1, 3);
+    index.setRows(2, 2);
+    ASSERT_EQ(index.rowCount(), 7);
+    ASSERT_EQ(index.firstRow(1), 1);
+    ASSERT_EQ(index.firstRow(2), 4);
+    ASSERT_EQ(index.firstRow(3), 6);
+    ASSERT_EQ(index.firstRow(4), 7);
+    ASSERT_EQ(index.locate(0), (VisualLineIndex::RowLocation{0, 0}));
+    ASSERT_EQ(index.locate(3), (VisualLineIndex::RowLocation{1, 2}));
+    ASSERT_EQ(index.locate(5), (VisualLineIndex::RowLocation{2, 1}));
+    ASSERT_EQ(index.locate(6), (VisualLineIndex::RowLocation{3, 0}));
+    index.setRows(1, 1);
+    ASSERT_EQ(index.rowCount(), 5);
+    ASSERT_EQ(index.locate(2), (VisualLineIndex::RowLocation{2, 0}));
+}
+
+TEST(teksLayoutVisualLineIndex, setRowsClampsToOneRow) {
+    VisualLineIndex index(2);
+    index.setRows(0, 0);
+    ASSERT_EQ(index.rows(0), 1);
+    ASSERT_EQ(index.rowCount(), 2);
+}
+
+TEST(teksLayoutVisualLineIndex, locatePastEndClampsToLastRow) {
+    VisualLineIndex index(2);
+    index.setRows(1, 4);
+    ASSERT_EQ(index.locate(100), (VisualLineIndex::RowLocation{1, 3}));
+}
+
+TEST(teksLayoutVisualLineIndex, replaceLinesKeepsOtherLinesRows) {
+    VisualLineIndex index(4);
+    index.setRows(0, 2);
+    index.setRows(1, 5);
+    index.setRows(3, 3);
+    index.replaceLines(1, 2, 3);
+    ASSERT_EQ(index.lineCount(), 5);
+    ASSERT_EQ(index.rows(0), 2);
+    ASSERT_EQ(index.rows(1), 1);
+    ASSERT_EQ(index.rows(3), 1);
+    ASSERT_EQ(index.rows(4), 3);
+    ASSERT_EQ(index.rowCount(), 8);
+    ASSERT_EQ(index.locate(5), (VisualLineIndex::RowLocation{4, 0}));
+}
+
+TEST(teksLayoutVisualLineIndex, replaceLinesWithSameCountResetsRows) {
+    VisualLineIndex index(3);
+    index.setRows(1, 5);
+    index.replaceLines(1, 1, 1);
+    ASSERT_EQ(index.rows(1), 1);
+    ASSERT_EQ(index.rowCount(), 3);
+}
+
+TEST(teksLayoutVisualLineIndex, replaceAllLinesWithNoneKeepsOneLine) {
+    VisualLineIndex index(3);
+    index.replaceLines(0, 3, 0);
+    ASSERT_EQ(index.lineCount(), 1);
+    ASSERT_EQ(index.rowCount(), 1);
+}
+
+TEST(teksLayoutVisualLineIndex, replaceLastLinesKeepsEarlierRows) {
+    VisualLineIndex index(3);
+    index.setRows(0, 4);
+    index.setRows(2, 2);
+    index.replaceLines(2, 1, 3);
+    ASSERT_EQ(index.lineCount(), 5);
+    ASSERT_EQ(index.rows(0), 4);
+    ASSERT_EQ(index.rows(2), 1);
+    ASSERT_EQ(index.rowCount(), 8);
+    ASSERT_EQ(index.locate(6), (VisualLineIndex::RowLocation{3, 0}));
+    index.setRows(4, 3);
+    ASSERT_EQ(index.rowCount(), 10);
+}
+
+TEST(teksLayoutVisualLineIndex, setRowsMarksLinesFresh) {
+    VisualLineIndex index(4);
+    ASSERT_EQ(index.staleCount(), 4);
+    index.setRows(1, 3);
+    index.setRows(2, 1);
+    ASSERT_FALSE(index.stale(1));
+    ASSERT_TRUE(index.stale(3));
+    ASSERT_EQ(index.staleCount(), 2);
+    ASSERT_EQ(index.nextStale(0), 0);
+    ASSERT_EQ(index.nextStale(1), 3);
+    ASSERT_EQ(index.nextStale(4), std::nullopt);
+
+    index.markAllStale();
+    ASSERT_EQ(index.staleCount(), 4);
+    ASSERT_EQ(index.rows(1), 3);
+}
+
+TEST(teksLayoutVisualLineIndex, replacedLinesAreStale) {
+    VisualLineIndex index(3);
+    for (usize line = 0; line < 3; ++line) {
+        index.setRows(line, 2);
+    }
+    index.replaceLines(1, 1, 2);
+    ASSERT_EQ(index.staleCount(), 2);
+    ASSERT_EQ(index.nextStale(0), 1);
+    ASSERT_EQ(index.nextStale(3), std::nullopt);
+    ASSERT_EQ(index.rowCount(), 6);
+}
+
+TEST(teksLayoutVisualLineIndex, editsInLargeDocumentsKeepOtherLinesRows) {
+    VisualLineIndex index(100000);
+    for (usize line = 0; line < index.lineCount(); line += 1000) {
+        index.setRows(line, 4);
+    }
+    // an Enter in the middle splits a line in two, a Backspace joins them again
+    index.replaceLines(50500, 1, 2);
+    ASSERT_EQ(index.lineCount(), 100001);
+    ASSERT_EQ(index.rows(51001), 4);
+    ASSERT_EQ(index.firstRow(51001), 51001 + 51 * 3);
+    index.replaceLines(50500, 2, 1);
+    ASSERT_EQ(index.rowCount(), 100000 + 100 * 3);
+    ASSERT_EQ(index.locate(51000 + 51 * 3), (VisualLineIndex::RowLocation{51000, 0}));
+}
@@ -0,0 +1,117 @@
+#include <teks/metrics.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace teks;
+using namespace teks::metrics;
+
+TEST(teksMetrics, bucketsAreExactForSmallLatenciesAndWithinASixteenthAbove) {
+    for (u64 nanoseconds = 0; nanoseconds < LatencyHistogram::subBucketCount; ++nanoseconds) {
+        const usize bucket = LatencyHistogram::bucketOf(nanoseconds);
+        ASSERT_EQ(LatencyHistogram::bucketLowest(bucket), nanoseconds);
+        ASSERT_EQ(LatencyHistogram::bucketHighest(bucket), nanoseconds);
+    }
+    for (u64 nanoseconds : {u64(16), u64(17), u64(1000), u64(123456789), u64(1) << 40, ~u64(0)}) {
+        const usize bucket = LatencyHistogram::bucketOf(nanoseconds);
+        ASSERT_LT(bucket, LatencyHistogram::bucketCount);
+        ASSERT_LE(LatencyHistogram::bucketLowest(bucket), nanoseconds);
+        ASSERT_GE(LatencyHistogram::bucketHighest(bucket), nanoseconds);
+        ASSERT_LE(LatencyHistogram::bucketHighest(bucket) - LatencyHistogram::bucketLowest(bucket), nanoseconds / 16);
+    }
+    // consecutive buckets leave no gaps
+    for (usize bucket = 0; bucket + 1 < LatencyHistogram::bucketCount; ++bucket) {
+        ASSERT_EQ(LatencyHistogram::bucketHighest(bucket) + 1, LatencyHistogram::bucketLowest(bucket + 1));
+    }
+}
+
+TEST(teksMetrics, histogramStatistics) {
+    LatencyHistogram histogram;
+    ASSERT_EQ(histogram.count(), 0);
+    ASSERT_EQ(histogram.percentile(50.0), 0);
+    for (u64 nanoseconds = 1; nanoseconds <= 1000; ++nanoseconds) {
+        histogram.record(nanoseconds * 1000);
+    }
+    ASSERT_EQ(histogram.count(), 1000);
+    ASSERT_EQ(histogram.min(), 1000);
+    ASSERT_EQ(histogram.max(), 1000000);
+    ASSERT_EQ(histogram.mean(), 500500);
+    ASSERT_NEAR(static_cast<double>(histogram.percentile(50.0)), 500000.0, 500000.0 / 16);
+    ASSERT_NEAR(static_cast<double>(histogram.percentile(99.0)), 990000.0, 990000.0 / 16);
+    ASSERT_EQ(histogram.percentile(100.0), 1000000);
+
+    LatencyHistogram other;
+    other.record(5);
+    histogram.merge(other);
+    ASSERT_EQ(histogram.count(), 1001);
+    ASSERT_EQ(histogram.min(), 5);
+    ASSERT_EQ(histogram.percentile(0.0), 5);
+}
+
+TEST(teksMetrics, recordsFromEveryThreadIncludingExitedOnes) {
+    reset();
+    std::vector<std::thread> threads;
+    for (u64 thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([thread]() {
+            for (u64 i = 0; i < 1000; ++i) {
+                record(Operation::FileSave, 100 + thread);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    record(Operation::FileSave, 1);
+
+    const LatencyHistogram saves = histogram(Operation::FileSave);
+    ASSERT_EQ(saves.count(), 4001);
+    ASSERT_EQ(saves.min(), 1);
+    ASSERT_EQ(saves.max(), 103);
+    ASSERT_EQ(histogram(Operation::FileOpen).count(), 0);
+
+    reset();
+    ASSERT_EQ(histogram(Operation::FileSave).count(), 0);
+    record(Operation::FileSave, 7);
+    ASSERT_EQ(histogram(Operation::FileSave).count(), 1);
+    ASSERT_EQ(histogram(Operation::FileSave).max(), 7);
+}
+
+TEST(teksMetrics, scopedLatencyRecordsOnceWhenEnabled) {
+    reset();
+    {
+        TEKS_MEASURE_LATENCY(FileOpen);
+    }
+    ASSERT_EQ(histogram(Operation::FileOpen).count(), enabled ? 1 : 0);
+}
+
+TEST(teksMetrics, cheapOperationsAreSampled) {
+    reset();
+    constexpr u64 calls = 64000;
+    for (u64 call = 0; call < calls; ++call) {
+        TEKS_MEASURE_LATENCY(LineRange);
+    }
+    // the gaps are random, about one in `samplingPeriod` calls is timed
+    const u64 expected = calls / samplingPeriod(Operation::LineRange);
+    const u64 timed = histogram(Operation::LineRange).count();
+    if (enabled) {
+        ASSERT_GT(timed, expected / 2);
+        ASSERT_LT(timed, expected * 2);
+    } else {
+        ASSERT_EQ(timed, 0);
+    }
+}
+
+TEST(teksMetrics, toJsonListsEveryOperation) {
+    reset();
+    record(Operation::Insert, 20);
+    record(Operation::Insert, 20);
+    const std::string json = toJson();
+    ASSERT_EQ(json.front(), '{');
+    ASSERT_EQ(json.back(), '}');
+    ASSERT_NE(json.find("\"insert\":{\"count\":2,\"min\":20,\"mean\":20,"), std::string::npos);
+    ASSERT_NE(json.find("\"max\":20,\"sampledOneIn\":1,\"buckets\":[[20,2]]"), std::string::npos);
+    for (const char* name : {"erase", "replace", "readString", "lineRange", "fileOpen", "fileSave", "paint", "keyToPaint"}) {
+        ASSERT_NE(json.find(std::string("\"") + name + "\":{\"count\":0,"), std::string::npos) << name;
+    }
+}
@@ -0,0 +1,103 @@
+#include <teks/trace.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace teks;
+
+namespace {
+    usize occurrences(const std::string& text, const std::string& part) {
+        usize count = 0;
+        for (usize at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) {
+            ++count;
+        }
+        return count;
+    }
+}
+
+TEST(teksTrace, recordsBeginAndEndInOrder) {
+    trace::clear();
+    trace::begin("outer");
+    trace::begin("inner");
+    trace::end("inner");
+    trace::end("outer");
+
+    const std::string json = trace::toChromeJson();
+    ASSERT_TRUE(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    ASSERT_TRUE(json.ends_with("]}"));
+    const usize outerBegin = json.find("{\"name\":\"outer\",\"ph\":\"B\"");
+    const usize innerBegin = json.find("{\"name\":\"inner\",\"ph\":\"B\"");
+    const usize innerEnd = json.find("{\"name\":\"inner\",\"ph\":\"E\"");
+    const usize outerEnd = json.find("{\"name\":\"outer\",\"ph\":\"E\"");
+    ASSERT_NE(outerEnd, std::string::npos);
+    ASSERT_LT(outerBegin, innerBegin);
+    ASSERT_LT(innerBegin, innerEnd);
+    ASSERT_LT(innerEnd, outerEnd);
+
+    trace::clear();
+    ASSERT_EQ(trace::toChromeJson(), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[]}");
+}
+
+TEST(teksTrace, scopeRecordsWhenEnabled) {
+    trace::clear();
+    {
+        TEKS_TRACE_SCOPE("scoped");
+    }
+    ASSERT_EQ(occurrences(trace::toChromeJson(), "\"name\":\"scoped\""), trace::enabled ? 2 : 0);
+}
+
+TEST(teksTrace, keepsTheNewestEventsOfEachThread) {
+    trace::clear();
+    // the threads are all running at once, an exited thread's ring would be reused by the next
+    std::atomic<int> recorded{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 3; ++thread) {
+        threads.emplace_back([&recorded]() {
+            for (usize event = 0; event < trace::ringEvents + 100; ++event) {
+                trace::begin("busy");
+            }
+            trace::end("last");
+            ++recorded;
+            while (recorded.load() < 3) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const std::string json = trace::toChromeJson();
+    ASSERT_EQ(occurrences(json, "\"name\":\"last\""), 3);
+    // each thread has its own id
+    std::vector<std::string> lastEvents;
+    for (usize at = json.find("\"name\":\"last\""); at != std::string::npos; at = json.find("\"name\":\"last\"", at + 1)) {
+        const usize tid = json.find("\"tid\":", at);
+        lastEvents.push_back(json.substr(tid, json.find(',', tid) - tid));
+    }
+    ASSERT_NE(lastEvents[0], lastEvents[1]);
+    ASSERT_NE(lastEvents[1], lastEvents[2]);
+    ASSERT_NE(lastEvents[0], lastEvents[2]);
+    ASSERT_GE(occurrences(json, "\"name\":\"busy\""), 3 * (trace::ringEvents - 2));
+    ASSERT_LE(occurrences(json, "\"name\":\"busy\""), 3 * (trace::ringEvents - 1));
+}
+
+TEST(teksTrace, exportsWhileOtherThreadsRecord) {
+    trace::clear();
+    std::atomic<bool> stop{false};
+    std::thread writer([&stop]() {
+        while (!stop.load()) {
+            trace::begin("spinning");
+            trace::end("spinning");
+        }
+    });
+    for (int exported = 0; exported < 20; ++exported) {
+        const std::string json = trace::toChromeJson();
+        ASSERT_TRUE(json.ends_with("]}"));
+        ASSERT_EQ(occurrences(json, "{\"name\":"), occurrences(json, "\"ts\":"));
+    }
+    stop.store(true);
+    writer.join();
+}